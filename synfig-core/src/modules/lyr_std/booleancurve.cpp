@@ -69,7 +69,7 @@ BooleanCurve::~BooleanCurve()
 {
 }
 
-bool BooleanCurve::set_param(const String & param, const ValueBase &value)
+bool BooleanCurve::set_shape_param(const String & param, const ValueBase &value)
 {
 	if(param=="regions" && value.same_type_as(ValueBase::List()))
 	{
@@ -85,7 +85,7 @@ bool BooleanCurve::set_param(const String & param, const ValueBase &value)
 		return true;
 	}
 
-	return Layer_Shape::set_param(param,value);
+	return Layer_Shape::set_shape_param(param,value);
 }
 
 ValueBase BooleanCurve::get_param(const String & param)const
@@ -113,14 +113,42 @@ Layer::Vocab BooleanCurve::get_param_vocab()const
 	return ret;
 }
 
-Color BooleanCurve::get_color(Context /*context*/, const Point &/*pos*/)const
+void BooleanCurve::sync_vfunc()
 {
-	Color c(Color::alpha());
+	clear();
 
-	return c;
-}
+	const Real k = 1.0/3.0;
 
-bool BooleanCurve::accelerated_render(Context /*context*/,Surface */*surface*/,int /*quality*/, const RendDesc &/*renddesc*/, ProgressCallback */*cb*/)const
-{
-	return false;
+	// every region is a closed loop of spline points,
+	// overlapping regions are combined by the winding style of the shape
+	for(region_list_type::const_iterator r = regions.begin(); r != regions.end(); ++r)
+	{
+		if (r->empty())
+			continue;
+
+		const BLinePoint &first = r->front();
+		move_to(first.get_vertex());
+
+		Vector prev = first.get_vertex();
+		Vector prev_tangent = first.get_tangent2();
+		for(std::vector<BLinePoint>::const_iterator i = r->begin() + 1; i != r->end(); ++i)
+		{
+			const Vector &p = i->get_vertex();
+			if (prev_tangent.is_equal_to(Vector::zero()) && i->get_tangent1().is_equal_to(Vector::zero()))
+				line_to(p);
+			else
+				cubic_to(p, prev + prev_tangent*k, p - i->get_tangent1()*k);
+
+			prev = p;
+			prev_tangent = i->get_tangent2();
+		}
+
+		// close loop
+		const Vector &p = first.get_vertex();
+		if ( !prev_tangent.is_equal_to(Vector::zero())
+		  || !first.get_tangent1().is_equal_to(Vector::zero()) )
+			cubic_to(p, prev + prev_tangent*k, p - first.get_tangent1()*k);
+
+		close();
+	}
 }
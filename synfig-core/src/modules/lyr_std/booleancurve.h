@@ -69,13 +69,13 @@ public:
 	BooleanCurve();
 	~BooleanCurve();
 
-	virtual bool set_param(const String &param, const ValueBase &value);
+	virtual bool set_shape_param(const String &param, const ValueBase &value);
 	virtual ValueBase get_param(const String &param)const;
 
 	virtual Vocab get_param_vocab()const;
 
-	virtual Color get_color(Context context, const Point &pos)const;
-	virtual bool accelerated_render(Context context, Surface *surface, int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
+protected:
+	virtual void sync_vfunc();
 };
 
 }; // END of namespace lyr_std
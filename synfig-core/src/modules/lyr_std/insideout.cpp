@@ -48,6 +48,9 @@
 #include <synfig/valuenode.h>
 #include <synfig/transform.h>
 
+#include <synfig/rendering/common/task/taskdistort.h>
+#include <synfig/rendering/software/task/tasksw.h>
+
 #endif
 
 using namespace synfig;
@@ -68,6 +71,133 @@ SYNFIG_LAYER_SET_VERSION(InsideOut,"0.1");
 
 /* === M E T H O D S ======================================================= */
 
+class TaskInsideOut
+	: public rendering::TaskDistort
+{
+public:
+	typedef etl::handle<TaskInsideOut> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Point origin;
+	//! Area and raster of the context as it is rendered for the legacy layer,
+	//! see InsideOut::get_sub_renddesc_vfunc()
+	Rect context_rect;
+	VectorInt context_size;
+
+	//! Returns NaN for the origin itself, as InsideOut::get_color() does
+	Point
+	transform(const Point &point) const
+	{
+		Point pos(point - origin);
+		Real mag_squared = pos.mag_squared();
+		if (mag_squared == 0.0)
+			return Point::nan();
+		return pos/mag_squared + origin;
+	}
+
+	Rect
+	compute_required_source_rect(const Rect& /*source_rect*/, const Matrix& inv_matrix) const override
+	{
+		// the neighbourhood of the origin is mapped to infinity, and colors
+		// out of the context area are transparent, so only the samples inside
+		// of that area are taken into account
+		Rect rect = Rect::zero();
+		bool found = false;
+		const Vector dx = inv_matrix.axis_x();
+		const Vector dy = inv_matrix.axis_y();
+		Point row = inv_matrix.get_transformed( Vector((Real)target_rect.minx, (Real)target_rect.miny) );
+		for (int iy = target_rect.miny; iy < target_rect.maxy; ++iy, row += dy) {
+			Point p = row;
+			for (int ix = target_rect.minx; ix < target_rect.maxx; ++ix, p += dx) {
+				const Point q = transform(p);
+				if (!context_rect.is_inside(q))
+					continue;
+				if (found)
+					rect.expand(q);
+				else
+					rect = Rect(q);
+				found = true;
+			}
+		}
+		return rect;
+	}
+
+	void
+	set_coords_sub_tasks() override
+	{
+		set_coords_sub_tasks_on_raster(context_rect, context_size);
+	}
+};
+
+class TaskInsideOutSW
+	: public TaskInsideOut, public rendering::TaskSW, public rendering::TaskInterfaceSplit
+{
+public:
+	typedef etl::handle<TaskInsideOutSW> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	bool run(Task::RunParams& /*params*/) const override
+	{
+		if (!is_valid())
+			return true;
+
+		LockWrite la(this);
+		if (!la)
+			return false;
+
+		// context may be empty, if no pixel takes its color from the context area
+		const bool has_context = sub_task() && sub_task()->is_valid();
+		LockRead lb(has_context ? sub_task() : Task::Handle());
+		if (has_context && !lb)
+			return false;
+
+		// the context is sampled as by the legacy layer, see Layer_RenderingTask::get_color()
+		const synfig::Surface *b = has_context ? &lb->get_surface() : nullptr;
+		const Vector ppub = has_context ? sub_task()->get_pixels_per_unit() : Vector();
+		const Point context_origin = required_source_rect.get_min();
+		auto sample = [&](const Point &point) -> Color {
+			if (!b || !context_rect.is_inside(point))
+				return Color::alpha();
+			const Real u = (point[0] - context_origin[0])*ppub[0];
+			const Real v = (point[1] - context_origin[1])*ppub[1];
+			if (!(u >= 0 && v >= 0 && u < b->get_w() && v < b->get_h()))
+				return Color::alpha();
+			return b->linear_sample(u, v);
+		};
+
+		// pixels are scanned in the same order as in compute_required_source_rect()
+		const Vector ppu = get_pixels_per_unit();
+		Matrix bounds_transformation;
+		bounds_transformation.m00 = ppu[0];
+		bounds_transformation.m11 = ppu[1];
+		bounds_transformation.m20 = target_rect.minx - ppu[0]*source_rect.minx;
+		bounds_transformation.m21 = target_rect.miny - ppu[1]*source_rect.miny;
+		const Matrix inv_matrix = bounds_transformation.get_inverted();
+
+		const Vector dx = inv_matrix.axis_x();
+		const Vector dy = inv_matrix.axis_y();
+		const int tw = target_rect.get_width();
+		synfig::Surface::pen pen(la->get_surface().get_pen(target_rect.minx, target_rect.miny));
+
+		Point row = inv_matrix.get_transformed( Vector((Real)target_rect.minx, (Real)target_rect.miny) );
+		for (int iy = target_rect.miny; iy < target_rect.maxy; ++iy, row += dy, pen.inc_y(), pen.dec_x(tw)) {
+			Point p = row;
+			for (int ix = target_rect.minx; ix < target_rect.maxx; ++ix, p += dx, pen.inc_x())
+				pen.put_value(sample(transform(p)));
+		}
+
+		return true;
+	}
+};
+
+rendering::Task::Token TaskInsideOut::token(
+	DescAbstract<TaskInsideOut>("InsideOut") );
+rendering::Task::Token TaskInsideOutSW::token(
+	DescReal<TaskInsideOutSW, TaskInsideOut>("InsideOutSW") );
+
+
 InsideOut::InsideOut():
 	param_origin(ValueBase(Point(0,0)))
 {
@@ -155,6 +285,19 @@ public:
 		return "insideout";
 	}
 };
+
+rendering::Task::Handle
+InsideOut::build_rendering_task_vfunc(Context context) const
+{
+	TaskInsideOut::Handle task(new TaskInsideOut());
+	task->origin = param_origin.get(Point());
+	const RendDesc desc = get_sub_renddesc(RendDesc());
+	task->context_rect = Rect(desc.get_tl(), desc.get_br());
+	task->context_size = VectorInt(desc.get_w(), desc.get_h());
+	task->sub_task() = context.build_rendering_task();
+	return task;
+}
+
 etl::handle<Transform>
 InsideOut::get_transform()const
 {
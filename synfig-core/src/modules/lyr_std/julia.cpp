@@ -44,6 +44,9 @@
 #include <synfig/renddesc.h>
 #include <synfig/value.h>
 
+#include <synfig/rendering/common/task/taskdistort.h>
+#include <synfig/rendering/software/task/tasksw.h>
+
 #endif
 
 using namespace synfig;
@@ -225,29 +228,51 @@ Julia::get_sub_renddesc_vfunc(const RendDesc &renddesc) const
 	return desc;
 }
 
-Color
-Julia::get_color(Context context, const Point &pos)const
+Julia::Params::Params():
+	iterations(),
+	distort_inside(),
+	shade_inside(),
+	solid_inside(),
+	invert_inside(),
+	color_inside(),
+	distort_outside(),
+	shade_outside(),
+	solid_outside(),
+	invert_outside(),
+	color_outside(),
+	color_cycle(),
+	smooth_outside(),
+	broken()
+{ }
+
+void
+Julia::fill_params(Params &params)const
 {
-	Color icolor=param_icolor.get(Color());
-	Color ocolor=param_ocolor.get(Color());
-	Angle color_shift=param_color_shift.get(Angle());
-	int iterations=param_iterations.get(int());
-	Point seed=param_seed.get(Point());
-	bool distort_inside=param_distort_inside.get(bool());
-	bool shade_inside=param_shade_inside.get(bool());
-	bool solid_inside=param_solid_inside.get(bool());
-	bool invert_inside=param_invert_inside.get(bool());
-	bool color_inside=param_color_inside.get(bool());
-	bool distort_outside=param_distort_outside.get(bool());
-	bool shade_outside=param_shade_outside.get(bool());
-	bool solid_outside=param_solid_outside.get(bool());
-	bool invert_outside=param_invert_outside.get(bool());
-	bool color_outside=param_color_outside.get(bool());
-
-	bool color_cycle=param_color_cycle.get(bool());
-	bool smooth_outside=param_smooth_outside.get(bool());
-	bool broken=param_broken.get(bool());
+	params.icolor=param_icolor.get(Color());
+	params.ocolor=param_ocolor.get(Color());
+	params.color_shift=param_color_shift.get(Angle());
+	params.iterations=param_iterations.get(int());
+	params.seed=param_seed.get(Point());
+	params.distort_inside=param_distort_inside.get(bool());
+	params.shade_inside=param_shade_inside.get(bool());
+	params.solid_inside=param_solid_inside.get(bool());
+	params.invert_inside=param_invert_inside.get(bool());
+	params.color_inside=param_color_inside.get(bool());
+	params.distort_outside=param_distort_outside.get(bool());
+	params.shade_outside=param_shade_outside.get(bool());
+	params.solid_outside=param_solid_outside.get(bool());
+	params.invert_outside=param_invert_outside.get(bool());
+	params.color_outside=param_color_outside.get(bool());
+
+	params.color_cycle=param_color_cycle.get(bool());
+	params.smooth_outside=param_smooth_outside.get(bool());
+	params.broken=param_broken.get(bool());
+}
 
+template<typename Sampler>
+Color
+Julia::Params::color(const Point &pos, const Sampler &sample)const
+{
 	Real
 		cr, ci,
 		zr, zi,
@@ -298,9 +323,9 @@ Julia::get_color(Context context, const Point &pos)const
 				ret=ocolor;
 			else
 				if(distort_outside)
-					ret=context.get_color(Point(zr,zi));
+					ret=sample(Point(zr,zi));
 				else
-					ret=context.get_color(pos);
+					ret=sample(pos);
 
 			if(invert_outside)
 				ret=~ret;
@@ -324,9 +349,9 @@ Julia::get_color(Context context, const Point &pos)const
 		ret=icolor;
 	else
 		if(distort_inside)
-			ret=context.get_color(Point(zr,zi));
+			ret=sample(Point(zr,zi));
 		else
-			ret=context.get_color(pos);
+			ret=sample(pos);
 
 	if(invert_inside)
 		ret=~ret;
@@ -340,6 +365,122 @@ Julia::get_color(Context context, const Point &pos)const
 	return ret;
 }
 
+Color
+Julia::get_color(Context context, const Point &pos)const
+{
+	Params params;
+	fill_params(params);
+	return params.color(pos, [&context](const Point &point) { return context.get_color(point); });
+}
+
+class lyr_std::TaskJulia
+	: public rendering::TaskDistort
+{
+public:
+	typedef etl::handle<TaskJulia> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Julia::Params params;
+
+	//! Area and raster of the context as it is rendered for the legacy layer,
+	//! see Julia::get_sub_renddesc_vfunc()
+	Rect context_rect;
+	VectorInt context_size;
+
+	Rect
+	compute_required_source_rect(const Rect& source_rect, const Matrix& /*inv_matrix*/) const override
+	{
+		// colors are taken from the context area only, as by the legacy layer,
+		// distorted ones may come from any place of it
+		if (params.solid_inside && params.solid_outside)
+			return Rect::zero();
+		if ( (params.distort_inside && !params.solid_inside)
+		  || (params.distort_outside && !params.solid_outside) )
+			return context_rect;
+		return source_rect & context_rect;
+	}
+
+	void
+	set_coords_sub_tasks() override
+	{
+		set_coords_sub_tasks_on_raster(context_rect, context_size);
+	}
+};
+
+class TaskJuliaSW
+	: public TaskJulia, public rendering::TaskSW, public rendering::TaskInterfaceSplit
+{
+public:
+	typedef etl::handle<TaskJuliaSW> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	// every pixel may run the whole sequence
+	Real get_split_pixel_cost() const override
+		{ return std::max(1, params.iterations); }
+
+	bool run(Task::RunParams& /*params*/) const override
+	{
+		if (!is_valid())
+			return true;
+
+		LockWrite la(this);
+		if (!la)
+			return false;
+
+		// context is empty, if no color is taken from the context area
+		const bool has_context = sub_task() && sub_task()->is_valid();
+		LockRead lb(has_context ? sub_task() : Task::Handle());
+		if (has_context && !lb)
+			return false;
+
+		// the context is sampled as by the legacy layer, see Layer_RenderingTask::get_color()
+		const synfig::Surface *b = has_context ? &lb->get_surface() : nullptr;
+		const Vector ppub = has_context ? sub_task()->get_pixels_per_unit() : Vector();
+		const Point origin = required_source_rect.get_min();
+		auto sample = [&](const Point &point) -> Color {
+			if (!b || !context_rect.is_inside(point))
+				return Color::alpha();
+			const Real u = (point[0] - origin[0])*ppub[0];
+			const Real v = (point[1] - origin[1])*ppub[1];
+			if (!(u >= 0 && v >= 0 && u < b->get_w() && v < b->get_h()))
+				return Color::alpha();
+			return b->linear_sample(u, v);
+		};
+
+		const Vector upp = get_units_per_pixel();
+		const int tw = target_rect.get_width();
+		synfig::Surface::pen pen(la->get_surface().get_pen(target_rect.minx, target_rect.miny));
+
+		Point p = source_rect.get_min();
+		for (int iy = target_rect.miny; iy < target_rect.maxy; ++iy, p[1] += upp[1], pen.inc_y(), pen.dec_x(tw)) {
+			p[0] = source_rect.minx;
+			for (int ix = target_rect.minx; ix < target_rect.maxx; ++ix, p[0] += upp[0], pen.inc_x())
+				pen.put_value(params.color(p, sample));
+		}
+
+		return true;
+	}
+};
+
+rendering::Task::Token TaskJulia::token(
+	DescAbstract<TaskJulia>("Julia") );
+rendering::Task::Token TaskJuliaSW::token(
+	DescReal<TaskJuliaSW, TaskJulia>("JuliaSW") );
+
+rendering::Task::Handle
+Julia::build_rendering_task_vfunc(Context context) const
+{
+	TaskJulia::Handle task(new TaskJulia());
+	fill_params(task->params);
+	const RendDesc desc = get_sub_renddesc(RendDesc());
+	task->context_rect = Rect(desc.get_tl(), desc.get_br());
+	task->context_size = VectorInt(desc.get_w(), desc.get_h());
+	task->sub_task() = context.build_rendering_task();
+	return task;
+}
+
 Layer::Vocab
 Julia::get_param_vocab()const
 {
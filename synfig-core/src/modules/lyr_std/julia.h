@@ -48,10 +48,14 @@ namespace modules
 namespace lyr_std
 {
 
+class TaskJulia;
+
 class Julia : public Layer
 {
 	SYNFIG_LAYER_MODULE_EXT
 
+	friend class TaskJulia;
+
 private:
 	//!Parameter: (Color)
 	ValueBase param_icolor;
@@ -93,7 +97,34 @@ private:
 	ValueBase param_broken;
 	Real lp;
 
-
+	struct Params {
+		Color icolor;
+		Color ocolor;
+		Angle color_shift;
+		int iterations;
+		Point seed;
+		bool distort_inside;
+		bool shade_inside;
+		bool solid_inside;
+		bool invert_inside;
+		bool color_inside;
+		bool distort_outside;
+		bool shade_outside;
+		bool solid_outside;
+		bool invert_outside;
+		bool color_outside;
+		bool color_cycle;
+		bool smooth_outside;
+		bool broken;
+
+		Params();
+
+		//! Color of the point, \a sample returns color of the context
+		template<typename Sampler>
+		Color color(const Point &pos, const Sampler &sample) const;
+	};
+
+	void fill_params(Params &params)const;
 
 public:
 	Julia();
@@ -105,6 +136,7 @@ public:
 
 protected:
 	virtual RendDesc get_sub_renddesc_vfunc(const RendDesc &renddesc) const;
+	virtual rendering::Task::Handle build_rendering_task_vfunc(Context context) const;
 };
 
 }; // END of namespace lyr_std
@@ -48,10 +48,14 @@ namespace modules
 namespace lyr_std
 {
 
+class TaskMandelbrot;
+
 class Mandelbrot : public Layer
 {
 	SYNFIG_LAYER_MODULE_EXT
 
+	friend class TaskMandelbrot;
+
 private:
 	//!Parameter: (int)
 	ValueBase param_iterations;
@@ -92,6 +96,38 @@ private:
 	//!Parameter: (Real)
 	ValueBase param_gradient_scale_outside;
 
+	struct Params {
+		int iterations;
+		Real bailout;
+		Real lp;
+		bool broken;
+
+		bool distort_inside;
+		bool shade_inside;
+		bool solid_inside;
+		bool invert_inside;
+		Gradient gradient_inside;
+		Real gradient_offset_inside;
+		bool gradient_loop_inside;
+
+		bool distort_outside;
+		bool shade_outside;
+		bool solid_outside;
+		bool invert_outside;
+		Gradient gradient_outside;
+		bool smooth_outside;
+		Real gradient_offset_outside;
+		Real gradient_scale_outside;
+
+		Params();
+
+		//! Color of the point, \a sample returns color of the context
+		template<typename Sampler>
+		Color color(const Point &pos, const Sampler &sample) const;
+	};
+
+	void fill_params(Params &params)const;
+
 public:
 	Mandelbrot();
 
@@ -102,6 +138,7 @@ public:
 
 protected:
 	virtual RendDesc get_sub_renddesc_vfunc(const RendDesc &renddesc) const;
+	virtual rendering::Task::Handle build_rendering_task_vfunc(Context context) const;
 };
 
 }; // END of namespace lyr_std
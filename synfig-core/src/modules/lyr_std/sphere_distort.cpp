@@ -49,6 +49,9 @@
 
 #include <synfig/curve_helper.h>
 
+#include <synfig/rendering/common/task/taskdistort.h>
+#include <synfig/rendering/software/task/taskdistortsw.h>
+
 #endif
 
 /* === U S I N G =========================================================== */
@@ -303,6 +306,78 @@ inline Point sphtrans(const Point &p, const Point &center, const Real &radius,
 	return sphtrans(p, center, radius, percent, type, tmp);
 }
 
+class TaskSphereDistort
+	: public rendering::TaskDistort
+{
+public:
+	typedef etl::handle<TaskSphereDistort> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Vector center;
+	Real radius;
+	Real amount;
+	int type;
+	bool clip;
+
+	TaskSphereDistort(): radius(), amount(), type(TYPE_NORMAL), clip() { }
+
+	Rect
+	compute_required_source_rect(const Rect& source_rect, const Matrix& /*inv_matrix*/) const override
+	{
+		// points are moved only inside of the sphere (or the bar),
+		// and never leave it
+		const Real r = std::fabs(radius);
+		const Rect sphere(center - Vector(r, r), center + Vector(r, r));
+		Rect sub_source_rect = source_rect;
+		switch(type)
+		{
+			case TYPE_NORMAL:
+				if (rect_intersect(source_rect, sphere))
+					sub_source_rect |= sphere;
+				break;
+			case TYPE_DISTH:
+				if (source_rect.minx < sphere.maxx && sphere.minx < source_rect.maxx)
+					sub_source_rect.expand(Point(sphere.minx, source_rect.miny)).expand(Point(sphere.maxx, source_rect.maxy));
+				break;
+			case TYPE_DISTV:
+				if (source_rect.miny < sphere.maxy && sphere.miny < source_rect.maxy)
+					sub_source_rect.expand(Point(source_rect.minx, sphere.miny)).expand(Point(source_rect.maxx, sphere.maxy));
+				break;
+			default:
+				break;
+		}
+		return sub_source_rect;
+	}
+};
+
+class TaskSphereDistortSW
+	: public TaskSphereDistort, public rendering::TaskDistortSW, public rendering::TaskInterfaceSplit
+{
+public:
+	typedef etl::handle<TaskSphereDistortSW> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Point
+	point_vfunc(const Point &point) const override
+	{
+		bool clipped;
+		Point p = sphtrans(point, center, radius, amount, type, clipped);
+		return clip && clipped ? Point::nan() : p;
+	}
+
+	bool run(Task::RunParams& /*params*/) const override
+	{
+		return run_task(*this);
+	}
+};
+
+rendering::Task::Token TaskSphereDistort::token(
+	DescAbstract<TaskSphereDistort>("SphereDistort") );
+rendering::Task::Token TaskSphereDistortSW::token(
+	DescReal<TaskSphereDistortSW, TaskSphereDistort>("SphereDistortSW") );
+
 Layer::Handle
 Layer_SphereDistort::hit_check(Context context, const Point &pos)const
 {
@@ -594,6 +669,19 @@ public:
 	}
 };
 
+rendering::Task::Handle
+Layer_SphereDistort::build_rendering_task_vfunc(Context context) const
+{
+	TaskSphereDistort::Handle task(new TaskSphereDistort());
+	task->center = param_center.get(Vector());
+	task->radius = param_radius.get(double());
+	task->amount = param_amount.get(double());
+	task->type = param_type.get(int());
+	task->clip = param_clip.get(bool());
+	task->sub_task() = context.build_rendering_task();
+	return task;
+}
+
 etl::handle<Transform>
 Layer_SphereDistort::get_transform()const
 {
@@ -45,6 +45,8 @@
 #include <synfig/renddesc.h>
 #include <synfig/value.h>
 
+#include <synfig/rendering/software/task/taskpaintpixelsw.h>
+
 #endif
 
 using namespace synfig;
@@ -63,8 +65,63 @@ SYNFIG_LAYER_SET_VERSION(XORPattern,"0.1");
 
 /* === P R O C E D U R E S ================================================= */
 
+static Color
+xor_pattern_color(const Point &point, const Point &origin, const Point &size)
+{
+	unsigned int a=(unsigned int)floor((point[0]-origin[0])/size[0]), b=(unsigned int)floor((point[1]-origin[1])/size[1]);
+	unsigned char rindex=(a^b);
+	unsigned char gindex=(a^(~b))*4;
+	unsigned char bindex=~(a^b)*2;
+
+	return Color((Color::value_type)rindex/(Color::value_type)255.0,
+				 (Color::value_type)gindex/(Color::value_type)255.0,
+				 (Color::value_type)bindex/(Color::value_type)255.0,
+				 1.0);
+}
+
 /* === M E T H O D S ======================================================= */
 
+class TaskXORPattern: public rendering::Task, public rendering::TaskInterfaceTransformation
+{
+public:
+	typedef etl::handle<TaskXORPattern> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Point origin;
+	Point size;
+	rendering::Holder<rendering::TransformationAffine> transformation;
+
+	TaskXORPattern() { }
+	virtual rendering::Transformation::Handle get_transformation() const override
+		{ return transformation.handle(); }
+};
+
+
+class TaskXORPatternSW: public TaskXORPattern, public rendering::TaskPaintPixelSW
+{
+public:
+	typedef etl::handle<TaskXORPatternSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const override { return token.handle(); }
+
+	bool run(RunParams&) const override
+	{
+		return run_task();
+	}
+
+	Color get_color(const Vector& p) const override
+	{
+		return xor_pattern_color(p, origin, size);
+	}
+};
+
+rendering::Task::Token TaskXORPattern::token(
+	DescAbstract<TaskXORPattern>("TaskXORPattern") );
+rendering::Task::Token TaskXORPatternSW::token(
+	DescReal<TaskXORPatternSW, TaskXORPattern>("TaskXORPatternSW") );
+
+
 XORPattern::XORPattern():
 	Layer_Composite(1.0,Color::BLEND_COMPOSITE),
 	param_origin(ValueBase(Vector(0.125,0.125))),
@@ -107,15 +164,7 @@ XORPattern::get_color(Context context, const Point &point)const
 	if(get_amount()==0.0)
 		return context.get_color(point);
 
-	unsigned int a=(unsigned int)floor((point[0]-origin[0])/size[0]), b=(unsigned int)floor((point[1]-origin[1])/size[1]);
-	unsigned char rindex=(a^b);
-	unsigned char gindex=(a^(~b))*4;
-	unsigned char bindex=~(a^b)*2;
-
-	Color color((Color::value_type)rindex/(Color::value_type)255.0,
-				(Color::value_type)gindex/(Color::value_type)255.0,
-				(Color::value_type)bindex/(Color::value_type)255.0,
-				1.0);
+	Color color=xor_pattern_color(point, origin, size);
 
 	if(get_amount() == 1 && get_blend_method() == Color::BLEND_STRAIGHT)
 		return color;
@@ -155,3 +204,12 @@ XORPattern::hit_check(Context context, const Point &getpos)const
 
 	return const_cast<XORPattern*>(this);
 }
+
+rendering::Task::Handle
+XORPattern::build_composite_task_vfunc(ContextParams /*context_params*/) const
+{
+	TaskXORPattern::Handle task(new TaskXORPattern());
+	task->origin = param_origin.get(Point());
+	task->size = param_size.get(Point());
+	return task;
+}
@@ -52,7 +52,47 @@ using namespace synfig;
 SYNFIG_TARGET_INIT(ffmpeg_trgt);
 SYNFIG_TARGET_SET_NAME(ffmpeg_trgt,"ffmpeg");
 SYNFIG_TARGET_SET_EXT(ffmpeg_trgt,"mpg");
-SYNFIG_TARGET_SET_VERSION(ffmpeg_trgt,"0.1");
+SYNFIG_TARGET_SET_VERSION(ffmpeg_trgt,"0.2");
+
+/* === P R O C E D U R E S ================================================= */
+
+// Colors are converted to yuv420p by ITU-R BT.601 matrix in limited (tv) range.
+// ffmpeg uses the same matrix and range for RGB input of the codecs which
+// take yuv420p only, and assumes them for untagged yuv420p rawvideo input.
+// Loops below use integer arithmetic without branches to be vectorized by compiler.
+
+static void
+convert_row_y(unsigned char *dst, const unsigned char *rgba, int width)
+{
+	for(int i = 0; i < width; ++i) {
+		const int r = rgba[4*i], g = rgba[4*i + 1], b = rgba[4*i + 2];
+		dst[i] = (unsigned char)(((66*r + 129*g + 25*b + 128) >> 8) + 16);
+	}
+}
+
+//! Chroma of yuv420p, average of 2x2 pixels taken from two rows,
+//! last column of odd width is averaged from two pixels (counted twice)
+static void
+convert_rows_uv420(unsigned char *dst_u, unsigned char *dst_v, const unsigned char *rgba0, const unsigned char *rgba1, int width)
+{
+	for(int i = 0; i < width/2; ++i) {
+		const unsigned char *p0 = rgba0 + 8*i, *p1 = rgba1 + 8*i;
+		const int r = p0[0] + p0[4] + p1[0] + p1[4];
+		const int g = p0[1] + p0[5] + p1[1] + p1[5];
+		const int b = p0[2] + p0[6] + p1[2] + p1[6];
+		dst_u[i] = (unsigned char)((-38*r -  74*g + 112*b + (128 << 10) + 512) >> 10);
+		dst_v[i] = (unsigned char)((112*r -  94*g -  18*b + (128 << 10) + 512) >> 10);
+	}
+	if (width & 1) {
+		const int i = width/2;
+		const unsigned char *p0 = rgba0 + 8*i, *p1 = rgba1 + 8*i;
+		const int r = 2*(p0[0] + p1[0]);
+		const int g = 2*(p0[1] + p1[1]);
+		const int b = 2*(p0[2] + p1[2]);
+		dst_u[i] = (unsigned char)((-38*r -  74*g + 112*b + (128 << 10) + 512) >> 10);
+		dst_v[i] = (unsigned char)((112*r -  94*g -  18*b + (128 << 10) + 512) >> 10);
+	}
+}
 
 /* === M E T H O D S ======================================================= */
 
@@ -65,11 +105,29 @@ ffmpeg_trgt::does_video_codec_support_alpha_channel(const synfig::String &video_
 	return std::find(valid_codecs.begin(), valid_codecs.end(), video_codec) != valid_codecs.end();
 }
 
+bool
+ffmpeg_trgt::does_video_codec_encode_yuv420p_only(const synfig::String &video_codec) const
+{
+	// codecs which have no other output pixel format for RGB input,
+	// libx264 takes yuv444p, so it is here only for lossless mode with explicit yuv420p output
+	const std::vector<const char*> yuv420p_codecs = {
+		"mpeg1video", "mpeg4", "msmpeg4", "msmpeg4v1", "msmpeg4v2", "wmv1", "wmv2",
+		"h263p", "flv", "libvpx", "libx264-lossless"
+	};
+	return std::find(yuv420p_codecs.begin(), yuv420p_codecs.end(), video_codec) != yuv420p_codecs.end();
+}
+
 ffmpeg_trgt::ffmpeg_trgt(const synfig::filesystem::Path& Filename, const synfig::TargetParam &params):
 	imagecount(0),
 	multi_image(false),
 	filename(Filename),
-	bitrate()
+	bitrate(),
+	current_scanline(0),
+	use_yuv420p(false),
+	current_frame(0),
+	writer_pending(false),
+	writer_stop(false),
+	writer_failed(false)
 {
 	// Set default video codec and bitrate if they weren't given.
 	if (params.video_codec == "none")
@@ -90,6 +148,8 @@ ffmpeg_trgt::ffmpeg_trgt(const synfig::filesystem::Path& Filename, const synfig:
 
 ffmpeg_trgt::~ffmpeg_trgt()
 {
+	stop_writer();
+
 	if(pipe)
 	{
 		pipe->close();
@@ -104,6 +164,45 @@ ffmpeg_trgt::~ffmpeg_trgt()
 	}
 }
 
+void
+ffmpeg_trgt::writer_loop()
+{
+	std::unique_lock<std::mutex> lock(writer_mutex);
+	while(true) {
+		writer_cond.wait(lock, [this]{ return writer_pending || writer_stop; });
+		if (!writer_pending)
+			break;
+
+		// renderer does not touch this frame until writer_pending is reset
+		const std::vector<unsigned char> &frame = frames[1 - current_frame];
+		lock.unlock();
+		const bool success = pipe->write(frame.data(), 1, frame.size()) == frame.size();
+		if (success)
+			pipe->flush();
+		lock.lock();
+
+		if (!success) {
+			synfig::error(_("Unable to write frame to ffmpeg pipe"));
+			writer_failed = true;
+		}
+		writer_pending = false;
+		writer_cond.notify_all();
+	}
+}
+
+void
+ffmpeg_trgt::stop_writer()
+{
+	if (!writer.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		writer_stop = true;
+	}
+	writer_cond.notify_all();
+	writer.join();
+}
+
 bool
 ffmpeg_trgt::set_rend_desc(RendDesc *given_desc)
 {
@@ -221,9 +320,12 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 		vargs.push_back(sound_filename);
 	}
 	vargs.push_back("-f");
-	vargs.push_back("image2pipe");
-	vargs.push_back("-vcodec");
-	vargs.push_back(use_alpha ? "pam" : "ppm");
+	vargs.push_back("rawvideo");
+	use_yuv420p = !use_alpha && does_video_codec_encode_yuv420p_only(video_codec);
+	vargs.push_back("-pix_fmt");
+	vargs.push_back(use_alpha ? "rgba" : use_yuv420p ? "yuv420p" : "rgb24");
+	vargs.push_back("-s");
+	vargs.push_back(strprintf("%dx%d", desc.get_w(), desc.get_h()));
 	vargs.push_back("-r");
 	{
 		// this should avoid conflicts with locale settings
@@ -285,14 +387,22 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 
 	synfig::info(_("Running async command: %s"), pipe->get_command().c_str());
 
+	writer = std::thread(&ffmpeg_trgt::writer_loop, this);
+
 	return true;
 }
 
 void
 ffmpeg_trgt::end_frame()
 {
-	//pipe->print(" ");
-	pipe->flush();
+	// wait until the previous frame is written, and pass the current one to writer
+	{
+		std::unique_lock<std::mutex> lock(writer_mutex);
+		writer_cond.wait(lock, [this]{ return !writer_pending; });
+		writer_pending = true;
+		current_frame = 1 - current_frame;
+	}
+	writer_cond.notify_all();
 	imagecount++;
 }
 
@@ -301,34 +411,34 @@ ffmpeg_trgt::start_frame(synfig::ProgressCallback */*callback*/)
 {
 	std::size_t w=desc.get_w(),h=desc.get_h();
 
-	if(!pipe || !pipe->is_writable())
+	if(!pipe || !pipe->is_writable() || !writer.joinable())
 		return false;
 
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		if (writer_failed)
+			return false;
+	}
+
 	const bool use_alpha = get_alpha_mode() == TARGET_ALPHA_MODE_KEEP;
 
-	if (!use_alpha) {
-		pipe->printf("P6\n");
-		pipe->printf("%zu %zu\n", w, h);
-		pipe->printf("%d\n", 255);
+	if (use_yuv420p) {
+		// chroma planes have half of width and height, rounded up
+		const std::size_t cw = (w + 1)/2, ch = (h + 1)/2;
+		frames[current_frame].resize(w*h + 2*cw*ch);
+		buffer.resize(w*4*2);
 	} else {
-		pipe->printf("P7\n");
-		pipe->printf("WIDTH %zu\n", w);
-		pipe->printf("HEIGHT %zu\n", h);
-		pipe->printf("DEPTH 4\n");
-		pipe->printf("MAXVAL %d\n", 255);
-		pipe->printf("TUPLTYPE RGB_ALPHA\n");
-		pipe->printf("ENDHDR\n");
+		frames[current_frame].resize(w*h*(use_alpha ? 4 : 3));
 	}
-
-	buffer.resize(w * (use_alpha ? 4 : 3));
 	color_buffer.resize(w);
 
 	return true;
 }
 
 Color *
-ffmpeg_trgt::start_scanline(int /*scanline*/)
+ffmpeg_trgt::start_scanline(int scanline)
 {
+	current_scanline = scanline;
 	return color_buffer.empty() ? nullptr : color_buffer.data();
 }
 
@@ -338,14 +448,33 @@ ffmpeg_trgt::end_scanline()
 	if(!pipe)
 		return false;
 
-	PixelFormat format = PF_RGB;
-	if(get_alpha_mode() == TARGET_ALPHA_MODE_KEEP)
-		format |= PF_A;
+	const int w = desc.get_w(), h = desc.get_h();
+	const int y = current_scanline;
+	if (y < 0 || y >= h)
+		return false;
 
-	color_to_pixelformat(buffer.data(), color_buffer.data(), format, 0, desc.get_w());
+	unsigned char *frame = frames[current_frame].data();
+	if (!use_yuv420p) {
+		const PixelFormat format = get_alpha_mode() == TARGET_ALPHA_MODE_KEEP ? PF_RGB|PF_A : PF_RGB;
+		const std::size_t row_size = (std::size_t)w*(format & PF_A ? 4 : 3);
+		color_to_pixelformat(frame + (std::size_t)y*row_size, color_buffer.data(), format, 0, w);
+		return true;
+	}
 
-	if(!pipe->write(buffer.data(),1,buffer.size()))
-		return false;
+	// two last rows are kept for chroma subsampling
+	unsigned char *row = buffer.data() + (y & 1)*w*4;
+	color_to_pixelformat(row, color_buffer.data(), PF_RGB|PF_A, 0, w);
+	convert_row_y(frame + (std::size_t)y*w, row, w);
+
+	// chroma is written after odd row, and after the last row of odd height
+	const std::size_t plane = (std::size_t)w*h;
+	const std::size_t cw = (w + 1)/2, ch = (h + 1)/2;
+	const std::size_t offset = (std::size_t)(y/2)*cw;
+	if (y & 1)
+		convert_rows_uv420(frame + plane + offset, frame + plane + cw*ch + offset, buffer.data(), buffer.data() + w*4, w);
+	else
+	if (y == h - 1)
+		convert_rows_uv420(frame + plane + offset, frame + plane + cw*ch + offset, row, row, w);
 
 	return true;
 }
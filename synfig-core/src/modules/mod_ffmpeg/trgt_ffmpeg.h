@@ -31,6 +31,10 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <synfig/os.h>
 #include <synfig/string.h>
 #include <synfig/target_scanline.h>
@@ -58,7 +62,27 @@ private:
 	std::string video_codec;
 	int bitrate;
 
+	int current_scanline;
+	//! frames are sent to ffmpeg as rawvideo rgb24 (or rgba),
+	//! or as yuv420p if video codec converts them to yuv420p anyway
+	std::vector<unsigned char> frames[2];
+	bool use_yuv420p;
+	//! index of frame which is filled by renderer
+	int current_frame;
+
+	//! writer thread sends the filled frame to the pipe, while the next one is rendered
+	std::thread writer;
+	std::mutex writer_mutex;
+	std::condition_variable writer_cond;
+	bool writer_pending;
+	bool writer_stop;
+	bool writer_failed;
+
 	bool does_video_codec_support_alpha_channel(const synfig::String& video_codec) const;
+	bool does_video_codec_encode_yuv420p_only(const synfig::String& video_codec) const;
+
+	void writer_loop();
+	void stop_writer();
 
 public:
 
@@ -492,7 +492,8 @@ Advanced_Outline::Advanced_Outline():
 	param_smoothness(ValueBase(Real(1))),
 	param_homogeneous(ValueBase(false)),
 	param_dash_offset(ValueBase(Real(0))),
-	param_dash_enabled(ValueBase(false))
+	param_dash_enabled(ValueBase(false)),
+	bend_cache(new rendering::Bend::Cache())
 {
 	clear();
 
@@ -687,7 +688,7 @@ Advanced_Outline::sync_vfunc()
 		aline.build_contour(contour);
 		
 		// bend contour
-		bend.bend(shape_contour(), contour, Matrix(), contour_segments);
+		bend.bend(shape_contour(), contour, Matrix(), contour_segments, bend_cache);
 	}
 	catch (...) { synfig::error("Advanced Outline::sync(): Exception thrown"); throw; }
 }
@@ -32,6 +32,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include <synfig/layers/layer_shape.h>
+#include <synfig/rendering/primitive/bend.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -68,6 +69,9 @@ private:
 	//! Parameter: (bool)
 	synfig::ValueBase param_dash_enabled;
 
+	//! Segments generated by the last sync, unchanged ones are reused
+	synfig::rendering::Bend::Cache::Handle bend_cache;
+
 public:
 	enum CuspType
 	{
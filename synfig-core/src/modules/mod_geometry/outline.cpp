@@ -73,7 +73,8 @@ SYNFIG_LAYER_SET_VERSION(Outline,"0.3");
 /* === M E T H O D S ======================================================= */
 
 
-Outline::Outline()
+Outline::Outline():
+	bend_cache(new rendering::Bend::Cache())
 {
 	old_version = false;
 	param_round_tip[0]=ValueBase(true);
@@ -206,7 +207,7 @@ Outline::sync_vfunc()
 		}
 		
 		contour.close_mirrored_vert();
-		bend.bend(shape_contour(), contour, Matrix(), contour_segments);
+		bend.bend(shape_contour(), contour, Matrix(), contour_segments, bend_cache);
 	} catch (...) { synfig::error("Outline::sync(): Exception thrown"); throw; }
 }
 
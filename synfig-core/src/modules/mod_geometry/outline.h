@@ -35,6 +35,7 @@
 #include <list>
 #include <vector>
 #include <synfig/layers/layer_shape.h>
+#include <synfig/rendering/primitive/bend.h>
 #include <synfig/value.h>
 
 /* === M A C R O S ========================================================= */
@@ -64,6 +65,9 @@ private:
 
 	bool old_version;
 
+	//! Segments generated by the last sync, unchanged ones are reused
+	synfig::rendering::Bend::Cache::Handle bend_cache;
+
 public:
 	Outline();
 
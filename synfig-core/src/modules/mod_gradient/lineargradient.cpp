@@ -33,6 +33,8 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+
 #include "lineargradient.h"
 
 #include <synfig/context.h>
@@ -97,6 +99,25 @@ public:
 		return params.gradient.average(dist - supersample, dist + supersample);
 		//return params.gradient.color(dist);
 	}
+
+	void get_color_span(const Vector& start, const Vector& step, int count, Color* out) const override
+	{
+		// distance along gradient changes linearly along the row
+		Real dist((start - params.p1)*params.diff);
+		Real dist_step(step*params.diff);
+		Color *end = out + count;
+
+		// row is orthogonal to the gradient, so all pixels have the same color
+		if (approximate_zero(dist_step*count)) {
+			std::fill(out, end, params.gradient.average(dist - supersample, dist + supersample));
+			return;
+		}
+
+		for(int i = 0; out < end; ++out, ++i) {
+			Real d = dist + dist_step*i;
+			*out = params.gradient.average(d - supersample, d + supersample);
+		}
+	}
 };
 
 rendering::Task::Token TaskLinearGradient::token(
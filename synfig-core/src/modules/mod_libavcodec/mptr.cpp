@@ -32,15 +32,50 @@
 #	include <config.h>
 #endif
 
-#include "mptr.h"
-#include <synfig/general.h>
-#include <synfig/localization.h>
-#include <synfig/surface.h>
+extern "C"
+{
+#ifdef HAVE_LIBAVFORMAT_AVFORMAT_H
+#	include <libavcodec/avcodec.h>
+#	include <libavformat/avformat.h>
+#	include <libavutil/pixdesc.h>
+#elif defined(HAVE_AVFORMAT_H)
+#	include <avformat.h>
+#elif defined(HAVE_FFMPEG_AVFORMAT_H)
+#	include <ffmpeg/avformat.h>
+#else
+#   ifndef DISABLE_MODULE
+#   define DISABLE_MODULE
+#   endif
+#endif
+
+#ifdef HAVE_LIBSWSCALE_SWSCALE_H
+#	include <libswscale/swscale.h>
+#elif defined(HAVE_SWSCALE_H)
+#	include <swscale.h>
+#elif defined(HAVE_FFMPEG_SWSCALE_H)
+#	include <ffmpeg/swscale.h>
+#else
+#   ifndef DISABLE_MODULE
+#   define DISABLE_MODULE
+#   endif
+#endif
+} // extern "C"
+
+#ifndef DISABLE_MODULE
+#	include <algorithm>
+#	include <cmath>
+#	include <deque>
+#	include "mptr.h"
+#	include <synfig/general.h>
+#	include <synfig/localization.h>
+#	include <synfig/surface.h>
+#	include <synfig/rendering/software/surfaceswpacked.h>
+#endif
 
-#include <algorithm>
-#include <functional>
 #endif
 
+#ifndef DISABLE_MODULE
+
 /* === U S I N G =========================================================== */
 
 using namespace synfig;
@@ -50,24 +85,363 @@ using namespace synfig;
 SYNFIG_IMPORTER_INIT(Importer_LibAVCodec);
 SYNFIG_IMPORTER_SET_NAME(Importer_LibAVCodec,"libav");
 SYNFIG_IMPORTER_SET_EXT(Importer_LibAVCodec,"avi");
-SYNFIG_IMPORTER_SET_VERSION(Importer_LibAVCodec,"0.1");
+SYNFIG_IMPORTER_SET_VERSION(Importer_LibAVCodec,"0.2");
 SYNFIG_IMPORTER_SET_SUPPORTS_FILE_SYSTEM_WRAPPER(Importer_LibAVCodec, false);
 
+/* === C L A S S E S & S T R U C T S ======================================= */
 
-/* === M E T H O D S ======================================================= */
+class Importer_LibAVCodec::Internal
+{
+private:
+	struct CacheEntry
+	{
+		int64_t pts;
+		rendering::Surface::Handle surface;
+		CacheEntry(int64_t pts, const rendering::Surface::Handle &surface):
+			pts(pts), surface(surface) { }
+	};
+
+	//! memory of decoded frames kept for nearby times, frames are packed to 8 bits per channel
+	static const size_t cache_max_size = 64*1024*1024;
+	//! decode forward instead of seeking when requested frame is not farther
+	static const int64_t max_skip_frames = 64;
+
+	AVFormatContext *format_context;
+	AVCodecContext *codec_context;
+	AVFrame *frame;
+	AVFrame *prev_frame;
+	AVPacket *packet;
+	SwsContext *swscale_context;
+
+	int stream_index;
+	AVRational time_base;
+	int64_t start_pts;
+	int64_t frame_duration;
+
+	//! pts of the frame in \c frame, or AV_NOPTS_VALUE when decoder position is unknown
+	int64_t position;
+	bool draining;
 
+	std::deque<CacheEntry> cache;
+	size_t cache_size;
+
+	int64_t time_to_pts(const Time &time) const
+		{ return start_pts + (int64_t)std::floor((double)time/av_q2d(time_base) + 0.5); }
+
+	rendering::Surface::Handle find_cached(int64_t pts) const
+	{
+		for(std::deque<CacheEntry>::const_iterator i = cache.begin(); i != cache.end(); ++i)
+			if (i->pts <= pts && pts < i->pts + frame_duration)
+				return i->surface;
+		return rendering::Surface::Handle();
+	}
+
+	bool seek(int64_t pts)
+	{
+		if (av_seek_frame(format_context, stream_index, pts, AVSEEK_FLAG_BACKWARD) < 0) {
+			// some formats can't seek by timestamp, so restart from the beginning
+			if (av_seek_frame(format_context, stream_index, start_pts, AVSEEK_FLAG_BACKWARD) < 0) {
+				synfig::error("Importer_LibAVCodec: could not seek");
+				return false;
+			}
+		}
+		avcodec_flush_buffers(codec_context);
+		av_frame_unref(frame);
+		av_frame_unref(prev_frame);
+		position = AV_NOPTS_VALUE;
+		draining = false;
+		return true;
+	}
+
+	//! decodes next frame into \c frame, returns false at the end of stream
+	bool decode_frame()
+	{
+		while(true) {
+			int res = avcodec_receive_frame(codec_context, frame);
+			if (res == 0) {
+				int64_t pts = frame->best_effort_timestamp;
+				if (pts == AV_NOPTS_VALUE)
+					pts = position == AV_NOPTS_VALUE ? start_pts : position + frame_duration;
+				position = pts;
+				return true;
+			}
+			if (res == AVERROR_EOF)
+				return false;
+			if (res != AVERROR(EAGAIN)) {
+				synfig::error("Importer_LibAVCodec: error while decoding frame");
+				return false;
+			}
+			if (draining)
+				return false;
+
+			// feed the decoder with the next packet of our stream
+			if (av_read_frame(format_context, packet) < 0) {
+				draining = true;
+				avcodec_send_packet(codec_context, nullptr);
+				continue;
+			}
+			if (packet->stream_index == stream_index)
+				res = avcodec_send_packet(codec_context, packet);
+			av_packet_unref(packet);
+			if (res < 0 && res != AVERROR(EAGAIN) && res != AVERROR_INVALIDDATA) {
+				synfig::error("Importer_LibAVCodec: error while sending packet to decoder");
+				return false;
+			}
+		}
+	}
+
+	//! converts frame straight into packed surface, it is expanded to floats only when it is used
+	rendering::Surface::Handle convert_frame(AVFrame *src)
+	{
+		const int w = src->width;
+		const int h = src->height;
+		if (w <= 0 || h <= 0)
+			return rendering::Surface::Handle();
+
+		swscale_context = sws_getCachedContext(
+			swscale_context,
+			w, h, (AVPixelFormat)src->format,
+			w, h, AV_PIX_FMT_RGBA,
+			SWS_POINT, nullptr, nullptr, nullptr );
+		if (!swscale_context) {
+			synfig::error("Importer_LibAVCodec: could not initialize the conversion context");
+			return rendering::Surface::Handle();
+		}
+
+		rendering::SurfaceSWPackedByte::Handle surface(new rendering::SurfaceSWPackedByte());
+		const int stride = w*4;
+		uint8_t *dst_data[4] = { surface->create_bytes(w, h), nullptr, nullptr, nullptr };
+		int dst_linesize[4] = { stride, 0, 0, 0 };
+		sws_scale(
+			swscale_context,
+			(const uint8_t * const *)src->data,
+			src->linesize,
+			0,
+			h,
+			dst_data,
+			dst_linesize );
+
+		// packed surface keeps colors premultiplied by alpha
+		const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)src->format);
+		if (desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA)) {
+			for(uint8_t *p = dst_data[0], *end = p + stride*h; p < end; p += 4) {
+				const unsigned int a = p[3];
+				if (a == 255) continue;
+				p[0] = (uint8_t)((p[0]*a + 127)/255);
+				p[1] = (uint8_t)((p[1]*a + 127)/255);
+				p[2] = (uint8_t)((p[2]*a + 127)/255);
+			}
+		}
+		return surface;
+	}
+
+public:
+	Internal():
+		format_context(),
+		codec_context(),
+		frame(),
+		prev_frame(),
+		packet(),
+		swscale_context(),
+		stream_index(-1),
+		time_base(),
+		start_pts(),
+		frame_duration(1),
+		position(AV_NOPTS_VALUE),
+		draining(),
+		cache_size()
+	{ }
+
+	~Internal()
+		{ close(); }
+
+	bool is_opened() const
+		{ return codec_context; }
+
+	bool open(const String &filename)
+	{
+		close();
+
+#if LIBAVCODEC_VERSION_MAJOR < 58 // FFMPEG < 4.0
+		static bool av_registered = false;
+		if (!av_registered) {
+			av_register_all();
+			av_registered = true;
+		}
+#endif
+
+		if (avformat_open_input(&format_context, filename.c_str(), nullptr, nullptr) < 0) {
+			synfig::error("Importer_LibAVCodec: could not open file: %s", filename.c_str());
+			close();
+			return false;
+		}
+		if (avformat_find_stream_info(format_context, nullptr) < 0) {
+			synfig::error("Importer_LibAVCodec: could not find stream information: %s", filename.c_str());
+			close();
+			return false;
+		}
+
+		stream_index = av_find_best_stream(format_context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+		if (stream_index < 0) {
+			synfig::error("Importer_LibAVCodec: video stream not found: %s", filename.c_str());
+			close();
+			return false;
+		}
+		AVStream *stream = format_context->streams[stream_index];
+
+		const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+		if (!codec) {
+			synfig::error("Importer_LibAVCodec: video codec not found: %s", filename.c_str());
+			close();
+			return false;
+		}
+
+		codec_context = avcodec_alloc_context3(codec);
+		if ( !codec_context
+		  || avcodec_parameters_to_context(codec_context, stream->codecpar) < 0
+		  || avcodec_open2(codec_context, codec, nullptr) < 0 )
+		{
+			synfig::error("Importer_LibAVCodec: could not open video codec: %s", filename.c_str());
+			close();
+			return false;
+		}
+
+		frame = av_frame_alloc();
+		prev_frame = av_frame_alloc();
+		packet = av_packet_alloc();
+		if (!frame || !prev_frame || !packet) {
+			synfig::error("Importer_LibAVCodec: could not allocate frame");
+			close();
+			return false;
+		}
+
+		time_base = stream->time_base;
+		start_pts = stream->start_time == AV_NOPTS_VALUE ? 0 : stream->start_time;
+
+		AVRational frame_rate = stream->avg_frame_rate;
+		if (frame_rate.num <= 0 || frame_rate.den <= 0)
+			frame_rate = stream->r_frame_rate;
+		if (frame_rate.num > 0 && frame_rate.den > 0)
+			frame_duration = av_rescale_q(1, av_inv_q(frame_rate), time_base);
+		frame_duration = std::max(frame_duration, (int64_t)1);
+
+		position = AV_NOPTS_VALUE;
+		draining = false;
+		return true;
+	}
+
+	void close()
+	{
+		cache.clear();
+		cache_size = 0;
+		if (swscale_context) {
+			sws_freeContext(swscale_context);
+			swscale_context = nullptr;
+		}
+		if (packet) av_packet_free(&packet);
+		if (frame) av_frame_free(&frame);
+		if (prev_frame) av_frame_free(&prev_frame);
+		if (codec_context) avcodec_free_context(&codec_context);
+		if (format_context) avformat_close_input(&format_context);
+		stream_index = -1;
+		position = AV_NOPTS_VALUE;
+		draining = false;
+	}
+
+	rendering::Surface::Handle get_frame(const Time &time)
+	{
+		const int64_t pts = time_to_pts(time);
+
+		if (rendering::Surface::Handle surface = find_cached(pts))
+			return surface;
+
+		// decode forward from the current position when the frame is close enough,
+		// otherwise jump to the keyframe before the requested time
+		if ( position == AV_NOPTS_VALUE
+		  || pts < position
+		  || pts - position > max_skip_frames*frame_duration )
+		{
+			if (!seek(pts))
+				return rendering::Surface::Handle();
+		}
+
+		AVFrame *found = nullptr;
+		while(true) {
+			// keep the previous frame for the times after the end of the stream
+			if (frame->data[0]) {
+				av_frame_unref(prev_frame);
+				av_frame_move_ref(prev_frame, frame);
+			}
+			if (!decode_frame())
+				break;
+			if (pts < position + frame_duration)
+				{ found = frame; break; }
+		}
+
+		// time is after the end of the stream, use the last frame
+		if (!found && prev_frame->data[0]) {
+			found = prev_frame;
+			position = prev_frame->best_effort_timestamp == AV_NOPTS_VALUE
+			         ? position : prev_frame->best_effort_timestamp;
+		}
+		if (!found)
+			return rendering::Surface::Handle();
+
+		rendering::Surface::Handle surface = convert_frame(found);
+		if (surface) {
+			cache.push_back(CacheEntry(position, surface));
+			cache_size += surface->get_memory_size();
+			while(cache_size > cache_max_size && cache.size() > 1) {
+				cache_size -= cache.front().surface->get_memory_size();
+				cache.pop_front();
+			}
+		}
+		return surface;
+	}
+};
+
+/* === M E T H O D S ======================================================= */
 
 Importer_LibAVCodec::Importer_LibAVCodec(const synfig::FileSystem::Identifier &identifier):
-	Importer(identifier)
+	Importer(identifier),
+	internal(new Internal())
 {
 }
 
 Importer_LibAVCodec::~Importer_LibAVCodec()
 {
+	delete internal;
+}
+
+bool
+Importer_LibAVCodec::is_animated()
+{
+	return true;
+}
+
+rendering::Surface::Handle
+Importer_LibAVCodec::get_frame(const RendDesc &/*renddesc*/, const Time &time)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!internal->is_opened() && !internal->open(identifier.filename.u8string()))
+		return rendering::Surface::Handle();
+
+	rendering::Surface::Handle surface = internal->get_frame(time);
+	if (!surface)
+		synfig::warning(_("Unable to get frame from \"%s\" [%s]"), identifier.filename.u8_str(), time.get_string().c_str());
+	return surface;
 }
 
 bool
-Importer_LibAVCodec::get_frame(Surface &/*surface*/, const RendDesc &/*renddesc*/, Time /*time*/, ProgressCallback */*callback*/)
+Importer_LibAVCodec::get_frame(Surface &surface, const RendDesc &renddesc, Time time, ProgressCallback */*callback*/)
 {
-	return false;
+	rendering::Surface::Handle frame = get_frame(renddesc, time);
+	if (!frame || !frame->is_exists())
+		return false;
+
+	surface.set_wh(frame->get_width(), frame->get_height());
+	return frame->get_pixels(surface[0]);
 }
+
+#endif
@@ -30,10 +30,11 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <mutex>
+
 #include <synfig/importer.h>
 #include <synfig/string.h>
 #include <synfig/time.h>
-#include <cstdio>
 
 /* === M A C R O S ========================================================= */
 
@@ -41,18 +42,28 @@
 
 /* === C L A S S E S & S T R U C T S ======================================= */
 
+//! Imports video files through libavformat/libavcodec.
+//! The decoder is kept open between frames, so sequential frames are decoded
+//! one after another, and other times are reached by seeking to the nearest
+//! keyframe. Recently decoded frames are kept packed to 8 bits per channel
+//! in a cache limited by memory size.
 class Importer_LibAVCodec : public synfig::Importer
 {
 SYNFIG_IMPORTER_MODULE_EXT
 
 private:
-	synfig::String filename;
+	class Internal;
+	Internal *internal;
+	std::mutex mutex;
 
 public:
-	Importer_LibAVCodec(const synfig::FileSystem::Identifier &identifier); 
+	Importer_LibAVCodec(const synfig::FileSystem::Identifier &identifier);
 	~Importer_LibAVCodec();
 
-	virtual bool get_frame(synfig::Surface &surface, const synfig::RendDesc &renddesc, synfig::Time time, synfig::ProgressCallback *callback);
+	bool is_animated() override;
+
+	bool get_frame(synfig::Surface &surface, const synfig::RendDesc &renddesc, synfig::Time time, synfig::ProgressCallback *callback) override;
+	synfig::rendering::Surface::Handle get_frame(const synfig::RendDesc &renddesc, const synfig::Time &time) override;
 };
 
 /* === E N D =============================================================== */
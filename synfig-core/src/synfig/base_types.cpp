@@ -148,10 +148,8 @@ public:
 		mutable Time t;
 		Real r;
 		Inner(): f(0.f), t(0.0), r(0.0) { }
-		Inner(const Inner& other) { r = other.r; }
 
 		bool operator== (const Inner &other) const { return r == other.r; }
-		Inner& operator= (const Inner &other) { return *this = other.r; }
 
 		Inner& operator= (const Real &other) { r = other; return *this; }
 		operator const Real&() const { return r; }
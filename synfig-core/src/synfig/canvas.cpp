@@ -488,6 +488,8 @@ Canvas::set_time(Time t)const
 		const_cast<Canvas&>(*this).cur_time_=t;
 
 		is_dirty_=false;
+		// shared value nodes are evaluated once for all the layers
+		ValueNode::EvaluationScope evaluation_scope;
 		get_independent_context().set_time(t);
 	}
 	is_dirty_=false;
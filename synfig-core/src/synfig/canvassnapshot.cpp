@@ -0,0 +1,153 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvassnapshot.cpp
+**	\brief Read-only evaluation of a Canvas at a fixed time
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "canvassnapshot.h"
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
+
+#include "layer.h"
+#include "valuenodes/valuenode_const.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+Canvas::Handle
+CanvasSnapshot::copy_canvas(const Canvas &source, Time time, CanvasMap &copies)
+{
+	Canvas::ConstHandle key(&source);
+	CanvasMap::const_iterator i = copies.find(key);
+	if (i != copies.end())
+		return i->second;
+
+	// the copy is always a root canvas, it must not be
+	// registered anywhere and must not share layers with source
+	Canvas::Handle canvas = Canvas::create();
+	copies[key] = canvas;
+
+	canvas->rend_desc() = source.rend_desc();
+	canvas->set_identifier(source.get_identifier());
+	canvas->set_file_name(source.get_file_name());
+	copy_layers(source, canvas, time, copies);
+	return canvas;
+}
+
+void
+CanvasSnapshot::copy_layers(const Canvas &source, const Canvas::Handle &dest, Time time, CanvasMap &copies)
+{
+	for(Canvas::const_iterator i = source.begin(); i != source.end(); ++i)
+	{
+		Layer::Handle layer = (*i)->clone(dest, GUID());
+		if (!layer)
+		{
+			synfig::error("CanvasSnapshot: unable to copy layer '%s'", (*i)->get_name().c_str());
+			continue;
+		}
+		detach_layer(layer, time, copies);
+		dest->push_back(layer);
+	}
+}
+
+void
+CanvasSnapshot::detach_layer(const Layer::Handle &layer, Time time, CanvasMap &copies)
+{
+	// Layer::clone() already duplicates inline canvases,
+	// but exported and external canvases are still shared with the source,
+	// so replace them by copies too
+	const Layer::DynamicParamList &dynamic_params = layer->dynamic_param_list();
+	Layer::ParamList params = layer->get_param_list();
+	for(Layer::ParamList::const_iterator i = params.begin(); i != params.end(); ++i)
+	{
+		if (i->second.get_type() != type_canvas)
+			continue;
+
+		Layer::DynamicParamList::const_iterator dynamic = dynamic_params.find(i->first);
+		Canvas::Handle sub_canvas = dynamic == dynamic_params.end()
+		                          ? i->second.get(Canvas::Handle())
+		                          : (*dynamic->second)(time).get(Canvas::Handle());
+		if (!sub_canvas)
+			continue;
+
+		if (sub_canvas->is_inline())
+		{
+			// inline canvas was cloned with layer, check its layers
+			for(Canvas::iterator j = sub_canvas->begin(); j != sub_canvas->end(); ++j)
+				detach_layer(*j, time, copies);
+			continue;
+		}
+
+		ValueBase value(copy_canvas(*sub_canvas, time, copies));
+		if (dynamic != dynamic_params.end())
+		{
+			// the snapshot is evaluated for the single time only,
+			// so animated canvas parameter may be safely frozen
+			layer->disconnect_dynamic_param(i->first);
+			layer->connect_dynamic_param(i->first, ValueNode_Const::create(value));
+		}
+		else
+		{
+			layer->set_param(i->first, value);
+		}
+	}
+}
+
+CanvasSnapshot::Handle
+CanvasSnapshot::create(
+	const Canvas &source,
+	Time time,
+	const ContextParams &context_params,
+	Real outline_grow )
+{
+	Handle snapshot(new CanvasSnapshot());
+	snapshot->time = time;
+
+	CanvasMap copies;
+	snapshot->canvas = copy_canvas(source, time, copies);
+	snapshot->canvas->set_time(time);
+	snapshot->canvas->load_resources(time);
+	snapshot->canvas->set_outline_grow(outline_grow);
+	snapshot->task = snapshot->canvas->build_rendering_task(context_params);
+	return snapshot;
+}
+
+/* === E N T R Y P O I N T ================================================= */
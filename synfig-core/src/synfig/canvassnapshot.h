@@ -0,0 +1,107 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvassnapshot.h
+**	\brief Read-only evaluation of a Canvas at a fixed time
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_CANVASSNAPSHOT_H
+#define __SYNFIG_CANVASSNAPSHOT_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <map>
+
+#include <ETL/handle>
+
+#include "canvas.h"
+#include "context.h"
+#include "time.h"
+#include "rendering/task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class CanvasSnapshot
+**	\brief State of a Canvas evaluated at a fixed time.
+**
+**	The snapshot owns a private copy of the layers of the source canvas
+**	(including inline and exported sub-canvases), so the time is set on
+**	that copy and the live layers are never touched.
+**	Several snapshots of the same canvas may be created on different threads
+**	and rendered side by side.
+**
+**	Value nodes which are exported from the source canvas are shared with
+**	the snapshot, they are only evaluated and never modified.
+**	The source canvas must not be edited while a snapshot is being created.
+*/
+class CanvasSnapshot: public etl::shared_object
+{
+public:
+	typedef etl::handle<CanvasSnapshot> Handle;
+
+private:
+	typedef std::map<Canvas::ConstHandle, Canvas::Handle> CanvasMap;
+
+	Canvas::Handle canvas;
+	Time time;
+	rendering::Task::Handle task;
+
+	CanvasSnapshot() { }
+
+	static Canvas::Handle copy_canvas(const Canvas &source, Time time, CanvasMap &copies);
+	static void copy_layers(const Canvas &source, const Canvas::Handle &dest, Time time, CanvasMap &copies);
+	static void detach_layer(const Layer::Handle &layer, Time time, CanvasMap &copies);
+
+public:
+	//! Evaluates \a source at \a time and builds its rendering task
+	static Handle create(
+		const Canvas &source,
+		Time time,
+		const ContextParams &context_params = ContextParams(),
+		Real outline_grow = 0.0 );
+
+	//! Returns the time of the snapshot
+	Time get_time() const { return time; }
+
+	//! Returns the evaluated layers, they should be treated as read-only
+	Canvas::ConstHandle get_canvas() const { return canvas; }
+
+	//! Returns the rendering task built for the snapshot.
+	/*! Every call returns a new copy of the task tree,
+	**	so it may be passed to the renderer without any extra care.
+	*/
+	rendering::Task::Handle get_task() const
+		{ return task ? task->clone_recursive() : rendering::Task::Handle(); }
+};
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -324,6 +324,10 @@ public:
 	/* Other */
 	static Color blend(Color a, Color b, float amount, BlendMethod type=BLEND_COMPOSITE);
 
+	//! Blends \a count pixels of \a src onto \a dest,
+	//! same as dest[i] = blend(src[i], dest[i], amount, type) but uses SIMD when available
+	static void blend_row(Color *dest, const Color *src, int count, float amount, BlendMethod type=BLEND_COMPOSITE);
+
 	static bool is_onto(BlendMethod x)
 		{ return BLEND_METHODS_ONTO & (1 << x); }
 
@@ -0,0 +1,143 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/color/colorblendingrow.cpp
+**	\brief Vectorized blending of pixel rows, SSE2 version and dispatching
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cassert>
+#include <cmath>
+
+#endif
+
+#include "colorblendingrow.h"
+
+#ifdef SYNFIG_BLENDROW_SSE2
+#include <emmintrin.h>
+#include "colorblendingrow.hpp"
+#endif
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+#ifdef SYNFIG_BLENDROW_SSE2
+
+class F4 {
+public:
+	enum { size = 4 };
+	__m128 v;
+	F4() { }
+	F4(__m128 v): v(v) { }
+	explicit F4(float x): v(_mm_set1_ps(x)) { }
+};
+
+inline F4 operator+(const F4 &a, const F4 &b) { return _mm_add_ps(a.v, b.v); }
+inline F4 operator-(const F4 &a, const F4 &b) { return _mm_sub_ps(a.v, b.v); }
+inline F4 operator*(const F4 &a, const F4 &b) { return _mm_mul_ps(a.v, b.v); }
+inline F4 operator/(const F4 &a, const F4 &b) { return _mm_div_ps(a.v, b.v); }
+inline F4 operator<(const F4 &a, const F4 &b) { return _mm_cmplt_ps(a.v, b.v); }
+inline F4 operator==(const F4 &a, const F4 &b) { return _mm_cmpeq_ps(a.v, b.v); }
+
+inline F4 select(const F4 &mask, const F4 &a, const F4 &b)
+	{ return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline F4 vmin(const F4 &a, const F4 &b) { return _mm_min_ps(a.v, b.v); }
+inline F4 vmax(const F4 &a, const F4 &b) { return _mm_max_ps(a.v, b.v); }
+inline F4 vabs(const F4 &a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v); }
+inline F4 vsqrt(const F4 &a) { return _mm_sqrt_ps(a.v); }
+inline F4 vcopysign(const F4 &a, const F4 &b) {
+	const __m128 sign = _mm_set1_ps(-0.f);
+	return _mm_or_ps(_mm_andnot_ps(sign, a.v), _mm_and_ps(sign, b.v));
+}
+
+inline void load(const float *p, blendrow::Pixels<F4> &c)
+{
+	__m128 r = _mm_loadu_ps(p), g = _mm_loadu_ps(p + 4), b = _mm_loadu_ps(p + 8), a = _mm_loadu_ps(p + 12);
+	_MM_TRANSPOSE4_PS(r, g, b, a);
+	c.r = r; c.g = g; c.b = b; c.a = a;
+}
+
+inline void store(float *p, const blendrow::Pixels<F4> &c)
+{
+	__m128 p0 = c.r.v, p1 = c.g.v, p2 = c.b.v, p3 = c.a.v;
+	_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+	_mm_storeu_ps(p, p0); _mm_storeu_ps(p + 4, p1); _mm_storeu_ps(p + 8, p2); _mm_storeu_ps(p + 12, p3);
+}
+
+void
+blend_row_sse2(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type)
+	{ blendrow::blend_row<F4>(dest, src, count, amount, type); }
+
+#endif // SYNFIG_BLENDROW_SSE2
+
+void
+blend_row_scalar(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type)
+{
+	for(Color *end = dest + count; dest < end; ++dest, ++src)
+		*dest = Color::blend(*src, *dest, amount, type);
+}
+
+blendrow::RowFunc
+choose_row_func()
+{
+	// with vImage Color::alpha() is not zero, and kernels do not know about it
+#ifndef HAS_VIMAGE
+#ifdef SYNFIG_BLENDROW_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return blendrow::blend_row_avx2;
+#endif
+#ifdef SYNFIG_BLENDROW_SSE2
+	return blend_row_sse2;
+#endif
+#endif
+	return blend_row_scalar;
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+void
+Color::blend_row(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type)
+{
+	// see Color::blend()
+	if (count <= 0 || fabsf(amount) <= COLOR_EPSILON) return;
+	assert(type < BLEND_END);
+
+	static const blendrow::RowFunc func = choose_row_func();
+	func(dest, src, count, amount, type);
+}
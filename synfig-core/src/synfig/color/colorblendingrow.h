@@ -0,0 +1,56 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/color/colorblendingrow.h
+**	\brief Vectorized blending of pixel rows, see Color::blend_row()
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifndef __SYNFIG_COLOR_COLORBLENDINGROW_H
+#define __SYNFIG_COLOR_COLORBLENDINGROW_H
+
+#include <synfig/color/color.h>
+#include <synfig/color/colorblendingfunctions.h>
+
+// SSE2 is a part of the base instruction set on x86-64,
+// AVX2 is compiled separately and selected at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SYNFIG_BLENDROW_SSE2
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SYNFIG_BLENDROW_AVX2
+#endif
+
+namespace synfig {
+namespace blendrow {
+
+//! Blends \a count pixels of \a src onto \a dest, see Color::blend_row()
+typedef void (*RowFunc)(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type);
+
+#ifdef SYNFIG_BLENDROW_AVX2
+//! AVX2 implementation, call it only when CPU supports AVX2
+void blend_row_avx2(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type);
+#endif
+
+} // blendrow namespace
+} // synfig namespace
+
+#endif // __SYNFIG_COLOR_COLORBLENDINGROW_H
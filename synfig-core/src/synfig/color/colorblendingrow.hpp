@@ -0,0 +1,525 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/color/colorblendingrow.hpp
+**	\brief Row blending kernels, vectorized copy of colorblendingfunctions.h
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+// Kernels are templates over the vector type T, which is defined in
+// the translation unit compiled for the specific instruction set.
+// T should be constructible from float, provide arithmetic operators,
+// operator< and operator== returning a lane mask and the functions
+// select(mask, a, b), vmin(), vmax(), vabs(), vsqrt(), vcopysign(),
+// load() and store() for Pixels<T>. Every kernel repeats the order of
+// operations of its scalar counterpart in colorblendingfunctions.h.
+//
+// This file is included after the target instruction set is enabled,
+// so it should not include anything that is not included already.
+
+#ifndef __SYNFIG_COLOR_COLORBLENDINGROW_HPP
+#define __SYNFIG_COLOR_COLORBLENDINGROW_HPP
+
+#include "colorblendingrow.h"
+
+namespace synfig {
+namespace blendrow {
+
+//! Channels of T::size pixels
+template<typename T>
+struct Pixels { T r, g, b, a; };
+
+template<typename T>
+inline T get_y(const Pixels<T> &c)
+	{ return c.r*T(EncodeYUV[0][0]) + c.g*T(EncodeYUV[0][1]) + c.b*T(EncodeYUV[0][2]); }
+
+template<typename T>
+inline T get_u(const Pixels<T> &c)
+	{ return c.r*T(EncodeYUV[1][0]) + c.g*T(EncodeYUV[1][1]) + c.b*T(EncodeYUV[1][2]); }
+
+template<typename T>
+inline T get_v(const Pixels<T> &c)
+	{ return c.r*T(EncodeYUV[2][0]) + c.g*T(EncodeYUV[2][1]) + c.b*T(EncodeYUV[2][2]); }
+
+template<typename T>
+inline void set_yuv(Pixels<T> &c, const T &y, const T &u, const T &v)
+{
+	c.r = y*T(DecodeYUV[0][0]) + u*T(DecodeYUV[0][1]) + v*T(DecodeYUV[0][2]);
+	c.g = y*T(DecodeYUV[1][0]) + u*T(DecodeYUV[1][1]) + v*T(DecodeYUV[1][2]);
+	c.b = y*T(DecodeYUV[2][0]) + u*T(DecodeYUV[2][1]) + v*T(DecodeYUV[2][2]);
+}
+
+template<typename T>
+inline Pixels<T> select(const T &mask, const Pixels<T> &a, const Pixels<T> &b)
+{
+	Pixels<T> c;
+	c.r = select(mask, a.r, b.r);
+	c.g = select(mask, a.g, b.g);
+	c.b = select(mask, a.b, b.b);
+	c.a = select(mask, a.a, b.a);
+	return c;
+}
+
+//! (temp - b)*amount*a + b, used by the YUV-based methods
+template<typename T>
+inline Pixels<T> mix(const Pixels<T> &temp, const Pixels<T> &b, const T &amount, const T &a)
+{
+	Pixels<T> c;
+	c.r = (temp.r - b.r)*amount*a + b.r;
+	c.g = (temp.g - b.g)*amount*a + b.g;
+	c.b = (temp.b - b.b)*amount*a + b.b;
+	c.a = (temp.a - b.a)*amount*a + b.a;
+	return c;
+}
+
+template<typename T>
+inline Pixels<T> composite(const Pixels<T> &src, const Pixels<T> &dest, const T &amount)
+{
+	const T one(1.f), zero(0.f);
+	const T a_src = src.a*amount;
+	const T a_dest = dest.a;
+	const T k = one - a_src;
+	const T a_out = a_src + a_dest*k;
+	const T mask = T(COLOR_EPSILON) < vabs(a_out);
+	const T inv = one/a_out;
+
+	Pixels<T> c;
+	c.r = select(mask, (src.r*a_src + dest.r*a_dest*k)*inv, zero);
+	c.g = select(mask, (src.g*a_src + dest.g*a_dest*k)*inv, zero);
+	c.b = select(mask, (src.b*a_src + dest.b*a_dest*k)*inv, zero);
+	c.a = select(mask, a_out, zero);
+	return c;
+}
+
+template<typename T>
+inline Pixels<T> straight(const Pixels<T> &src, const Pixels<T> &bg, const T &amount)
+{
+	const T one(1.f), zero(0.f);
+	const T a_out = (src.a - bg.a)*amount + bg.a;
+	const T mask = T(COLOR_EPSILON) < vabs(a_out);
+	const T inv = one/a_out;
+
+	Pixels<T> c;
+	c.r = select(mask, ((src.r*src.a - bg.r*bg.a)*amount + bg.r*bg.a)*inv, zero);
+	c.g = select(mask, ((src.g*src.a - bg.g*bg.a)*amount + bg.g*bg.a)*inv, zero);
+	c.b = select(mask, ((src.b*src.a - bg.b*bg.a)*amount + bg.b*bg.a)*inv, zero);
+	c.a = select(mask, a_out, zero);
+	return c;
+}
+
+template<typename T>
+inline Pixels<T> onto(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+{
+	Pixels<T> solid(b);
+	solid.a = T(1.f);
+	Pixels<T> c = composite(a, solid, amount);
+	c.a = b.a;
+	return c;
+}
+
+struct BlendComposite {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+		{ return composite(a, b, amount); }
+};
+
+struct BlendStraight {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+		{ return straight(a, b, amount); }
+};
+
+struct BlendOnto {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+		{ return onto(a, b, amount); }
+};
+
+struct BlendStraightOnto {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> c(a);
+		c.a = a.a*b.a;
+		return straight(c, b, amount);
+	}
+};
+
+struct BlendBrighten {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T alpha = a.a*amount;
+		Pixels<T> c(b);
+		c.r = vmax(a.r*alpha, b.r);
+		c.g = vmax(a.g*alpha, b.g);
+		c.b = vmax(a.b*alpha, b.b);
+		return c;
+	}
+};
+
+struct BlendDarken {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T one(1.f);
+		const T alpha = a.a*amount;
+		Pixels<T> c(b);
+		c.r = vmin((a.r - one)*alpha + one, b.r);
+		c.g = vmin((a.g - one)*alpha + one, b.g);
+		c.b = vmin((a.b - one)*alpha + one, b.b);
+		return c;
+	}
+};
+
+struct BlendAdd {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T aa = a.a*amount;
+		Pixels<T> c(b);
+		c.r = b.r*b.a + a.r*aa;
+		c.g = b.g*b.a + a.g*aa;
+		c.b = b.b*b.a + a.b*aa;
+		return c;
+	}
+};
+
+struct BlendAddComposite {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T one(1.f), zero(0.f);
+		T ba = b.a;
+		T aa = a.a*amount;
+		const T sum = ba + aa;
+		const T alpha = select(zero < sum, select(sum < one, sum, one), zero);
+		const T k = select(T(1e-8f) < vabs(alpha), one/alpha, zero);
+		aa = aa*k;
+		ba = ba*k;
+
+		Pixels<T> c;
+		c.r = b.r*ba + a.r*aa;
+		c.g = b.g*ba + a.g*aa;
+		c.b = b.b*ba + a.b*aa;
+		c.a = alpha;
+		return c;
+	}
+};
+
+struct BlendSubtract {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T aa = a.a*amount;
+		Pixels<T> c(b);
+		c.r = b.r*b.a - a.r*aa;
+		c.g = b.g*b.a - a.g*aa;
+		c.b = b.b*b.a - a.b*aa;
+		return c;
+	}
+};
+
+struct BlendDifference {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T aa = a.a*amount;
+		Pixels<T> c(b);
+		c.r = vabs(b.r*b.a - a.r*aa);
+		c.g = vabs(b.g*b.a - a.g*aa);
+		c.b = vabs(b.b*b.a - a.b*aa);
+		return c;
+	}
+};
+
+struct BlendMultiply {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T k = amount*a.a;
+		Pixels<T> c(b);
+		c.r = (b.r*a.r - b.r)*k + b.r;
+		c.g = (b.g*a.g - b.g)*k + b.g;
+		c.b = (b.b*a.b - b.b)*k + b.b;
+		return c;
+	}
+};
+
+struct BlendDivide {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T e(COLOR_EPSILON);
+		const T k = amount*a.a;
+		Pixels<T> c(b);
+		c.r = (b.r/(a.r + e) - b.r)*k + b.r;
+		c.g = (b.g/(a.g + e) - b.g)*k + b.g;
+		c.b = (b.b/(a.b + e) - b.b)*k + b.b;
+		return c;
+	}
+};
+
+struct BlendColor {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> temp(b);
+		set_yuv(temp, get_y(b), get_u(a), get_v(a));
+		return mix(temp, b, amount, a.a);
+	}
+};
+
+struct BlendHue {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T zero(0.f);
+
+		// sin and cos of atan2(u, v) without trigonometry,
+		// atan2(+-0, +-0) gives an angle of 0 or pi depending on the sign of v
+		const T ua = get_u(a), va = get_v(a);
+		const T ra = vsqrt(ua*ua + va*va);
+		const T mask = zero < ra;
+		const T sin = select(mask, ua/ra, zero);
+		const T cos = select(mask, va/ra, vcopysign(T(1.f), va));
+
+		const T ub = get_u(b), vb = get_v(b);
+		const T s = vsqrt(ub*ub + vb*vb);
+
+		Pixels<T> temp(b);
+		set_yuv(temp, get_y(b), s*sin, s*cos);
+		return mix(temp, b, amount, a.a);
+	}
+};
+
+struct BlendSaturation {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T ua = get_u(a), va = get_v(a);
+		const T x = vsqrt(ua*ua + va*va);
+
+		const T ub = get_u(b), vb = get_v(b);
+		const T s = vsqrt(ub*ub + vb*vb);
+
+		Pixels<T> temp(b);
+		set_yuv(temp, get_y(b), (ub/s)*x, (vb/s)*x);
+		return mix(select(T(0.f) < s, temp, b), b, amount, a.a);
+	}
+};
+
+struct BlendLuminance {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> temp(b);
+		set_yuv(temp, get_y(a), get_u(b), get_v(b));
+		return mix(temp, b, amount, a.a);
+	}
+};
+
+struct BlendBehind {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> c(a);
+		c.a = select(a.a == T(0.f), T(COLOR_EPSILON)*amount, a.a*amount);
+		return composite(b, c, T(1.f));
+	}
+};
+
+struct BlendAlphaBrighten {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> c(a);
+		c.a = a.a*amount;
+		return select(a.a < b.a*amount, c, b);
+	}
+};
+
+struct BlendAlphaDarken {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> c(a);
+		c.a = a.a*amount;
+		return select(b.a < c.a, c, b);
+	}
+};
+
+struct BlendScreen {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		const T one(1.f);
+		Pixels<T> c(a);
+		c.r = one - (one - a.r)*(one - b.r);
+		c.g = one - (one - a.g)*(one - b.g);
+		c.b = one - (one - a.b)*(one - b.b);
+		return onto(c, b, amount);
+	}
+};
+
+struct BlendOverlay {
+	template<typename T>
+	static T channel(const T &a, const T &b)
+	{
+		const T one(1.f);
+		const T rm = b*a;
+		const T rs = one - (one - a)*(one - b);
+		return a*rs + (one - a)*rm;
+	}
+
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> c(a);
+		c.r = channel(a.r, b.r);
+		c.g = channel(a.g, b.g);
+		c.b = channel(a.b, b.b);
+		return onto(c, b, amount);
+	}
+};
+
+struct BlendHardLight {
+	template<typename T>
+	static T channel(const T &a, const T &b)
+	{
+		const T one(1.f), two(2.f);
+		return select( T(0.5f) < a,
+			one - (one - (a*two - one))*(one - b),
+			b*(a*two) );
+	}
+
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> c(a);
+		c.r = channel(a.r, b.r);
+		c.g = channel(a.g, b.g);
+		c.b = channel(a.b, b.b);
+		return onto(c, b, amount);
+	}
+};
+
+struct BlendAlpha {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> rm(b);
+		rm.a = a.a*b.a;
+		return straight(rm, b, amount);
+	}
+};
+
+struct BlendAlphaOver {
+	template<typename T>
+	static Pixels<T> blend(const Pixels<T> &a, const Pixels<T> &b, const T &amount)
+	{
+		Pixels<T> rm(b);
+		rm.a = (T(1.f) - a.a)*b.a;
+		return straight(rm, b, amount);
+	}
+};
+
+//! Blends the row by groups of T::size pixels, the tail goes through a padded buffer
+template<typename T, typename Method>
+void blend_row(Color *dest, const Color *src, int count, float amount, bool invert)
+{
+	const T k(amount);
+	float *d = reinterpret_cast<float*>(dest);
+	const float *s = reinterpret_cast<const float*>(src);
+
+	Pixels<T> a, b;
+	for(; count >= T::size; count -= T::size, d += 4*T::size, s += 4*T::size) {
+		load(s, a);
+		load(d, b);
+		if (invert) {
+			const T one(1.f);
+			a.r = one - a.r; a.g = one - a.g; a.b = one - a.b;
+		}
+		store(d, Method::blend(a, b, k));
+	}
+
+	if (count > 0) {
+		float ts[4*T::size] = { }, td[4*T::size] = { };
+		std::copy(s, s + 4*count, ts);
+		std::copy(d, d + 4*count, td);
+		load(ts, a);
+		load(td, b);
+		if (invert) {
+			const T one(1.f);
+			a.r = one - a.r; a.g = one - a.g; a.b = one - a.b;
+		}
+		store(td, Method::blend(a, b, k));
+		std::copy(td, td + 4*count, d);
+	}
+}
+
+//! Selects kernel by blend method, should be called with non-zero \a amount
+template<typename T>
+void blend_row(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type)
+{
+	// methods which invert the color of the source for negative amount
+	const bool invert = amount < 0.f
+	                 && ( type == Color::BLEND_MULTIPLY
+	                   || type == Color::BLEND_SCREEN
+	                   || type == Color::BLEND_OVERLAY
+	                   || type == Color::BLEND_HARD_LIGHT );
+	if (invert) amount = -amount;
+
+	switch(type) {
+	case Color::BLEND_COMPOSITE:      blend_row<T, BlendComposite    >(dest, src, count, amount, invert); break;
+	case Color::BLEND_STRAIGHT:       blend_row<T, BlendStraight     >(dest, src, count, amount, invert); break;
+	case Color::BLEND_ONTO:           blend_row<T, BlendOnto         >(dest, src, count, amount, invert); break;
+	case Color::BLEND_STRAIGHT_ONTO:  blend_row<T, BlendStraightOnto >(dest, src, count, amount, invert); break;
+	case Color::BLEND_BEHIND:         blend_row<T, BlendBehind       >(dest, src, count, amount, invert); break;
+	case Color::BLEND_SCREEN:         blend_row<T, BlendScreen       >(dest, src, count, amount, invert); break;
+	case Color::BLEND_OVERLAY:        blend_row<T, BlendOverlay      >(dest, src, count, amount, invert); break;
+	case Color::BLEND_HARD_LIGHT:     blend_row<T, BlendHardLight    >(dest, src, count, amount, invert); break;
+	case Color::BLEND_MULTIPLY:       blend_row<T, BlendMultiply     >(dest, src, count, amount, invert); break;
+	case Color::BLEND_DIVIDE:         blend_row<T, BlendDivide       >(dest, src, count, amount, invert); break;
+	case Color::BLEND_ADD:            blend_row<T, BlendAdd          >(dest, src, count, amount, invert); break;
+	case Color::BLEND_SUBTRACT:       blend_row<T, BlendSubtract     >(dest, src, count, amount, invert); break;
+	case Color::BLEND_DIFFERENCE:     blend_row<T, BlendDifference   >(dest, src, count, amount, invert); break;
+	case Color::BLEND_BRIGHTEN:       blend_row<T, BlendBrighten     >(dest, src, count, amount, invert); break;
+	case Color::BLEND_DARKEN:         blend_row<T, BlendDarken       >(dest, src, count, amount, invert); break;
+	case Color::BLEND_COLOR:          blend_row<T, BlendColor        >(dest, src, count, amount, invert); break;
+	case Color::BLEND_HUE:            blend_row<T, BlendHue          >(dest, src, count, amount, invert); break;
+	case Color::BLEND_SATURATION:     blend_row<T, BlendSaturation   >(dest, src, count, amount, invert); break;
+	case Color::BLEND_LUMINANCE:      blend_row<T, BlendLuminance    >(dest, src, count, amount, invert); break;
+	case Color::BLEND_ALPHA_OVER:     blend_row<T, BlendAlphaOver    >(dest, src, count, amount, invert); break;
+	case Color::BLEND_ALPHA_BRIGHTEN: blend_row<T, BlendAlphaBrighten>(dest, src, count, amount, invert); break;
+	case Color::BLEND_ALPHA_DARKEN:   blend_row<T, BlendAlphaDarken  >(dest, src, count, amount, invert); break;
+	case Color::BLEND_ADD_COMPOSITE:  blend_row<T, BlendAddComposite >(dest, src, count, amount, invert); break;
+	case Color::BLEND_ALPHA:          blend_row<T, BlendAlpha        >(dest, src, count, amount, invert); break;
+	default:
+		for(Color *end = dest + count; dest < end; ++dest, ++src)
+			*dest = Color::blend(*src, *dest, amount, type);
+		break;
+	}
+}
+
+} // blendrow namespace
+} // synfig namespace
+
+#endif // __SYNFIG_COLOR_COLORBLENDINGROW_HPP
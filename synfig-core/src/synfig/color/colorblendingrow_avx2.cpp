@@ -0,0 +1,137 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/color/colorblendingrow_avx2.cpp
+**	\brief Vectorized blending of pixel rows, AVX2 version
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#endif
+
+#include "colorblendingrow.h"
+
+#ifdef SYNFIG_BLENDROW_AVX2
+
+#include <immintrin.h>
+
+// Only the code below is compiled for AVX2, it is called
+// from Color::blend_row() after the check of CPU features.
+// FMA is not enabled to keep results equal to the scalar code.
+#ifdef __clang__
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "colorblendingrow.hpp"
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+class F8 {
+public:
+	enum { size = 8 };
+	__m256 v;
+	F8() { }
+	F8(__m256 v): v(v) { }
+	explicit F8(float x): v(_mm256_set1_ps(x)) { }
+};
+
+inline F8 operator+(const F8 &a, const F8 &b) { return _mm256_add_ps(a.v, b.v); }
+inline F8 operator-(const F8 &a, const F8 &b) { return _mm256_sub_ps(a.v, b.v); }
+inline F8 operator*(const F8 &a, const F8 &b) { return _mm256_mul_ps(a.v, b.v); }
+inline F8 operator/(const F8 &a, const F8 &b) { return _mm256_div_ps(a.v, b.v); }
+inline F8 operator<(const F8 &a, const F8 &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline F8 operator==(const F8 &a, const F8 &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+
+inline F8 select(const F8 &mask, const F8 &a, const F8 &b)
+	{ return _mm256_blendv_ps(b.v, a.v, mask.v); }
+inline F8 vmin(const F8 &a, const F8 &b) { return _mm256_min_ps(a.v, b.v); }
+inline F8 vmax(const F8 &a, const F8 &b) { return _mm256_max_ps(a.v, b.v); }
+inline F8 vabs(const F8 &a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v); }
+inline F8 vsqrt(const F8 &a) { return _mm256_sqrt_ps(a.v); }
+inline F8 vcopysign(const F8 &a, const F8 &b) {
+	const __m256 sign = _mm256_set1_ps(-0.f);
+	return _mm256_or_ps(_mm256_andnot_ps(sign, a.v), _mm256_and_ps(sign, b.v));
+}
+
+// every 128-bit lane is transposed separately, so channels contain
+// pixels in order 0, 2, 4, 6, 1, 3, 5, 7, and store() restores the order
+
+inline void load(const float *p, blendrow::Pixels<F8> &c)
+{
+	const __m256 m0 = _mm256_loadu_ps(p);
+	const __m256 m1 = _mm256_loadu_ps(p + 8);
+	const __m256 m2 = _mm256_loadu_ps(p + 16);
+	const __m256 m3 = _mm256_loadu_ps(p + 24);
+	const __m256 t0 = _mm256_unpacklo_ps(m0, m1);
+	const __m256 t1 = _mm256_unpackhi_ps(m0, m1);
+	const __m256 t2 = _mm256_unpacklo_ps(m2, m3);
+	const __m256 t3 = _mm256_unpackhi_ps(m2, m3);
+	c.r = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	c.g = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	c.b = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	c.a = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+inline void store(float *p, const blendrow::Pixels<F8> &c)
+{
+	const __m256 t0 = _mm256_unpacklo_ps(c.r.v, c.g.v);
+	const __m256 t1 = _mm256_unpackhi_ps(c.r.v, c.g.v);
+	const __m256 t2 = _mm256_unpacklo_ps(c.b.v, c.a.v);
+	const __m256 t3 = _mm256_unpackhi_ps(c.b.v, c.a.v);
+	_mm256_storeu_ps(p,      _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)));
+	_mm256_storeu_ps(p + 8,  _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)));
+	_mm256_storeu_ps(p + 16, _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)));
+	_mm256_storeu_ps(p + 24, _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+void
+blendrow::blend_row_avx2(Color *dest, const Color *src, int count, float amount, Color::BlendMethod type)
+	{ blend_row<F8>(dest, src, count, amount, type); }
+
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // SYNFIG_BLENDROW_AVX2
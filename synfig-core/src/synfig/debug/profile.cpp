@@ -0,0 +1,254 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file profile.cpp
+**	\brief Recording of rendering timings in Chrome trace event format
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+#include <synfig/general.h>
+
+#include "profile.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+using namespace debug;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+namespace {
+
+struct Event {
+	const char *category;
+	String name;
+	Profile::Time begin;
+	Profile::Time duration;
+	Profile::Time cpu_begin;
+	Profile::Time cpu_duration; //!< negative when unknown
+	String args;
+};
+
+//! Events of one thread, the mutex is locked by the owner thread
+//! for each event, so it is almost never contended
+struct ThreadEvents {
+	std::mutex mutex;
+	int thread;
+	std::vector<Event> events;
+	explicit ThreadEvents(int thread): thread(thread) { }
+};
+
+typedef std::shared_ptr<ThreadEvents> ThreadEventsHandle;
+
+std::mutex threads_mutex;
+std::vector<ThreadEventsHandle> threads;
+std::atomic<long long> origin(0);
+
+thread_local ThreadEventsHandle current_thread_events;
+
+ThreadEvents&
+get_thread_events()
+{
+	if (!current_thread_events) {
+		std::lock_guard<std::mutex> lock(threads_mutex);
+		current_thread_events = std::make_shared<ThreadEvents>((int)threads.size() + 1);
+		threads.push_back(current_thread_events);
+	}
+	return *current_thread_events;
+}
+
+void
+add_event(Event &&event)
+{
+	ThreadEvents &thread_events = get_thread_events();
+	std::lock_guard<std::mutex> lock(thread_events.mutex);
+	thread_events.events.push_back(std::move(event));
+}
+
+long long
+steady_time_us()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+} // end of anonymous namespace
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+std::atomic<bool> Profile::enabled(false);
+
+void
+Profile::Scope::init()
+{
+	begin = now();
+	cpu_begin = thread_cpu_time();
+}
+
+void
+Profile::Scope::finish()
+{
+	const Time cpu_end = thread_cpu_time();
+	const Time end = now();
+	add_event(Event{
+		category,
+		dynamic_name.empty() ? String(name) : std::move(dynamic_name),
+		begin,
+		end - begin,
+		cpu_begin,
+		cpu_end - cpu_begin,
+		std::move(args) });
+}
+
+void
+Profile::start()
+{
+	enabled = false;
+	{
+		std::lock_guard<std::mutex> lock(threads_mutex);
+		for(const ThreadEventsHandle &t : threads) {
+			std::lock_guard<std::mutex> thread_lock(t->mutex);
+			t->events.clear();
+		}
+	}
+	origin = steady_time_us();
+	enabled = true;
+}
+
+bool
+Profile::stop(const filesystem::Path &filename)
+{
+	enabled = false;
+
+	std::ofstream f(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+	if (!f) {
+		synfig::error("Cannot write profile to file: %s", filename.u8_str());
+		return false;
+	}
+
+	f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+	f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"synfig\"}}";
+
+	std::lock_guard<std::mutex> lock(threads_mutex);
+	for(const ThreadEventsHandle &t : threads) {
+		std::lock_guard<std::mutex> thread_lock(t->mutex);
+		for(const Event &e : t->events) {
+			f << "," << std::endl
+			  << "{\"name\":\"" << escape(e.name)
+			  << "\",\"cat\":\"" << e.category
+			  << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t->thread
+			  << ",\"ts\":" << e.begin
+			  << ",\"dur\":" << e.duration;
+			if (e.cpu_duration >= 0)
+				f << ",\"tts\":" << e.cpu_begin
+				  << ",\"tdur\":" << e.cpu_duration;
+			if (!e.args.empty())
+				f << ",\"args\":{" << e.args << "}";
+			f << "}";
+		}
+		t->events.clear();
+	}
+
+	f << std::endl << "]}" << std::endl;
+	return (bool)f;
+}
+
+Profile::Time
+Profile::now()
+	{ return steady_time_us() - origin.load(std::memory_order_relaxed); }
+
+Profile::Time
+Profile::thread_cpu_time()
+{
+#ifdef _WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+		return 0;
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernel_time.dwLowDateTime;
+	kernel.HighPart = kernel_time.dwHighDateTime;
+	user.LowPart = user_time.dwLowDateTime;
+	user.HighPart = user_time.dwHighDateTime;
+	return (Time)((kernel.QuadPart + user.QuadPart)/10);
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		return 0;
+	return (Time)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+#endif
+}
+
+void
+Profile::add(
+	const char *category,
+	const String &name,
+	Time begin,
+	Time end,
+	const String &args )
+{
+	if (!is_enabled()) return;
+	add_event(Event{ category, name, begin, end - begin, 0, -1, args });
+}
+
+String
+Profile::escape(const String &x)
+{
+	String s;
+	s.reserve(x.size());
+	for(char c : x) {
+		if (c == '"' || c == '\\') {
+			s += '\\';
+			s += c;
+		} else
+		if ((unsigned char)c < 0x20) {
+			s += strprintf("\\u%04x", (int)(unsigned char)c);
+		} else {
+			s += c;
+		}
+	}
+	return s;
+}
@@ -0,0 +1,120 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file profile.h
+**	\brief Recording of rendering timings in Chrome trace event format
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_DEBUG_PROFILE_H
+#define __SYNFIG_DEBUG_PROFILE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <atomic>
+
+#include <synfig/filesystem_path.h>
+#include <synfig/string.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+namespace debug {
+
+//! Collects timings of rendering stages and writes them as Chrome trace events
+/*! Events are kept in per-thread buffers while profiling is active,
+	when it is not active Profile::Scope only checks one flag.
+	The output file may be opened in chrome://tracing or Perfetto. */
+class Profile {
+public:
+	//! Microseconds since Profile::start()
+	typedef long long Time;
+
+	//! Records wall and CPU time of the current thread between construction and destruction
+	class Scope {
+	private:
+		const char *category;
+		const char *name;
+		String dynamic_name;
+		String args;
+		bool active;
+		Time begin;
+		Time cpu_begin;
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	public:
+		//! \a category and \a name should be string literals
+		Scope(const char *category, const char *name):
+			category(category), name(name), active(is_enabled()), begin(), cpu_begin()
+			{ if (active) init(); }
+		~Scope()
+			{ if (active) finish(); }
+
+		bool is_active() const { return active; }
+		//! Changes name of the event, call it only when is_active()
+		void set_name(const String &x) { dynamic_name = x; }
+		//! Sets arguments of the event as JSON object members, like "\"frame\":1"
+		void set_args(const String &x) { args = x; }
+
+	private:
+		void init();
+		void finish();
+	};
+
+private:
+	static std::atomic<bool> enabled;
+
+public:
+	static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+	//! Drops previously recorded events and begins recording
+	static void start();
+	//! Stops recording and writes all events to \a filename, returns false on failure
+	static bool stop(const filesystem::Path &filename);
+
+	static Time now();
+	static Time thread_cpu_time();
+
+	//! Records the event which may begin and end on different threads
+	static void add(
+		const char *category,
+		const String &name,
+		Time begin,
+		Time end,
+		const String &args = String() );
+
+	//! Escapes \a x to be placed into JSON string literal
+	static String escape(const String &x);
+};
+
+}; // END of namespace debug
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -82,6 +82,21 @@ int FileSystem::ReadStream::underflow()
 	return std::streambuf::traits_type::to_int_type(*gptr());
 }
 
+std::streamsize FileSystem::ReadStream::xsgetn(char *s, std::streamsize n)
+{
+	// pass whole block to internal_read instead of reading it by one char
+	std::streamsize count = 0;
+	if (n > 0 && gptr() < egptr())
+		{ *s = *gptr(); gbump(1); count = 1; }
+	while(count < n)
+	{
+		size_t size = internal_read(s + count, (size_t)(n - count));
+		if (!size) break;
+		count += (std::streamsize)size;
+	}
+	return count;
+}
+
 // WriteStream
 
 FileSystem::WriteStream::WriteStream(FileSystem::Handle file_system):
@@ -96,6 +111,10 @@ FileSystem::WriteStream::overflow(int character)
 	return character != EOF && sizeof(c) == internal_write(&c, sizeof(c)) ? character : EOF;
 }
 
+std::streamsize
+FileSystem::WriteStream::xsputn(const char *s, std::streamsize n)
+	{ return n > 0 ? (std::streamsize)internal_write(s, (size_t)n) : 0; }
+
 // Identifier
 
 FileSystem::ReadStream::Handle FileSystem::Identifier::get_read_stream() const
@@ -81,6 +81,7 @@ namespace synfig
 
 			ReadStream(FileSystem::Handle file_system);
 			virtual int underflow();
+			virtual std::streamsize xsgetn(char *s, std::streamsize n);
 			virtual size_t internal_read(void *buffer, size_t size) = 0;
 
 		public:
@@ -103,18 +104,14 @@ namespace synfig
 		protected:
 			WriteStream(FileSystem::Handle file_system);
 	        virtual int overflow(int ch);
+			virtual std::streamsize xsputn(const char *s, std::streamsize n);
 			virtual size_t internal_write(const void *buffer, size_t size) = 0;
 
 		public:
 			bool write_block(const void *buffer, size_t size)
-			{
-				for(size_t i = 0; i < size; i++)
-					if (!put(((const char*)buffer)[i]).good())
-						return i;
-				return size;
-			}
+				{ return write((const char*)buffer, size).good(); }
 			bool write_whole_block(const void *buffer, size_t size)
-				{ return size == write_block(buffer, size); }
+				{ return write_block(buffer, size); }
 			bool write_whole_stream(std::streambuf &streambuf)
 				{ return (*this << &streambuf).good(); }
 			bool write_whole_stream(std::istream &stream)
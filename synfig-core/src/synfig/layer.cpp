@@ -418,7 +418,7 @@ Layer::get_z_depth(const synfig::Time& t)const
 {
 	if(!dynamic_param_list().count("z_depth"))
 		return param_z_depth.get(Real());
-	return (*dynamic_param_list().find("z_depth")->second)(t).get(Real());
+	return dynamic_param_list().find("z_depth")->second->evaluate(t).get(Real());
 }
 
 float
@@ -610,7 +610,7 @@ Layer::set_time(IndependentContext context, Time time)
 	Layer::DynamicParamList::const_iterator iter;
 	// For each parameter of the layer sets the value by the operator()(time)
 	for (iter = dynamic_param_list().begin(); iter != dynamic_param_list().end(); ++iter)
-		params[iter->first]=(*iter->second)(time);
+		params[iter->first]=iter->second->evaluate(time);
 	// Sets the modified parameter list to the current context layer
 	const_cast<Layer*>(this)->set_param_list(params);
 
@@ -42,6 +42,8 @@
 #include <synfig/time.h>
 #include <synfig/value.h>
 
+#include <synfig/threadpool.h>
+
 #include <synfig/rendering/common/task/taskblend.h>
 #include <synfig/rendering/common/task/tasklayer.h>
 
@@ -222,14 +224,32 @@ Real Layer_SkeletonDeformation::distance_to_line(const Vector &p0, const Vector
 	return std::min(distance_to_line, std::min(distance_to_p0, distance_to_p1) );
 }
 
+//! Deformation of one bone and the range of grid points it can affect
+struct Layer_SkeletonDeformation::BoneInfluence {
+	Bone::Shape shape;
+	Bone::Shape expanded_shape;
+	Real depth;
+	Matrix matrix;
+	RectInt points; //!< grid points inside the bounds of expanded shape
+
+	inline bool contains(int i, int j) const
+		{ return i >= points.minx && i < points.maxx && j >= points.miny && j < points.maxy; }
+};
+
 void
 Layer_SkeletonDeformation::prepare_mesh()
 {
 	static const Real precision = 1e-10;
 
-	rendering::Mesh::Handle mesh(new rendering::Mesh());
+	// Grid is split to blocks of block_size*block_size cells.
+	// Block affected by only one bone is deformed by affine transformation,
+	// so it is represented by a few triangles without inner grid points.
+	static const int block_size = 4;
+
+	// rough count of point-bone pairs processed by one thread
+	static const Real thread_work = 65536.0;
 
-	// TODO: build grid with dynamic size
+	rendering::Mesh::Handle mesh(new rendering::Mesh());
 
 	const Point grid_p0 = param_point1.get(Point());
 	const Point grid_p1 = param_point2.get(Point());
@@ -240,30 +260,40 @@ Layer_SkeletonDeformation::prepare_mesh()
 	const Real grid_step_y = (grid_p1[1] - grid_p0[1]) / (Real)(grid_side_count_y - 1);
 	const Real grid_step_diagonal = sqrt(grid_step_x*grid_step_x + grid_step_y*grid_step_y);
 
-	// build grid
-	std::vector<GridPoint> grid;
-	grid.reserve(grid_side_count_x * grid_side_count_y);
-	for(int j = 0; j < grid_side_count_y; ++j)
-		for(int i = 0; i < grid_side_count_x; ++i)
-			grid.push_back(GridPoint(Vector(
-				grid_p0[0] + i*grid_step_x,
-				grid_p0[1] + j*grid_step_y )));
-
-	// apply deformation
+	// returns range of grid indices [first, last) placed inside of [min, max]
+	auto grid_range = [](Real min, Real max, Real origin, Real step, int count) {
+		if (std::fabs(step) < precision)
+			return std::make_pair(0, count);
+		Real a = (min - origin)/step;
+		Real b = (max - origin)/step;
+		if (b < a) std::swap(a, b);
+		if (!(b >= 0.0 && a <= count - 1.0))
+			return std::make_pair(0, 0);
+		return std::make_pair(
+			std::max(0, (int)std::floor(a)),
+			std::min(count, (int)std::ceil(b) + 1) );
+	};
+
+	// prepare bones
+	std::vector<BoneInfluence> influences;
 	if (param_bones.can_get(ValueBase::List()))
 	{
 		const ValueBase::List &bones = param_bones.get_list();
+		influences.reserve(bones.size());
 		for(ValueBase::List::const_iterator i = bones.begin(); i != bones.end(); ++i)
 		{
 			if (i->can_get(BonePair()))
 			{
 				const BonePair &bone_pair = i->get(BonePair());
-				Bone::Shape shape0 = bone_pair.first.get_shape();
+				BoneInfluence influence;
+				Bone::Shape &shape0 = influence.shape;
+				shape0 = bone_pair.first.get_shape();
 				Bone::Shape shape1 = bone_pair.second.get_shape();
-				Bone::Shape expandedShape0 = shape0;
+				Bone::Shape &expandedShape0 = influence.expanded_shape;
+				expandedShape0 = shape0;
 				expandedShape0.r0 += 2.0*grid_step_diagonal;
 				expandedShape0.r1 += 2.0*grid_step_diagonal;
-				Real depth = bone_pair.second.get_depth();
+				influence.depth = bone_pair.second.get_depth();
 
 				Matrix into_bone(
 					shape0.p1[0] - shape0.p0[0], shape0.p1[1] - shape0.p0[1], 0.0,
@@ -276,13 +306,120 @@ Layer_SkeletonDeformation::prepare_mesh()
 					shape1.p0[1] - shape1.p1[1], shape1.p1[0] - shape1.p0[0], 0.0,
 					shape1.p0[0], shape1.p0[1], 1.0
 				);
-				Matrix matrix = from_bone * into_bone;
+				influence.matrix = from_bone * into_bone;
+
+				// bone affects only points inside of its expanded shape
+				Rect bounds = Rect(expandedShape0.p0).expand(std::fabs(expandedShape0.r0));
+				bounds.expand( Rect(expandedShape0.p1).expand(std::fabs(expandedShape0.r1)).get_min() );
+				bounds.expand( Rect(expandedShape0.p1).expand(std::fabs(expandedShape0.r1)).get_max() );
+				std::pair<int, int> range_x = grid_range(bounds.minx, bounds.maxx, grid_p0[0], grid_step_x, grid_side_count_x);
+				std::pair<int, int> range_y = grid_range(bounds.miny, bounds.maxy, grid_p0[1], grid_step_y, grid_side_count_y);
+				influence.points = RectInt(range_x.first, range_y.first, range_x.second, range_y.second);
+				if (influence.points.minx < influence.points.maxx && influence.points.miny < influence.points.maxy)
+					influences.push_back(influence);
+			}
+		}
+	}
 
-				for(std::vector<GridPoint>::iterator j = grid.begin(); j != grid.end(); ++j)
+	// bones which may affect each block, listed in the original order
+	const int block_count_x = (grid_side_count_x - 2)/block_size + 1;
+	const int block_count_y = (grid_side_count_y - 2)/block_size + 1;
+	std::vector< std::vector<int> > block_bones(block_count_x*block_count_y);
+	for(int k = 0; k < (int)influences.size(); ++k) {
+		const RectInt &r = influences[k].points;
+		const int bx0 = std::min(block_count_x - 1, std::max(0, r.minx - 1)/block_size);
+		const int by0 = std::min(block_count_y - 1, std::max(0, r.miny - 1)/block_size);
+		const int bx1 = std::min(block_count_x - 1, (r.maxx - 1)/block_size);
+		const int by1 = std::min(block_count_y - 1, (r.maxy - 1)/block_size);
+		for(int by = by0; by <= by1; ++by)
+			for(int bx = bx0; bx <= bx1; ++bx) {
+				// check intersection with points of block, including its border
+				if ( r.minx <= std::min(grid_side_count_x - 1, (bx + 1)*block_size) && r.maxx > bx*block_size
+				  && r.miny <= std::min(grid_side_count_y - 1, (by + 1)*block_size) && r.maxy > by*block_size )
+					block_bones[by*block_count_x + bx].push_back(k);
+			}
+	}
+
+	// build grid
+	std::vector<GridPoint> grid;
+	grid.reserve(grid_side_count_x * grid_side_count_y);
+	for(int j = 0; j < grid_side_count_y; ++j)
+		for(int i = 0; i < grid_side_count_x; ++i)
+			grid.push_back(GridPoint(Vector(
+				grid_p0[0] + i*grid_step_x,
+				grid_p0[1] + j*grid_step_y )));
+
+	// choose blocks which need all grid points,
+	// block is simple when all its corners are inside of the single bone
+	std::vector<bool> simple_blocks(block_bones.size(), false);
+	for(int by = 0; by < block_count_y; ++by) {
+		for(int bx = 0; bx < block_count_x; ++bx) {
+			const int i0 = bx*block_size, i1 = i0 + block_size;
+			const int j0 = by*block_size, j1 = j0 + block_size;
+			const std::vector<int> &bones = block_bones[by*block_count_x + bx];
+			if (bones.size() != 1 || i1 >= grid_side_count_x || j1 >= grid_side_count_y)
+				continue;
+			const Bone::Shape &shape = influences[bones.front()].expanded_shape;
+			simple_blocks[by*block_count_x + bx] =
+				   Bone::distance_to_shape_center_percent(shape, grid[j0*grid_side_count_x + i0].initial_position) > precision
+				&& Bone::distance_to_shape_center_percent(shape, grid[j0*grid_side_count_x + i1].initial_position) > precision
+				&& Bone::distance_to_shape_center_percent(shape, grid[j1*grid_side_count_x + i0].initial_position) > precision
+				&& Bone::distance_to_shape_center_percent(shape, grid[j1*grid_side_count_x + i1].initial_position) > precision;
+		}
+	}
+
+	// returns true when block uses all its grid points
+	auto fine_block = [&](int bx, int by) {
+		return bx >= 0 && bx < block_count_x && by >= 0 && by < block_count_y
+			&& !block_bones[by*block_count_x + bx].empty()
+			&& !simple_blocks[by*block_count_x + bx];
+	};
+	auto has_fine_neighbour = [&](int bx, int by) {
+		return fine_block(bx, by - 1) || fine_block(bx + 1, by) || fine_block(bx, by + 1) || fine_block(bx - 1, by);
+	};
+
+	// Edge shared by simple block with fine one keeps all its grid points,
+	// and such simple block is split to triangles around its center point.
+	// So neighbour blocks have the same vertices on the common edges
+	// and the mesh has no T-junctions.
+	std::vector<bool> needed(grid.size(), false);
+	for(int by = 0; by < block_count_y; ++by) {
+		for(int bx = 0; bx < block_count_x; ++bx) {
+			const int i0 = bx*block_size, i1 = std::min(grid_side_count_x - 1, i0 + block_size);
+			const int j0 = by*block_size, j1 = std::min(grid_side_count_y - 1, j0 + block_size);
+			if (block_bones[by*block_count_x + bx].empty())
+				continue;
+			if (simple_blocks[by*block_count_x + bx]) {
+				needed[j0*grid_side_count_x + i0] = needed[j0*grid_side_count_x + i1] = true;
+				needed[j1*grid_side_count_x + i0] = needed[j1*grid_side_count_x + i1] = true;
+				if (has_fine_neighbour(bx, by))
+					needed[(j0 + block_size/2)*grid_side_count_x + i0 + block_size/2] = true;
+			} else {
+				for(int j = j0; j <= j1; ++j)
+					for(int i = i0; i <= i1; ++i)
+						needed[j*grid_side_count_x + i] = true;
+			}
+		}
+	}
+
+	// apply deformation to the needed points
+	auto deform_rows = [&](int row_begin, int row_end) {
+		for(int j = row_begin; j < row_end; ++j) {
+			const int by = std::min(block_count_y - 1, j/block_size);
+			for(int i = 0; i < grid_side_count_x; ++i) {
+				if (!needed[j*grid_side_count_x + i]) continue;
+				GridPoint &point = grid[j*grid_side_count_x + i];
+
+				// any block which contains the point lists all bones which may affect it
+				const int bx = std::min(block_count_x - 1, i/block_size);
+				const std::vector<int> &bones = block_bones[by*block_count_x + bx];
+				for(std::vector<int>::const_iterator k = bones.begin(); k != bones.end(); ++k)
 				{
-					Real percent = Bone::distance_to_shape_center_percent(expandedShape0, j->initial_position);
+					const BoneInfluence &influence = influences[*k];
+					if (!influence.contains(i, j)) continue;
+					Real percent = Bone::distance_to_shape_center_percent(influence.expanded_shape, point.initial_position);
 					if (percent > precision) {
-						Real distance = distance_to_line(shape0.p0, shape0.p1, j->initial_position);
+						Real distance = distance_to_line(influence.shape.p0, influence.shape.p1, point.initial_position);
 						if (distance < precision) distance = precision;
 						Real weight =
 							percent/(distance*distance);
@@ -290,46 +427,122 @@ Layer_SkeletonDeformation::prepare_mesh()
 							// 1.0/(distance*distance);
 							// 1.0/(distance*distance*distance);
 							// exp(-4.0*distance);
-						j->summary_position += matrix.get_transformed(j->initial_position) * weight;
-						j->summary_depth += depth * weight;
-						j->summary_weight += weight;
-						j->used = true;
+						point.summary_position += influence.matrix.get_transformed(point.initial_position) * weight;
+						point.summary_depth += influence.depth * weight;
+						point.summary_weight += weight;
+						point.used = true;
 					}
 				}
 			}
 		}
+	};
+
+	{
+		// split rows to parts of similar work for threads
+		ThreadPool::Group group;
+		Real work = 0.0;
+		int row_begin = 0;
+		for(int j = 0; j < grid_side_count_y; ++j) {
+			const int by = std::min(block_count_y - 1, j/block_size);
+			for(int bx = 0; bx < block_count_x; ++bx)
+				work += (Real)(block_size*block_bones[by*block_count_x + bx].size());
+			if (work >= thread_work || j + 1 == grid_side_count_y) {
+				const int row_end = j + 1;
+				group.enqueue([&deform_rows, row_begin, row_end]() { deform_rows(row_begin, row_end); }, work/thread_work);
+				work = 0.0;
+				row_begin = j + 1;
+			}
+		}
+		group.run();
 	}
 
 	// build vertices
-	mesh->vertices.reserve(grid.size());
-	for(std::vector<GridPoint>::iterator i = grid.begin(); i != grid.end(); ++i) {
-		Vector average_position = i->summary_weight > precision ? i->summary_position/i->summary_weight : i->initial_position;
-		i->average_depth = i->summary_weight > precision ? i->summary_depth/i->summary_weight : 0.0;
+	std::vector<int> vertex_indices(grid.size(), -1);
+	for(int k = 0; k < (int)grid.size(); ++k) {
+		if (!needed[k]) continue;
+		GridPoint &point = grid[k];
+		Vector average_position = point.summary_weight > precision ? point.summary_position/point.summary_weight : point.initial_position;
+		point.average_depth = point.summary_weight > precision ? point.summary_depth/point.summary_weight : 0.0;
+		vertex_indices[k] = (int)mesh->vertices.size();
 		mesh->vertices.push_back( rendering::Mesh::Vertex(
-			average_position, i->initial_position ));
+			average_position, point.initial_position ));
 	}
 
 	// build triangles
 	std::vector< std::pair<Real, rendering::Mesh::Triangle> > triangles;
 	triangles.reserve(2*(grid_side_count_x-1)*(grid_side_count_y-1));
-	for(int j = 1; j < grid_side_count_y; ++j)
-	{
-		for(int i = 1; i < grid_side_count_x; ++i)
+	auto all_used = [&](const std::vector<int> &points) {
+		for(std::vector<int>::const_iterator k = points.begin(); k != points.end(); ++k)
+			if (!grid[*k].used) return false;
+		return true;
+	};
+	auto add_quad = [&](int i0, int j0, int i1, int j1) {
+		int v[] = {
+			j0*grid_side_count_x + i0,
+			j0*grid_side_count_x + i1,
+			j1*grid_side_count_x + i1,
+			j1*grid_side_count_x + i0,
+		};
+		if (grid[v[0]].used && grid[v[1]].used && grid[v[2]].used && grid[v[3]].used)
 		{
-			int v[] = {
-				(j-1)*grid_side_count_x + (i-1),
-				(j-1)*grid_side_count_x +  i,
-				 j   *grid_side_count_x +  i,
-				 j   *grid_side_count_x + (i-1),
-			};
-			if (grid[v[0]].used && grid[v[1]].used && grid[v[2]].used && grid[v[3]].used)
-			{
-				Real depth = 0.25*(grid[v[0]].average_depth
-						         + grid[v[1]].average_depth
-								 + grid[v[2]].average_depth
-								 + grid[v[3]].average_depth);
-				triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[0], v[1], v[3])));
-				triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[1], v[2], v[3])));
+			Real depth = 0.25*(grid[v[0]].average_depth
+					         + grid[v[1]].average_depth
+							 + grid[v[2]].average_depth
+							 + grid[v[3]].average_depth);
+			for(int k = 0; k < 4; ++k)
+				v[k] = vertex_indices[v[k]];
+			triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[0], v[1], v[3])));
+			triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[1], v[2], v[3])));
+		}
+	};
+	// splits simple block to triangles around its center,
+	// grid points of edge are included when the block across it is fine
+	auto add_fan = [&](int bx, int by) {
+		const int i0 = bx*block_size, i1 = i0 + block_size;
+		const int j0 = by*block_size, j1 = j0 + block_size;
+		const int center = (j0 + block_size/2)*grid_side_count_x + i0 + block_size/2;
+		const bool split[] = {
+			fine_block(bx, by - 1), fine_block(bx + 1, by), fine_block(bx, by + 1), fine_block(bx - 1, by) };
+
+		// border of block in the same direction as in add_quad()
+		std::vector<int> border;
+		border.reserve(4*block_size);
+		for(int i = i0; i < i1; ++i)
+			if (i == i0 || split[0]) border.push_back(j0*grid_side_count_x + i);
+		for(int j = j0; j < j1; ++j)
+			if (j == j0 || split[1]) border.push_back(j*grid_side_count_x + i1);
+		for(int i = i1; i > i0; --i)
+			if (i == i1 || split[2]) border.push_back(j1*grid_side_count_x + i);
+		for(int j = j1; j > j0; --j)
+			if (j == j1 || split[3]) border.push_back(j*grid_side_count_x + i0);
+		if (!grid[center].used || !all_used(border))
+			return;
+
+		Real depth = 0.25*(grid[j0*grid_side_count_x + i0].average_depth
+		                 + grid[j0*grid_side_count_x + i1].average_depth
+		                 + grid[j1*grid_side_count_x + i1].average_depth
+		                 + grid[j1*grid_side_count_x + i0].average_depth);
+		for(size_t k = 0; k < border.size(); ++k)
+			triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(
+				vertex_indices[center],
+				vertex_indices[border[k]],
+				vertex_indices[border[(k + 1)%border.size()]] )));
+	};
+	for(int by = 0; by < block_count_y; ++by) {
+		for(int bx = 0; bx < block_count_x; ++bx) {
+			const int i0 = bx*block_size, i1 = std::min(grid_side_count_x - 1, i0 + block_size);
+			const int j0 = by*block_size, j1 = std::min(grid_side_count_y - 1, j0 + block_size);
+			if (block_bones[by*block_count_x + bx].empty())
+				continue;
+			if (!simple_blocks[by*block_count_x + bx]) {
+				for(int j = j0 + 1; j <= j1; ++j)
+					for(int i = i0 + 1; i <= i1; ++i)
+						add_quad(i - 1, j - 1, i, j);
+			} else
+			if (has_fine_neighbour(bx, by)) {
+				add_fan(bx, by);
+			} else {
+				add_quad(i0, j0, i1, j1);
 			}
 		}
 	}
@@ -61,6 +61,7 @@ private:
 	synfig::ValueBase param_y_subdivisions;
 
 	struct GridPoint;
+	struct BoneInfluence;
 	static Real distance_to_line(const Vector &p0, const Vector &p1, const Vector &x);
 
 public:
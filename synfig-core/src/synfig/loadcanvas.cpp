@@ -41,12 +41,14 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <exception>
 #include <iostream>
 #include <map>
 #include <vector>
 #include <stdexcept>
 
 #include <libxml++/libxml++.h>
+#include <libxml/xmlreader.h>
 #include <sigc++/bind.h>
 
 #include "loadcanvas.h"
@@ -157,6 +159,149 @@ static void _canvas_file_name_changed(Canvas *x)
 	canvas_map[x] = filesystem::Path::absolute_path(x->get_file_name());
 }
 
+static FileSystem::ReadStream::Handle
+_open_canvas_stream(const FileSystem::Identifier &identifier)
+{
+	FileSystem::ReadStream::Handle stream = identifier.get_read_stream();
+	if (stream && identifier.filename.extension().u8string() == ".sifz")
+		stream = FileSystem::ReadStream::Handle(new ZReadStream(stream, zstreambuf::compression::gzip));
+	return stream;
+}
+
+static int
+_read_xml_stream(void *context, char *buffer, int len)
+{
+	FileSystem::ReadStream *stream = static_cast<FileSystem::ReadStream*>(context);
+	size_t size = stream->read_block(buffer, len);
+	return size || !stream->bad() ? (int)size : -1;
+}
+
+static int
+_close_xml_stream(void *)
+	{ return 0; }
+
+//! Text reader of libxml2 over the synfig stream.
+//! It keeps the xml tree of the current element and its ancestors only,
+//! subtrees of the read elements are freed when the reader moves to the next sibling.
+struct CanvasParser::XmlStreamReader
+{
+	xmlTextReaderPtr reader;
+	String errors;
+	//! False after the first exception of the parser, the rest of the file is only checked to be well-formed
+	bool parse;
+	std::exception_ptr failure;
+
+	XmlStreamReader(FileSystem::ReadStream &stream, const String &filename):
+		reader(xmlReaderForIO(_read_xml_stream, _close_xml_stream, &stream, filename.c_str(), NULL, 0)),
+		parse(true)
+	{
+		if (reader)
+			xmlTextReaderSetErrorHandler(reader, on_error, this);
+	}
+
+	~XmlStreamReader()
+	{
+		if (reader)
+			xmlFreeTextReader(reader);
+	}
+
+	static void on_error(void *arg, const char *msg, xmlParserSeverities, xmlTextReaderLocatorPtr)
+		{ static_cast<XmlStreamReader*>(arg)->errors += msg; }
+
+	bool ok() const
+		{ return errors.empty(); }
+
+	String get_name() const
+		{ return String((const char*)xmlTextReaderConstName(reader)); }
+
+	bool has_attribute(const char *name) const
+	{
+		xmlChar *value = xmlTextReaderGetAttribute(reader, (const xmlChar*)name);
+		xmlFree(value);
+		return value != NULL;
+	}
+
+	//! Wraps the current element into xmlpp node, its children are not read yet.
+	//! libxml2 knows nothing about xmlpp wrappers, so they must be freed by free_wrappers()
+	//! before the reader moves past the element
+	xmlpp::Element* wrap() const
+	{
+		xmlNode *node = xmlTextReaderCurrentNode(reader);
+		xmlpp::Node::create_wrapper(node);
+		return static_cast<xmlpp::Element*>(node->_private);
+	}
+
+	//! Calls \a func, its exception is held until the end of the file
+	template<typename T>
+	void call(const T &func)
+	{
+		if (!parse)
+			return;
+		try { func(); }
+		catch(...) { failure = std::current_exception(); parse = false; }
+	}
+
+	//! Calls \a func for every child element of the current element, \a func moves the reader past that child.
+	//! Returns false on xml errors, otherwise the reader stays at the end of the element
+	template<typename T>
+	bool for_each_child(const T &func)
+	{
+		if (xmlTextReaderIsEmptyElement(reader))
+			return true;
+		const int depth = xmlTextReaderDepth(reader);
+		int ret = xmlTextReaderRead(reader);
+		while(ret == 1 && ok() && xmlTextReaderDepth(reader) > depth)
+		{
+			if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
+				ret = func();
+			else
+				ret = xmlTextReaderRead(reader);
+		}
+		return ret == 1 && ok();
+	}
+
+	//! Frees the wrapper of the current \a element and moves past it, returns the result of xmlTextReaderRead()
+	int next(xmlpp::Element *element, bool read)
+	{
+		xmlpp::Node::free_wrappers(element->cobj());
+		return read ? xmlTextReaderRead(reader) : -1;
+	}
+
+	//! Reads the current element as a whole, calls \a func for it and moves past it
+	template<typename T>
+	int expand(const T &func)
+	{
+		if (!parse)
+			return xmlTextReaderNext(reader);
+		xmlNode *node = xmlTextReaderExpand(reader);
+		if (!node || !ok())
+			return -1;
+		xmlpp::Element *element = wrap();
+		call([&]() { func(element); });
+		xmlpp::Node::free_wrappers(node);
+		return xmlTextReaderNext(reader);
+	}
+};
+
+//! Parsing state of <layer>, shared by its parameters
+struct CanvasParser::LayerState
+{
+	String type;
+	String version;
+
+	// Load old groups
+	bool old_pastecanvas;
+	ValueNode::Handle origin_node;
+	ValueNode_Composite::Handle transformation_node;
+	ValueNode_Add::Handle offset_node;
+	ValueNode_Scale::Handle scale_scalar_node;
+	ValueNode_Exp::Handle scale_node;
+	bool origin_const, focus_const, zoom_const;
+
+	LayerState():
+		old_pastecanvas(false), origin_const(true), focus_const(true), zoom_const(true) { }
+};
+
 Canvas::Handle
 synfig::open_canvas_as(const FileSystem::Identifier &identifier,const String &as,String &errors,String &warnings)
 {
@@ -221,7 +366,10 @@ CanvasParser::warning(xmlpp::Node *element, const String &text)
 {
 	std::string str=strprintf("%s:<%s>:%d: ",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
 
-	synfig::warning(str);
+	if (hold_messages_)
+		held_messages_.push_back(std::make_pair(true, str));
+	else
+		synfig::warning(str);
 	// cerr<<str<<endl;
 
 	total_warnings_++;
@@ -238,10 +386,30 @@ CanvasParser::error(xmlpp::Node *element, const String &text)
 	errors_text += "  * " + str + "\n";
 	if(!allow_errors_)
 		throw std::runtime_error(str);
-	std::cerr<<str.c_str()<<std::endl;
+	if (hold_messages_)
+		held_messages_.push_back(std::make_pair(false, str));
+	else
+		std::cerr<<str.c_str()<<std::endl;
 	//	synfig::error(str);
 }
 
+void
+CanvasParser::release_held_messages(bool print)
+{
+	hold_messages_ = false;
+	if (print)
+	{
+		for(std::vector<std::pair<bool, String> >::const_iterator i = held_messages_.begin(); i != held_messages_.end(); ++i)
+		{
+			if (i->first)
+				synfig::warning(i->second);
+			else
+				std::cerr<<i->second.c_str()<<std::endl;
+		}
+	}
+	held_messages_.clear();
+}
+
 void
 CanvasParser::fatal_error(xmlpp::Node *element, const String &text)
 {
@@ -2757,6 +2925,26 @@ CanvasParser::parse_canvas_bones(xmlpp::Element *element,Canvas::Handle canvas)
 
 Layer::Handle
 CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
+{
+	LayerState state;
+	Layer::Handle layer(parse_layer_header(element,canvas,state));
+	if(!layer)
+		return layer;
+
+	xmlpp::Element::NodeList list = element->get_children();
+	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	{
+		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
+		if(child)
+			parse_layer_child(child,layer,canvas,state);
+	}
+
+	parse_layer_end(element,layer,canvas,state);
+	return layer;
+}
+
+Layer::Handle
+CanvasParser::parse_layer_header(xmlpp::Element *element,Canvas::Handle canvas,LayerState &state)
 {
 
 	assert(element->get_name()=="layer");
@@ -2767,9 +2955,10 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 		error(element,_("Missing \"type\" attribute to \"layer\" element"));
 		return Layer::Handle();
 	}
-	if(element->get_attribute("type")->get_value() == "filled_rectangle")
+	state.type = element->get_attribute("type")->get_value();
+	if(state.type == "filled_rectangle")
 	layer=Layer::create("rectangle");
-	else layer=Layer::create(element->get_attribute("type")->get_value());
+	else layer=Layer::create(state.type);
 	layer->set_canvas(canvas);
 
 	if(element->get_attribute("group"))
@@ -2780,14 +2969,13 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 	}
 
 	// Handle the version attribute
-	String version;
 	if(element->get_attribute("version"))
 	{
-		version = element->get_attribute("version")->get_value();
-		if(version>layer->get_version())
+		state.version = element->get_attribute("version")->get_value();
+		if(state.version>layer->get_version())
 			warning(element,_("Installed layer version is smaller than layer version in file"));
-		if(version!=layer->get_version())
-			layer->set_version(version);
+		if(state.version!=layer->get_version())
+			layer->set_version(state.version);
 	}
 
 	// Handle the description
@@ -2802,296 +2990,312 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 
 	// Load old groups
 	Layer_PasteCanvas::Handle layer_pastecanvas = etl::handle<Layer_Group>::cast_dynamic(layer);
-	bool old_pastecanvas = layer_pastecanvas && version=="0.1";
-	ValueNode::Handle origin_node;
-	ValueNode_Composite::Handle transformation_node;
-	ValueNode_Add::Handle offset_node;
-	ValueNode_Scale::Handle scale_scalar_node;
-	ValueNode_Exp::Handle scale_node;
-	bool origin_const=true, focus_const=true, zoom_const=true;
-	if (old_pastecanvas) {
-		transformation_node = ValueNode_Composite::create(ValueBase(Transformation()), canvas);
-		layer->connect_dynamic_param("transformation", ValueNode::Handle(transformation_node));
+	state.old_pastecanvas = layer_pastecanvas && state.version=="0.1";
+	if (state.old_pastecanvas) {
+		state.transformation_node = ValueNode_Composite::create(ValueBase(Transformation()), canvas);
+		layer->connect_dynamic_param("transformation", ValueNode::Handle(state.transformation_node));
 
-		offset_node = ValueNode_Add::create(ValueBase(Vector(0,0)));
-		transformation_node->set_link("offset", offset_node);
+		state.offset_node = ValueNode_Add::create(ValueBase(Vector(0,0)));
+		state.transformation_node->set_link("offset", state.offset_node);
 
-		origin_node = offset_node->get_link("rhs");
-		layer->connect_dynamic_param("origin", ValueNode::Handle(origin_node));
+		state.origin_node = state.offset_node->get_link("rhs");
+		layer->connect_dynamic_param("origin", ValueNode::Handle(state.origin_node));
 
-		scale_scalar_node = ValueNode_Scale::create(ValueBase(Vector(1,1)));
-		transformation_node->set_link("scale", scale_scalar_node);
+		state.scale_scalar_node = ValueNode_Scale::create(ValueBase(Vector(1,1)));
+		state.transformation_node->set_link("scale", state.scale_scalar_node);
 
-		scale_node = ValueNode_Exp::create(ValueBase(Real(1)));
-		scale_scalar_node->set_link("scalar", scale_node);
+		state.scale_node = ValueNode_Exp::create(ValueBase(Real(1)));
+		state.scale_scalar_node->set_link("scalar", state.scale_node);
 	}
 
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(!child)
-			continue;
-		else
-		if(child->get_name()=="name")
-			warning(child,_("<name> entry for <layer> is not yet supported. Ignoring..."));
-		else
-		if(child->get_name()=="desc")
-			warning(child,_("<desc> entry for <layer> is not yet supported. Ignoring..."));
-		else
-		if(child->get_name()=="param")
-		{
-			xmlpp::Element::NodeList list = child->get_children();
-
-			if(!child->get_attribute("name"))
-			{
-				error(child,_("Missing \"name\" attribute for <param>."));
-				continue;
-			}
-
-			String param_name=child->get_attribute("name")->get_value();
-
-			// SVN r2013 and r2014 renamed all 'pos' and 'offset' parameters to 'origin'
-			// 'pos' and 'offset' will appear in old .sif files; handle them correctly
-			if (param_name == "pos" || param_name == "offset")
-				param_name = "origin";
-
-			if(child->get_attribute("use"))
-			{
-				// If the "use" attribute is used, then the
-				// element should be empty. Warn the user if
-				// we find otherwise.
-				if(!list.empty())
-					warning(child,_("Found \"use\" attribute for <param>, but it wasn't empty. Ignoring contents..."));
-
-				String str=	child->get_attribute("use")->get_value();
-
-				if (str.empty())
-					error(child,_("Empty use=\"\" value in <param>"));
-				else if(layer->get_param(param_name).get_type()==type_canvas)
-				{
-					String warnings;
-					Canvas::Handle c(canvas->surefind_canvas(str, warnings));
-					warnings_text += warnings;
-					if(!c) error((*iter),strprintf(_("Failed to load subcanvas '%s'"), str.c_str()));
-					if(!layer->set_param(param_name,c))
-						error((*iter),_("Layer rejected canvas link"));
-					//Parse the static option and sets it to the canvas ValueBase
-					ValueBase v=layer->get_param(param_name);
-					v.set_static(parse_static(child));
-					layer->set_param(param_name, v);
-				}
-				else
-				try
-				{
-					ValueNode::Handle value_node=canvas->surefind_value_node(str);
-					if(PlaceholderValueNode::Handle::cast_dynamic(value_node))
-						throw Exception::IDNotFound("parse_layer()");
-
-					// Assign the value_node to the dynamic parameter list
-					if (param_name == "segment_list" && (layer->get_name() == "region" || layer->get_name() == "outline"))
-					{
-						synfig::warning("%s: Updated valuenode connection to use the \"bline\" parameter instead of \"segment_list\".",
-										layer->get_name().c_str());
-						param_name = "bline";
-					}
+	return layer;
+}
 
-					// NB: this part of code has copy below
-					bool processed = false;
-					if (old_pastecanvas)
-					{
-						processed = true;
-						if (param_name == "origin")
-						{
-							origin_const = false;
-							offset_node->set_link("lhs", value_node);
-						}
-						else
-						if (param_name == "focus")
-						{
-							focus_const = false;
-							origin_node = value_node;
-							layer->connect_dynamic_param("origin_node", ValueNode::Handle(origin_node));
-							offset_node->set_link("rhs", value_node);
-						}
-						else
-						if (param_name == "zoom")
-						{
-							zoom_const = false;
-							scale_node->set_link("exp", value_node);
-						}
-						else
-							processed = false;
-					}
+void
+CanvasParser::parse_layer_child(xmlpp::Element *child,Layer::Handle layer,Canvas::Handle canvas,LayerState &state)
+{
+	if(child->get_name()=="name")
+		warning(child,_("<name> entry for <layer> is not yet supported. Ignoring..."));
+	else
+	if(child->get_name()=="desc")
+		warning(child,_("<desc> entry for <layer> is not yet supported. Ignoring..."));
+	else
+	if(child->get_name()=="param")
+		parse_layer_param(child,layer,canvas,state);
+	else
+	{
+		printf("%s:%d\n", __FILE__, __LINE__);
+		error_unexpected_element(child,child->get_name());
+	}
+}
 
-					if (!processed) layer->connect_dynamic_param(param_name,value_node);
-    			}
-				catch(Exception::IDNotFound&)
-				{
-					error(child,strprintf(_("Unknown ID (%s) referenced in parameter \"%s\""),str.c_str(), param_name.c_str()));
-				}
+void
+CanvasParser::parse_layer_param(xmlpp::Element *child,Layer::Handle layer,Canvas::Handle canvas,LayerState &state)
+{
+	xmlpp::Element::NodeList list = child->get_children();
 
-				continue;
-			}
+	if(!child->get_attribute("name"))
+	{
+		error(child,_("Missing \"name\" attribute for <param>."));
+		return;
+	}
 
-			xmlpp::Element::NodeList::iterator iter;
+	String param_name=child->get_attribute("name")->get_value();
 
-			// Search for the first non-text XML element
-			for(iter = list.begin(); iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter))
-					break;
-				//if(!(!dynamic_cast<xmlpp::Element*>(*iter) && (*iter)->get_name()=="text"||(*iter)->get_name()=="comment"   )) break;
+	// SVN r2013 and r2014 renamed all 'pos' and 'offset' parameters to 'origin'
+	// 'pos' and 'offset' will appear in old .sif files; handle them correctly
+	if (param_name == "pos" || param_name == "offset")
+		param_name = "origin";
 
-			if(iter==list.end())
-			{
-				error(child,_("<param> is either missing its contents, or missing a \"use\" attribute."));
-				continue;
-			}
+	if(child->get_attribute("use"))
+	{
+		// If the "use" attribute is used, then the
+		// element should be empty. Warn the user if
+		// we find otherwise.
+		if(!list.empty())
+			warning(child,_("Found \"use\" attribute for <param>, but it wasn't empty. Ignoring contents..."));
 
-			ValueBase data;
-			ValueNode::Handle value_node;
+		String str=	child->get_attribute("use")->get_value();
 
-			// If we recognize the element name as a
-			// ValueBase, then treat is at one
-			if(/*(*iter)->get_name()!="canvas" && */ValueBase::ident_type((*iter)->get_name()) != type_nil && !dynamic_cast<xmlpp::Element*>(*iter)->get_attribute("guid"))
-			{
-				data=parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
+		if (str.empty())
+			error(child,_("Empty use=\"\" value in <param>"));
+		else if(layer->get_param(param_name).get_type()==type_canvas)
+		{
+			String warnings;
+			Canvas::Handle c(canvas->surefind_canvas(str, warnings));
+			warnings_text += warnings;
+			if(!c) error(child,strprintf(_("Failed to load subcanvas '%s'"), str.c_str()));
+			if(!layer->set_param(param_name,c))
+				error(child,_("Layer rejected canvas link"));
+			//Parse the static option and sets it to the canvas ValueBase
+			ValueBase v=layer->get_param(param_name);
+			v.set_static(parse_static(child));
+			layer->set_param(param_name, v);
+		}
+		else
+		try
+		{
+			ValueNode::Handle value_node=canvas->surefind_value_node(str);
+			if(PlaceholderValueNode::Handle::cast_dynamic(value_node))
+				throw Exception::IDNotFound("parse_layer()");
 
-				if(!data.is_valid())
-				{
-					error((*iter),_("Bad data for <param>"));
-					continue;
-				}
-			}
-			else	// ... otherwise, we assume that it is a ValueNode
+			// Assign the value_node to the dynamic parameter list
+			if (param_name == "segment_list" && (layer->get_name() == "region" || layer->get_name() == "outline"))
 			{
-				value_node=parse_value_node(dynamic_cast<xmlpp::Element*>(*iter),canvas);
-
-				if(!value_node)
-				{
-					error((*iter),_("Bad data for <param>"));
-					continue;
-				}
+				synfig::warning("%s: Updated valuenode connection to use the \"bline\" parameter instead of \"segment_list\".",
+								layer->get_name().c_str());
+				param_name = "bline";
 			}
 
-			// NB: this part of code has copy above
+			// NB: this part of code has copy in set_layer_param()
 			bool processed = false;
-			if (old_pastecanvas)
+			if (state.old_pastecanvas)
 			{
 				processed = true;
-				bool is_const = !value_node;
-				ValueNode::Handle node = value_node ? value_node : ValueNode_Const::create(data,canvas);
 				if (param_name == "origin")
 				{
-					// ice0: check here 
-					if (!is_const) origin_const = false;
-					offset_node->set_link("lhs", node);
+					state.origin_const = false;
+					state.offset_node->set_link("lhs", value_node);
 				}
 				else
 				if (param_name == "focus")
 				{
-					if (!is_const) focus_const = false;
-					origin_node = node;
-					layer->connect_dynamic_param("origin_node", ValueNode::Handle(origin_node));
-					offset_node->set_link("rhs", node);
+					state.focus_const = false;
+					state.origin_node = value_node;
+					layer->connect_dynamic_param("origin_node", ValueNode::Handle(state.origin_node));
+					state.offset_node->set_link("rhs", value_node);
 				}
 				else
 				if (param_name == "zoom")
 				{
-					if (!is_const) zoom_const = false;
-					scale_node->set_link("exp", node);
+					state.zoom_const = false;
+					state.scale_node->set_link("exp", value_node);
 				}
 				else
 					processed = false;
 			}
 
-			if (!processed)
-			{
-				if (value_node) {
-					// Assign the value_node to the dynamic parameter list
-					layer->connect_dynamic_param(param_name,value_node);
-				} else {
-					// Set the layer's parameter, and make sure that
-					// the layer linked it
-					if(!layer->set_param(param_name,data))
-					{
-						// TODO(ice0): Add normal version comparison function (check glib)
-						// TODO(ice0): Remove stubs after updating image files (.sif)
-						if (param_name == "loopyness" && layer->get_name() == "outline" && (layer->get_version() == "0.3")) {
-							continue;
-						}
+			if (!processed) layer->connect_dynamic_param(param_name,value_node);
+		}
+		catch(Exception::IDNotFound&)
+		{
+			error(child,strprintf(_("Unknown ID (%s) referenced in parameter \"%s\""),str.c_str(), param_name.c_str()));
+		}
 
-						if (param_name == "falloff" && layer->get_name() == "circle" && (layer->get_version() == "0.2")) {
-							continue;
-						}
+		return;
+	}
 
-						if (param_name == "fast" && layer->get_name() == "advanced_outline" && (layer->get_version() == "0.3")) {
-							continue;
-						}
+	xmlpp::Element::NodeList::iterator iter;
 
-						if (param_name == "enable_transformation" && layer->get_name() == "group" && (layer->get_version() == "0.3")) {
-							continue;
-						}
+	// Search for the first non-text XML element
+	for(iter = list.begin(); iter != list.end(); ++iter)
+		if(dynamic_cast<xmlpp::Element*>(*iter))
+			break;
+		//if(!(!dynamic_cast<xmlpp::Element*>(*iter) && (*iter)->get_name()=="text"||(*iter)->get_name()=="comment"   )) break;
 
+	if(iter==list.end())
+	{
+		error(child,_("<param> is either missing its contents, or missing a \"use\" attribute."));
+		return;
+	}
 
-						warning((*iter),strprintf(_("Layer '%s' rejected value for parameter '%s'"),
-												  element->get_attribute("type")->get_value().c_str(),
-												  param_name.c_str()));
-						continue;
-					}
-				}
-			}
+	if(!parse_layer_param_value(dynamic_cast<xmlpp::Element*>(*iter),layer,canvas,param_name,state))
+		return;
 
-			// Warn if there is trash after the param value
-			for (++iter; iter != list.end(); ++iter)
-				if(dynamic_cast<xmlpp::Element*>(*iter))
-					warning((*iter),strprintf(_("Unexpected element <%s> after <param> data, ignoring..."),(*iter)->get_name().c_str()));
-			continue;
+	// Warn if there is trash after the param value
+	for (++iter; iter != list.end(); ++iter)
+		if(dynamic_cast<xmlpp::Element*>(*iter))
+			warning((*iter),strprintf(_("Unexpected element <%s> after <param> data, ignoring..."),(*iter)->get_name().c_str()));
+}
+
+bool
+CanvasParser::parse_layer_param_value(xmlpp::Element *element,Layer::Handle layer,Canvas::Handle canvas,const String &param_name,LayerState &state)
+{
+	ValueBase data;
+	ValueNode::Handle value_node;
+
+	// If we recognize the element name as a
+	// ValueBase, then treat is at one
+	if(/*element->get_name()!="canvas" && */ValueBase::ident_type(element->get_name()) != type_nil && !element->get_attribute("guid"))
+	{
+		data=parse_value(element,canvas);
+
+		if(!data.is_valid())
+		{
+			error(element,_("Bad data for <param>"));
+			return false;
+		}
+	}
+	else	// ... otherwise, we assume that it is a ValueNode
+	{
+		value_node=parse_value_node(element,canvas);
+
+		if(!value_node)
+		{
+			error(element,_("Bad data for <param>"));
+			return false;
+		}
+	}
+
+	return set_layer_param(element,layer,canvas,param_name,data,value_node,state);
+}
+
+bool
+CanvasParser::set_layer_param(xmlpp::Element *element,Layer::Handle layer,Canvas::Handle canvas,const String &param_name,const ValueBase &data,ValueNode::Handle value_node,LayerState &state)
+{
+	// NB: this part of code has copy in parse_layer_param()
+	bool processed = false;
+	if (state.old_pastecanvas)
+	{
+		processed = true;
+		bool is_const = !value_node;
+		ValueNode::Handle node = value_node ? value_node : ValueNode_Const::create(data,canvas);
+		if (param_name == "origin")
+		{
+			// ice0: check here 
+			if (!is_const) state.origin_const = false;
+			state.offset_node->set_link("lhs", node);
 		}
 		else
+		if (param_name == "focus")
 		{
-			printf("%s:%d\n", __FILE__, __LINE__);
-			error_unexpected_element(child,child->get_name());
+			if (!is_const) state.focus_const = false;
+			state.origin_node = node;
+			layer->connect_dynamic_param("origin_node", ValueNode::Handle(state.origin_node));
+			state.offset_node->set_link("rhs", node);
 		}
+		else
+		if (param_name == "zoom")
+		{
+			if (!is_const) state.zoom_const = false;
+			state.scale_node->set_link("exp", node);
+		}
+		else
+			processed = false;
 	}
 
+	if (!processed)
+	{
+		if (value_node) {
+			// Assign the value_node to the dynamic parameter list
+			layer->connect_dynamic_param(param_name,value_node);
+		} else {
+			// Set the layer's parameter, and make sure that
+			// the layer linked it
+			if(!layer->set_param(param_name,data))
+			{
+				// TODO(ice0): Add normal version comparison function (check glib)
+				// TODO(ice0): Remove stubs after updating image files (.sif)
+				if (param_name == "loopyness" && layer->get_name() == "outline" && (layer->get_version() == "0.3")) {
+					return false;
+				}
+
+				if (param_name == "falloff" && layer->get_name() == "circle" && (layer->get_version() == "0.2")) {
+					return false;
+				}
+
+				if (param_name == "fast" && layer->get_name() == "advanced_outline" && (layer->get_version() == "0.3")) {
+					return false;
+				}
+
+				if (param_name == "enable_transformation" && layer->get_name() == "group" && (layer->get_version() == "0.3")) {
+					return false;
+				}
+
+
+				warning(element,strprintf(_("Layer '%s' rejected value for parameter '%s'"),
+										  state.type.c_str(),
+										  param_name.c_str()));
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void
+CanvasParser::parse_layer_end(xmlpp::Element *element,Layer::Handle layer,Canvas::Handle canvas,LayerState &state)
+{
+	const String &version = state.version;
+
 	// Simplify old pastecanvas conversion
-	if (old_pastecanvas) {
-		bool focus_zero = focus_const && (*origin_node)(0).get(Vector()) == Vector(0,0);
-		bool zoom_zero = zoom_const && (*scale_node->get_link("exp"))(0).get(Real()) == 0;
-		if (origin_const && focus_const && zoom_const)
-		{
-			ValueBase origin = (*origin_node)(0);
-			transformation_node->set_link("offset", ValueNode_Const::create((*offset_node)(0), canvas));
-			transformation_node->set_link("scale", ValueNode_Const::create((*scale_scalar_node)(0), canvas));
+	if (state.old_pastecanvas) {
+		bool focus_zero = state.focus_const && (*state.origin_node)(0).get(Vector()) == Vector(0,0);
+		bool zoom_zero = state.zoom_const && (*state.scale_node->get_link("exp"))(0).get(Real()) == 0;
+		if (state.origin_const && state.focus_const && state.zoom_const)
+		{
+			ValueBase origin = (*state.origin_node)(0);
+			state.transformation_node->set_link("offset", ValueNode_Const::create((*state.offset_node)(0), canvas));
+			state.transformation_node->set_link("scale", ValueNode_Const::create((*state.scale_scalar_node)(0), canvas));
 			layer->disconnect_dynamic_param("origin");
 			layer->set_param("origin", origin);
 		} else {
-			if (origin_const && focus_const)
+			if (state.origin_const && state.focus_const)
 			{
-				ValueBase origin = (*origin_node)(0);
+				ValueBase origin = (*state.origin_node)(0);
 				layer->disconnect_dynamic_param("origin");
 				layer->set_param("origin", origin);
-				transformation_node->set_link("offset", ValueNode_Const::create((*offset_node)(0), canvas));
+				state.transformation_node->set_link("offset", ValueNode_Const::create((*state.offset_node)(0), canvas));
 			} else
 			if (focus_zero)
 			{
 				layer->disconnect_dynamic_param("origin");
-				transformation_node->set_link("offset", offset_node->get_link("lhs"));
+				state.transformation_node->set_link("offset", state.offset_node->get_link("lhs"));
 			}
 			else
-			if (focus_const)
+			if (state.focus_const)
 			{
-				ValueBase origin = (*origin_node)(0);
+				ValueBase origin = (*state.origin_node)(0);
 				layer->disconnect_dynamic_param("origin");
 				layer->set_param("origin", origin);
 			}
 
 			if (zoom_zero)
-				transformation_node->set_link("scale", ValueNode_Const::create(ValueBase(Vector(1,1)), canvas));
+				state.transformation_node->set_link("scale", ValueNode_Const::create(ValueBase(Vector(1,1)), canvas));
 			else
-			if (zoom_const)
-				transformation_node->set_link("scale", ValueNode_Const::create((*scale_scalar_node)(0), canvas));
+			if (state.zoom_const)
+				state.transformation_node->set_link("scale", ValueNode_Const::create((*state.scale_scalar_node)(0), canvas));
 		}
 	}
 
@@ -3134,13 +3338,35 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 	}
 
 	layer->reset_version();
-	return layer;
 }
 
 Canvas::Handle
 CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
 {
+	bool existing;
+	Canvas::Handle canvas(parse_canvas_header(element,parent,inline_,identifier,filename,existing));
+	if(!canvas || existing)
+		return canvas;
+
+	xmlpp::Element::NodeList list = element->get_children();
+	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	{
+		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
+		if(child)
+			parse_canvas_child(child,canvas);
+//		else
+//		if((child->get_name()=="text"||child->get_name()=="comment") && child->has_child_text())
+//			continue;
+	}
 
+	parse_canvas_end(element,canvas);
+	return canvas;
+}
+
+Canvas::Handle
+CanvasParser::parse_canvas_header(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename,bool &existing)
+{
+	existing=false;
 	if(element->get_name()!="canvas")
 	{
 		error_unexpected_element(element,element->get_name(),"canvas");
@@ -3186,7 +3412,10 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 	{
 		GUID guid(element->get_attribute("guid")->get_value());
 		if(guid_cast<Canvas>(guid))
+		{
+			existing=true;
 			return guid_cast<Canvas>(guid);
+		}
 		else
 			canvas->set_guid(guid);
 	}
@@ -3306,165 +3535,162 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 	}
 
 	canvas->rend_desc().set_flags(RendDesc::PX_ASPECT|RendDesc::IM_SPAN);
+	return canvas;
+}
 
-	std::list<ValueNode::Handle> bone_list;
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+void
+CanvasParser::parse_canvas_child(xmlpp::Element *child,Canvas::Handle canvas)
+{
+	if(child->get_name()=="defs")
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(child)
+		if(canvas->is_inline())
+			error(child,_("Group canvases cannot have a <defs> section"));
+		parse_canvas_defs(child, canvas);
+	}
+	else
+	if(child->get_name()=="bones")
+	{
+		if(canvas->is_inline())
+			error(child,_("Inline canvas cannot have a <bones> section"));
+		parse_canvas_bones(child, canvas);
+	}
+	else
+	if(child->get_name()=="keyframe")
+	{
+		if(canvas->is_inline())
 		{
-			if(child->get_name()=="defs")
-			{
-				if(canvas->is_inline())
-					error(child,_("Group canvases cannot have a <defs> section"));
-				parse_canvas_defs(child, canvas);
-			}
-			else
-			if(child->get_name()=="bones")
-			{
-				if(canvas->is_inline())
-					error(child,_("Inline canvas cannot have a <bones> section"));
-				bone_list = parse_canvas_bones(child, canvas);
-			}
-			else
-			if(child->get_name()=="keyframe")
-			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have keyframes"));
-					continue;
-				}
+			warning(child,_("Group canvases cannot have keyframes"));
+			return;
+		}
 
-				canvas->keyframe_list().add(parse_keyframe(child,canvas));
-				canvas->keyframe_list().sync();
-			}
-			else
-			if(child->get_name()=="meta")
-			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have metadata"));
-					continue;
-				}
+		canvas->keyframe_list().add(parse_keyframe(child,canvas));
+		canvas->keyframe_list().sync();
+	}
+	else
+	if(child->get_name()=="meta")
+	{
+		if(canvas->is_inline())
+		{
+			warning(child,_("Group canvases cannot have metadata"));
+			return;
+		}
 
-				if(!child->get_attribute("name"))
-				{
-					warning(child,_("<meta> must have a name"));
-					continue;
-				}
+		if(!child->get_attribute("name"))
+		{
+			warning(child,_("<meta> must have a name"));
+			return;
+		}
 
-				if(!child->get_attribute("content"))
-				{
-					warning(child,_("<meta> must have content"));
-					continue;
-				}
-				
-				std::string meta_name = child->get_attribute("name")->get_value();
-				std::string content = child->get_attribute("content")->get_value();
-
-				// In Synfig prior to version 1.0 we have messed decimal separator:
-				// some files use ".", but other ones use ","/
-				// Let's try to put a workaround for that.
-				std::vector<String> replacelist;
-				replacelist.push_back("background_first_color");
-				replacelist.push_back("background_second_color");
-				replacelist.push_back("background_size");
-				replacelist.push_back("grid_color");
-				replacelist.push_back("grid_size");
-				replacelist.push_back("jack_offset");
-				if(std::find(replacelist.begin(), replacelist.end(), meta_name) != replacelist.end())
-				{
-					size_t index = 0;
-					while (true) {
-					     /* Locate the substring to replace. */
-					     index = content.find(',', index);
-					     if (index == std::string::npos) break;
+		if(!child->get_attribute("content"))
+		{
+			warning(child,_("<meta> must have content"));
+			return;
+		}
+		
+		std::string meta_name = child->get_attribute("name")->get_value();
+		std::string content = child->get_attribute("content")->get_value();
+
+		// In Synfig prior to version 1.0 we have messed decimal separator:
+		// some files use ".", but other ones use ","/
+		// Let's try to put a workaround for that.
+		std::vector<String> replacelist;
+		replacelist.push_back("background_first_color");
+		replacelist.push_back("background_second_color");
+		replacelist.push_back("background_size");
+		replacelist.push_back("grid_color");
+		replacelist.push_back("grid_size");
+		replacelist.push_back("jack_offset");
+		if(std::find(replacelist.begin(), replacelist.end(), meta_name) != replacelist.end())
+		{
+			size_t index = 0;
+			while (true) {
+			     /* Locate the substring to replace. */
+			     index = content.find(',', index);
+			     if (index == std::string::npos) break;
 
-					     /* Make the replacement. */
-					     content.replace(index, 1, ".");
+			     /* Make the replacement. */
+			     content.replace(index, 1, ".");
 
-					     /* Advance index forward so the next iteration doesn't pick it up as well. */
-					     index += 1;
-					}
-					
-				}
+			     /* Advance index forward so the next iteration doesn't pick it up as well. */
+			     index += 1;
+			}
+			
+		}
 
-				// Commit b172e37 (#2777) changed guide lines storage to give them rotation ability
-				if (meta_name == "guide_x") {
-					upgrade_guide_metadata(content, canvas->get_meta_data("guide"), true);
-					meta_name = "guide";
-				}
+		// Commit b172e37 (#2777) changed guide lines storage to give them rotation ability
+		if (meta_name == "guide_x") {
+			upgrade_guide_metadata(content, canvas->get_meta_data("guide"), true);
+			meta_name = "guide";
+		}
 
-				if (meta_name == "guide_y") {
-					upgrade_guide_metadata(content, canvas->get_meta_data("guide"), false);
-					meta_name = "guide";
-				}
+		if (meta_name == "guide_y") {
+			upgrade_guide_metadata(content, canvas->get_meta_data("guide"), false);
+			meta_name = "guide";
+		}
 
-				canvas->set_meta_data(meta_name, content);
-			}
-			else if(child->get_name()=="name")
-			{
-				xmlpp::Element::NodeList list = child->get_children();
+		canvas->set_meta_data(meta_name, content);
+	}
+	else if(child->get_name()=="name")
+	{
+		xmlpp::Element::NodeList list = child->get_children();
 
-				// If we don't have any name, warn
-				if(list.empty())
-					warning(child,_("blank \"name\" entity"));
+		// If we don't have any name, warn
+		if(list.empty())
+			warning(child,_("blank \"name\" entity"));
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_name(tmp);
-			}
-			else
-			if(child->get_name()=="desc")
-			{
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_name(tmp);
+	}
+	else
+	if(child->get_name()=="desc")
+	{
 
-				xmlpp::Element::NodeList list = child->get_children();
+		xmlpp::Element::NodeList list = child->get_children();
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"desc\" entity"));
+		// If we don't have any description, warn
+		if(list.empty())
+			warning(child,_("blank \"desc\" entity"));
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_description(tmp);
-			}
-			else
-			if(child->get_name()=="author")
-			{
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_description(tmp);
+	}
+	else
+	if(child->get_name()=="author")
+	{
 
-				xmlpp::Element::NodeList list = child->get_children();
+		xmlpp::Element::NodeList list = child->get_children();
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"author\" entity"));
+		// If we don't have any description, warn
+		if(list.empty())
+			warning(child,_("blank \"author\" entity"));
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_author(tmp);
-			}
-			else
-			if(child->get_name()=="layer")
-			{
-				//if(canvas->is_inline())
-				//	canvas->push_front(parse_layer(child,canvas->parent()));
-				//else
-					canvas->push_front(parse_layer(child,canvas));
-			}
-			else
-			{
-				printf("%s:%d\n", __FILE__, __LINE__);
-				error_unexpected_element(child,child->get_name());
-			}
-		}
-//		else
-//		if((child->get_name()=="text"||child->get_name()=="comment") && child->has_child_text())
-//			continue;
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_author(tmp);
 	}
+	else
+	if(child->get_name()=="layer")
+	{
+		//if(canvas->is_inline())
+		//	canvas->push_front(parse_layer(child,canvas->parent()));
+		//else
+			canvas->push_front(parse_layer(child,canvas));
+	}
+	else
+	{
+		printf("%s:%d\n", __FILE__, __LINE__);
+		error_unexpected_element(child,child->get_name());
+	}
+}
 
+void
+CanvasParser::parse_canvas_end(xmlpp::Element *element,Canvas::Handle canvas)
+{
 	if(canvas->value_node_list().placeholder_count())
 	{
 		String nodes;
@@ -3482,7 +3708,178 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 	}
 
 	canvas->set_version(CURRENT_CANVAS_VERSION);
-	return canvas;
+}
+
+bool
+CanvasParser::stream_canvas(XmlStreamReader &reader,xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename,Canvas::Handle &canvas)
+{
+	bool existing = false;
+	reader.call([&]() { canvas = parse_canvas_header(element,parent,inline_,identifier,filename,existing); });
+	const bool parse = canvas && !existing;
+
+	const bool ok = reader.for_each_child([&]() -> int {
+		if (!parse)
+			return xmlTextReaderNext(reader.reader);
+		return stream_canvas_child(reader,canvas);
+	});
+	if (ok && parse)
+		reader.call([&]() { parse_canvas_end(element,canvas); });
+	return ok;
+}
+
+int
+CanvasParser::stream_canvas_child(XmlStreamReader &reader,Canvas::Handle canvas)
+{
+	const String name = reader.get_name();
+	if (name == "layer")
+		return stream_layer(reader,canvas);
+
+	if (name != "defs")
+		return reader.expand([&](xmlpp::Element *child) { parse_canvas_child(child,canvas); });
+
+	// exported canvases are read by their children, as the root one
+	xmlpp::Element *element = reader.wrap();
+	reader.call([&]() {
+		if(canvas->is_inline())
+			error(element,_("Group canvases cannot have a <defs> section"));
+	});
+	const bool ok = reader.for_each_child([&]() -> int {
+		if (reader.get_name() != "canvas")
+			return reader.expand([&](xmlpp::Element *child) { parse_value_node(child,canvas); });
+
+		xmlpp::Element *child = reader.wrap();
+		Canvas::Handle exported;
+		return reader.next(child, stream_canvas(reader,child,canvas,false,FileSystemNative::instance()->get_identifier(std::string()),".",exported));
+	});
+	return reader.next(element,ok);
+}
+
+int
+CanvasParser::stream_layer(XmlStreamReader &reader,Canvas::Handle canvas)
+{
+	xmlpp::Element *element = reader.wrap();
+	LayerState state;
+	Layer::Handle layer;
+	reader.call([&]() { layer = parse_layer_header(element,canvas,state); });
+
+	// contents of the rejected layer are not parsed, as by parse_layer()
+	const bool ok = reader.for_each_child([&]() -> int {
+		if (!layer)
+			return xmlTextReaderNext(reader.reader);
+		return stream_layer_param(reader,layer,canvas,state);
+	});
+	if (ok)
+		reader.call([&]() {
+			if (layer)
+				parse_layer_end(element,layer,canvas,state);
+			canvas->push_front(layer);
+		});
+	return reader.next(element,ok);
+}
+
+int
+CanvasParser::stream_layer_param(XmlStreamReader &reader,Layer::Handle layer,Canvas::Handle canvas,LayerState &state)
+{
+	// only parameters of canvas type are read by their children,
+	// the rest is small enough to be parsed as a whole
+	bool stream = reader.parse
+	           && !xmlTextReaderIsEmptyElement(reader.reader)
+	           && reader.get_name() == "param"
+	           && !reader.has_attribute("use");
+	String param_name;
+	if (stream)
+	{
+		xmlChar *name = xmlTextReaderGetAttribute(reader.reader, (const xmlChar*)"name");
+		if (name)
+			param_name = (const char*)name;
+		xmlFree(name);
+		stream = !param_name.empty() && layer->get_param(param_name).get_type() == type_canvas;
+	}
+	if (!stream)
+		return reader.expand([&](xmlpp::Element *child) { parse_layer_child(child,layer,canvas,state); });
+
+	xmlpp::Element *element = reader.wrap();
+	bool found = false;
+	bool check_trash = false;
+	const bool ok = reader.for_each_child([&]() -> int {
+		if (found)
+		{
+			// Warn if there is trash after the param value
+			if (!check_trash)
+				return xmlTextReaderNext(reader.reader);
+			return reader.expand([&](xmlpp::Element *child) {
+				warning(child,strprintf(_("Unexpected element <%s> after <param> data, ignoring..."),child->get_name().c_str()));
+			});
+		}
+		found = true;
+
+		if (reader.get_name() != "canvas" || reader.has_attribute("guid"))
+			return reader.expand([&](xmlpp::Element *child) {
+				check_trash = parse_layer_param_value(child,layer,canvas,param_name,state);
+			});
+
+		// inline canvas, as parse_value() reads it
+		xmlpp::Element *child = reader.wrap();
+		Canvas::Handle inline_canvas;
+		const bool read = stream_canvas(reader,child,canvas,true,FileSystemNative::instance()->get_identifier(std::string()),".",inline_canvas);
+		if (read)
+			reader.call([&]() {
+				ValueBase data;
+				data.set(inline_canvas);
+				data.set_static(parse_static(child));
+				check_trash = set_layer_param(child,layer,canvas,param_name,data,ValueNode::Handle(),state);
+			});
+		return reader.next(child,read);
+	});
+	if (ok && !found)
+		reader.call([&]() { error(element,_("<param> is either missing its contents, or missing a \"use\" attribute.")); });
+	return reader.next(element,ok);
+}
+
+bool
+CanvasParser::parse_canvas_stream(FileSystem::ReadStream &stream,const FileSystem::Identifier &identifier,Canvas::Handle &canvas,String &xml_errors)
+{
+	XmlStreamReader reader(stream, filename);
+	if (!reader.reader)
+		return false;
+
+	// Messages and exceptions of the parser are held until the end of the file,
+	// xml errors found later are reported first, as DOM parser does
+	held_messages_.clear();
+	hold_messages_ = true;
+
+	int ret;
+	while((ret = xmlTextReaderRead(reader.reader)) == 1 && xmlTextReaderNodeType(reader.reader) != XML_READER_TYPE_ELEMENT) { }
+
+	if (ret == 1 && reader.ok())
+	{
+		xmlpp::Element *root = reader.wrap();
+		ret = reader.next(root, stream_canvas(reader,root,0,false,identifier,filename,canvas));
+	}
+	else
+	{
+		ret = -1;
+	}
+
+	// comments after the root element
+	while(ret == 1 && reader.ok())
+		ret = xmlTextReaderRead(reader.reader);
+
+	if (ret < 0 || !reader.ok())
+	{
+		release_held_messages(false);
+		xml_errors = reader.errors;
+		canvas = Canvas::Handle();
+		return false;
+	}
+
+	release_held_messages(true);
+	if (reader.failure)
+	{
+		canvas = Canvas::Handle();
+		std::rethrow_exception(reader.failure);
+	}
+	return true;
 }
 
 void
@@ -3526,18 +3923,52 @@ CanvasParser::parse_from_file_as(const FileSystem::Identifier &identifier,const
 		total_warnings_=0;
 		
 		synfig::info(String("Loading file: ") + filename);
-		FileSystem::ReadStream::Handle stream = identifier.get_read_stream();
+		FileSystem::ReadStream::Handle stream = _open_canvas_stream(identifier);
 		if (stream)
 		{
-			if (identifier.filename.extension().u8string() == ".sifz")
-				stream = FileSystem::ReadStream::Handle(new ZReadStream(stream, zstreambuf::compression::gzip));
+			Canvas::Handle canvas;
+			bool parsed = false;
+
+			// Canvases and layers are parsed while the file is read, only the xml tree
+			// of the current element and its ancestors is kept in memory. Any xml error
+			// or warning makes DOM parser reject the file too, so then it is read again
+			// to report the same message. Set SYNFIG_STREAM_LOADING=0 to disable.
+			const char *s = getenv("SYNFIG_STREAM_LOADING");
+			if (s == nullptr || atoi(s) != 0)
+			{
+				const int errors_count = total_errors_;
+				const String errors_before = errors_text;
+				const String warnings_before = warnings_text;
+				String xml_errors;
+				parsed = parse_canvas_stream(*stream,identifier,canvas,xml_errors);
+				if (!parsed)
+				{
+					// read the file again by DOM parser, it reports xml errors as before
+					synfig::info("Streaming load of %s failed, using DOM parser", filename.c_str());
+					total_errors_ = errors_count;
+					total_warnings_ = 0;
+					errors_text = errors_before;
+					warnings_text = warnings_before;
+					stream = _open_canvas_stream(identifier);
+					if (!stream)
+						throw std::runtime_error(xml_errors);
+				}
+			}
 
 			xmlpp::DomParser parser;
-			parser.parse_stream(*stream);
+			if (!parsed)
+			{
+				parser.parse_stream(*stream);
+				if (parser)
+				{
+					canvas = parse_canvas(parser.get_document()->get_root_node(),0,false,identifier,as);
+					parsed = true;
+				}
+			}
 			stream.reset();
-			if(parser)
+
+			if (parsed)
 			{
-				Canvas::Handle canvas(parse_canvas(parser.get_document()->get_root_node(),0,false,identifier,as));
 				if (!canvas) return canvas;
 				register_canvas_in_map(canvas, as);
 
@@ -87,6 +87,10 @@ private:
 	GUID guid_;
 	//
 	bool in_bones_section;
+	//! True while messages are held back instead of being printed
+	bool hold_messages_;
+	//! Held messages, the flag is true for warnings and false for errors
+	std::vector<std::pair<bool, String> > held_messages_;
 
 	/*
  --	** -- C O N S T R U C T O R S ---------------------------------------------
@@ -99,7 +103,8 @@ public:
 		total_warnings_	(0),
 		total_errors_	(0),
 		allow_errors_	(false),
-		in_bones_section(false)
+		in_bones_section(false),
+		hold_messages_	(false)
 	{ }
 
 	/*
@@ -154,12 +159,19 @@ public:
 
 private:
 
+	//! Parsing state of <layer>, shared by its parameters
+	struct LayerState;
+	//! Text reader of libxml2 used by streaming parser
+	struct XmlStreamReader;
+
 	//! Error handling function
 	void error(xmlpp::Node *node,const String &text);
 	//! Fatal Error handling function
 	void fatal_error(xmlpp::Node *node,const String &text);
 	//! Warning handling function
 	void warning(xmlpp::Node *node,const String &text);
+	//! Prints held messages, or drops them if \a print is false
+	void release_held_messages(bool print);
 	//! Unexpected element error handling function
 	void error_unexpected_element(xmlpp::Node *node,const String &got, const String &expected);
 	//! Unexpected element error handling function
@@ -167,6 +179,23 @@ private:
 
 	//! Canvas Parsing Function
 	Canvas::Handle parse_canvas(xmlpp::Element *node,Canvas::Handle parent=0,bool inline_=false,const FileSystem::Identifier &identifier = FileSystemNative::instance()->get_identifier(std::string()),String path=".");
+	//! Creates Canvas from attributes of <canvas>, \a existing is set if canvas with the same GUID is already loaded
+	Canvas::Handle parse_canvas_header(xmlpp::Element *node,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String path,bool &existing);
+	//! Parses one child element of <canvas>
+	void parse_canvas_child(xmlpp::Element *node,Canvas::Handle canvas);
+	//! Checks for undefined ValueNodes after all children of <canvas> are parsed
+	void parse_canvas_end(xmlpp::Element *node,Canvas::Handle canvas);
+	//! Parses the root Canvas while the stream is read, returns false if the stream is not a well-formed xml.
+	//! Messages of the parser are printed only if the stream is well-formed.
+	bool parse_canvas_stream(FileSystem::ReadStream &stream,const FileSystem::Identifier &identifier,Canvas::Handle &canvas,String &xml_errors);
+	//! Parses the current <canvas> of \a reader by its children, returns false on xml errors
+	bool stream_canvas(XmlStreamReader &reader,xmlpp::Element *node,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String path,Canvas::Handle &canvas);
+	//! Parses the current child of <canvas>, returns the result of xmlTextReaderRead() after it
+	int stream_canvas_child(XmlStreamReader &reader,Canvas::Handle canvas);
+	//! Parses the current <layer> by its children, returns the result of xmlTextReaderRead() after it
+	int stream_layer(XmlStreamReader &reader,Canvas::Handle canvas);
+	//! Parses the current child of <layer>, returns the result of xmlTextReaderRead() after it
+	int stream_layer_param(XmlStreamReader &reader,etl::handle<Layer> layer,Canvas::Handle canvas,LayerState &state);
 	//! Canvas definitions Parsing Function (exported value nodes and exported canvases)
 	void parse_canvas_defs(xmlpp::Element *node,Canvas::Handle canvas);
 
@@ -174,6 +203,18 @@ private:
 
 	//! Layer Parsing Function
 	etl::handle<Layer> parse_layer(xmlpp::Element *node,Canvas::Handle canvas);
+	//! Creates Layer from attributes of <layer>
+	etl::handle<Layer> parse_layer_header(xmlpp::Element *node,Canvas::Handle canvas,LayerState &state);
+	//! Parses one child element of <layer>
+	void parse_layer_child(xmlpp::Element *node,etl::handle<Layer> layer,Canvas::Handle canvas,LayerState &state);
+	//! Parses <param> of layer
+	void parse_layer_param(xmlpp::Element *node,etl::handle<Layer> layer,Canvas::Handle canvas,LayerState &state);
+	//! Parses the value of <param>, returns false if elements after the value should not be checked
+	bool parse_layer_param_value(xmlpp::Element *node,etl::handle<Layer> layer,Canvas::Handle canvas,const String &param_name,LayerState &state);
+	//! Sets the parsed value of <param>, returns false if elements after the value should not be checked
+	bool set_layer_param(xmlpp::Element *node,etl::handle<Layer> layer,Canvas::Handle canvas,const String &param_name,const ValueBase &data,ValueNode::Handle value_node,LayerState &state);
+	//! Finishes parsing of <layer> after all its children
+	void parse_layer_end(xmlpp::Element *node,etl::handle<Layer> layer,Canvas::Handle canvas,LayerState &state);
 	//! Generic Value Base Parsing Function
 	ValueBase parse_value(xmlpp::Element *node,Canvas::Handle canvas);
 	//! Generic Value Node Parsing Function
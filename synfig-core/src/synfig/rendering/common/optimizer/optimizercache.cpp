@@ -0,0 +1,192 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizercache.cpp
+**	\brief OptimizerCache
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
+
+#include "optimizercache.h"
+
+#include "../task/taskcache.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+OptimizerCache::OptimizerCache(
+	const TaskCacheStorage::Handle &storage,
+	const Surface::Token::Handle &storage_token
+):
+	storage(storage),
+	storage_token(storage_token)
+{
+	category_id = CATEGORY_ID_COORDS;
+	depends_from = CATEGORY_BEGIN;
+	for_root_task = true;
+}
+
+TaskCacheStorage::Key
+OptimizerCache::get_key(const Task &task, const Task::HashMap &hashes, bool &found) const
+{
+	Task::HashMap::const_iterator i = hashes.find(&task);
+	found = i != hashes.end();
+	if (!found || !storage_token)
+		return found ? i->second : TaskCacheStorage::Key();
+
+	// results in different formats are stored separately
+	TaskHash hash;
+	hash << i->second;
+	hash.add(storage_token->name.data(), storage_token->name.size());
+	return hash.get();
+}
+
+void
+OptimizerCache::release_recursive(const Task::Handle &task, const Task::HashMap &hashes) const
+{
+	for(Task::List::const_iterator i = task->sub_tasks.begin(); i != task->sub_tasks.end(); ++i) {
+		if (!*i) continue;
+		bool found;
+		TaskCacheStorage::Key key = get_key(**i, hashes, found);
+		if (found)
+			storage->release(key);
+		release_recursive(*i, hashes);
+	}
+}
+
+Task::Handle
+OptimizerCache::optimize_recursive(const Task::Handle &task, const Task::HashMap &hashes) const
+{
+	//
+	// the biggest sub-tree is checked first
+	//
+	//  taskA(targetA) - found in storage
+	//  - taskB(targetB)
+	//
+	// converts to:
+	//
+	//  cacheA(targetA)
+	//  - surfaceC(targetC) - stored result of taskA
+	//
+	//  taskA(targetA) - was met in previous frame
+	//  - taskB(targetB)
+	//
+	// converts to:
+	//
+	//  cacheA(targetA) - puts targetC into storage
+	//  - taskA(targetC)
+	//    - taskB(targetB)
+	//
+
+	if ( !task
+	  || task.type_is<TaskSurface>()
+	  || task.type_is<TaskCache>() )
+		return task;
+
+	bool found = false;
+	TaskCacheStorage::Key key = task->is_valid() ? get_key(*task, hashes, found) : TaskCacheStorage::Key();
+	if (found) {
+		const TaskCacheStorage::Signature signature(*task);
+		SurfaceResource::Handle surface;
+		RectInt rect;
+		TaskCacheStorage::Status status = storage->find(key, signature, surface, rect);
+		if (status != TaskCacheStorage::STATUS_NEW) {
+			// sub-trees will not be met while the result of this one is reused
+			release_recursive(task, hashes);
+
+			TaskCache::Handle cache(new TaskCache());
+			cache->assign_target(*task);
+
+			if (status == TaskCacheStorage::STATUS_FOUND) {
+				Task::Handle sub_task(new TaskSurface());
+				sub_task->source_rect = task->source_rect;
+				sub_task->target_rect = rect;
+				sub_task->target_surface = surface;
+				cache->sub_task() = sub_task;
+			} else {
+				// stored surface should never be touched by parent tasks,
+				// so move the sub-tree to the separate surface
+				Task::Handle sub_target(new TaskSurface());
+				sub_target->assign_target(*task);
+				sub_target->target_surface = new SurfaceResource();
+				sub_target->target_surface->create(task->target_surface->get_size());
+
+				cache->storage = storage;
+				cache->key = key;
+				cache->signature = signature;
+				cache->storage_token = storage_token;
+				cache->sub_task() = replace_target(sub_target, task);
+			}
+			return cache;
+		}
+	}
+
+	// sub-tree is met first time, but its parts may be reused
+	Task::Handle result = task;
+	for(int i = 0; i < (int)task->sub_tasks.size(); ++i) {
+		Task::Handle sub_task = optimize_recursive(task->sub_tasks[i], hashes);
+		if (sub_task != task->sub_tasks[i]) {
+			if (result == task)
+				result = task->clone();
+			result->sub_tasks[i] = sub_task;
+		}
+	}
+	return result;
+}
+
+void
+OptimizerCache::run(const RunParams& params) const
+{
+	if (!storage || !params.ref_task) return;
+
+	// hashes of all sub-trees are calculated once, from leaves to the root
+	Task::HashMap hashes;
+	TaskHash hash;
+	params.ref_task->calc_hash_recursive(hash, &hashes);
+	if (hashes.empty())
+		return;
+
+	Task::Handle task = optimize_recursive(params.ref_task, hashes);
+	if (task != params.ref_task)
+		apply(params, task);
+}
+
+/* === E N T R Y P O I N T ================================================= */
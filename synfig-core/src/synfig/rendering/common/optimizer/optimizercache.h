@@ -0,0 +1,80 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizercache.h
+**	\brief OptimizerCache Header
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_OPTIMIZERCACHE_H
+#define __SYNFIG_RENDERING_OPTIMIZERCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include "../../optimizer.h"
+#include "../task/taskcache.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Replaces sub-trees, which were already rendered in previous frames,
+//! by their results from TaskCacheStorage.
+//! Sub-trees which are met second time are wrapped into TaskCache
+//! to put their results into storage.
+//! Runs once for each root task, hashes of all sub-trees are calculated
+//! in one pass from leaves to the root, so each sub-tree is hashed once.
+//! If storage_token is set then results are stored in this format,
+//! so lossy formats like SurfaceSWPackedHalf may be chosen to keep more
+//! results in the same memory.
+class OptimizerCache: public Optimizer
+{
+public:
+	const TaskCacheStorage::Handle storage;
+	const Surface::Token::Handle storage_token;
+
+	explicit OptimizerCache(
+		const TaskCacheStorage::Handle &storage,
+		const Surface::Token::Handle &storage_token = Surface::Token::Handle() );
+	virtual void run(const RunParams &params) const;
+
+private:
+	//! Key of sub-tree in the storage, \a found is false when sub-tree can not be hashed
+	TaskCacheStorage::Key get_key(const Task &task, const Task::HashMap &hashes, bool &found) const;
+	//! Forgets requests of all sub-trees of \a task
+	void release_recursive(const Task::Handle &task, const Task::HashMap &hashes) const;
+	Task::Handle optimize_recursive(const Task::Handle &task, const Task::HashMap &hashes) const;
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -32,6 +32,8 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+
 #include <synfig/general.h>
 #include <synfig/localization.h>
 
@@ -50,42 +52,84 @@ using namespace rendering;
 
 /* === M E T H O D S ======================================================= */
 
-OptimizerSplit::OptimizerSplit()
+OptimizerSplit::OptimizerSplit(int threads):
+	threads(threads)
 {
 	category_id = CATEGORY_ID_LIST;
 	depends_from = CATEGORY_SPECIALIZED;
 	for_list = true;
 }
 
+std::vector<RectInt>
+OptimizerSplit::split_rect(const RectInt &rect, Real cost, int threads)
+{
+	std::vector<RectInt> parts;
+	if (threads < 2 || !rect.is_valid() || !(cost > 0.0))
+		return parts;
+
+	const int w = rect.maxx - rect.minx;
+	const int h = rect.maxy - rect.miny;
+
+	// count of parts by cost, but not more than threads can take
+	const long long max_count = (long long)threads*parts_per_thread;
+	const Real total_cost = (Real)w*(Real)h*cost;
+	const long long count = total_cost >= (Real)(max_count*min_part_cost)
+	                      ? max_count
+	                      : (long long)(total_cost/min_part_cost);
+	if (count < 2)
+		return parts;
+
+	// full-width bands are preferred, rows of surface stay contiguous
+	const int rows = (int)std::min(count, (long long)std::max(1, h/min_part_size));
+
+	// bands which do not fit into the cache are cut to tiles,
+	// but total count of parts is limited to avoid the overhead of queue
+	const long long band_bytes = (long long)w*((h + rows - 1)/rows)*(long long)sizeof(Color);
+	long long cols = std::max(count/rows, (band_bytes + cache_size - 1)/cache_size);
+	cols = std::min(cols, 4*max_count/rows);
+	cols = std::max(1ll, std::min(cols, (long long)(w/min_part_size)));
+
+	if (rows*cols < 2)
+		return parts;
+
+	parts.reserve(rows*cols);
+	for(int j = 0; j < rows; ++j) {
+		const int y0 = rect.miny + (int)((long long)h*j/rows);
+		const int y1 = rect.miny + (int)((long long)h*(j + 1)/rows);
+		for(int i = 0; i < cols; ++i) {
+			const int x0 = rect.minx + (int)((long long)w*i/cols);
+			const int x1 = rect.minx + (int)((long long)w*(i + 1)/cols);
+			parts.push_back(RectInt(x0, y0, x1, y1));
+		}
+	}
+	return parts;
+}
+
 void
 OptimizerSplit::run(const RunParams &params) const
 {
 	if (!params.list) return;
-	const int min_area = 256*256;
 	for(Task::List::iterator i = params.list->begin(); i != params.list->end(); ++i)
 	{
 		if (TaskInterfaceSplit *split = i->type_pointer<TaskInterfaceSplit>())
 		if (split->is_splittable())
 		{
-			RectInt r = (*i)->target_rect;
-			int w = r.maxx - r.minx;
-			int h = r.maxy - r.miny;
-			int t = std::min(h/10, w*h/min_area);
-			if (t >= 2)
+			std::vector<RectInt> parts = split_rect(
+				(*i)->target_rect, split->get_split_pixel_cost(), threads );
+			if (parts.empty())
+				continue;
+
+			Task::Handle task = *i;
+			for(std::vector<RectInt>::const_iterator j = parts.begin(); j + 1 != parts.end(); ++j)
 			{
-				int hh = h/t;
-				int y = r.miny;
-				for(int j = 1; j < t; ++j, y += hh)
-				{
-					Task::Handle task = (*i)->clone();
-					task->trunc_target_rect( RectInt(r.minx, y, r.maxx, y + hh) );
-					i = params.list->insert(i, task);
-					++i;
-				}
-				*i = (*i)->clone();
-				(*i)->trunc_target_rect( RectInt(r.minx, y, r.maxx, r.maxy) );
-				apply(params);
+				Task::Handle part = task->clone();
+				part->trunc_target_rect(*j);
+				i = params.list->insert(i, part);
+				++i;
 			}
+			*i = task->clone();
+			(*i)->trunc_target_rect(parts.back());
+			apply(params);
 		}
 	}
 }
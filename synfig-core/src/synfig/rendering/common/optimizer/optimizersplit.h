@@ -30,6 +30,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <vector>
+
 #include "../../optimizer.h"
 
 /* === M A C R O S ========================================================= */
@@ -43,11 +45,38 @@ namespace synfig
 namespace rendering
 {
 
+/*!
+ * Splits large tasks (TaskInterfaceSplit) into parts rendered by different threads.
+ *
+ * Cost of the task is estimated as area of its target multiplied
+ * by TaskInterfaceSplit::get_split_pixel_cost(). Cheap tasks are not split,
+ * expensive tasks are cut into several parts for each thread, so threads
+ * can balance the load. Parts are full-width bands when possible,
+ * wide bands are cut to tiles which fit into the cache.
+ */
 class OptimizerSplit: public Optimizer
 {
 public:
-	OptimizerSplit();
+	//! Minimal cost of one part, smaller parts spend more time in the queue than in rendering
+	static const int min_part_cost = 128*128;
+	//! Minimal width and height of one part in pixels
+	static const int min_part_size = 16;
+	//! Desired size of one part in bytes, the part should fit into L2 cache
+	static const int cache_size = 512*1024;
+	//! Count of parts per thread, more parts give better load balancing
+	static const int parts_per_thread = 4;
+
+	//! \param threads count of threads which render tasks simultaneously
+	explicit OptimizerSplit(int threads);
+
+	//! Returns parts of \a rect for the task with given \a cost,
+	//! returns empty list when task should not be split
+	SYNFIG_EXPORT static std::vector<RectInt> split_rect(const RectInt &rect, Real cost, int threads);
+
 	virtual void run(const RunParams &params) const;
+
+private:
+	int threads;
 };
 
 } /* end namespace rendering */
@@ -0,0 +1,105 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizersurfaceconvert.cpp
+**	\brief OptimizerSurfaceConvert
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <map>
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
+
+#include "optimizersurfaceconvert.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+OptimizerSurfaceConvert::OptimizerSurfaceConvert(const Surface::Token::Handle &surface_token):
+	surface_token(surface_token)
+{
+	category_id = CATEGORY_ID_LIST;
+	depends_from = CATEGORY_SPECIALIZED;
+	for_list = true;
+}
+
+void
+OptimizerSurfaceConvert::run(const RunParams &params) const
+{
+	if (!params.list || !surface_token) return;
+	Task::List &list = *params.list;
+
+	// index of the last task which draws the surface
+	// and index of the first task which reads it as sub-task
+	typedef std::map<SurfaceResource::Handle, int> Map;
+	Map last_writers, first_readers;
+	for(int i = 0; i < (int)list.size(); ++i) {
+		const Task::Handle &task = list[i];
+		if (!task || !task->is_valid())
+			continue;
+		if (task.type_is<TaskSurfaceConvert>())
+			return; // list is already processed
+		for(Task::List::const_iterator j = task->sub_tasks.begin(); j != task->sub_tasks.end(); ++j)
+			if (*j && (*j)->target_surface && (*j)->target_surface != task->target_surface)
+				first_readers.insert(Map::value_type((*j)->target_surface, i));
+		last_writers[task->target_surface] = i;
+	}
+
+	// insert from the end of list to keep indices valid
+	std::multimap<int, SurfaceResource::Handle> converts;
+	for(Map::const_iterator i = last_writers.begin(); i != last_writers.end(); ++i) {
+		Map::const_iterator reader = first_readers.find(i->first);
+		if (reader != first_readers.end() && i->second < reader->second)
+			converts.insert(std::make_pair(i->second, i->first));
+	}
+	if (converts.empty())
+		return;
+
+	for(std::multimap<int, SurfaceResource::Handle>::const_reverse_iterator i = converts.rbegin(); i != converts.rend(); ++i) {
+		TaskSurfaceConvert::Handle task(new TaskSurfaceConvert());
+		task->assign_target(*list[i->first]);
+		task->target_rect = RectInt(VectorInt::zero(), i->second->get_size());
+		task->surface_token = surface_token;
+		list.insert(list.begin() + i->first + 1, task);
+	}
+	apply(params);
+}
+
+/* === E N T R Y P O I N T ================================================= */
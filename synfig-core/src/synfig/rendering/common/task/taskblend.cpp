@@ -84,4 +84,11 @@ TaskBlend::calc_bounds() const
 	return bounds;
 }
 
+bool
+TaskBlend::calc_hash(TaskHash &hash) const
+{
+	hash << (int)blend_method << amount;
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
@@ -96,4 +96,11 @@ TaskBlur::set_coords_sub_tasks()
 	sub_task()->set_coords(sub_source_rect, sub_target_size);
 }
 
+bool
+TaskBlur::calc_hash(TaskHash &hash) const
+{
+	hash << (int)blur.type << blur.size[0] << blur.size[1];
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,198 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/task/taskcache.cpp
+**	\brief TaskCache
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <synfig/color.h>
+
+#include "taskcache.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+
+SYNFIG_EXPORT Task::Token TaskCache::token(
+	DescAbstract<TaskCache>("Cache") );
+
+
+TaskCacheStorage::TaskCacheStorage(size_t memory_limit):
+	memory_limit(memory_limit),
+	memory_used(),
+	requests_limit(4096)
+{ }
+
+void
+TaskCacheStorage::remove(Map::iterator i)
+{
+	if (i->second.surface) {
+		memory_used -= i->second.size;
+		stored.erase(i->second.position);
+	} else {
+		requested.erase(i->second.position);
+	}
+	entries.erase(i);
+}
+
+void
+TaskCacheStorage::evict()
+{
+	while(memory_used > memory_limit && !stored.empty())
+		remove(entries.find(stored.back()));
+	while(requested.size() > requests_limit)
+		remove(entries.find(requested.back()));
+}
+
+void
+TaskCacheStorage::set_memory_limit(size_t memory_limit)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->memory_limit = memory_limit;
+	evict();
+}
+
+size_t
+TaskCacheStorage::get_memory_limit() const
+	{ std::lock_guard<std::mutex> lock(mutex); return memory_limit; }
+
+size_t
+TaskCacheStorage::get_memory_used() const
+	{ std::lock_guard<std::mutex> lock(mutex); return memory_used; }
+
+TaskCacheStorage::Status
+TaskCacheStorage::find(Key key, const Signature &signature, SurfaceResource::Handle &surface, RectInt &rect)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!memory_limit)
+		return STATUS_NEW;
+
+	Map::iterator i = entries.find(key);
+	if (i == entries.end()) {
+		Entry &entry = entries[key];
+		entry.signature = signature;
+		entry.position = requested.insert(requested.begin(), key);
+		evict();
+		return STATUS_NEW;
+	}
+
+	// collision of hashes, the entry belongs to another sub-tree
+	Entry &entry = i->second;
+	if (entry.signature != signature)
+		return STATUS_NEW;
+
+	KeyList &list = entry.surface ? stored : requested;
+	list.splice(list.begin(), list, entry.position);
+	if (!entry.surface)
+		return STATUS_REQUESTED;
+
+	surface = entry.surface;
+	rect = entry.rect;
+	return STATUS_FOUND;
+}
+
+void
+TaskCacheStorage::store(Key key, const Signature &signature, const SurfaceResource::Handle &surface, const RectInt &rect)
+{
+	if (!surface || !rect.is_valid())
+		return;
+	size_t size = surface->get_memory_size();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size > memory_limit)
+		return;
+
+	Map::iterator i = entries.find(key);
+	if (i != entries.end()) {
+		// result may be already stored by another frame
+		if (i->second.surface)
+			return;
+		remove(i);
+	}
+
+	Entry &entry = entries[key];
+	entry.signature = signature;
+	entry.surface = surface;
+	entry.rect = rect;
+	entry.size = size;
+	entry.position = stored.insert(stored.begin(), key);
+	memory_used += size;
+	evict();
+}
+
+void
+TaskCacheStorage::release(Key key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Map::iterator i = entries.find(key);
+	if (i != entries.end() && !i->second.surface)
+		remove(i);
+}
+
+void
+TaskCacheStorage::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	stored.clear();
+	requested.clear();
+	memory_used = 0;
+}
+
+
+Rect
+TaskCache::calc_bounds() const
+	{ return sub_task() ? sub_task()->get_bounds() : Rect::zero(); }
+
+void
+TaskCache::store() const
+{
+	if (!storage || !sub_task() || !sub_task()->is_valid())
+		return;
+	const SurfaceResource::Handle &surface = sub_task()->target_surface;
+	if (storage_token) {
+		// exclusive lock drops all other formats of the surface
+		SurfaceResource::LockWriteBase lock(surface, storage_token);
+		lock.convert(storage_token);
+	}
+	storage->store(key, signature, surface, sub_task()->target_rect);
+}
+
+/* === E N T R Y P O I N T ================================================= */
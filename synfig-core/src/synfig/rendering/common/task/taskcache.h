@@ -0,0 +1,173 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/task/taskcache.h
+**	\brief TaskCache Header
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_TASKCACHE_H
+#define __SYNFIG_RENDERING_TASKCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <list>
+#include <map>
+#include <mutex>
+
+#include "../../task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+
+//! Keeps results of task sub-trees between frames,
+//! entries are identified by hash of sub-tree (see Task::calc_hash_recursive())
+//! and evicted in least-recently-used order when memory limit is exceeded
+class TaskCacheStorage: public etl::shared_object
+{
+public:
+	typedef etl::handle<TaskCacheStorage> Handle;
+	typedef TaskHash::Value Key;
+
+	//! Parameters of the root task of sub-tree, they are compared on each lookup,
+	//! so results are not reused when different sub-trees have the same hash
+	class Signature {
+	public:
+		Task::Token::Handle token;
+		Rect source_rect;
+		VectorInt target_size;
+
+		Signature() { }
+		explicit Signature(const Task &task):
+			token(task.get_token()),
+			source_rect(task.source_rect),
+			target_size(task.target_rect.get_size()) { }
+
+		bool operator==(const Signature &other) const {
+			return token == other.token
+			    && source_rect == other.source_rect
+			    && target_size == other.target_size;
+		}
+		bool operator!=(const Signature &other) const
+			{ return !(*this == other); }
+	};
+
+	enum Status {
+		STATUS_NEW,       //!< sub-tree is met first time
+		STATUS_REQUESTED, //!< sub-tree was met before, but its result is not stored yet
+		STATUS_FOUND      //!< result of sub-tree is ready
+	};
+
+private:
+	typedef std::list<Key> KeyList;
+
+	struct Entry {
+		Signature signature;
+		SurfaceResource::Handle surface;
+		RectInt rect;
+		size_t size;
+		KeyList::iterator position;
+		Entry(): size() { }
+	};
+
+	typedef std::map<Key, Entry> Map;
+
+	mutable std::mutex mutex;
+	size_t memory_limit;
+	size_t memory_used;
+	size_t requests_limit;
+	Map entries;
+	KeyList stored;    //!< keys of stored results, recently used first
+	KeyList requested; //!< keys of sub-trees without results, recently used first
+
+	void remove(Map::iterator i);
+	void evict();
+
+public:
+	explicit TaskCacheStorage(size_t memory_limit = 0);
+
+	//! Sets max size of stored surfaces in bytes, zero disables the cache
+	void set_memory_limit(size_t memory_limit);
+	size_t get_memory_limit() const;
+	size_t get_memory_used() const;
+
+	//! Searches for the result of sub-tree,
+	//! when not found marks the key as requested.
+	//! Entry with the same key but other \a signature is never returned.
+	Status find(Key key, const Signature &signature, SurfaceResource::Handle &surface, RectInt &rect);
+	//! Stores the result of sub-tree, surface should not be changed anymore
+	void store(Key key, const Signature &signature, const SurfaceResource::Handle &surface, const RectInt &rect);
+	//! Forgets the request of sub-tree, which is not needed anymore
+	//! because the result of its parent is reused, stored results are kept
+	void release(Key key);
+	void clear();
+};
+
+
+//! Copies result of sub-task to the own target.
+//! If storage is set then result of sub-task will be stored there
+//! to reuse in next frames, else sub-task is TaskSurface with the
+//! already stored result.
+class TaskCache: public Task
+{
+public:
+	typedef etl::handle<TaskCache> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	TaskCacheStorage::Handle storage;
+	TaskCacheStorage::Key key;
+	TaskCacheStorage::Signature signature;
+	//! Format of the stored result, it is not converted when empty
+	Surface::Token::Handle storage_token;
+
+	TaskCache(): key() { }
+
+	const Task::Handle& sub_task() const { return Task::sub_task(0); }
+	Task::Handle& sub_task() { return Task::sub_task(0); }
+
+	virtual int get_pass_subtask_index() const
+		{ return sub_task() ? PASSTO_THIS_TASK : PASSTO_NO_TASK; }
+
+	virtual Rect calc_bounds() const;
+
+	//! Puts result of sub-task into storage, implementations should call it from run()
+	//! after the result is read, because it may be converted to storage_token
+	void store() const;
+};
+
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -60,4 +60,23 @@ TaskContour::calc_bounds() const
          :                   contour->calc_bounds(transformation->matrix);
 }
 
+bool
+TaskContour::calc_hash(TaskHash &hash) const
+{
+	hash << detail << allow_antialias << transformation->matrix << (bool)contour;
+	if (!contour)
+		return true;
+
+	const Contour::ChunkList &chunks = contour->get_chunks();
+	hash << contour->invert
+	     << contour->antialias
+	     << (int)contour->winding_style
+	     << contour->color
+	     << contour->beginning_of_unclosed()
+	     << (int)chunks.size();
+	for(Contour::ChunkList::const_iterator i = chunks.begin(); i != chunks.end(); ++i)
+		hash << (int)i->type << i->p1 << i->pp0 << i->pp1;
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
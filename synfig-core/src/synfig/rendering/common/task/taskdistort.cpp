@@ -33,6 +33,8 @@
 #  include <config.h>
 # endif
 
+# include <cmath>
+
 # include "taskdistort.h"
 
 #endif
@@ -47,6 +49,22 @@ using namespace synfig;
 
 /* === M E T H O D S ======================================================= */
 
+Rect
+rendering::TaskDistort::calc_required_source_rect() const
+{
+	const Vector ppu = get_pixels_per_unit();
+
+	Matrix bounds_transformation;
+	bounds_transformation.m00 = ppu[0];
+	bounds_transformation.m11 = ppu[1];
+	bounds_transformation.m20 = target_rect.minx - ppu[0]*source_rect.minx;
+	bounds_transformation.m21 = target_rect.miny - ppu[1]*source_rect.miny;
+
+	Matrix inv_matrix = bounds_transformation.get_inverted();
+
+	return compute_required_source_rect(source_rect, inv_matrix);
+}
+
 void
 rendering::TaskDistort::set_coords_sub_tasks()
 {
@@ -59,16 +77,46 @@ rendering::TaskDistort::set_coords_sub_tasks()
 		return;
 	}
 
-	const Vector ppu = get_pixels_per_unit();
+	required_source_rect = calc_required_source_rect();
+	sub_task()->set_coords(required_source_rect, target_rect.get_size());
+}
 
-	Matrix bounds_transformation;
-	bounds_transformation.m00 = ppu[0];
-	bounds_transformation.m11 = ppu[1];
-	bounds_transformation.m20 = target_rect.minx - ppu[0]*source_rect.minx;
-	bounds_transformation.m21 = target_rect.miny - ppu[1]*source_rect.miny;
+void
+rendering::TaskDistort::set_coords_sub_tasks_on_raster(const Rect &raster_rect, const VectorInt &raster_size)
+{
+	if (!sub_task()) {
+		trunc_to_zero();
+		return;
+	}
+	if (!is_valid_coords()) {
+		sub_task()->set_coords_zero();
+		return;
+	}
 
-	Matrix inv_matrix = bounds_transformation.get_inverted();
+	required_source_rect = calc_required_source_rect();
 
-	required_source_rect = compute_required_source_rect(source_rect, inv_matrix);
-	sub_task()->set_coords(required_source_rect, target_rect.get_size());
+	RectInt pixels;
+	if (required_source_rect.is_valid()) {
+		const Vector upp(
+			(raster_rect.maxx - raster_rect.minx)/raster_size[0],
+			(raster_rect.maxy - raster_rect.miny)/raster_size[1] );
+		pixels = RectInt(
+			(int)std::floor((required_source_rect.minx - raster_rect.minx)/upp[0]) - 1,
+			(int)std::floor((required_source_rect.miny - raster_rect.miny)/upp[1]) - 1,
+			(int)std::ceil ((required_source_rect.maxx - raster_rect.minx)/upp[0]) + 1,
+			(int)std::ceil ((required_source_rect.maxy - raster_rect.miny)/upp[1]) + 1 );
+		pixels &= RectInt(VectorInt(), raster_size);
+		required_source_rect = Rect(
+			raster_rect.minx + pixels.minx*upp[0],
+			raster_rect.miny + pixels.miny*upp[1],
+			raster_rect.minx + pixels.maxx*upp[0],
+			raster_rect.miny + pixels.maxy*upp[1] );
+	}
+
+	if (!pixels.is_valid()) {
+		required_source_rect = Rect::zero();
+		sub_task()->set_coords_zero();
+		return;
+	}
+	sub_task()->set_coords(required_source_rect, pixels.get_size());
 }
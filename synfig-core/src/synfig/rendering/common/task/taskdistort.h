@@ -88,6 +88,21 @@ protected:
 	 */
 	virtual Rect compute_required_source_rect(const Rect& source_rect, const Matrix& inv_matrix) const = 0;
 
+	/**
+	 * Compute the required area by compute_required_source_rect()
+	 * for the current coordinates of the task.
+	 */
+	Rect calc_required_source_rect() const;
+
+	/**
+	 * Use it in set_coords_sub_tasks() instead of TaskDistort::set_coords_sub_tasks()
+	 * to render the required area on the pixels of a raster of @a raster_size pixels
+	 * over @a raster_rect, as legacy layers rendered their context by get_sub_renddesc().
+	 * @c required_source_rect is expanded to whole raster pixels, plus one pixel
+	 * for interpolation, and is clipped by @a raster_rect.
+	 */
+	void set_coords_sub_tasks_on_raster(const Rect &raster_rect, const VectorInt &raster_size);
+
 };
 
 } /* end namespace rendering */
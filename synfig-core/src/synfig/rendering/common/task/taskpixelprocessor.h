@@ -100,6 +100,9 @@ public:
 	Gamma gamma;
 	TaskPixelGamma() { }
 
+	virtual bool calc_hash(TaskHash &hash) const
+		{ hash << gamma.get_r() << gamma.get_g() << gamma.get_b(); return true; }
+
 	virtual bool is_transparent() const
 	{
 		return approximate_equal_lp(gamma.get_r(), ColorReal(1.0))
@@ -118,6 +121,9 @@ public:
 
 	ColorMatrix matrix;
 
+	virtual bool calc_hash(TaskHash &hash) const
+		{ hash.add(matrix.c, sizeof(matrix.c)); return true; }
+
 	virtual bool is_zero() const
 		{ return matrix.is_transparent(); }
 	virtual bool is_transparent() const
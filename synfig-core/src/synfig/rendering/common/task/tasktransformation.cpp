@@ -137,4 +137,11 @@ TaskTransformationAffine::get_pass_subtask_index() const
 	return TaskTransformation::get_pass_subtask_index();
 }
 
+bool
+TaskTransformationAffine::calc_hash(TaskHash &hash) const
+{
+	hash << (int)interpolation << supersample << transformation->matrix;
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
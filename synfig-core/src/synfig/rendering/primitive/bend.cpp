@@ -33,8 +33,10 @@
 #endif
 
 #include <algorithm> //std::sort
+#include <functional>
 
 #include <synfig/curve.h>
+#include <synfig/threadpool.h>
 
 #include "bend.h"
 
@@ -61,18 +63,37 @@ namespace {
 	
 	typedef std::vector<Intersection> IntersectionList;
 
-	
-	void touch(Contour &dst, bool &dst_move_flag, const Vector &p) {
-		if (dst.get_chunks().empty() || dst_move_flag) {
-			dst.move_to(p);
-			dst_move_flag = false;
-		} else
-		if (!p.is_equal_to( dst.get_chunks().back().p1 )) {
-			dst.line_to(p);
-		}
+	class Curve {
+	public:
+		Contour::ChunkType type;
+		Hermite h;
+		bool degenerate;
+		Vector tangent, next_tangent; //!< normalized
+		bool next_is_first;           //!< next tangent is the tangent at the beginning of subpath
+		Bend::Segment::Handle segment;
+		Curve(): type(), degenerate(), next_is_first() { }
+	};
+
+	bool same(const Vector &a, const Vector &b)
+		{ return a[0] == b[0] && a[1] == b[1]; }
+	bool is_near(const Vector &a, const Vector &b)
+		{ return approximate_equal(a[0], b[0]) && approximate_equal(a[1], b[1]); }
+
+	void add(Bend::Segment &segment, Bend::Segment::Action action, const Vector &p) {
+		segment.actions.push_back(action);
+		segment.vertices.push_back(p);
+	}
+	void touch(Bend::Segment &segment, const Vector &p)
+		{ add(segment, Bend::Segment::TOUCH, p); }
+	void line_to(Bend::Segment &segment, const Vector &p)
+		{ add(segment, Bend::Segment::LINE, p); }
+	void cubic_to(Bend::Segment &segment, const Vector &p, const Vector &pp0, const Vector &pp1) {
+		add(segment, Bend::Segment::CUBIC, p);
+		segment.vertices.push_back(pp0);
+		segment.vertices.push_back(pp1);
 	}
 
-	void half_corner(Contour &dst, bool &dst_move_flag, const Bend::Point &point, Real radius, bool flip, bool out) {
+	void half_corner(Bend::Segment &segment, const Bend::Point &point, Real radius, bool flip, bool out) {
 		if (point.mode == Bend::NONE || approximate_zero(radius))
 			return;
 
@@ -97,30 +118,26 @@ namespace {
 				Real k = (ppp - p).mag()/(3*rmod);
 				if (p * ppp.perp() < 0) k = -k;
 				if (out) {
-					touch(dst, dst_move_flag, center + pp);
-					dst.cubic_to(
+					touch(segment, center + pp);
+					cubic_to(segment,
 						center + ppp,
 						center + pp  +  pp.perp()*k,
 						center + ppp - ppp.perp()*k );
-					dst.remove_collapsed_tail();
-					dst.cubic_to(
+					cubic_to(segment,
 						center + p,
 						center + ppp + ppp.perp()*k,
 						center + p   -   p.perp()*k );
-					dst.remove_collapsed_tail();
 				} else {
 					k = -k;
-					touch(dst, dst_move_flag, center + p);
-					dst.cubic_to(
+					touch(segment, center + p);
+					cubic_to(segment,
 						center + ppp,
 						center + p   +   p.perp()*k,
 						center + ppp - ppp.perp()*k );
-					dst.remove_collapsed_tail();
-					dst.cubic_to(
+					cubic_to(segment,
 						center + pp,
 						center + ppp + ppp.perp()*k,
 						center + pp  -  pp.perp()*k);
-					dst.remove_collapsed_tail();
 				}
 			} else
 			if (point.mode == Bend::CORNER) {
@@ -130,30 +147,222 @@ namespace {
 				Real c = 1/sqrt(b);
 				pp *= std::min(Real(2), (a + b)*c*0.5)*c*radius;
 				if (out) {
-					touch(dst, dst_move_flag, center + pp);
-					dst.line_to(center + p);
-					dst.remove_collapsed_tail();
+					touch(segment, center + pp);
+					line_to(segment, center + p);
 				} else {
-					touch(dst, dst_move_flag, center + p);
-					dst.line_to(center + pp);
-					dst.remove_collapsed_tail();
+					touch(segment, center + p);
+					line_to(segment, center + pp);
 				}
 			}
 		} else {
 			Vector pp = (p0 + p1)*0.5;
 			if (out) {
-				touch(dst, dst_move_flag, center + pp);
-				dst.line_to(center + p);
-				dst.remove_collapsed_tail();
+				touch(segment, center + pp);
+				line_to(segment, center + p);
 			} else {
-				touch(dst, dst_move_flag, center + p);
-				dst.line_to(center + pp);
-				dst.remove_collapsed_tail();
+				touch(segment, center + p);
+				line_to(segment, center + pp);
 			}
 		}
 		
 		return;
 	}
+
+	Range get_range(const Hermite &h, Real *bends, int &bends_count) {
+		bends_count = h.bends(0, bends);
+		Range r(h.p0[0]);
+		r.expand(h.p1[0]);
+		for(Real *i = bends, *end = i + bends_count; i != end; ++i)
+			r.expand( h.p(0, *i) );
+		return r;
+	}
+
+	void generate(Bend::Segment &segment, IntersectionList &intersections, const Bend &bend, const Hermite &h, int segments) {
+		const Real step = Real(1)/segments;
+		intersections.clear();
+
+		Real bends[3] = {0, 0, 0};
+		int bends_count = 0;
+		const Range r = get_range(h, bends, bends_count);
+		bends_count += h.inflection(0, bends + bends_count);
+		
+		for(Bend::PointList::const_iterator bi = bend.find(r.min); bi != bend.points.end() && !approximate_less(r.max, bi->length); ++bi) {
+			Real roots[3] = {0, 0, 0};
+			int count = h.intersections(0, roots, bi->length);
+			for(Real *i = roots, *end = i + count; i != end; ++i)
+				intersections.push_back( Intersection(*i, *bi) );
+		}
+		for(Real *i = bends, *end = i + bends_count; i != end; ++i)
+			intersections.push_back( Intersection(*i, bend.interpolate( h.p(0, *i) )) );
+		Real bsl = step;
+		for(int i = 1; i < segments; ++i, bsl += step)
+			intersections.push_back( Intersection(bsl, bend.interpolate( h.p(0, bsl) )) );
+		std::sort(intersections.begin(), intersections.end());
+		
+		Intersection prev(0, bend.interpolate(h.p0[0]));
+		intersections.push_back( Intersection(1, bend.interpolate(h.p1[0])) );
+		segment.actions.reserve(2*intersections.size());
+		segment.vertices.reserve(2*intersections.size());
+		
+		for(IntersectionList::const_iterator bi = intersections.begin(); bi != intersections.end(); ++bi) {
+			const Intersection &next = *bi;
+			if (approximate_equal(prev.l, next.l)) continue;
+
+			bool flip = next.point.l < prev.point.l;
+			bool e0 = flip ? prev.point.e0 : prev.point.e1;
+			bool e1 = flip ? next.point.e1 : next.point.e0;
+			if (e0 && e1) {
+				const Vector &tn0 = flip ? prev.point.tn0 : prev.point.tn1;
+				const Vector &tn1 = flip ? next.point.tn1 : next.point.tn0;
+				
+				Real src_p0y = h.p(1, prev.l);
+				Real src_p1y = h.p(1, next.l);
+				
+				Vector dst_p0 = prev.point.p + tn0.perp()*src_p0y;
+				Vector dst_p1 = next.point.p + tn1.perp()*src_p1y;
+				
+				bool vertical = approximate_equal(next.point.l, prev.point.l);
+				
+				half_corner(segment, prev.point, src_p0y, flip || vertical, true);
+				touch(segment, dst_p0);
+				add(segment, Bend::Segment::AUTOCURVE, dst_p1);
+				half_corner(segment, next.point, src_p1y, flip && !vertical, false);
+			} else {
+				segment.actions.push_back(Bend::Segment::CORNER);
+			}
+			
+			prev = next;
+		}
+	}
+
+	void generate_range(const Bend *bend, Curve **begin, Curve **end, int segments) {
+		IntersectionList intersections;
+		for(Curve **i = begin; i != end; ++i)
+			generate(*(*i)->segment, intersections, *bend, (*i)->h, segments);
+	}
+
+	//! The curve and the bend points under it
+	class Key {
+	public:
+		Hermite curve; //!< relative to the first point
+		Bend::PointList::const_iterator begin, end;
+		Real l, length;
+		bool first, last;
+		size_t hash;
+		Key(): l(), length(), first(), last(), hash() { }
+	};
+
+	void build_key(Key &key, const Bend &bend, const Hermite &h) {
+		Real bends[3] = {0, 0, 0};
+		int bends_count = 0;
+		const Range r = get_range(h, bends, bends_count);
+
+		// take neighbours too, they are used for interpolation
+		const Bend::PointList &points = bend.points;
+		key.begin = bend.find(r.min);
+		key.end = bend.find(r.max);
+		if (key.begin != points.begin()) --key.begin;
+		for(int i = 0; i < 2 && key.end != points.end(); ++i) ++key.end;
+
+		key.first = key.begin == points.begin();
+		key.last = key.end == points.end();
+		key.l = key.begin->l;
+		key.length = key.begin->length;
+
+		key.hash = key.end - key.begin;
+		for(Bend::PointList::const_iterator i = key.begin; i != key.end; ++i) {
+			key.hash = key.hash*31 + std::hash<Real>()(i->p[0]);
+			key.hash = key.hash*31 + std::hash<Real>()(i->p[1]);
+		}
+
+		key.curve = h;
+		key.curve.p0[0] -= key.length;
+		key.curve.p1[0] -= key.length;
+	}
+
+	void assign_key(Bend::Segment &segment, const Key &key) {
+		segment.curve = key.curve;
+		segment.points.assign(key.begin, key.end);
+		for(Bend::PointList::iterator i = segment.points.begin(); i != segment.points.end(); ++i) {
+			i->l -= key.l;
+			i->length -= key.length;
+		}
+		segment.first = key.first;
+		segment.last = key.last;
+		segment.hash = key.hash;
+	}
+
+	bool is_same(const Bend::Segment &segment, const Key &key) {
+		if ( segment.hash != key.hash
+		  || segment.first != key.first
+		  || segment.last != key.last
+		  || (int)segment.points.size() != key.end - key.begin
+		  || !is_near(segment.curve.p0, key.curve.p0)
+		  || !is_near(segment.curve.p1, key.curve.p1)
+		  || !is_near(segment.curve.t0, key.curve.t0)
+		  || !is_near(segment.curve.t1, key.curve.t1) )
+			return false;
+		Bend::PointList::const_iterator j = key.begin;
+		for(Bend::PointList::const_iterator i = segment.points.begin(); i != segment.points.end(); ++i, ++j)
+			if ( !same(i->p, j->p)
+			  || !same(i->t0, j->t0)
+			  || !same(i->t1, j->t1)
+			  || !same(i->tn0, j->tn0)
+			  || !same(i->tn1, j->tn1)
+			  || i->mode != j->mode
+			  || i->e0 != j->e0
+			  || i->e1 != j->e1
+			  || !approximate_equal(i->l, j->l - key.l)
+			  || !approximate_equal(i->length, j->length - key.length) )
+				return false;
+		return true;
+	}
+
+	class HashLess {
+	public:
+		bool operator()(const Bend::Segment *a, const Bend::Segment *b) const
+			{ return a->hash < b->hash; }
+		bool operator()(const Bend::Segment *a, size_t b) const
+			{ return a->hash < b; }
+		bool operator()(size_t a, const Bend::Segment *b) const
+			{ return a < b->hash; }
+	};
+
+	void touch(Contour &dst, bool &dst_move_flag, const Vector &p) {
+		if (dst.get_chunks().empty() || dst_move_flag) {
+			dst.move_to(p);
+			dst_move_flag = false;
+		} else
+		if (!p.is_equal_to( dst.get_chunks().back().p1 )) {
+			dst.line_to(p);
+		}
+	}
+
+	void replay(Contour &dst, bool &dst_move_flag, const Bend::Segment &segment) {
+		Bend::Segment::VertexList::const_iterator p = segment.vertices.begin();
+		for(Bend::Segment::ActionList::const_iterator i = segment.actions.begin(); i != segment.actions.end(); ++i) {
+			switch(*i) {
+				case Bend::Segment::TOUCH:
+					touch(dst, dst_move_flag, *p++);
+					break;
+				case Bend::Segment::LINE:
+					dst.line_to(*p++);
+					dst.remove_collapsed_tail();
+					break;
+				case Bend::Segment::CUBIC:
+					dst.cubic_to(p[0], p[1], p[2]);
+					dst.remove_collapsed_tail();
+					p += 3;
+					break;
+				case Bend::Segment::AUTOCURVE:
+					dst.autocurve_to(*p++);
+					break;
+				default:
+					dst.autocurve_corner();
+					break;
+			}
+		}
+	}
 }
 
 /* === P R O C E D U R E S ================================================= */
@@ -349,22 +558,23 @@ Bend::interpolate(Real length) const
 }
 
 void
-Bend::bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments) const
+Bend::bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments, const Cache::Handle &cache) const
 {
 	if (!dst.closed()) dst.close();
 
 	if (points.empty() || src.get_chunks().empty())
 		return;
 
-	const Real step = Real(1)/segments;
+	// collect curves of source contour
+	std::vector<Curve> curves;
+	curves.reserve(src.get_chunks().size());
 	Contour::ChunkList::const_iterator i = src.get_chunks().begin();
 	Vector p0 = matrix.get_transformed(i->p1);
-	Vector first_tangent;
-	bool dst_move_flag = true;
-	
-	IntersectionList intersections;
 	while(++i != src.get_chunks().end()) {
-		Hermite h;
+		curves.push_back(Curve());
+		Curve &curve = curves.back();
+		curve.type = i->type;
+		Hermite &h = curve.h;
 		Vector current_tangent;
 		switch(i->type) {
 			case Contour::CUBIC:
@@ -384,18 +594,14 @@ Bend::bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments)
 				break;
 			case Contour::MOVE:
 				p0 = matrix.get_transformed(i->p1);
-				dst_move_flag = true;
-				first_tangent = Vector();
 				continue;
 			default: // line, close
 				h = Hermite(p0, matrix.get_transformed(i->p1));
 				break;
 		}
 		
-		if (dst_move_flag) first_tangent = h.t0;
-		
 		if ( h.p0.is_equal_to(h.p1) && approximate_zero(h.t0 * h.t1.perp()) ) {
-			if (i->type == Contour::CLOSE) dst.close();
+			curve.degenerate = true;
 			continue;
 		}
 
@@ -410,9 +616,10 @@ Bend::bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments)
 					next_tangent = matrix.get_transformed(j->pp0 - i->p1, false);
 					break;
 				case Contour::CLOSE:
-					next_tangent = j->p1.is_equal_to( i->p1 )
-								 ? first_tangent
-								 : matrix.get_transformed(j->p1 - i->p1, false);
+					if (j->p1.is_equal_to( i->p1 ))
+						curve.next_is_first = true;
+					else
+						next_tangent = matrix.get_transformed(j->p1 - i->p1, false);
 					break;
 				case Contour::MOVE:
 					break;
@@ -422,70 +629,126 @@ Bend::bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments)
 			}
 		}
 		
-		current_tangent = current_tangent.norm();
-		next_tangent = next_tangent.norm();
-		Real tangent_dot = current_tangent * next_tangent;
-		Real tangent_dot_perp = current_tangent * next_tangent.perp();
-		bool corner = fabs(tangent_dot_perp) > 0.01 || tangent_dot < 0.5;
-				   
-		Real bends[3] = {0, 0, 0};
-		int bends_count = h.bends(0, bends);
-		Range r(h.p0[0]);
-		r.expand(h.p1[0]);
-		for(Real *i = bends, *end = i + bends_count; i != end; ++i)
-			r.expand( h.p(0, *i) );
-		bends_count += h.inflection(0, bends + bends_count);
-		
-		for(PointList::const_iterator bi = find(r.min); bi != points.end() && !approximate_less(r.max, bi->length); ++bi) {
-			Real roots[3] = {0, 0, 0};
-			int count = h.intersections(0, roots, bi->length);
-			for(Real *i = roots, *end = i + count; i != end; ++i)
-				intersections.push_back( Intersection(*i, *bi) );
+		curve.tangent = current_tangent.norm();
+		curve.next_tangent = next_tangent.norm();
+	}
+
+	// take segments from cache and collect curves to generate
+	std::unique_lock<std::mutex> lock;
+	Cache::List list;
+	if (cache) {
+		lock = std::unique_lock<std::mutex>(cache->mutex);
+		if (cache->segments != segments) {
+			cache->list.clear();
+			cache->index.clear();
+			cache->segments = segments;
 		}
-		for(Real *i = bends, *end = i + bends_count; i != end; ++i)
-			intersections.push_back( Intersection(*i, interpolate( h.p(0, *i) )) );
-		Real bsl = step;
-		for(int i = 1; i < segments; ++i, bsl += step)
-			intersections.push_back( Intersection(bsl, interpolate( h.p(0, bsl) )) );
-		std::sort(intersections.begin(), intersections.end());
-		
-		Intersection prev(0, interpolate(h.p0[0]));
-		intersections.push_back( Intersection(1, interpolate(h.p1[0])) );
-		
-		for(IntersectionList::const_iterator bi = intersections.begin(); bi != intersections.end(); ++bi) {
-			const Intersection &next = *bi;
-			if (approximate_equal(prev.l, next.l)) continue;
+	}
 
-			bool flip = next.point.l < prev.point.l;
-			bool e0 = flip ? prev.point.e0 : prev.point.e1;
-			bool e1 = flip ? next.point.e1 : next.point.e0;
-			if (e0 && e1) {
-				const Vector &tn0 = flip ? prev.point.tn0 : prev.point.tn1;
-				const Vector &tn1 = flip ? next.point.tn1 : next.point.tn0;
-				
-				Real src_p0y = h.p(1, prev.l);
-				Real src_p1y = h.p(1, next.l);
-				
-				Vector dst_p0 = prev.point.p + tn0.perp()*src_p0y;
-				Vector dst_p1 = next.point.p + tn1.perp()*src_p1y;
-				
-				bool vertical = approximate_equal(next.point.l, prev.point.l);
-				
-				half_corner(dst, dst_move_flag, prev.point, src_p0y, flip || vertical, true);
-				touch(dst, dst_move_flag, dst_p0);
-				dst.autocurve_to(dst_p1);
-				half_corner(dst, dst_move_flag, next.point, src_p1y, flip && !vertical, false);
-			} else {
-				dst.autocurve_corner();
+	// estimate the work only when it may be split between threads
+	const bool multithreading = (int)points.size() >= 2*MIN_THREAD_POINTS;
+	std::vector<Curve*> queue;
+	std::vector<int> weights;
+	int total_weight = 0;
+	for(std::vector<Curve>::iterator i = curves.begin(); i != curves.end(); ++i) {
+		if (i->type == Contour::MOVE || i->degenerate)
+			continue;
+		bool found = false;
+		if (cache) {
+			Key key;
+			build_key(key, *this, i->h);
+			std::pair<Cache::Index::const_iterator, Cache::Index::const_iterator> range =
+				std::equal_range(cache->index.begin(), cache->index.end(), key.hash, HashLess());
+			for(Cache::Index::const_iterator j = range.first; j != range.second; ++j)
+				if (is_same(**j, key))
+					{ i->segment = *j; found = true; break; }
+			if (!found) {
+				i->segment = new Segment();
+				assign_key(*i->segment, key);
 			}
-			
-			prev = next;
+			list.push_back(i->segment);
+		}
+		if (!found) {
+			queue.push_back(&*i);
+			if (multithreading) {
+				Real bends[3] = {0, 0, 0};
+				int bends_count = 0;
+				const Range r = get_range(i->h, bends, bends_count);
+				const int weight = (int)(find(r.max) - find(r.min)) + segments;
+				weights.push_back(weight);
+				total_weight += weight;
+			}
+		}
+	}
+
+	// generate segments, in parallel for long outlines
+	const int threads = !multithreading || queue.size() < 2 || total_weight < 2*MIN_THREAD_POINTS ? 1
+		: std::min((int)total_weight/MIN_THREAD_POINTS, ThreadPool::instance().get_max_threads());
+	if (threads > 1) {
+		for(std::vector<Curve*>::const_iterator i = queue.begin(); i != queue.end(); ++i)
+			if (!(*i)->segment) (*i)->segment = new Segment();
+		ThreadPool::Group group;
+		int begin = 0, weight = 0, thread = 1;
+		for(int k = 0; k < (int)queue.size(); ++k) {
+			weight += weights[k];
+			if (weight*threads >= total_weight*thread && k + 1 < (int)queue.size()) {
+				group.enqueue( sigc::bind( sigc::ptr_fun(&generate_range),
+					this, &queue.front() + begin, &queue.front() + k + 1, segments ));
+				begin = k + 1;
+				++thread;
+			}
+		}
+		group.enqueue( sigc::bind( sigc::ptr_fun(&generate_range),
+			this, &queue.front() + begin, &queue.front() + queue.size(), segments ));
+		group.run();
+	} else
+	if (cache && !queue.empty()) {
+		generate_range(this, &queue.front(), &queue.front() + queue.size(), segments);
+	}
+
+	if (cache) {
+		cache->list.swap(list);
+		cache->index.clear();
+		for(Cache::List::const_iterator i = cache->list.begin(); i != cache->list.end(); ++i)
+			cache->index.push_back(i->get());
+		std::sort(cache->index.begin(), cache->index.end(), HashLess());
+	}
+
+	// put segments into contour
+	Segment temporary;
+	IntersectionList intersections;
+	Vector first_tangent;
+	bool dst_move_flag = true;
+	for(std::vector<Curve>::const_iterator i = curves.begin(); i != curves.end(); ++i) {
+		if (i->type == Contour::MOVE) {
+			dst_move_flag = true;
+			first_tangent = Vector();
+			continue;
 		}
 		
-		intersections.clear();
+		if (dst_move_flag) first_tangent = i->h.t0;
+		
+		if (i->degenerate) {
+			if (i->type == Contour::CLOSE) dst.close();
+			continue;
+		}
+
+		if (i->segment) {
+			replay(dst, dst_move_flag, *i->segment);
+		} else {
+			// segment is not stored anywhere, so generate it right before use
+			temporary.actions.clear();
+			temporary.vertices.clear();
+			generate(temporary, intersections, *this, i->h, segments);
+			replay(dst, dst_move_flag, temporary);
+		}
+
+		const Vector next_tangent = i->next_is_first ? first_tangent.norm() : i->next_tangent;
+		Real tangent_dot = i->tangent * next_tangent;
+		Real tangent_dot_perp = i->tangent * next_tangent.perp();
+		bool corner = fabs(tangent_dot_perp) > 0.01 || tangent_dot < 0.5;
 		if (corner) dst.autocurve_corner();
 	}
 	
 	if (!dst.closed()) dst.close();
 }
-
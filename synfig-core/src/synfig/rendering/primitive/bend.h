@@ -30,10 +30,12 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <mutex>
 #include <vector>
 
 #include <ETL/handle>
 
+#include <synfig/curve.h>
 #include <synfig/vector.h>
 #include <synfig/matrix.h>
 
@@ -79,6 +81,57 @@ public:
 
 	typedef std::vector<Point> PointList;
 
+	//! Geometry generated by bend() for one curve of the source contour
+	class Segment: public etl::shared_object {
+	public:
+		typedef etl::handle<Segment> Handle;
+
+		enum Action {
+			TOUCH,     //!< move or line to the point, if the pen is not there
+			LINE,
+			CUBIC,
+			AUTOCURVE,
+			CORNER     //!< autocurve_corner()
+		};
+
+		typedef std::vector<Action> ActionList;
+		typedef std::vector<Vector> VertexList;
+
+		// Key: the source curve and the bend points under it.
+		// Lengths are relative to the first point, so segment still matches
+		// when the outline was changed before it.
+		Hermite curve;
+		PointList points;
+		bool first, last; //!< points are at the beginning or at the end of bend
+		size_t hash;
+
+		// Generated geometry: the actions and their points,
+		// CUBIC takes three points, CORNER takes none, other actions take one
+		ActionList actions;
+		VertexList vertices;
+
+		Segment(): first(), last(), hash() { }
+	};
+
+	//! Segments generated by the last call of bend(),
+	//! only curves which were changed since that call will be generated again
+	class Cache: public etl::shared_object {
+	public:
+		typedef etl::handle<Cache> Handle;
+		typedef std::vector<Segment::Handle> List;
+		typedef std::vector<Segment*> Index;
+
+		std::mutex mutex;
+		int segments;
+		List list;
+		Index index; //!< segments from the list sorted by hash
+
+		Cache(): segments() { }
+	};
+
+	//! Bend points to process by one thread while segments are generated in parallel
+	enum { MIN_THREAD_POINTS = 4096 };
+
 	PointList points;
 
 	void add(const Vector &p, const Vector &t0, const Vector &t1, Mode mode, bool calc_length, int segments);
@@ -100,7 +153,7 @@ public:
 	Real length_by_l(Real length) const;
 	Point interpolate(Real length) const;
 	
-	void bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments) const;
+	void bend(Contour &dst, const Contour &src, const Matrix &matrix, int segments, const Cache::Handle &cache = Cache::Handle()) const;
 };
 
 } /* end namespace rendering */
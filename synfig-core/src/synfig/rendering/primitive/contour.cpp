@@ -37,6 +37,7 @@
 #include "intersector.h"
 
 #include "contour.h"
+#include "polyspan.h"
 
 
 #endif
@@ -290,6 +291,116 @@ public:
 			}
 		}
 	}
+
+	static bool is_same(const Vector &a, const Vector &b)
+		{ return a[0] == b[0] && a[1] == b[1]; }
+
+	static bool is_same(const Flattened::Entry &entry, const Chunk &chunk, const Vector &p0)
+	{
+		return entry.chunk.type == chunk.type
+			&& is_same(entry.chunk.p1, chunk.p1)
+			&& is_same(entry.chunk.pp0, chunk.pp0)
+			&& is_same(entry.chunk.pp1, chunk.pp1)
+			&& is_same(entry.p0, p0);
+	}
+
+	static bool is_same(const Matrix &a, const Matrix &b)
+	{
+		for(int i = 0; i < 3; ++i)
+			for(int j = 0; j < 3; ++j)
+				if (a.m[i][j] != b.m[i][j]) return false;
+		return true;
+	}
+
+	//! curves are split by Polyspan itself, so polyline is the same as drawn by Polyspan::conic_to() and cubic_to()
+	static void flatten(Flattened &flattened, Flattened::Entry &entry)
+	{
+		const Matrix &m = flattened.matrix;
+		const Chunk &chunk = entry.chunk;
+		std::vector<Vector> &points = flattened.points;
+
+		entry.polyline = false;
+		entry.begin = entry.end = (int)points.size();
+		if (chunk.type != CONIC && chunk.type != CUBIC)
+			return;
+
+		const Vector p0 = m.get_transformed(entry.p0);
+		const Vector p1 = m.get_transformed(chunk.p1);
+		const Vector pp0 = m.get_transformed(chunk.pp0);
+		const Vector pp1 = chunk.type == CUBIC ? m.get_transformed(chunk.pp1) : pp0;
+		points.push_back(p0);
+		entry.polyline = chunk.type == CUBIC
+			? Polyspan::flatten_cubic(points, p0[0], p0[1], p1[0], p1[1], pp0[0], pp0[1], pp1[0], pp1[1], flattened.detail)
+			: Polyspan::flatten_conic(points, p0[0], p0[1], p1[0], p1[1], pp0[0], pp0[1], flattened.detail);
+		if (!entry.polyline) {
+			points.pop_back();
+			return;
+		}
+		entry.bounds = Rect(p0).expand(p1).expand(pp0).expand(pp1);
+		entry.end = (int)points.size();
+	}
+
+	//! flatten chunks, entries of previous with the same source are copied
+	static Flattened::Handle flatten(
+		const ChunkList &chunks,
+		const Matrix &matrix,
+		Real detail,
+		const Flattened::Handle &previous )
+	{
+		const Flattened::EntryList *prev_entries = previous ? &previous->entries : nullptr;
+
+		// check is previous result still valid
+		if (prev_entries && prev_entries->size() == chunks.size()) {
+			Vector p0, first;
+			bool same = true;
+			for(int i = 0; i < (int)chunks.size() && same; ++i) {
+				same = is_same((*prev_entries)[i], chunks[i], p0);
+				next_pen(chunks[i], p0, first);
+			}
+			if (same) return previous;
+		}
+
+		Flattened::Handle flattened(new Flattened());
+		flattened->matrix = matrix;
+		flattened->detail = detail;
+		flattened->entries.resize(chunks.size());
+		if (previous)
+			flattened->points.reserve(previous->points.size());
+
+		Vector p0, first;
+		for(int i = 0; i < (int)chunks.size(); ++i) {
+			Flattened::Entry &entry = flattened->entries[i];
+			if (prev_entries && i < (int)prev_entries->size() && is_same((*prev_entries)[i], chunks[i], p0)) {
+				const Flattened::Entry &prev = (*prev_entries)[i];
+				entry = prev;
+				entry.begin = (int)flattened->points.size();
+				flattened->points.insert(
+					flattened->points.end(),
+					previous->points.begin() + prev.begin,
+					previous->points.begin() + prev.end );
+				entry.end = (int)flattened->points.size();
+			} else {
+				entry.chunk = chunks[i];
+				entry.p0 = p0;
+				flatten(*flattened, entry);
+			}
+			next_pen(chunks[i], p0, first);
+		}
+		return flattened;
+	}
+
+	//! position of pen after chunk like in Polyspan
+	static void next_pen(const Chunk &chunk, Vector &pen, Vector &first)
+	{
+		switch(chunk.type) {
+		case CLOSE: pen = first; break;
+		case MOVE:  pen = first = chunk.p1; break;
+		case LINE:
+		case CONIC:
+		case CUBIC: pen = chunk.p1; break;
+		default: break;
+		}
+	}
 };
 
 
@@ -298,6 +409,7 @@ Contour::Contour():
 	autocurve_begin(false),
 	autocurve_end(false),
 	bounds_calculated(false),
+	flattened_cache(new FlattenedCache()),
 	invert(false),
 	antialias(false),
 	winding_style(WINDING_NON_ZERO)
@@ -312,6 +424,7 @@ Contour::touch_chunks()
 	autocurve_end = false;
 	bounds_calculated = false;
 	intersector.reset();
+	flattened.reset();
 }
 
 void
@@ -477,6 +590,11 @@ Contour::assign(const Contour &other)
 		std::lock_guard<std::mutex> lock(other.intersector_read_mutex);
 		intersector = other.intersector;
 	}
+	{
+		std::lock_guard<std::mutex> lock(other.flattened_read_mutex);
+		flattened_cache = other.flattened_cache;
+		flattened = other.flattened;
+	}
 }
 
 void
@@ -655,6 +773,47 @@ Contour::get_intersector() const
 	return *intersector;
 }
 
+Contour::Flattened::Handle
+Contour::get_flattened(const Matrix &transform_matrix, Real detail) const
+{
+	const int max_cache_size = 4;
+	const Matrix &matrix = transform_matrix;
+
+	std::lock_guard<std::mutex> lock(flattened_read_mutex);
+	if ( flattened
+	  && flattened->detail == detail
+	  && Helper::is_same(flattened->matrix, matrix)
+	  && flattened->entries.size() == chunks.size() )
+		return flattened;
+
+	// result for the same transformation may be made for other version of the contour
+	Flattened::Handle previous;
+	{
+		std::lock_guard<std::mutex> cache_lock(flattened_cache->mutex);
+		for(std::vector<Flattened::Handle>::const_iterator i = flattened_cache->list.begin(); i != flattened_cache->list.end(); ++i)
+			if ((*i)->detail == detail && Helper::is_same((*i)->matrix, matrix))
+				{ previous = *i; break; }
+	}
+
+	flattened = Helper::flatten(chunks, matrix, detail, previous);
+
+	{
+		std::lock_guard<std::mutex> cache_lock(flattened_cache->mutex);
+		std::vector<Flattened::Handle> &list = flattened_cache->list;
+		std::vector<Flattened::Handle>::iterator i = std::find(list.begin(), list.end(), previous);
+		if (i == list.end()) {
+			list.insert(list.begin(), flattened);
+			if ((int)list.size() > max_cache_size)
+				list.pop_back();
+		} else {
+			list.erase(i);
+			list.insert(list.begin(), flattened);
+		}
+	}
+
+	return flattened;
+}
+
 void
 Contour::split(
 	Contour &out_contour,
@@ -98,9 +98,42 @@ public:
 
 	typedef std::vector<Chunk> ChunkList;
 
+	//! Curves transformed by a matrix and split into polylines as Polyspan does
+	class Flattened: public etl::shared_object
+	{
+	public:
+		typedef etl::handle<Flattened> Handle;
+
+		struct Entry {
+			Chunk chunk;     //!< source chunk
+			Vector p0;       //!< source position of pen before the chunk
+			bool polyline;   //!< curve was split
+			Rect bounds;     //!< bounds of transformed control points of split curve
+			int begin, end;  //!< range of points of split curve, from the transformed position of pen
+		};
+
+		typedef std::vector<Entry> EntryList;
+
+		Matrix matrix;
+		Real detail;
+		EntryList entries;
+		std::vector<Vector> points;
+
+		Flattened(): detail() { }
+	};
+
 private:
 	class Helper;
 
+	//! Flattened chunks shared between contour and its copies made by assign()
+	class FlattenedCache: public etl::shared_object
+	{
+	public:
+		typedef etl::handle<FlattenedCache> Handle;
+		std::mutex mutex;
+		std::vector<Flattened::Handle> list; //!< most recently used first
+	};
+
 	ChunkList chunks;
 	int first;
 	bool autocurve_begin, autocurve_end;
@@ -112,6 +145,10 @@ private:
 	mutable std::mutex intersector_read_mutex;
 	mutable etl::handle<Intersector> intersector;
 
+	FlattenedCache::Handle flattened_cache;
+	mutable std::mutex flattened_read_mutex;
+	mutable Flattened::Handle flattened;
+
 	//! call this when 'chunks' or 'first' was changed
 	void touch_chunks();
 
@@ -182,6 +219,12 @@ public:
 	//! method is thread-safe for constant contours - you must not modify a contour while this call
 	const Intersector& get_intersector() const;
 
+	//! return curves flattened by transform_matrix, it should be affine,
+	//! result is cached and shared with copies of the contour,
+	//! so only changed chunks are flattened again when contour of the next frame is built
+	//! method is thread-safe for constant contours - you must not modify a contour while this call
+	Flattened::Handle get_flattened(const Matrix &transform_matrix, Real detail) const;
+
 	void split(
 		Contour &out_contour,
 		Rect &ref_bounds,
@@ -32,6 +32,9 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+
 #include "mesh.h"
 
 #endif
@@ -45,15 +48,121 @@ using namespace rendering;
 
 /* === P R O C E D U R E S ================================================= */
 
+static bool
+is_finite(const Rect &r)
+	{ return std::isfinite(r.minx) && std::isfinite(r.miny) && std::isfinite(r.maxx) && std::isfinite(r.maxy); }
+
 /* === M E T H O D S ======================================================= */
 
+void
+Mesh::CoordIndex::clear()
+{
+	bounds = Rect();
+	size_x = size_y = 0;
+	cells_per_unit = Vector();
+	cells.clear();
+	triangles.clear();
+}
+
+void
+Mesh::CoordIndex::build(const VertexList &vertices, const TriangleList &triangles, bool by_tex_coords)
+{
+	clear();
+	if (triangles.empty())
+		return;
+
+	const Vector Vertex::*coord = by_tex_coords ? &Vertex::tex_coords : &Vertex::position;
+
+	// bounds of triangles, triangles with invalid coords are skipped
+	std::vector<Rect> triangle_bounds;
+	triangle_bounds.reserve(triangles.size());
+	bool has_bounds = false;
+	for(TriangleList::const_iterator i = triangles.begin(); i != triangles.end(); ++i) {
+		Rect r(vertices[i->vertices[0]].*coord);
+		r.expand(vertices[i->vertices[1]].*coord);
+		r.expand(vertices[i->vertices[2]].*coord);
+		if (is_finite(r)) {
+			if (has_bounds) {
+				bounds.expand(r.get_min());
+				bounds.expand(r.get_max());
+			} else {
+				bounds = r;
+				has_bounds = true;
+			}
+		}
+		triangle_bounds.push_back(r);
+	}
+	if (!has_bounds)
+		{ clear(); return; }
+
+	// points at the edges of triangles must not be lost by rounding errors
+	const Real epsilon = 1e-9*(1.0 + std::max(bounds.get_width(), bounds.get_height()));
+	bounds.expand(epsilon);
+
+	// about one triangle per cell
+	const Real w = bounds.get_width();
+	const Real h = bounds.get_height();
+	const Real count = (Real)triangles.size();
+	size_x = std::max(1, std::min(1024, (int)std::round(std::sqrt(count*w/h))));
+	size_y = std::max(1, std::min(1024, (int)std::round(std::sqrt(count*h/w))));
+	cells_per_unit = Vector(size_x/w, size_y/h);
+
+	// count triangles of each cell, then fill cells in order of triangles
+	std::vector<RectInt> triangle_cells;
+	triangle_cells.reserve(triangle_bounds.size());
+	cells.resize(size_x*size_y + 1, 0);
+	for(std::vector<Rect>::iterator i = triangle_bounds.begin(); i != triangle_bounds.end(); ++i) {
+		if (!is_finite(*i))
+			{ triangle_cells.push_back(RectInt()); continue; }
+		i->expand(epsilon);
+		RectInt r(
+			std::max(0,          (int)std::floor((i->minx - bounds.minx)*cells_per_unit[0])),
+			std::max(0,          (int)std::floor((i->miny - bounds.miny)*cells_per_unit[1])),
+			std::min(size_x - 1, (int)std::floor((i->maxx - bounds.minx)*cells_per_unit[0])) + 1,
+			std::min(size_y - 1, (int)std::floor((i->maxy - bounds.miny)*cells_per_unit[1])) + 1 );
+		for(int y = r.miny; y < r.maxy; ++y)
+			for(int x = r.minx; x < r.maxx; ++x)
+				++cells[y*size_x + x + 1];
+		triangle_cells.push_back(r);
+	}
+	for(int i = 1; i < (int)cells.size(); ++i)
+		cells[i] += cells[i - 1];
+
+	this->triangles.resize(cells.back());
+	std::vector<int> positions(cells.begin(), cells.end() - 1);
+	for(int i = 0; i < (int)triangle_cells.size(); ++i) {
+		const RectInt &r = triangle_cells[i];
+		for(int y = r.miny; y < r.maxy; ++y)
+			for(int x = r.minx; x < r.maxx; ++x)
+				this->triangles[ positions[y*size_x + x]++ ] = i;
+	}
+}
+
+bool
+Mesh::CoordIndex::find(const Vector &point, const int *&begin, const int *&end) const
+{
+	if ( cells.empty()
+	  || !(point[0] >= bounds.minx && point[0] <= bounds.maxx
+	    && point[1] >= bounds.miny && point[1] <= bounds.maxy) )
+		return false;
+	const int x = std::min(size_x - 1, (int)((point[0] - bounds.minx)*cells_per_unit[0]));
+	const int y = std::min(size_y - 1, (int)((point[1] - bounds.miny)*cells_per_unit[1]));
+	const int cell = y*size_x + x;
+	begin = triangles.data() + cells[cell];
+	end = triangles.data() + cells[cell + 1];
+	return begin != end;
+}
+
 Mesh::Mesh():
+	world_index_built(false),
+	texture_index_built(false),
 	resolution_transfrom_calculated(false) { }
 
 void
 Mesh::assign(const Mesh &other) {
 	vertices = other.vertices;
 	triangles = other.triangles;
+	reset_coord_index();
 	
 	// other mesh is constant, so we need to lock mutexes for read the relolution data
 	// see comment for calculate_resolution_transfrom() declaration
@@ -72,12 +181,38 @@ Mesh::clear()
 	vertices.clear();
 	triangles.clear();
 	reset_resolution_transfrom();
+	reset_coord_index();
 }
 
 void
 Mesh::reset_resolution_transfrom()
 	{ resolution_transfrom_calculated = false; }
 
+void
+Mesh::reset_coord_index()
+{
+	std::lock_guard<std::mutex> lock(coord_index_mutex);
+	world_index_built = false;
+	texture_index_built = false;
+	world_index.clear();
+	texture_index.clear();
+}
+
+const Mesh::CoordIndex&
+Mesh::get_coord_index(bool by_tex_coords) const
+{
+	std::atomic<bool> &built = by_tex_coords ? texture_index_built : world_index_built;
+	CoordIndex &index = by_tex_coords ? texture_index : world_index;
+	if (!built.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock(coord_index_mutex);
+		if (!built.load(std::memory_order_relaxed)) {
+			index.build(vertices, triangles, by_tex_coords);
+			built.store(true, std::memory_order_release);
+		}
+	}
+	return index;
+}
+
 Rect
 Mesh::calc_target_rectangle() const
 {
@@ -197,38 +332,50 @@ Mesh::transform_coord_world_to_texture(
 bool
 Mesh::transform_coord_world_to_texture(const Vector &src, Vector &dest) const
 {
+	const int *begin, *end;
+	if (!get_coord_index(false).find(src, begin, end))
+		return false;
+
 	// process triangles backward
-	for(TriangleList::const_reverse_iterator ri = triangles.rbegin(); ri != triangles.rend(); ++ri)
+	while(end != begin) {
+		const Triangle &t = triangles[*--end];
 		if (transform_coord_world_to_texture(
 			src,
 			dest,
-			vertices[ri->vertices[0]].position,
-			vertices[ri->vertices[0]].tex_coords,
-			vertices[ri->vertices[1]].position,
-			vertices[ri->vertices[1]].tex_coords,
-			vertices[ri->vertices[2]].position,
-			vertices[ri->vertices[2]].tex_coords
+			vertices[t.vertices[0]].position,
+			vertices[t.vertices[0]].tex_coords,
+			vertices[t.vertices[1]].position,
+			vertices[t.vertices[1]].tex_coords,
+			vertices[t.vertices[2]].position,
+			vertices[t.vertices[2]].tex_coords
 		))
 			return true;
+	}
 	return false;
 }
 
 bool
 Mesh::transform_coord_texture_to_world(const Vector &src, Vector &dest) const
 {
+	const int *begin, *end;
+	if (!get_coord_index(true).find(src, begin, end))
+		return false;
+
 	// process triangles backward
-	for(TriangleList::const_reverse_iterator ri = triangles.rbegin(); ri != triangles.rend(); ++ri)
+	while(end != begin) {
+		const Triangle &t = triangles[*--end];
 		if (transform_coord_texture_to_world(
 			src,
 			dest,
-			vertices[ri->vertices[0]].position,
-			vertices[ri->vertices[0]].tex_coords,
-			vertices[ri->vertices[1]].position,
-			vertices[ri->vertices[1]].tex_coords,
-			vertices[ri->vertices[2]].position,
-			vertices[ri->vertices[2]].tex_coords
+			vertices[t.vertices[0]].position,
+			vertices[t.vertices[0]].tex_coords,
+			vertices[t.vertices[1]].position,
+			vertices[t.vertices[1]].tex_coords,
+			vertices[t.vertices[2]].position,
+			vertices[t.vertices[2]].tex_coords
 		))
 			return true;
+	}
 	return false;
 }
 
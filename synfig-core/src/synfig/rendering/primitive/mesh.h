@@ -30,6 +30,7 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <atomic>
 #include <cstring>
 
 #include <vector>
@@ -81,6 +82,33 @@ public:
 	TriangleList triangles;
 
 private:
+	//! Uniform grid of triangles, used to find triangles which contain a point.
+	//! Each cell holds indices of triangles in ascending order,
+	//! so the search from the end of the cell keeps "last triangle wins" rule
+	struct CoordIndex
+	{
+		Rect bounds;
+		int size_x;
+		int size_y;
+		Vector cells_per_unit;
+		std::vector<int> cells;     //!< offsets in triangles list for each cell, plus the end
+		std::vector<int> triangles;
+
+		CoordIndex(): size_x(), size_y() { }
+		void clear();
+		void build(const VertexList &vertices, const TriangleList &triangles, bool by_tex_coords);
+		//! returns range of triangles of the cell which contains the point
+		bool find(const Vector &point, const int *&begin, const int *&end) const;
+	};
+
+	mutable std::mutex coord_index_mutex;
+	mutable std::atomic<bool> world_index_built;
+	mutable std::atomic<bool> texture_index_built;
+	mutable CoordIndex world_index;
+	mutable CoordIndex texture_index;
+
+	const CoordIndex& get_coord_index(bool by_tex_coords) const;
+
 	mutable std::mutex resolution_transfrom_read_mutex;
 	mutable bool resolution_transfrom_calculated;
 	mutable Rect target_rectangle;
@@ -94,6 +122,8 @@ public:
 	void assign(const Mesh &other);
 	void clear();
 	void reset_resolution_transfrom();
+	//! Call it when vertices or triangles are changed after the coords was transformed
+	void reset_coord_index();
 
 	Rect calc_target_rectangle() const;
 	Rect calc_target_rectangle(const Matrix &transform_matrix) const;
@@ -108,6 +138,8 @@ public:
 	Rect get_target_rectangle() const;
 	Rect get_source_rectangle() const;
 
+	// the triangle with the greatest index is used when several triangles contain the point,
+	// lookup index is built at the first call, it is thread-safe for constant meshes like above
 	bool transform_coord_world_to_texture(const Vector &src, Vector &dest) const;
 	bool transform_coord_texture_to_world(const Vector &src, Vector &dest) const;
 
@@ -37,7 +37,7 @@
 
 #include "polyspan.h"
 
-#include <algorithm> // std::sort
+#include <algorithm> // std::stable_sort
 #include <cassert>
 
 #include <synfig/general.h>
@@ -141,7 +141,7 @@ void
 Polyspan::merge_all()
 {
 	finish_line();
-	std::sort(covers.begin(),covers.end());
+	sort_covers(0);
 	open_index = 0;
 }
 
@@ -156,11 +156,59 @@ Polyspan::sort_marks()
 		addcurrent();
 		current.setcover(0,0);
 
-		std::sort(covers.begin() + open_index,covers.end());
+		sort_covers(open_index);
 		flags &= ~NotSorted;
 	}
 }
 
+//stable sort of marks from index by scanline and then by column
+void
+Polyspan::sort_covers(int begin)
+{
+	const int count = (int)covers.size() - begin;
+	if (count < 2) return;
+	const cover_array::iterator first = covers.begin() + begin;
+
+	int minx = first->x, maxx = first->x;
+	int miny = first->y, maxy = first->y;
+	for(cover_array::const_iterator i = first + 1; i != covers.end(); ++i) {
+		if (i->x < minx) minx = i->x; else
+		if (i->x > maxx) maxx = i->x;
+		if (i->y < miny) miny = i->y; else
+		if (i->y > maxy) maxy = i->y;
+	}
+
+	// few or sparse marks are cheaper to sort by comparison
+	const long long columns = (long long)maxx - minx + 1;
+	const long long rows = (long long)maxy - miny + 1;
+	const long long limit = 4ll*count + 4096;
+	if (count < 64 || columns > limit || rows > limit) {
+		std::stable_sort(first, covers.end());
+		return;
+	}
+
+	// two passes of counting sort: by column and then by scanline,
+	// both passes keep order of equal marks, so the result is the same as of std::stable_sort
+	std::vector<int> offsets((size_t)std::max(columns, rows) + 1);
+	cover_array buffer(count);
+
+	std::fill(offsets.begin(), offsets.begin() + columns + 1, 0);
+	for(cover_array::const_iterator i = first; i != covers.end(); ++i)
+		++offsets[i->x - minx + 1];
+	for(int column = 1; column < columns; ++column)
+		offsets[column] += offsets[column - 1];
+	for(cover_array::const_iterator i = first; i != covers.end(); ++i)
+		buffer[ offsets[i->x - minx]++ ] = *i;
+
+	std::fill(offsets.begin(), offsets.begin() + rows + 1, 0);
+	for(cover_array::const_iterator i = buffer.begin(); i != buffer.end(); ++i)
+		++offsets[i->y - miny + 1];
+	for(int row = 1; row < rows; ++row)
+		offsets[row] += offsets[row - 1];
+	for(cover_array::const_iterator i = buffer.begin(); i != buffer.end(); ++i)
+		first[ offsets[i->y - miny]++ ] = *i;
+}
+
 //encapsulate the current sublist of marks (used for drawing)
 void
 Polyspan::encapsulate_current()
@@ -666,6 +714,106 @@ Polyspan::cubic_to(Real x, Real y, Real x1, Real y1, Real x2, Real y2, Real deta
 }
 
 
+bool
+Polyspan::flatten_conic(std::vector<Point> &out_points, Real x0, Real y0, Real x, Real y, Real x1, Real y1, Real detail)
+{
+	// same steps as in conic_to(), except of clipping
+	Point arc[3*MAX_SUBDIVISION_SIZE + 1];
+	x = clamp_coord(x);
+	y = clamp_coord(y);
+	x1 = clamp_coord(x1);
+	y1 = clamp_coord(y1);
+	detail = clamp_detail(detail);
+
+	arc[0] = Point(x,y);
+	arc[1] = Point(x1,y1);
+	arc[2] = Point(clamp_coord(x0),clamp_coord(y0));
+	if (max_edges_conic(arc) <= detail*0.5)
+		return false;
+
+	Point *current = arc;
+	Point *last = arc + sizeof(arc)/sizeof(*arc) - 2;
+	detail = std::max(0.1, detail*0.5);
+	while(current >= arc)
+	{
+		if(current >= last)
+		{
+			out_points.push_back(Point(x, y));
+			return true;
+		}else
+		if(max_edges_conic(current) > detail)
+		{
+			subd_conic_stack(current);
+			current += 2;
+		}else
+		{
+			out_points.push_back(current[1]);
+			out_points.push_back(current[0]);
+			current -= 2;
+		}
+	}
+	return true;
+}
+
+bool
+Polyspan::flatten_cubic(std::vector<Point> &out_points, Real x0, Real y0, Real x, Real y, Real x1, Real y1, Real x2, Real y2, Real detail)
+{
+	// same steps as in cubic_to(), except of clipping
+	Point arc[3*MAX_SUBDIVISION_SIZE + 1];
+	x = clamp_coord(x);
+	y = clamp_coord(y);
+	x1 = clamp_coord(x1);
+	y1 = clamp_coord(y1);
+	x2 = clamp_coord(x2);
+	y2 = clamp_coord(y2);
+	detail = clamp_detail(detail);
+
+	arc[0] = Point(x,y);
+	arc[1] = Point(x2,y2);
+	arc[2] = Point(x1,y1);
+	arc[3] = Point(clamp_coord(x0),clamp_coord(y0));
+	if (max_edges_cubic(arc) <= detail*0.5)
+		return false;
+
+	Point *current = arc;
+	Point *last = arc + sizeof(arc)/sizeof(*arc) - 3;
+	detail = std::max(0.1, detail*0.5);
+	while(current >= arc)
+	{
+		if(current >= last)
+		{
+			out_points.push_back(Point(x, y));
+			return true;
+		}else
+		if(max_edges_cubic(current) > detail)
+		{
+			subd_cubic_stack(current);
+			current += 3;
+		}else
+		{
+			out_points.push_back(current[2]);
+			out_points.push_back(current[1]);
+			out_points.push_back(current[0]);
+			current -= 3;
+		}
+	}
+	return true;
+}
+
+bool
+Polyspan::polyline_to(Real x0, Real y0, const Point *begin, const Point *end, const Rect &bounds)
+{
+	// curve is never clipped, when all its control points are inside of the window
+	if ( (flags & NotFinishedLine)
+	  || cur_x != x0 || cur_y != y0
+	  || !(bounds.minx >= window.minx && bounds.maxx <= window.maxx
+	    && bounds.miny >= window.miny && bounds.maxy <= window.maxy) )
+		return false;
+	for(const Point *p = begin; p < end; ++p)
+		line_to((*p)[0], (*p)[1], 0.0);
+	return true;
+}
+
 void
 Polyspan::draw_scanline(int y, Real x1, Real y1, Real x2, Real y2)
 {
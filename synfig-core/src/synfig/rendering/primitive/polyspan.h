@@ -133,6 +133,9 @@ private:
 
 	void finish_line();
 
+	//stable sort of marks from index by scanline and then by column
+	void sort_covers(int begin);
+
 public:
 	Polyspan();
 
@@ -175,6 +178,16 @@ public:
 	void conic_to(Real x, Real y, Real x1, Real y1, Real detail = 1.0);
 	void cubic_to(Real x, Real y, Real x1, Real y1, Real x2, Real y2, Real detail = 1.0);
 
+	//split curve from (x0, y0) into lines exactly as conic_to() and cubic_to() do when the curve is inside of the window,
+	//ends of lines are appended to out_points, returns false if curve is small and would be drawn as single line
+	static bool flatten_conic(std::vector<Point> &out_points, Real x0, Real y0, Real x, Real y, Real x1, Real y1, Real detail = 1.0);
+	static bool flatten_cubic(std::vector<Point> &out_points, Real x0, Real y0, Real x, Real y, Real x1, Real y1, Real x2, Real y2, Real detail = 1.0);
+
+	//draw lines through curve flattened by flatten_conic() or flatten_cubic(),
+	//returns false and draws nothing if conic_to() or cubic_to() would draw the curve in the other way:
+	//when the pen is not at (x0, y0), the last line is not finished or bounds of curve are out of the window
+	bool polyline_to(Real x0, Real y0, const Point *begin, const Point *end, const Rect &bounds);
+
 	void draw_scanline(int y, Real x1, Real y1, Real x2, Real y2);
 	void draw_line(Real x1, Real y1, Real x2, Real y2);
 
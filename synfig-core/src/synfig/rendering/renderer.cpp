@@ -43,6 +43,7 @@
 #include <synfig/debug/debugsurface.h>
 #include <synfig/debug/log.h>
 #include <synfig/debug/measure.h>
+#include <synfig/debug/profile.h>
 
 #include "renderer.h"
 #include "renderqueue.h"
@@ -505,6 +506,9 @@ Renderer::optimize(Task::List &list) const
 	while(categories_to_process &= Optimizer::CATEGORY_ALL)
 	{
 		while (prepared_category_id < current_category_id) {
+			debug::Profile::Scope profile_scope("optimizer", "prepare");
+			if (profile_scope.is_active())
+				profile_scope.set_name(strprintf("prepare category %d", prepared_category_id + 1));
 			switch (++prepared_category_id) {
 			case Optimizer::CATEGORY_ID_COORDS:
 				calc_coords(list); break;
@@ -581,6 +585,10 @@ Renderer::optimize(Task::List &list) const
 		debug::Measure t(strprintf("optimize category %d index %d", current_category_id, current_optimizer_index));
 		#endif
 
+		debug::Profile::Scope profile_scope("optimizer", "optimize");
+		if (profile_scope.is_active())
+			profile_scope.set_name(strprintf("optimize category %d index %d", current_category_id, current_optimizer_index));
+
 		#ifdef DEBUG_OPTIMIZATION_COUNTERS
 		std::atomic<int> calls_count(0), *calls_count_ptr = &calls_count;
 		std::atomic<int> optimizations_count(0), *optimizations_count_ptr = &optimizations_count;
@@ -838,8 +846,14 @@ Renderer::enqueue(const Task::List &list, const TaskEvent::Handle &finish_event_
 		log(get_debug_options().task_list_log, list, "input list");
 
 	Task::List optimized_list(list);
-	optimize(optimized_list);
-	find_deps(optimized_list, ++last_batch_index);
+	{
+		debug::Profile::Scope profile_scope("renderer", "optimize");
+		optimize(optimized_list);
+	}
+	{
+		debug::Profile::Scope profile_scope("renderer", "find dependencies");
+		find_deps(optimized_list, ++last_batch_index);
+	}
 
 	#ifdef DEBUG_TASK_LIST
 	if (!quiet) log("", optimized_list, "optimized list");
@@ -40,6 +40,7 @@
 #include <synfig/debug/debugsurface.h>
 #include <synfig/debug/log.h>
 #include <synfig/debug/measure.h>
+#include <synfig/debug/profile.h>
 
 #include "renderqueue.h"
 #include "renderer.h"
@@ -86,7 +87,63 @@ Task::Token TaskSubQueue::token(
 } // end of anonimous namespace
 
 
-RenderQueue::RenderQueue(): started(false) { start(); }
+namespace {
+	// index of the rendering thread, which runs the current code,
+	// it allows to push ready tasks to the queue of the current thread
+	thread_local const RenderQueue *current_queue = nullptr;
+	thread_local int current_thread_index = -1;
+}
+
+
+// RenderQueue::ReadyQueue
+
+void
+RenderQueue::ReadyQueue::push(const Task::Handle &task)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	tasks.push_back(task);
+}
+
+Task::Handle
+RenderQueue::ReadyQueue::pop_front()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (tasks.empty()) return Task::Handle();
+	Task::Handle task = tasks.front();
+	tasks.pop_front();
+	return task;
+}
+
+Task::Handle
+RenderQueue::ReadyQueue::pop_back()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (tasks.empty()) return Task::Handle();
+	Task::Handle task = tasks.back();
+	tasks.pop_back();
+	return task;
+}
+
+void
+RenderQueue::ReadyQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	tasks.clear();
+}
+
+
+// RenderQueue
+
+RenderQueue::RenderQueue():
+	started(false),
+	ready_count(0),
+	single_ready_count(0),
+	sleeping_count(0),
+	single_sleeping_count(0)
+{
+	start();
+}
+
 RenderQueue::~RenderQueue() { stop(); }
 
 void
@@ -110,12 +167,16 @@ RenderQueue::start()
 	if (count > SYNFIG_RENDERING_MAX_THREADS) count = SYNFIG_RENDERING_MAX_THREADS;
 	if (count < 2) count = 2;
 
+	// queues must be ready before the first thread starts
+	while(ready_queues.size() < count)
+		ready_queues.emplace_back();
+
+	started = true;
 	for(unsigned int i = 0; i < count; ++i)
 		threads.push_back(
 			std::thread(
 				sigc::bind(sigc::mem_fun(*this, &RenderQueue::process), i) ));
 	info("rendering threads %d", count);
-	started = true;
 }
 
 void
@@ -134,13 +195,31 @@ RenderQueue::stop()
 void
 RenderQueue::process(int thread_index)
 {
+	current_queue = this;
+	current_thread_index = thread_index;
+
 	while(Task::Handle task = get(thread_index))
 	{
+		Task::RendererData &rd = task->renderer_data;
+
+		// task may be cancelled while it was in the queue,
+		// then just notify dependent tasks
+		int state = Task::RendererData::STATE_READY;
+		if (!rd.state.compare_exchange_strong(state, Task::RendererData::STATE_RUNNING))
+		{
+			assert(state == Task::RendererData::STATE_CANCELLED);
+			done(thread_index, task);
+			continue;
+		}
+
+		// all dependencies are finished, so nobody touches this set now
+		rd.deps.clear();
+
 		#ifdef DEBUG_THREAD_TASK
 		info( "thread %d: begin task #%05d-%04d '%s'",
 			  thread_index,
-			  task->renderer_data.batch_index,
-			  task->renderer_data.index,
+			  rd.batch_index,
+			  rd.index,
 			  task->get_token()->name.c_str() );
 		#endif
 
@@ -152,114 +231,178 @@ RenderQueue::process(int thread_index)
 		}
 
 		bool success = false;
-		try {
-			success = task->run(task->renderer_data.params);
-		} catch(...) { }
+		{
+			debug::Profile::Scope profile_scope("task", "task");
+			if (profile_scope.is_active()) {
+				profile_scope.set_name(task->get_token()->name);
+				profile_scope.set_args(strprintf(
+					"\"thread\":%d,\"batch\":%d,\"index\":%d,\"rect\":[%d,%d,%d,%d]",
+					thread_index,
+					rd.batch_index,
+					rd.index,
+					task->target_rect.minx, task->target_rect.miny,
+					task->target_rect.maxx, task->target_rect.maxy ));
+			}
+			try {
+				success = task->run(rd.params);
+			} catch(...) { }
+		}
 		if (!success)
-			task->renderer_data.success = false;
+			rd.success = false;
 
 		#ifdef DEBUG_TASK_SURFACE
 		debug::DebugSurface::save_to_file(
 			task->target_surface,
 			strprintf(
 				"task-%05d-%04d-%05d",
-				task->renderer_data.batch_index,
-				task->renderer_data.index,
+				rd.batch_index,
+				rd.index,
 				task->target_surface ? task->target_surface->get_id() : 0 ));
 		#endif
 
 		#ifdef DEBUG_THREAD_TASK
 		info( "thread %d: end task #%05d-%04d '%s'",
 			  thread_index,
-			  task->renderer_data.batch_index,
-			  task->renderer_data.index,
+			  rd.batch_index,
+			  rd.index,
 			  task->get_token()->name.c_str() );
 		#endif
 
-		if (!task->renderer_data.params.sub_queue.empty())
+		if (!rd.params.sub_queue.empty())
 		{
-			if (task->renderer_data.params.renderer)
+			if (rd.params.renderer)
 			{
 				TaskSubQueue::Handle task_sub_queue(new TaskSubQueue());
 				task_sub_queue->sub_task() = task;
-				task->renderer_data.params.renderer->enqueue(task->renderer_data.params.sub_queue, task_sub_queue, true);
+				rd.params.renderer->enqueue(rd.params.sub_queue, task_sub_queue, true);
 				continue;
 			}
-			task->renderer_data.success = false;
+			rd.success = false;
 		}
 
 		done(thread_index, task);
 	}
+
+	current_queue = nullptr;
+	current_thread_index = -1;
+}
+
+void
+RenderQueue::push_ready(const Task::Handle &task)
+{
+	// counter is incremented before push, so sleeping threads never miss the task
+	if (!task->get_allow_multithreading()) {
+		++single_ready_count;
+		ready_queues.front().push(task);
+	} else
+	if (current_queue == this && current_thread_index > 0) {
+		++ready_count;
+		ready_queues[current_thread_index].push(task);
+	} else {
+		++ready_count;
+		incoming_tasks.push(task);
+	}
+}
+
+void
+RenderQueue::wakeup(int signals, int single_signals)
+{
+	// limit signals count
+	int threads = get_threads_count() - 1;
+	if (signals > threads) signals = threads;
+	if (single_signals > 1) single_signals = 1;
+
+	if (signals > 0 && sleeping_count > 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		while(signals-- > 0) cond.notify_one();
+	}
+	if (single_signals > 0 && single_sleeping_count > 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		single_cond.notify_one();
+	}
 }
 
 void
 RenderQueue::done(int thread_index, const Task::Handle &task)
 {
 	assert(task);
+	Task::RendererData &rd = task->renderer_data;
+
+	int state = Task::RendererData::STATE_RUNNING;
+	rd.state.compare_exchange_strong(state, Task::RendererData::STATE_DONE);
+
+	// back_deps is not changed after enqueue, and only the thread
+	// which finishes the task may read it now
 	int single_signals = 0;
 	int signals = 0;
-	std::lock_guard<std::mutex> lock(mutex);
-	for(Task::Set::iterator i = task->renderer_data.back_deps.begin(); i != task->renderer_data.back_deps.end(); ++i)
+	for(Task::Set::const_iterator i = rd.back_deps.begin(); i != rd.back_deps.end(); ++i)
 	{
 		assert(*i);
-		(*i)->renderer_data.deps.erase(task);
-		if ((*i)->renderer_data.deps.empty())
+		Task::RendererData &back_rd = (*i)->renderer_data;
+		if (--back_rd.deps_count == 0)
 		{
-			bool mt = (*i)->get_allow_multithreading();
-			TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-			TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-			wait.erase(*i);
-			queue.push_back(*i);
-			++(mt ? signals : single_signals);
+			// cancelled tasks are also passed to the queue,
+			// they will not be run, but they should notify their own dependent tasks
+			int waiting = Task::RendererData::STATE_WAITING;
+			back_rd.state.compare_exchange_strong(waiting, Task::RendererData::STATE_READY);
+			push_ready(*i);
+			++((*i)->get_allow_multithreading() ? signals : single_signals);
 		}
 	}
-	task->renderer_data.back_deps.clear();
-	assert( tasks_in_process.count(thread_index) == 1 );
-	tasks_in_process.erase(thread_index);
-	//info("rendering threads used %d", tasks_in_process.size());
-
-	// limit signals count
-	int threads = get_threads_count() - 1;
-	if (signals > threads) signals = threads;
-	if (single_signals > 1) single_signals = 1;
+	rd.back_deps.clear();
 
 	// we don't need to wakeup the current thread
 	--(thread_index ? signals : single_signals);
+	wakeup(signals, single_signals);
+}
+
+Task::Handle
+RenderQueue::take(int thread_index)
+{
+	Task::Handle task;
+	if (!thread_index)
+	{
+		task = ready_queues.front().pop_front();
+		if (task) --single_ready_count;
+		return task;
+	}
 
-	// wake up
-	while(signals-- > 0) cond.notify_one();
-	while(single_signals-- > 0) single_cond.notify_one();
+	// own queue first, then incoming tasks, then steal from other threads
+	task = ready_queues[thread_index].pop_back();
+	if (!task)
+		task = incoming_tasks.pop_front();
+	for(int i = 1, count = (int)ready_queues.size(); !task && i < count; ++i)
+	{
+		int index = (thread_index + i) % count;
+		if (index)
+			task = ready_queues[index].pop_front();
+	}
+	if (task) --ready_count;
+	return task;
 }
 
 Task::Handle
 RenderQueue::get(int thread_index)
 {
-	std::unique_lock<std::mutex> lock(mutex);
+	std::atomic<int> &count    = thread_index ? ready_count    : single_ready_count;
+	std::atomic<int> &sleeping = thread_index ? sleeping_count : single_sleeping_count;
+	std::condition_variable &c = thread_index ? cond           : single_cond;
 
-	TaskQueue &queue  = thread_index == 0 ? single_ready_tasks     : ready_tasks;
-	TaskQueue &queue2 = thread_index != 0 ? single_ready_tasks     : ready_tasks;
-	TaskSet   &wait   = thread_index == 0 ? single_not_ready_tasks : not_ready_tasks;
 	while(started)
 	{
-		if (!queue.empty())
-		{
-			Task::Handle task = queue.front();
-			queue.pop_front();
-			if (!task) continue;
-			assert( tasks_in_process.count(thread_index) == 0 );
-			tasks_in_process[thread_index] = task;
-			//info("rendering threads used %d", tasks_in_process.size());
+		if (Task::Handle task = take(thread_index))
 			return task;
-		}
 
-		#ifdef DEBUG_THREAD_WAIT
-		if (!wait.empty())
+		std::unique_lock<std::mutex> lock(mutex);
+		++sleeping;
+		while(started && count <= 0)
+		{
+			#ifdef DEBUG_THREAD_WAIT
 			info("thread %d: rendering wait for task", thread_index);
-		#endif
-
-		assert( wait.empty() || !tasks_in_process.empty() || !queue2.empty() );
-
-		(thread_index ? cond : single_cond).wait(lock);
+			#endif
+			c.wait(lock);
+		}
+		--sleeping;
 	}
 	return Task::Handle();
 }
@@ -267,11 +410,13 @@ RenderQueue::get(int thread_index)
 void
 RenderQueue::fix_task(const Task &task, const Task::RunParams &params)
 {
-	//for(Task::List::iterator i = task.back_deps.begin(); i != task.back_deps.end();)
-	//	if (*i) ++i; else i = (*i)->back_deps.erase(i);
-	task.renderer_data.params = params;
-	task.renderer_data.params.sub_queue.clear();
-	task.renderer_data.success = true;
+	Task::RendererData &rd = task.renderer_data;
+	rd.params = params;
+	rd.params.sub_queue.clear();
+	rd.success = true;
+	rd.deps_count = (int)rd.deps.size();
+	rd.back_deps_count = (int)rd.back_deps.size();
+	rd.state = Task::RendererData::STATE_WAITING;
 }
 
 int
@@ -280,81 +425,32 @@ RenderQueue::get_threads_count() const
 	return threads.size();
 }
 
-bool
-RenderQueue::remove_if_orphan(const Task::Handle &task, bool in_queue)
-{
-	// mutex must be already locked
-
-	if (!task)
-		return true;
-
-	TaskSet* tasks = nullptr;
-	TaskSet::iterator ii;
-	if (!in_queue) {
-		bool mt = task->get_allow_multithreading();
-		tasks = mt ? &not_ready_tasks : &single_not_ready_tasks;
-		ii = tasks->find(task);
-		if (ii == tasks->end())
-			return true;
-	}
-
-	if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
-		if (!task_event->is_finished())
-			return false;
-
-	if (!task->renderer_data.back_deps.empty())
-		return false;
-		
-	for(TaskSet::iterator i = task->renderer_data.deps.begin(); i != task->renderer_data.deps.end(); ++i)
-		if (*i) {
-			(*i)->renderer_data.back_deps.erase(task);
-			if ((*i)->renderer_data.back_deps.empty())
-				remove_if_orphan(*i, false);
-		}
-	task->renderer_data.deps.clear();
-
-	// don't remove task if 'in_queue' is set (it will removed by caller)
-	if (tasks) tasks->erase(ii);
-	return true;
-}
-
 void
-RenderQueue::remove_orphans()
+RenderQueue::cancel_recursive(const Task::Handle &task)
 {
-	// mutex must be already locked
-
-	for(TaskQueue::iterator i = ready_tasks.begin(); i != ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) ready_tasks.erase(i++); else ++i;
-	for(TaskQueue::iterator i = single_ready_tasks.begin(); i != single_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) single_ready_tasks.erase(i++); else ++i;
-
-	for(TaskSet::iterator i = not_ready_tasks.begin(); i != not_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) not_ready_tasks.erase(i++); else ++i;
-	for(TaskSet::iterator i = single_not_ready_tasks.begin(); i != single_not_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) single_not_ready_tasks.erase(i++); else ++i;
+	if (!task)
+		return;
+
+	// only tasks which are not started yet may be cancelled
+	Task::RendererData &rd = task->renderer_data;
+	int state = Task::RendererData::STATE_WAITING;
+	if ( !rd.state.compare_exchange_strong(state, Task::RendererData::STATE_CANCELLED)
+	  && !( state == Task::RendererData::STATE_READY
+	     && rd.state.compare_exchange_strong(state, Task::RendererData::STATE_CANCELLED) ))
+		return;
+
+	// the cancelled task will never run, so this thread owns its deps now,
+	// dependencies which are not required by anyone else are cancelled too
+	for(Task::Set::const_iterator i = rd.deps.begin(); i != rd.deps.end(); ++i)
+		if (*i && --(*i)->renderer_data.back_deps_count <= 0)
+			cancel_recursive(*i);
+	rd.deps.clear();
 }
 
-
 void
 RenderQueue::enqueue(const Task::Handle &task, const Task::RunParams &params)
 {
-	if (!task) return;
-	fix_task(*task, params);
-	std::lock_guard<std::mutex> lock(mutex);
-
-	bool mt = task->get_allow_multithreading();
-	TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-	TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-	if (task->renderer_data.deps.empty()) {
-		queue.push_back(task);
-		(mt ? cond : single_cond).notify_one();
-	}
-	else
-	{
-		wait.insert(task);
-	}
-
-	remove_orphans();
+	enqueue(Task::List(1, task), params);
 }
 
 void
@@ -362,62 +458,37 @@ RenderQueue::enqueue(const Task::List &tasks, const Task::RunParams &params)
 {
 	Task::RunParams p(params);
 	p.sub_queue.clear();
+
+	// all counters must be initialized before the first task will be passed to threads
 	int count = 0;
 	for(Task::List::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
 		if (*i) { fix_task(**i, p); ++count; }
 	if (!count) return;
 
-	std::lock_guard<std::mutex> lock(mutex);
 	int single_signals = 0;
 	int signals = 0;
+	Task::List orphans;
 	for(Task::List::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
 	{
-		if (*i)
-		{
-			bool mt = (*i)->get_allow_multithreading();
-			if ((*i)->renderer_data.deps.empty()) {
-				TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-				queue.push_back(*i);
-				++(mt ? signals : single_signals);
-			} else {
-				TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-				wait.insert(*i);
-			}
+		if (!*i) continue;
+		Task::RendererData &rd = (*i)->renderer_data;
+
+		// nobody waits for results of this task
+		if (rd.back_deps.empty() && !TaskEvent::Handle::cast_dynamic(*i))
+			orphans.push_back(*i);
+
+		if (rd.deps.empty()) {
+			int waiting = Task::RendererData::STATE_WAITING;
+			rd.state.compare_exchange_strong(waiting, Task::RendererData::STATE_READY);
+			push_ready(*i);
+			++((*i)->get_allow_multithreading() ? signals : single_signals);
 		}
 	}
 
-	// limit signals count
-	int threads = get_threads_count() - 1;
-	if (signals > threads) signals = threads;
-	if (single_signals > 1) single_signals = 1;
-
-	// wake up
-	while(signals-- > 0) cond.notify_one();
-	while(single_signals-- > 0) single_cond.notify_one();
+	wakeup(signals, single_signals);
 
-	remove_orphans();
-}
-
-bool
-RenderQueue::remove_task(const Task::Handle &task)
-{
-	bool found = false;
-	if (task) {
-		bool mt = task->get_allow_multithreading();
-		TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-		TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-
-		for(TaskQueue::iterator i = queue.begin(); i != queue.end(); ) {
-			if (*i == task) {
-				found = true;
-				i = queue.erase(i);
-			} else {
-				++i;
-			}
-		}
-		if (wait.erase(task)) found = true;
-	}
-	return found;
+	for(Task::List::const_iterator i = orphans.begin(); i != orphans.end(); ++i)
+		cancel_recursive(*i);
 }
 
 void
@@ -425,11 +496,7 @@ RenderQueue::cancel(const Task::Handle &task)
 {
 	if (!task) return;
 
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (remove_task(task))
-			remove_orphans();
-	}
+	cancel_recursive(task);
 
 	if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
 		task_event->finish(false);
@@ -438,34 +505,19 @@ RenderQueue::cancel(const Task::Handle &task)
 void
 RenderQueue::cancel(const Task::List &list)
 {
-	if (list.empty()) return;
-
-	TaskEvent::List events;
-
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		bool found = false;
-		for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i) {
-			if (remove_task(*i))
-				found = true;
-			if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(*i))
-				events.push_back(task_event);
-		}
-		if (found) remove_orphans();
-	}
-
-	for(TaskEvent::List::const_iterator i = events.begin(); i != events.end(); ++i)
-		(*i)->finish(false);
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		cancel(*i);
 }
 
 void
 RenderQueue::clear()
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	ready_tasks.clear();
-	single_ready_tasks.clear();
-	not_ready_tasks.clear();
-	single_not_ready_tasks.clear();
+	// tasks are just dropped, the same as on program exit
+	for(ReadyQueueList::iterator i = ready_queues.begin(); i != ready_queues.end(); ++i)
+		i->clear();
+	incoming_tasks.clear();
+	ready_count = 0;
+	single_ready_count = 0;
 }
 
 /* === E N T R Y P O I N T ================================================= */
@@ -30,7 +30,9 @@
 
 /* === H E A D E R S ======================================================= */
 
-#include <map>
+#include <atomic>
+#include <deque>
+#include <list>
 
 #include <mutex>
 #include <condition_variable>
@@ -49,31 +51,57 @@ namespace synfig
 namespace rendering
 {
 
+/*!	\class RenderQueue
+**	\brief Work-stealing scheduler of rendering tasks.
+**
+**	Every rendering thread owns a queue of ready tasks. The owner takes tasks
+**	from the back of its queue, idle threads steal them from the front.
+**	Tasks which are enqueued from outside of the rendering threads go to
+**	the shared incoming queue.
+**
+**	Dependencies are resolved by atomic counters stored in Task::RendererData,
+**	so finishing of a task doesn't lock anything except the queue of the
+**	current thread.
+**
+**	Thread #0 is reserved for tasks which are not allowed to run
+**	in multiple threads (OpenGL), it processes its own queue only.
+*/
 class RenderQueue
 {
 public:
 	typedef std::list<std::thread> ThreadList;
-	typedef std::map<int, Task::Handle> ThreadTaskMap;
-	typedef std::set<Task::Handle> TaskSet;
-	typedef std::list<Task::Handle> TaskQueue;
+	typedef std::deque<Task::Handle> TaskQueue;
 
-private:
-	static int last_batch_index;
+	class ReadyQueue
+	{
+	private:
+		std::mutex mutex;
+		TaskQueue tasks;
 
+	public:
+		void push(const Task::Handle &task);
+		Task::Handle pop_front();
+		Task::Handle pop_back();
+		void clear();
+	};
+
+	typedef std::deque<ReadyQueue> ReadyQueueList;
+
+private:
 	std::mutex mutex;
-	std::mutex threads_mutex;
 	std::condition_variable cond;
 	std::condition_variable single_cond;
 
-	TaskQueue ready_tasks;
-	TaskQueue single_ready_tasks;
-	TaskSet not_ready_tasks;
-	TaskSet single_not_ready_tasks;
+	std::atomic<bool> started;
+	std::atomic<int> ready_count;
+	std::atomic<int> single_ready_count;
+	std::atomic<int> sleeping_count;
+	std::atomic<int> single_sleeping_count;
 
-	bool started;
+	ReadyQueue incoming_tasks;
+	ReadyQueueList ready_queues; //!< one queue per thread, the first one is for non-multithreading tasks
 
 	ThreadList threads;
-	ThreadTaskMap tasks_in_process;
 
 	void start();
 	void stop();
@@ -81,11 +109,13 @@ private:
 	void process(int thread_index);
 	void done(int thread_index, const Task::Handle &task);
 	Task::Handle get(int thread_index);
+	Task::Handle take(int thread_index);
+
+	void push_ready(const Task::Handle &task);
+	void wakeup(int signals, int single_signals);
+	void cancel_recursive(const Task::Handle &task);
 
 	static void fix_task(const Task &task, const Task::RunParams &params);
-	bool remove_if_orphan(const Task::Handle &task, bool in_queue);
-	void remove_orphans();
-	bool remove_task(const Task::Handle &task);
 
 public:
 	RenderQueue();
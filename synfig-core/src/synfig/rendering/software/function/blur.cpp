@@ -309,36 +309,37 @@ software::Blur::blur_fft(const Params &params)
 	const int channels = 4;
 	int rows = FFT::get_valid_count(params.src_rect.get_size()[1]);
 	int cols = FFT::get_valid_count(params.src_rect.get_size()[0]);
-	std::vector<Complex> surface(rows*cols*channels);
-	std::vector<Complex> full_pattern;
-	std::vector<Complex> row_pattern;
-	std::vector<Complex> col_pattern;
+	int half_rows = rows/2 + 1;
+	int half_cols = cols/2 + 1;
+	std::vector<Real> surface(rows*cols*channels);
+	std::vector<Real> full_pattern;
+	std::vector<Real> row_pattern;
+	std::vector<Real> col_pattern;
 	bool full = false;
 	bool cross = false;
 
-	Array<Real, 4> arr_surface((Real*)&surface.front());
-
+	// all data is real, so use real-to-complex transforms,
+	// they store only the half of spectrum
+	Array<Real, 3> arr_surface(&surface.front());
 	arr_surface
-		.set_dim(rows, cols*channels*2)
-		.set_dim(cols, channels*2)
-		.set_dim(channels, 2)
-		.set_dim(2, 1);
-	Array<Real, 3> arr_full_pattern;
+		.set_dim(rows, cols*channels)
+		.set_dim(cols, channels)
+		.set_dim(channels, 1);
+	Array<Real, 2> arr_full_pattern;
 	arr_full_pattern
-		.set_dim(rows, 2*cols)
-		.set_dim(cols, 2)
-		.set_dim(2, 1);
+		.set_dim(rows, cols)
+		.set_dim(cols, 1);
 	Array<Real, 2> arr_row_pattern;
 	arr_row_pattern
-		.set_dim(cols, 2)
-		.set_dim(2, 1);
+		.set_dim(1, cols)
+		.set_dim(cols, 1);
 	Array<Real, 2> arr_col_pattern;
 	arr_col_pattern
-		.set_dim(rows, 2)
-		.set_dim(2, 1);
+		.set_dim(1, rows)
+		.set_dim(rows, 1);
 
-	// convert surface to complex
-	BlurTemplates::surface_read(arr_surface.reorder(0, 1, 2), *params.src, VectorInt(0, 0), params.src_rect);
+	// read surface
+	BlurTemplates::surface_read(arr_surface, *params.src, VectorInt(0, 0), params.src_rect);
 
 	// alloc memory
 	switch(params.type)
@@ -349,12 +350,12 @@ software::Blur::blur_fft(const Params &params)
 	case rendering::Blur::FASTGAUSSIAN:
 		row_pattern.resize(cols);
 		col_pattern.resize(rows);
-		arr_row_pattern.pointer = (Real*)&row_pattern.front();
-		arr_col_pattern.pointer = (Real*)&col_pattern.front();
+		arr_row_pattern.pointer = &row_pattern.front();
+		arr_col_pattern.pointer = &col_pattern.front();
 		break;
 	case rendering::Blur::DISC:
 		full_pattern.resize(rows*cols);
-		arr_full_pattern.pointer = (Real*)&full_pattern.front();
+		arr_full_pattern.pointer = &full_pattern.front();
 		break;
 	default:
 		assert(false);
@@ -365,22 +366,22 @@ software::Blur::blur_fft(const Params &params)
 	switch(params.type)
 	{
 	case rendering::Blur::BOX:
-		BlurTemplates::fill_pattern_box(arr_row_pattern.reorder(0), params.amplified_size[0]);
-		BlurTemplates::fill_pattern_box(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		BlurTemplates::fill_pattern_box(arr_row_pattern[0], params.amplified_size[0]);
+		BlurTemplates::fill_pattern_box(arr_col_pattern[0], params.amplified_size[1]);
 		break;
 	case rendering::Blur::CROSS:
-		BlurTemplates::fill_pattern_box(arr_row_pattern.reorder(0), params.amplified_size[0]);
-		BlurTemplates::fill_pattern_box(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		BlurTemplates::fill_pattern_box(arr_row_pattern[0], params.amplified_size[0]);
+		BlurTemplates::fill_pattern_box(arr_col_pattern[0], params.amplified_size[1]);
 		cross = true;
 		break;
 	case rendering::Blur::GAUSSIAN:
 	case rendering::Blur::FASTGAUSSIAN:
-		BlurTemplates::fill_pattern_gauss(arr_row_pattern.reorder(0), params.amplified_size[0]);
-		BlurTemplates::fill_pattern_gauss(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		BlurTemplates::fill_pattern_gauss(arr_row_pattern[0], params.amplified_size[0]);
+		BlurTemplates::fill_pattern_gauss(arr_col_pattern[0], params.amplified_size[1]);
 		break;
 	case rendering::Blur::DISC:
 		BlurTemplates::fill_pattern_2d_disk(
-			arr_full_pattern.reorder(0, 1),
+			arr_full_pattern,
 			params.amplified_size[0],
 			params.amplified_size[1] );
 		full = true;
@@ -393,68 +394,95 @@ software::Blur::blur_fft(const Params &params)
 	// process
 	if (full)
 	{
-		BlurTemplates::mirror_pattern_2d( arr_full_pattern.reorder(0, 1) );
-		BlurTemplates::normalize_full_pattern_2d( arr_full_pattern.reorder(0, 1) );
-
-		FFT::fft2d(arr_full_pattern.group_items<Complex>(), false);
-		for(Array<Complex, 3>::Iterator channel(arr_surface.group_items<Complex>().reorder(2, 0, 1)); channel; ++channel)
+		BlurTemplates::mirror_pattern_2d( arr_full_pattern );
+		BlurTemplates::normalize_full_pattern_2d( arr_full_pattern );
+
+		std::vector<Complex> pattern_spectrum(rows*half_cols);
+		std::vector<Complex> spectrum(rows*half_cols);
+		Array<Complex, 2> arr_pattern_spectrum(&pattern_spectrum.front());
+		arr_pattern_spectrum
+			.set_dim(rows, half_cols)
+			.set_dim(half_cols, 1);
+		Array<Complex, 2> arr_spectrum(&spectrum.front(), arr_pattern_spectrum);
+
+		FFT::fft2d_real(arr_full_pattern, arr_pattern_spectrum);
+		for(Array<Real, 3>::Iterator channel(arr_surface.reorder(2, 0, 1)); channel; ++channel)
 		{
-			FFT::fft2d(*channel, false);
-			channel->process< std::multiplies<Complex> >(arr_full_pattern.group_items<Complex>());
-			FFT::fft2d(*channel, true);
+			FFT::fft2d_real(*channel, arr_spectrum);
+			arr_spectrum.process< std::multiplies<Complex> >(arr_pattern_spectrum);
+			FFT::ifft2d_real(arr_spectrum, *channel);
 		}
 	}
 	else
 	{
-		BlurTemplates::mirror_pattern( arr_row_pattern.reorder(0) );
-		BlurTemplates::mirror_pattern( arr_col_pattern.reorder(0) );
-		BlurTemplates::normalize_full_pattern( arr_row_pattern.reorder(0) );
-		BlurTemplates::normalize_full_pattern( arr_col_pattern.reorder(0) );
+		BlurTemplates::mirror_pattern( arr_row_pattern[0] );
+		BlurTemplates::mirror_pattern( arr_col_pattern[0] );
+		BlurTemplates::normalize_full_pattern( arr_row_pattern[0] );
+		BlurTemplates::normalize_full_pattern( arr_col_pattern[0] );
 
-		std::vector<Complex> surface_copy;
-		Array<Complex, 3> arr_surface_rows(arr_surface.group_items<Complex>().reorder(2, 0, 1));
-		Array<Complex, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
+		std::vector<Real> surface_copy;
+		Array<Real, 3> arr_surface_rows(arr_surface.reorder(2, 0, 1));
+		Array<Real, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
 
 		if (cross)
 		{
-			arr_row_pattern.reorder(0).process< std::multiplies<Real> >(0.5);
-			arr_col_pattern.reorder(0).process< std::multiplies<Real> >(0.5);
+			arr_row_pattern.process< std::multiplies<Real> >(0.5);
+			arr_col_pattern.process< std::multiplies<Real> >(0.5);
 			surface_copy = surface;
 			arr_surface_cols.pointer = &surface_copy.front();
 		}
 
-		FFT::fft(arr_row_pattern.group_items<Complex>(), false);
-		for(Array<Complex, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
+		std::vector<Complex> pattern_spectrum(std::max(half_cols, half_rows));
+		std::vector<Complex> spectrum(std::max(rows*half_cols, cols*half_rows));
+
+		Array<Complex, 2> arr_row_pattern_spectrum(&pattern_spectrum.front());
+		arr_row_pattern_spectrum
+			.set_dim(1, half_cols)
+			.set_dim(half_cols, 1);
+		Array<Complex, 2> arr_row_spectrum(&spectrum.front());
+		arr_row_spectrum
+			.set_dim(rows, half_cols)
+			.set_dim(half_cols, 1);
+
+		FFT::fft_real(arr_row_pattern, arr_row_pattern_spectrum);
+		for(Array<Real, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
 		{
-			FFT::fft2d(*channel, false, true, false);
-			for(Array<Complex, 2>::Iterator r(*channel); r; ++r)
-				r->process< std::multiplies<Complex> >(arr_row_pattern.group_items<Complex>());
-			FFT::fft2d(*channel, true, true, false);
+			FFT::fft_real(*channel, arr_row_spectrum);
+			for(Array<Complex, 2>::Iterator r(arr_row_spectrum); r; ++r)
+				r->process< std::multiplies<Complex> >(arr_row_pattern_spectrum[0]);
+			FFT::ifft_real(arr_row_spectrum, *channel);
 		}
 
-		FFT::fft(arr_col_pattern.group_items<Complex>(), false);
-		for(Array<Complex, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
+		Array<Complex, 2> arr_col_pattern_spectrum(&pattern_spectrum.front());
+		arr_col_pattern_spectrum
+			.set_dim(1, half_rows)
+			.set_dim(half_rows, 1);
+		Array<Complex, 2> arr_col_spectrum(&spectrum.front());
+		arr_col_spectrum
+			.set_dim(cols, half_rows)
+			.set_dim(half_rows, 1);
+
+		FFT::fft_real(arr_col_pattern, arr_col_pattern_spectrum);
+		for(Array<Real, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
 		{
-			FFT::fft2d(*channel, false, true, false);
-			for(Array<Complex, 2>::Iterator c(*channel); c; ++c)
-				c->process< std::multiplies<Complex> >(arr_col_pattern.group_items<Complex>());
-			FFT::fft2d(*channel, true, true, false);
+			FFT::fft_real(*channel, arr_col_spectrum);
+			for(Array<Complex, 2>::Iterator c(arr_col_spectrum); c; ++c)
+				c->process< std::multiplies<Complex> >(arr_col_pattern_spectrum[0]);
+			FFT::ifft_real(arr_col_spectrum, *channel);
 		}
 
-		arr_surface_rows.process< BlurTemplates::Abs<Complex> >();
+		arr_surface_rows.process< BlurTemplates::Abs<Real> >();
 		if (cross)
 		{
-			arr_surface_cols.process< BlurTemplates::Abs<Complex> >();
-			arr_surface_rows.split_items<Real>().reorder(0, 1, 2)
-				.process< std::plus<Real> >(
-					arr_surface_cols.split_items<Real>().reorder(0, 2, 1) );
+			arr_surface_cols.process< BlurTemplates::Abs<Real> >();
+			arr_surface_rows.process< std::plus<Real> >( arr_surface_cols.reorder(0, 2, 1) );
 		}
 	}
 
-	// convert surface from complex to color
+	// write surface
 	BlurTemplates::surface_write(
 		*params.dest,
-		arr_surface.reorder(0, 1, 2),
+		arr_surface,
 		params.dest_rect,
 		params.src_offset - params.src_rect.get_min(),
 		params.blend,
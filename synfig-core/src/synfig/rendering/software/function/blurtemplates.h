@@ -69,7 +69,7 @@ public:
 
 
 	template<typename T>
-	struct Abs { T operator() (const T &x) { return abs(x); } };
+	struct Abs { T operator() (const T &x) { return std::abs(x); } };
 
 	template<typename T>
 	static T gauss(const T &x, const T &r)
@@ -34,7 +34,12 @@
 
 #include "contour.h"
 
+#include <algorithm>
+
+#include <sigc++/bind.h>
+
 #include <synfig/debug/debugsurface.h>
+#include <synfig/threadpool.h>
 
 #endif
 
@@ -47,67 +52,56 @@ using namespace rendering;
 
 /* === P R O C E D U R E S ================================================= */
 
-/* === M E T H O D S ======================================================= */
+namespace {
 
+struct BandParams
+{
+	synfig::Surface *target_surface;
+	const Polyspan *polyspan;
+	bool invert;
+	bool antialias;
+	bool simple_fill;
+	rendering::Contour::WindingStyle winding_style;
+	Color color;
+	Color::value_type opacity;
+	Color::BlendMethod blend_method;
+};
+
+//! Renders sorted marks [begin, end) which all are placed in scanlines [miny, maxy)
 void
-software::Contour::render_polyspan(
-	synfig::Surface &target_surface,
-	const Polyspan &polyspan,
-	bool invert,
-	bool antialias,
-	rendering::Contour::WindingStyle winding_style,
-	const Color &color,
-	Color::value_type opacity,
-	Color::BlendMethod blend_method )
+render_band(const BandParams *params, int begin, int end, int miny, int maxy)
 {
-	bool simple_fill = (Color::BLEND_METHODS_OVERWRITE_ON_ALPHA_ONE & (1 << blend_method))
-			        && fabsf(1.f - opacity*color.get_a()) <= 1e-6;
-
-	synfig::Surface::alpha_pen p(target_surface.begin(), opacity, blend_method);
-	synfig::Surface::pen sp(target_surface.begin());
+	const Polyspan &polyspan = *params->polyspan;
+	const bool invert = params->invert;
+	const bool antialias = params->antialias;
+	const bool simple_fill = params->simple_fill;
+	const rendering::Contour::WindingStyle winding_style = params->winding_style;
+
+	synfig::Surface::alpha_pen p(params->target_surface->begin(), params->opacity, params->blend_method);
+	synfig::Surface::pen sp(params->target_surface->begin());
 	const RectInt &window = polyspan.get_window();
-	const Polyspan::cover_array &covers = polyspan.get_covers();
 
-	Polyspan::cover_array::const_iterator cur_mark = covers.begin();
-	Polyspan::cover_array::const_iterator end_mark = covers.end();
+	Polyspan::cover_array::const_iterator cur_mark = polyspan.get_covers().begin() + begin;
+	Polyspan::cover_array::const_iterator end_mark = polyspan.get_covers().begin() + end;
 
 	Real cover = 0, area = 0, alpha = 0;
 	int	y = 0, x = 0;
 
-	p.set_value(color);
-	sp.set_value(color);
+	p.set_value(params->color);
+	sp.set_value(params->color);
 	cover = 0;
 
-	if (cur_mark == end_mark)
-	{
-		// no marks at all
-		if (invert)
-		{
-			if (simple_fill)
-			{
-				sp.move_to(window.minx, window.miny);
-				sp.put_block(window.maxy - window.miny, window.maxx - window.minx);
-			}
-			else
-			{
-				p.move_to(window.minx, window.miny);
-				p.put_block(window.maxy - window.miny, window.maxx - window.minx);
-			}
-		}
-		return;
-	}
-
 	// fill initial rect / line
 	if (invert)
 	{
 		if (simple_fill)
 		{
 			// fill all the area above the first vertex
-			sp.move_to(window.minx, window.miny);
-			y = window.miny;
+			sp.move_to(window.minx, miny);
+			y = miny;
 			int l = window.maxx - window.minx;
 
-			sp.put_block(cur_mark->y - window.miny, l);
+			sp.put_block(cur_mark->y - miny, l);
 
 			// fill the area to the left of the first vertex on that line
 			l = cur_mark->x - window.minx;
@@ -117,11 +111,11 @@ software::Contour::render_polyspan(
 		else
 		{
 			// fill all the area above the first vertex
-			p.move_to(window.minx, window.miny);
-			y = window.miny;
+			p.move_to(window.minx, miny);
+			y = miny;
 			int l = window.maxx - window.minx;
 
-			p.put_block(cur_mark->y - window.miny, l);
+			p.put_block(cur_mark->y - miny, l);
 
 			// fill the area to the left of the first vertex on that line
 			l = cur_mark->x - window.minx;
@@ -141,7 +135,7 @@ software::Contour::render_polyspan(
 		cover += cur_mark->cover;
 
 		// accumulate for the current pixel
-		while(++cur_mark != covers.end())
+		while(++cur_mark != end_mark)
 		{
 			if (y != cur_mark->y || x != cur_mark->x)
 				break;
@@ -264,7 +258,7 @@ software::Contour::render_polyspan(
 
 			//fill area at the beginning of the next line
 			sp.move_to(window.minx, y+1);
-			sp.put_block(window.maxy - y - 1, window.maxx - window.minx);
+			sp.put_block(maxy - y - 1, window.maxx - window.minx);
 		}
 		else
 		{
@@ -273,9 +267,92 @@ software::Contour::render_polyspan(
 
 			//fill area at the beginning of the next line
 			p.move_to(window.minx, y+1);
-			p.put_block(window.maxy - y - 1, window.maxx - window.minx);
+			p.put_block(maxy - y - 1, window.maxx - window.minx);
+		}
+	}
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+int
+software::Contour::get_band_count(int marks)
+{
+	const int bands = marks/MIN_BAND_MARKS;
+	return bands < 2 ? 1 : std::min(bands, ThreadPool::instance().get_max_threads());
+}
+
+void
+software::Contour::render_polyspan(
+	synfig::Surface &target_surface,
+	const Polyspan &polyspan,
+	bool invert,
+	bool antialias,
+	rendering::Contour::WindingStyle winding_style,
+	const Color &color,
+	Color::value_type opacity,
+	Color::BlendMethod blend_method,
+	int bands )
+{
+	bool simple_fill = (Color::BLEND_METHODS_OVERWRITE_ON_ALPHA_ONE & (1 << blend_method))
+			        && fabsf(1.f - opacity*color.get_a()) <= 1e-6;
+
+	const RectInt &window = polyspan.get_window();
+	const Polyspan::cover_array &covers = polyspan.get_covers();
+
+	if (covers.empty())
+	{
+		// no marks at all
+		if (invert)
+		{
+			if (simple_fill)
+			{
+				synfig::Surface::pen sp(target_surface.begin());
+				sp.set_value(color);
+				sp.move_to(window.minx, window.miny);
+				sp.put_block(window.maxy - window.miny, window.maxx - window.minx);
+			}
+			else
+			{
+				synfig::Surface::alpha_pen p(target_surface.begin(), opacity, blend_method);
+				p.set_value(color);
+				p.move_to(window.minx, window.miny);
+				p.put_block(window.maxy - window.miny, window.maxx - window.minx);
+			}
+		}
+		return;
+	}
+
+	if (bands <= 0)
+		bands = get_band_count((int)covers.size());
+
+	BandParams params = {
+		&target_surface, &polyspan, invert, antialias, simple_fill,
+		winding_style, color, opacity, blend_method };
+
+	// bands of whole scanlines are independent,
+	// so each pixel is accumulated and drawn exactly as in a single pass
+	ThreadPool::Group group;
+	const int count = (int)covers.size();
+	int begin = 0;
+	int miny = window.miny;
+	for(int band = 1; band <= bands && begin < count; ++band)
+	{
+		int end = count;
+		int maxy = window.maxy;
+		if (band < bands)
+		{
+			// move the split point to the beginning of the scanline
+			end = std::max(begin + 1, (int)((long long)count*band/bands));
+			while(end < count && covers[end].y == covers[end - 1].y) ++end;
+			if (end < count) maxy = covers[end].y;
 		}
+		group.enqueue( sigc::bind( sigc::ptr_fun(&render_band), &params, begin, end, miny, maxy ));
+		begin = end;
+		miny = maxy;
 	}
+	group.run();
 }
 
 void
@@ -285,39 +362,87 @@ software::Contour::build_polyspan(
 	Polyspan &out_polyspan,
 	Real detail )
 {
-	Vector p1, pp0, pp1;
 	for(rendering::Contour::ChunkList::const_iterator i = chunks.begin(); i != chunks.end(); ++i)
+		add_chunk(*i, transform_matrix, out_polyspan, detail);
+}
+
+void
+software::Contour::build_polyspan(
+	const rendering::Contour &contour,
+	const Matrix &transform_matrix,
+	Polyspan &out_polyspan,
+	Real detail )
+{
+	// whole contour is flattened, so don't cache it when only small part of it is visible,
+	// projective transformation is not cached too
+	const Real max_size = 16384;
+	const Rect bounds = contour.get_bounds();
+	const Rect transformed_bounds = Rect( transform_matrix.get_transformed(bounds.get_min()) )
+		.expand( transform_matrix.get_transformed(bounds.get_max()) )
+		.expand( transform_matrix.get_transformed(Vector(bounds.minx, bounds.maxy)) )
+		.expand( transform_matrix.get_transformed(Vector(bounds.maxx, bounds.miny)) );
+	if ( !bounds.valid()
+	  || !(transformed_bounds.get_width() <= max_size)
+	  || !(transformed_bounds.get_height() <= max_size)
+	  || transform_matrix.m02 != 0.0
+	  || transform_matrix.m12 != 0.0
+	  || transform_matrix.m22 != 1.0 )
 	{
-		switch(i->type)
-		{
-			case rendering::Contour::CLOSE:
-				out_polyspan.close();
-				break;
-			case rendering::Contour::MOVE:
-				p1 = transform_matrix.get_transformed(i->p1);
-				out_polyspan.move_to(p1[0], p1[1]);
-				break;
-			case rendering::Contour::LINE:
-				p1 = transform_matrix.get_transformed(i->p1);
-				out_polyspan.line_to(p1[0], p1[1], detail);
-				break;
-			case rendering::Contour::CONIC:
-				p1 = transform_matrix.get_transformed(i->p1);
-				pp0 = transform_matrix.get_transformed(i->pp0);
-				out_polyspan.conic_to(p1[0], p1[1], pp0[0], pp0[1], detail);
-				break;
-			case rendering::Contour::CUBIC:
-				p1 = transform_matrix.get_transformed(i->p1);
-				pp0 = transform_matrix.get_transformed(i->pp0);
-				pp1 = transform_matrix.get_transformed(i->pp1);
-				out_polyspan.cubic_to(p1[0], p1[1], pp0[0], pp0[1], pp1[0], pp1[1], detail);
-				break;
-			default:
-				break;
-		}
+		build_polyspan(contour.get_chunks(), transform_matrix, out_polyspan, detail);
+		return;
+	}
+
+	// split curves are drawn from the cache, when Polyspan would draw them in the same way,
+	// other chunks are drawn as in the chunk path
+	const rendering::Contour::Flattened::Handle flattened = contour.get_flattened(transform_matrix, detail);
+	const Vector *points = flattened->points.empty() ? nullptr : &flattened->points.front();
+	for(rendering::Contour::Flattened::EntryList::const_iterator i = flattened->entries.begin(); i != flattened->entries.end(); ++i)
+	{
+		if ( i->polyline
+		  && out_polyspan.polyline_to(
+				points[i->begin][0], points[i->begin][1],
+				points + i->begin + 1, points + i->end, i->bounds ))
+			continue;
+		add_chunk(i->chunk, transform_matrix, out_polyspan, detail);
 	}
 }
 
+void
+software::Contour::add_chunk(
+	const rendering::Contour::Chunk &chunk,
+	const Matrix &transform_matrix,
+	Polyspan &out_polyspan,
+	Real detail )
+{
+	Vector p1, pp0, pp1;
+	switch(chunk.type)
+	{
+		case rendering::Contour::CLOSE:
+			out_polyspan.close();
+			break;
+		case rendering::Contour::MOVE:
+			p1 = transform_matrix.get_transformed(chunk.p1);
+			out_polyspan.move_to(p1[0], p1[1]);
+			break;
+		case rendering::Contour::LINE:
+			p1 = transform_matrix.get_transformed(chunk.p1);
+			out_polyspan.line_to(p1[0], p1[1], detail);
+			break;
+		case rendering::Contour::CONIC:
+			p1 = transform_matrix.get_transformed(chunk.p1);
+			pp0 = transform_matrix.get_transformed(chunk.pp0);
+			out_polyspan.conic_to(p1[0], p1[1], pp0[0], pp0[1], detail);
+			break;
+		case rendering::Contour::CUBIC:
+			p1 = transform_matrix.get_transformed(chunk.p1);
+			pp0 = transform_matrix.get_transformed(chunk.pp0);
+			pp1 = transform_matrix.get_transformed(chunk.pp1);
+			out_polyspan.cubic_to(p1[0], p1[1], pp0[0], pp0[1], pp1[0], pp1[1], detail);
+			break;
+		default:
+			break;
+	}
+}
 
 void
 software::Contour::render_contour(
@@ -51,6 +51,16 @@ namespace software
 class Contour
 {
 public:
+	enum {
+		//! minimal count of marks worth to be rendered in a separate thread
+		MIN_BAND_MARKS = 16384
+	};
+
+	//! Count of bands of scanlines to render \a marks in parallel
+	static int get_band_count(int marks);
+
+	//! Renders sorted marks of \a polyspan,
+	//! bands of scanlines are rendered in parallel, \a bands is zero to choose count automatically
 	static void render_polyspan(
 		synfig::Surface &target_surface,
 		const Polyspan &polyspan,
@@ -59,7 +69,15 @@ public:
 		rendering::Contour::WindingStyle winding_style,
 		const Color &color,
 		Color::value_type opacity,
-		Color::BlendMethod blend_method );
+		Color::BlendMethod blend_method,
+		int bands = 0 );
+
+	//! Adds single chunk to the polyspan
+	static void add_chunk(
+		const rendering::Contour::Chunk &chunk,
+		const Matrix &transform_matrix,
+		Polyspan &out_polyspan,
+		Real detail = 0.25 );
 
 	static void build_polyspan(
 		const rendering::Contour::ChunkList &chunks,
@@ -67,6 +85,15 @@ public:
 		Polyspan &out_polyspan,
 		Real detail = 0.25 );
 
+	//! Builds polyspan from the curves flattened and cached in \a contour, result is the same as built from chunks,
+	//! falls back to the chunks when the transformed contour is too big to be flattened entirely
+	//! or the transformation is not affine
+	static void build_polyspan(
+		const rendering::Contour &contour,
+		const Matrix &transform_matrix,
+		Polyspan &out_polyspan,
+		Real detail = 0.25 );
+
 	static void render_contour(
 		synfig::Surface &target_surface,
 		const rendering::Contour::ChunkList &chunks,
@@ -34,15 +34,21 @@
 
 #include <cassert>
 #include <climits>
+#include <cstdlib>
 //#include <ccomplex>
 
+#include <memory>
 #include <mutex>
 
+#include <map>
+#include <string>
 #include <vector>
 #include <set>
 
 #include <fftw3.h>
 
+#include <synfig/general.h>
+
 #include "fft.h"
 
 #endif
@@ -61,12 +67,157 @@ using namespace rendering;
 class software::FFT::Internal
 {
 public:
+	enum Kind {
+		KIND_FORWARD,
+		KIND_BACKWARD,
+		KIND_REAL_FORWARD,
+		KIND_REAL_BACKWARD
+	};
+
+	typedef std::vector<int> Key;
+	typedef std::shared_ptr<fftw_plan_s> Plan;
+	typedef std::map<Key, Plan> PlanMap;
+
+	static const size_t max_plans = 1024;
+
 	static std::set<int> counts;
-	static std::mutex mutex;
+
+	//! FFTW planner is not thread-safe, so creation and destruction of plans
+	//! are protected by this mutex, but execution of plans is not.
+	//! Mutex is recursive because plans may be destroyed when cache is cleared
+	static std::recursive_mutex mutex;
+	static PlanMap plans;
+	static unsigned int planner_flags;
+	static std::string wisdom_filename;
+	static bool wisdom_changed;
+
+	static void destroy_plan(fftw_plan plan)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		fftw_destroy_plan(plan);
+	}
+
+	//! returns count of items which should be allocated to pass to the plan
+	static size_t extent(int rank, const fftw_iodim *dims, int howmany_rank, const fftw_iodim *howmany, bool input, Kind kind)
+	{
+		bool halved = input ? kind == KIND_REAL_BACKWARD : kind == KIND_REAL_FORWARD;
+		size_t size = 1;
+		for(int i = 0; i < rank; ++i) {
+			int n = halved && i == rank - 1 ? dims[i].n/2 + 1 : dims[i].n;
+			size += (size_t)(n - 1)*std::abs(input ? dims[i].is : dims[i].os);
+		}
+		for(int i = 0; i < howmany_rank; ++i)
+			size += (size_t)(howmany[i].n - 1)*std::abs(input ? howmany[i].is : howmany[i].os);
+		return size;
+	}
+
+	static fftw_plan create_plan(Kind kind, int rank, const fftw_iodim *dims, int howmany_rank, const fftw_iodim *howmany, void *in, void *out, unsigned int flags)
+	{
+		switch(kind) {
+		case KIND_FORWARD:
+		case KIND_BACKWARD:
+			return fftw_plan_guru_dft(
+				rank, dims, howmany_rank, howmany,
+				(fftw_complex*)in, (fftw_complex*)out,
+				kind == KIND_BACKWARD ? FFTW_BACKWARD : FFTW_FORWARD, flags );
+		case KIND_REAL_FORWARD:
+			return fftw_plan_guru_dft_r2c(
+				rank, dims, howmany_rank, howmany,
+				(double*)in, (fftw_complex*)out, flags );
+		case KIND_REAL_BACKWARD:
+			return fftw_plan_guru_dft_c2r(
+				rank, dims, howmany_rank, howmany,
+				(fftw_complex*)in, (double*)out, flags );
+		}
+		return nullptr;
+	}
+
+	static Plan get_plan(Kind kind, int rank, const fftw_iodim *dims, int howmany_rank, const fftw_iodim *howmany, void *in, void *out)
+	{
+		// plan may be executed for another arrays with the same layout and alignment
+		Key key;
+		key.reserve(6 + 3*(rank + howmany_rank));
+		key.push_back(kind);
+		key.push_back(in == out);
+		key.push_back(fftw_alignment_of((double*)in));
+		key.push_back(fftw_alignment_of((double*)out));
+		key.push_back(rank);
+		key.push_back(howmany_rank);
+		for(int i = 0; i < rank; ++i)
+			{ key.push_back(dims[i].n); key.push_back(dims[i].is); key.push_back(dims[i].os); }
+		for(int i = 0; i < howmany_rank; ++i)
+			{ key.push_back(howmany[i].n); key.push_back(howmany[i].is); key.push_back(howmany[i].os); }
+
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+
+		PlanMap::const_iterator i = plans.find(key);
+		if (i != plans.end())
+			return i->second;
+
+		if (plans.size() >= max_plans)
+			plans.clear(); // plans which are executing now will be destroyed after execution
+
+		fftw_plan plan;
+		if (planner_flags & FFTW_ESTIMATE) {
+			// arrays are not touched while estimating
+			plan = create_plan(kind, rank, dims, howmany_rank, howmany, in, out, planner_flags);
+		} else {
+			// measuring overwrites the arrays, so use temporary arrays with the same alignment
+			const size_t align = 64;
+			size_t in_size = extent(rank, dims, howmany_rank, howmany, true, kind)
+			               * (kind == KIND_REAL_FORWARD ? sizeof(double) : sizeof(fftw_complex));
+			size_t out_size = extent(rank, dims, howmany_rank, howmany, false, kind)
+			                * (kind == KIND_REAL_BACKWARD ? sizeof(double) : sizeof(fftw_complex));
+			if (in == out)
+				in_size = out_size = std::max(in_size, out_size);
+
+			char *in_buffer = (char*)fftw_malloc(in_size + align);
+			char *out_buffer = in == out ? in_buffer : (char*)fftw_malloc(out_size + align);
+			plan = create_plan(
+				kind, rank, dims, howmany_rank, howmany,
+				in_buffer + fftw_alignment_of((double*)in),
+				out_buffer + fftw_alignment_of((double*)out),
+				planner_flags );
+			if (out_buffer != in_buffer) fftw_free(out_buffer);
+			fftw_free(in_buffer);
+			wisdom_changed = true;
+		}
+
+		assert(plan);
+		if (!plan) return Plan();
+		return plans[key] = Plan(plan, &destroy_plan);
+	}
+
+	static void execute(Kind kind, int rank, const fftw_iodim *dims, int howmany_rank, const fftw_iodim *howmany, void *in, void *out)
+	{
+		Plan plan = get_plan(kind, rank, dims, howmany_rank, howmany, in, out);
+		if (!plan) return;
+
+		// new-array execute functions are thread-safe
+		switch(kind) {
+		case KIND_FORWARD:
+		case KIND_BACKWARD:
+			fftw_execute_dft(plan.get(), (fftw_complex*)in, (fftw_complex*)out);
+			break;
+		case KIND_REAL_FORWARD:
+			fftw_execute_dft_r2c(plan.get(), (double*)in, (fftw_complex*)out);
+			break;
+		case KIND_REAL_BACKWARD:
+			fftw_execute_dft_c2r(plan.get(), (fftw_complex*)in, (double*)out);
+			break;
+		}
+	}
+
+	static void set_dim(fftw_iodim &dim, int n, int is, int os)
+		{ dim.n = n; dim.is = is; dim.os = os; }
 };
 
 std::set<int> software::FFT::Internal::counts;
-std::mutex software::FFT::Internal::mutex;
+std::recursive_mutex software::FFT::Internal::mutex;
+software::FFT::Internal::PlanMap software::FFT::Internal::plans;
+unsigned int software::FFT::Internal::planner_flags = FFTW_ESTIMATE;
+std::string software::FFT::Internal::wisdom_filename;
+bool software::FFT::Internal::wisdom_changed = false;
 
 void
 software::FFT::initialize()
@@ -80,13 +231,35 @@ software::FFT::initialize()
 			for(int c5 = c3; c5 < max5; c5 *= 5)
 				for(int c7 = c5; c7 < max7; c7 *= 7)
 					Internal::counts.insert(c7);
-	fftw_set_timelimit(0.0);
+
+	std::lock_guard<std::recursive_mutex> lock(Internal::mutex);
+
+	// when file for FFTW wisdom is specified, plans are measured once and stored there,
+	// otherwise plans are just estimated
+	const char *wisdom = getenv("SYNFIG_RENDERING_FFTW_WISDOM");
+	Internal::wisdom_filename = wisdom ? wisdom : "";
+	Internal::wisdom_changed = false;
+	if (Internal::wisdom_filename.empty()) {
+		Internal::planner_flags = FFTW_ESTIMATE;
+		fftw_set_timelimit(0.0);
+	} else {
+		Internal::planner_flags = FFTW_MEASURE;
+		fftw_set_timelimit(1.0);
+		fftw_import_wisdom_from_filename(Internal::wisdom_filename.c_str());
+	}
 }
 
 void
 software::FFT::deinitialize()
 {
 	Internal::counts.clear();
+
+	std::lock_guard<std::recursive_mutex> lock(Internal::mutex);
+	Internal::plans.clear();
+	if (!Internal::wisdom_filename.empty() && Internal::wisdom_changed)
+		if (!fftw_export_wisdom_to_filename(Internal::wisdom_filename.c_str()))
+			synfig::warning("FFT: cannot write FFTW wisdom to file: %s", Internal::wisdom_filename.c_str());
+	Internal::wisdom_changed = false;
 }
 
 int
@@ -116,19 +289,10 @@ software::FFT::fft(const Array<Complex, 1> &x, bool invert)
 	assert(is_valid_count(x.count));
 
 	fftw_iodim iodim;
-	iodim.n  = x.count;
-	iodim.is = x.stride;
-	iodim.os = x.stride;
-
-	{
-		std::lock_guard<std::mutex> lock(Internal::mutex);
-		fftw_plan plan = fftw_plan_guru_dft(
-			1, &iodim, 0, nullptr,
-			(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-			invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
-	}
+	Internal::set_dim(iodim, x.count, x.stride, x.stride);
+	Internal::execute(
+		invert ? Internal::KIND_BACKWARD : Internal::KIND_FORWARD,
+		1, &iodim, 0, nullptr, x.pointer, x.pointer );
 
 	// divide by count to complete back-FFT
 	if (invert)
@@ -148,34 +312,14 @@ software::FFT::fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows, bool
 	if (!do_rows && !do_cols) return;
 
 	fftw_iodim iodim[2];
-	iodim[0].n  = x.sub().count;
-	iodim[0].is = x.sub().stride;
-	iodim[0].os = x.sub().stride;
-	iodim[1].n  = x.count;
-	iodim[1].is = x.stride;
-	iodim[1].os = x.stride;
+	Internal::set_dim(iodim[0], x.sub().count, x.sub().stride, x.sub().stride);
+	Internal::set_dim(iodim[1], x.count, x.stride, x.stride);
 
-	{
-		std::lock_guard<std::mutex> lock(Internal::mutex);
-
-		fftw_plan plan;
-		if (do_rows && do_cols)
-		{
-			plan = fftw_plan_guru_dft(
-				2, iodim, 0, nullptr,
-				(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-				invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		}
-		else
-		{
-			plan = fftw_plan_guru_dft(
-				1, &iodim[do_rows ? 0 : 1], 1, &iodim[do_rows ? 1 : 0],
-				(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-				invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		}
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
-	}
+	Internal::Kind kind = invert ? Internal::KIND_BACKWARD : Internal::KIND_FORWARD;
+	if (do_rows && do_cols)
+		Internal::execute(kind, 2, iodim, 0, nullptr, x.pointer, x.pointer);
+	else
+		Internal::execute(kind, 1, &iodim[do_rows ? 0 : 1], 1, &iodim[do_rows ? 1 : 0], x.pointer, x.pointer);
 
 	// divide by count to complete back-FFT
 	if (invert)
@@ -186,4 +330,71 @@ software::FFT::fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows, bool
 	}
 }
 
+void
+software::FFT::fft_real(const Array<Real, 2> &src, const Array<Complex, 2> &dst)
+{
+	assert(src.count == dst.count);
+	assert(src.sub().count/2 + 1 == dst.sub().count);
+	if (src.count == 0 || src.sub().count == 0) return;
+
+	assert(is_valid_count(src.sub().count));
+
+	fftw_iodim iodim, howmany;
+	Internal::set_dim(iodim, src.sub().count, src.sub().stride, dst.sub().stride);
+	Internal::set_dim(howmany, src.count, src.stride, dst.stride);
+	Internal::execute(Internal::KIND_REAL_FORWARD, 1, &iodim, 1, &howmany, src.pointer, dst.pointer);
+}
+
+void
+software::FFT::ifft_real(const Array<Complex, 2> &src, const Array<Real, 2> &dst)
+{
+	assert(src.count == dst.count);
+	assert(dst.sub().count/2 + 1 == src.sub().count);
+	if (dst.count == 0 || dst.sub().count == 0) return;
+
+	assert(is_valid_count(dst.sub().count));
+
+	fftw_iodim iodim, howmany;
+	Internal::set_dim(iodim, dst.sub().count, src.sub().stride, dst.sub().stride);
+	Internal::set_dim(howmany, dst.count, src.stride, dst.stride);
+	Internal::execute(Internal::KIND_REAL_BACKWARD, 1, &iodim, 1, &howmany, src.pointer, dst.pointer);
+
+	// divide by count to complete back-FFT
+	dst.process< std::multiplies<Real> >( 1.0/(Real)dst.sub().count );
+}
+
+void
+software::FFT::fft2d_real(const Array<Real, 2> &src, const Array<Complex, 2> &dst)
+{
+	assert(src.count == dst.count);
+	assert(src.sub().count/2 + 1 == dst.sub().count);
+	if (src.count == 0 || src.sub().count == 0) return;
+
+	assert(is_valid_count(src.count) && is_valid_count(src.sub().count));
+
+	// the last dimension is the halved one
+	fftw_iodim iodim[2];
+	Internal::set_dim(iodim[0], src.count, src.stride, dst.stride);
+	Internal::set_dim(iodim[1], src.sub().count, src.sub().stride, dst.sub().stride);
+	Internal::execute(Internal::KIND_REAL_FORWARD, 2, iodim, 0, nullptr, src.pointer, dst.pointer);
+}
+
+void
+software::FFT::ifft2d_real(const Array<Complex, 2> &src, const Array<Real, 2> &dst)
+{
+	assert(src.count == dst.count);
+	assert(dst.sub().count/2 + 1 == src.sub().count);
+	if (dst.count == 0 || dst.sub().count == 0) return;
+
+	assert(is_valid_count(dst.count) && is_valid_count(dst.sub().count));
+
+	fftw_iodim iodim[2];
+	Internal::set_dim(iodim[0], dst.count, src.stride, dst.stride);
+	Internal::set_dim(iodim[1], dst.sub().count, src.sub().stride, dst.sub().stride);
+	Internal::execute(Internal::KIND_REAL_BACKWARD, 2, iodim, 0, nullptr, src.pointer, dst.pointer);
+
+	// divide by count to complete back-FFT
+	dst.process< std::multiplies<Real> >( 1.0/((Real)dst.count*(Real)dst.sub().count) );
+}
+
 /* === E N T R Y P O I N T ================================================= */
@@ -58,6 +58,21 @@ public:
 	static void fft(const Array<Complex, 1> &x, bool invert);
 	static void fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows = true, bool do_cols = true);
 
+	//! Real-to-complex transform of each row of \a src.
+	//! \a dst should have the same count of rows and src.sub().count/2 + 1 columns,
+	//! the rest of spectrum is complex conjugate
+	static void fft_real(const Array<Real, 2> &src, const Array<Complex, 2> &dst);
+	//! Inverse of fft_real(), \a src will be overwritten
+	static void ifft_real(const Array<Complex, 2> &src, const Array<Real, 2> &dst);
+
+	//! Real-to-complex 2D transform, \a dst should have src.sub().count/2 + 1 columns
+	static void fft2d_real(const Array<Real, 2> &src, const Array<Complex, 2> &dst);
+	//! Inverse of fft2d_real(), \a src will be overwritten
+	static void ifft2d_real(const Array<Complex, 2> &src, const Array<Real, 2> &dst);
+
+	//! Plans of transforms are cached until deinitialize(),
+	//! when environment variable SYNFIG_RENDERING_FFTW_WISDOM contains a file name,
+	//! plans are measured and FFTW wisdom is loaded from and saved to this file
 	static void initialize();
 	static void deinitialize();
 };
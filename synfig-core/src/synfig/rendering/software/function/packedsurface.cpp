@@ -32,6 +32,7 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -232,13 +233,81 @@ PackedSurface::clear() {
 	data.clear();
 }
 
+unsigned short
+PackedSurface::float_to_half(float x)
+{
+	unsigned int f;
+	memcpy(&f, &x, sizeof(f));
+	const unsigned int sign = (f >> 16) & 0x8000;
+	const unsigned int abs = f & 0x7fffffff;
+
+	if (abs >= 0x7f800000) // inf or nan
+		return (unsigned short)(sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+	if (abs >= 0x477ff000) // rounds to inf
+		return (unsigned short)(sign | 0x7c00);
+
+	// round to nearest even
+	if (abs < 0x38800000) {
+		// denormal
+		if (abs < 0x33000000)
+			return (unsigned short)sign;
+		const unsigned int m = (abs & 0x007fffff) | 0x00800000;
+		const int shift = 126 - (int)(abs >> 23);
+		const unsigned int rem = m & ((1u << shift) - 1);
+		const unsigned int middle = 1u << (shift - 1);
+		unsigned int h = m >> shift;
+		if (rem > middle || (rem == middle && (h & 1)))
+			++h;
+		return (unsigned short)(sign | h);
+	}
+
+	unsigned int h = (abs - 0x38000000) >> 13;
+	const unsigned int rem = abs & 0x1fff;
+	if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+		++h;
+	return (unsigned short)(sign | h);
+}
+
+float
+PackedSurface::half_to_float(unsigned short x)
+{
+	const unsigned int sign = (unsigned int)(x & 0x8000) << 16;
+	const unsigned int e = (x >> 10) & 0x1f;
+	const unsigned int m = x & 0x3ff;
+
+	unsigned int f;
+	if (e == 0) {
+		// zero or denormal
+		const float v = (float)m*(1.f/16777216.f);
+		return sign ? -v : v;
+	}
+	if (e == 31)
+		f = sign | 0x7f800000 | (m << 13);
+	else
+		f = sign | ((e + 112) << 23) | (m << 13);
+
+	float result;
+	memcpy(&result, &f, sizeof(result));
+	return result;
+}
+
 Color::value_type
 PackedSurface::get_channel(const void *pixel, int offset, ChannelType type, Color::value_type constant, const Color::value_type *discrete_to_float)
 {
 	if (offset < 0)
 		return constant;
-	if (type == ChannelUInt8)
+	switch(type) {
+	case ChannelUInt8:
+	case ChannelUInt8Premulted:
 		return discrete_to_float[((const unsigned char*)pixel)[offset]];
+	case ChannelFloat16: {
+		unsigned short h;
+		memcpy(&h, (const char*)pixel + offset, sizeof(h));
+		return half_to_float(h);
+	}
+	default:
+		break;
+	}
 	return *(const Color::value_type*)((const char*)pixel + offset);
 }
 
@@ -247,6 +316,15 @@ PackedSurface::set_channel(void *pixel, int offset, ChannelType type, Color::val
 {
 	if (offset < 0)
 		return;
+	if (type == ChannelUInt8Premulted) {
+		((unsigned char*)pixel)[offset] = (unsigned char)(std::max(0.f, std::min(1.f, (float)color))*255.f + 0.5f);
+		return;
+	}
+	if (type == ChannelFloat16) {
+		const unsigned short h = float_to_half(color);
+		memcpy((char*)pixel + offset, &h, sizeof(h));
+		return;
+	}
 	if (type == ChannelUInt8) {
 		int i = 0;
 		int j = 255;
@@ -266,16 +344,27 @@ PackedSurface::set_channel(void *pixel, int offset, ChannelType type, Color::val
 Color
 PackedSurface::get_pixel(const void *pixel) const
 {
-	return Color(
+	Color color(
 		get_channel(pixel, channels[0], channel_type, constant.get_r(), discrete_to_float),
 		get_channel(pixel, channels[1], channel_type, constant.get_g(), discrete_to_float),
 		get_channel(pixel, channels[2], channel_type, constant.get_b(), discrete_to_float),
 		get_channel(pixel, channels[3], channel_type, constant.get_a(), discrete_to_float) );
+	if (channel_type == ChannelUInt8Premulted)
+		color = color.demult_alpha();
+	return color;
 }
 
 void
 PackedSurface::set_pixel(void *pixel, const Color &color)
 {
+	if (channel_type == ChannelUInt8Premulted) {
+		const Color::value_type a = std::max(0.f, std::min(1.f, color.get_a()));
+		set_channel(pixel, channels[0], channel_type, color.get_r()*a, discrete_to_float);
+		set_channel(pixel, channels[1], channel_type, color.get_g()*a, discrete_to_float);
+		set_channel(pixel, channels[2], channel_type, color.get_b()*a, discrete_to_float);
+		set_channel(pixel, channels[3], channel_type, a, discrete_to_float);
+		return;
+	}
 	set_channel(pixel, channels[0], channel_type, color.get_r(), discrete_to_float);
 	set_channel(pixel, channels[1], channel_type, color.get_g(), discrete_to_float);
 	set_channel(pixel, channels[2], channel_type, color.get_b(), discrete_to_float);
@@ -466,10 +555,66 @@ PackedSurface::set_pixels(const Color *pixels, int width, int height, int pitch)
 	}
 }
 
+void
+PackedSurface::init_lossy(int width, int height, ChannelType type) {
+	assert(type == ChannelFloat16 || type == ChannelUInt8Premulted);
+	channel_type = type;
+	const int channel_size = type == ChannelFloat16 ? sizeof(unsigned short) : sizeof(unsigned char);
+	for(int i = 0; i < 4; ++i)
+		channels[i] = i*channel_size;
+	if (type == ChannelUInt8Premulted)
+		for(int i = 0; i < 256; ++i)
+			discrete_to_float[i] = (Color::value_type)i/(Color::value_type)255;
+
+	pixel_size = 4*channel_size;
+	this->width = width;
+	this->height = height;
+	row_size = width*pixel_size;
+
+	data.resize(row_size*height);
+}
+
+void
+PackedSurface::set_pixels_lossy(const Color *pixels, int width, int height, ChannelType type, int pitch) {
+	clear();
+	if (!pixels || width <= 0 || height <= 0)
+		return;
+
+	if (pitch == 0) pitch = sizeof(Color)*width;
+
+	init_lossy(width, height, type);
+	char *pixel = &data.front();
+	for(int row = 0; row < height; ++row)
+		for(const Color *color = (const Color*)((const char*)pixels + row*pitch), *end = color + width; color < end; ++color, pixel += pixel_size)
+			set_pixel(pixel, *color);
+}
+
+unsigned char*
+PackedSurface::create_premulted_bytes(int width, int height) {
+	clear();
+	if (width <= 0 || height <= 0)
+		return nullptr;
+	init_lossy(width, height, ChannelUInt8Premulted);
+	return (unsigned char*)&data.front();
+}
+
 void
 PackedSurface::get_pixels(Color *target) const {
 	if (!target || width <= 0 || height <= 0)
 		return;
+
+	if (!chunk_size) {
+		// plain data, read it without Reader and its bounds checks
+		Color *end = target + width*height;
+		if (!pixel_size) {
+			std::fill(target, end, constant);
+			return;
+		}
+		for(const char *pixel = &data.front(); target < end; ++target, pixel += pixel_size)
+			*target = get_pixel(pixel);
+		return;
+	}
+
 	Reader reader(*this);
 	Color *color = target;
 	for(int y = 0; y < height; ++y)
@@ -56,8 +56,10 @@ class PackedSurface
 {
 public:
 	enum ChannelType {
-		ChannelUInt8,
-		ChannelFloat32
+		ChannelUInt8,           //!< index in the table of up to 256 values met in the image
+		ChannelFloat32,
+		ChannelFloat16,         //!< IEEE 754 half precision, lossy
+		ChannelUInt8Premulted   //!< color premultiplied by alpha in range 0..1 with 255 steps, lossy
 	};
 
 	enum {
@@ -155,6 +157,8 @@ private:
 	void set_pixel(void *pixel, const Color &color);
 
 	void get_compressed_chunk(int index, const void *&data, int &size, bool &compressed) const;
+	//! Prepares plain (not chunked) storage of \a width x \a height pixels for lossy \a type
+	void init_lossy(int width, int height, ChannelType type);
 
 public:
 	PackedSurface();
@@ -162,9 +166,21 @@ public:
 
 	void clear();
 	void set_pixels(const Color *pixels, int width, int height, int pitch = 0);
+	//! Stores all channels in lossy \a type (ChannelFloat16 or ChannelUInt8Premulted)
+	//! without analysis of the image, so it is much faster than set_pixels()
+	void set_pixels_lossy(const Color *pixels, int width, int height, ChannelType type, int pitch = 0);
+	//! Prepares storage for premultiplied RGBA pixels with 8 bits per channel (ChannelUInt8Premulted)
+	//! and returns it, so the caller can write rows of 4*width bytes there directly
+	unsigned char* create_premulted_bytes(int width, int height);
 	int get_width() const { return width; }
 	int get_height() const { return height; }
+	ChannelType get_channel_type() const { return channel_type; }
+	//! Size of packed pixels in bytes
+	size_t get_data_size() const { return data.size(); }
 	void get_pixels(Color *target) const;
+
+	static unsigned short float_to_half(float x);
+	static float half_to_float(unsigned short x);
 };
 
 } /* end namespace software */
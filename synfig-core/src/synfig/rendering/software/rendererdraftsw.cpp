@@ -36,6 +36,7 @@
 
 #include "rendererdraftsw.h"
 
+#include "surfaceswpacked.h"
 #include "task/tasksw.h"
 
 #include "../common/optimizer/optimizerblendassociative.h"
@@ -44,6 +45,7 @@
 #include "../common/optimizer/optimizerdraft.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
+#include "../common/optimizer/optimizersurfaceconvert.h"
 #include "../common/optimizer/optimizertransformation.h"
 #include "../common/optimizer/optimizerpass.h"
 
@@ -101,7 +103,8 @@ RendererDraftSW::RendererDraftSW()
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit(get_max_simultaneous_threads()));
+	register_optimizer(new OptimizerSurfaceConvert(SurfaceSWPackedByte::token.handle()));
 }
 
 String RendererDraftSW::get_name() const
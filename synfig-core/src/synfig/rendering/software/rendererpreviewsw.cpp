@@ -35,18 +35,23 @@
 #include <synfig/localization.h>
 
 #include "rendererpreviewsw.h"
+#include "renderersw.h"
 
 #include  "task/tasksw.h"
 
 #include "../common/optimizer/optimizerblendassociative.h"
 #include "../common/optimizer/optimizerblendmerge.h"
 #include "../common/optimizer/optimizerblendtotarget.h"
+#include "../common/optimizer/optimizercache.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
+#include "../common/optimizer/optimizersurfaceconvert.h"
 #include "../common/optimizer/optimizertransformation.h"
 #include "../common/optimizer/optimizerpass.h"
 #include "../common/optimizer/optimizerdraft.h"
 
+#include "surfaceswpacked.h"
+
 #include "function/fft.h"
 
 #endif
@@ -69,13 +74,15 @@ RendererPreviewSW::RendererPreviewSW()
 	// register optimizers
 	register_optimizer(new OptimizerTransformation());
 	register_optimizer(new OptimizerDraftTransformation());
+	register_optimizer(new OptimizerCache(RendererSW::get_cache_storage(), RendererSW::get_cache_token()));
 	register_optimizer(new OptimizerPass(false));
 	register_optimizer(new OptimizerPass(true));
 	register_optimizer(new OptimizerBlendMerge());
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit(get_max_simultaneous_threads()));
+	register_optimizer(new OptimizerSurfaceConvert(SurfaceSWPackedHalf::token.handle()));
 }
 
 String RendererPreviewSW::get_name() const
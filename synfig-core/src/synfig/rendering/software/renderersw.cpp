@@ -32,15 +32,21 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cstdlib>
+
+#include <synfig/general.h>
 #include <synfig/localization.h>
 
 #include "renderersw.h"
+#include "surfaceswpacked.h"
 
 #include  "task/tasksw.h"
 
 #include "../common/optimizer/optimizerblendassociative.h"
 #include "../common/optimizer/optimizerblendmerge.h"
 #include "../common/optimizer/optimizerblendtotarget.h"
+#include "../common/optimizer/optimizercache.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
 #include "../common/optimizer/optimizertransformation.h"
@@ -55,12 +61,17 @@ using namespace rendering;
 
 /* === M A C R O S ========================================================= */
 
+#define DEFAULT_CACHE_SIZE 256 // in megabytes
+
 /* === G L O B A L S ======================================================= */
 
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
 
+TaskCacheStorage::Handle RendererSW::cache_storage;
+rendering::Surface::Token::Handle RendererSW::cache_token;
+
 RendererSW::RendererSW()
 {
 	register_mode(TaskSW::mode_token.handle());
@@ -68,13 +79,15 @@ RendererSW::RendererSW()
 	// register optimizers
 	register_optimizer(new OptimizerTransformation());
 
+	register_optimizer(new OptimizerCache(get_cache_storage(), get_cache_token()));
+
 	register_optimizer(new OptimizerPass(false));
 	register_optimizer(new OptimizerPass(true));
 	register_optimizer(new OptimizerBlendMerge());
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit(get_max_simultaneous_threads()));
 }
 
 RendererSW::~RendererSW() { }
@@ -84,10 +97,29 @@ String RendererSW::get_name() const { return _("Cobra (software)"); }
 void RendererSW::initialize()
 {
 	software::FFT::initialize();
+
+	long long cache_size = DEFAULT_CACHE_SIZE;
+	if (const char *s = getenv("SYNFIG_RENDERING_CACHE_SIZE"))
+		cache_size = std::max(0ll, atoll(s));
+	cache_storage = new TaskCacheStorage((size_t)cache_size*1024*1024);
+
+	cache_token = rendering::Surface::Token::Handle();
+	if (const char *s = getenv("SYNFIG_RENDERING_CACHE_FORMAT")) {
+		const String format(s);
+		if (format == "half")
+			cache_token = SurfaceSWPackedHalf::token.handle();
+		else
+		if (format == "byte")
+			cache_token = SurfaceSWPackedByte::token.handle();
+		else
+		if (format != "float")
+			warning("SYNFIG_RENDERING_CACHE_FORMAT: unknown format '%s', use float, half or byte", s);
+	}
 }
 
 void RendererSW::deinitialize()
 {
+	cache_storage.reset();
 	software::FFT::deinitialize();
 }
 
@@ -31,6 +31,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include "../renderer.h"
+#include "../common/task/taskcache.h"
 
 /* === M A C R O S ========================================================= */
 
@@ -45,6 +46,10 @@ namespace rendering
 
 class RendererSW: public Renderer
 {
+private:
+	static TaskCacheStorage::Handle cache_storage;
+	static Surface::Token::Handle cache_token;
+
 public:
 	typedef etl::handle<RendererSW> Handle;
 
@@ -53,6 +58,16 @@ public:
 
 	virtual String get_name() const;
 
+	//! Storage of results of sub-tasks shared between frames,
+	//! its memory limit may be changed by SYNFIG_RENDERING_CACHE_SIZE (in megabytes)
+	static const TaskCacheStorage::Handle& get_cache_storage()
+		{ return cache_storage; }
+
+	//! Format of results in the cache storage, empty token keeps them unchanged (full precision).
+	//! Lossy packed formats are used only when set by SYNFIG_RENDERING_CACHE_FORMAT (float, half or byte)
+	static const Surface::Token::Handle& get_cache_token()
+		{ return cache_token; }
+
 	static void initialize();
 	static void deinitialize();
 };
@@ -50,23 +50,36 @@ using namespace rendering;
 
 rendering::Surface::Token SurfaceSWPacked::token(
 	Desc<SurfaceSWPacked>("SurfaceSWPacked") );
+rendering::Surface::Token SurfaceSWPackedHalf::token(
+	Desc<SurfaceSWPackedHalf>("SurfaceSWPackedHalf") );
+rendering::Surface::Token SurfaceSWPackedByte::token(
+	Desc<SurfaceSWPackedByte>("SurfaceSWPackedByte") );
 
 
+template<typename Func>
 bool
-SurfaceSWPacked::assign_vfunc(const rendering::Surface &surface)
+SurfaceSWPacked::with_pixels(const rendering::Surface &surface, Func func)
 {
 	std::vector<Color> data;
 	const Color *pixels = surface.get_pixels_pointer();
 	if (!pixels) {
-		data.resize(get_pixels_count());
+		data.resize(surface.get_pixels_count());
 		if (!surface.get_pixels(&data.front()))
 			return false;
 		pixels = &data.front();
 	}
-	this->surface.set_pixels(pixels, surface.get_width(), surface.get_height());
+	func(pixels);
 	return true;
 }
 
+bool
+SurfaceSWPacked::assign_vfunc(const rendering::Surface &surface)
+{
+	return with_pixels(surface, [&](const Color *pixels) {
+		this->surface.set_pixels(pixels, surface.get_width(), surface.get_height());
+	});
+}
+
 bool
 SurfaceSWPacked::reset_vfunc()
 {
@@ -81,4 +94,28 @@ SurfaceSWPacked::get_pixels_vfunc(Color *buffer) const
 	return true;
 }
 
+bool
+SurfaceSWPackedHalf::assign_vfunc(const rendering::Surface &surface)
+{
+	return with_pixels(surface, [&](const Color *pixels) {
+		this->surface.set_pixels_lossy(pixels, surface.get_width(), surface.get_height(), software::PackedSurface::ChannelFloat16);
+	});
+}
+
+bool
+SurfaceSWPackedByte::assign_vfunc(const rendering::Surface &surface)
+{
+	return with_pixels(surface, [&](const Color *pixels) {
+		this->surface.set_pixels_lossy(pixels, surface.get_width(), surface.get_height(), software::PackedSurface::ChannelUInt8Premulted);
+	});
+}
+
+unsigned char*
+SurfaceSWPackedByte::create_bytes(int width, int height)
+{
+	unsigned char *bytes = surface.create_premulted_bytes(width, height);
+	set_desc(width, height, false);
+	return bytes;
+}
+
 /* === E N T R Y P O I N T ================================================= */
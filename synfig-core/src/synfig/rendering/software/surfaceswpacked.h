@@ -58,9 +58,12 @@ protected:
 	virtual bool reset_vfunc();
 	virtual bool get_pixels_vfunc(Color *buffer) const;
 
-private:
 	software::PackedSurface surface;
 
+	//! Calls \a func with pixels of \a surface, makes temporary copy if they are not accessible directly
+	template<typename Func>
+	static bool with_pixels(const Surface &surface, Func func);
+
 public:
 	SurfaceSWPacked()
 		{ }
@@ -68,6 +71,41 @@ public:
 		{ assign(other); }
 	const software::PackedSurface& get_surface() const
 		{ return surface; }
+	virtual size_t get_memory_size() const
+		{ return surface.get_data_size(); }
+};
+
+//! Keeps pixels as half-precision floats,
+//! uses half of memory of SurfaceSW and keeps colors out of range 0..1
+class SurfaceSWPackedHalf: public SurfaceSWPacked
+{
+public:
+	typedef etl::handle<SurfaceSWPackedHalf> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const
+		{ return token.handle(); }
+
+protected:
+	virtual bool assign_vfunc(const Surface &surface);
+};
+
+//! Keeps pixels premultiplied by alpha with 8 bits per channel,
+//! uses quarter of memory of SurfaceSW and clamps colors to range 0..1
+class SurfaceSWPackedByte: public SurfaceSWPacked
+{
+public:
+	typedef etl::handle<SurfaceSWPackedByte> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const
+		{ return token.handle(); }
+
+protected:
+	virtual bool assign_vfunc(const Surface &surface);
+
+public:
+	//! Creates the surface and returns its premultiplied RGBA pixels for writing,
+	//! rows are 4*width bytes long, see PackedSurface::create_premulted_bytes()
+	unsigned char* create_bytes(int width, int height);
 };
 
 } /* end namespace rendering */
@@ -0,0 +1,123 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/task/taskcachesw.cpp
+**	\brief TaskCacheSW
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "../../common/task/taskcache.h"
+#include "tasksw.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+namespace {
+
+class TaskCacheSW: public TaskCache, public TaskSW
+{
+public:
+	typedef etl::handle<TaskCacheSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	virtual bool run(RunParams&) const {
+		if (!sub_task() || !sub_task()->is_valid())
+			return true;
+
+		// result of sub-task is complete here, and nobody will write to it,
+		// it is stored after copying because it may be converted to the storage format
+		bool success = copy();
+		store();
+		return success;
+	}
+
+private:
+	bool copy() const {
+		if (!is_valid())
+			return true;
+
+		// sub-task has the same coordinates, so just copy it
+		RectInt rs = sub_task()->target_rect;
+		RectInt rd = target_rect;
+		int w = std::min(rs.get_width(), rd.get_width());
+		int h = std::min(rs.get_height(), rd.get_height());
+		if (w <= 0 || h <= 0)
+			return true;
+
+		LockWrite ld(this);
+		if (!ld) return false;
+		synfig::Surface &dst = ld->get_surface();
+
+		// read stored result in its own format to not keep the unpacked copy in the storage
+		SurfaceResource::LockReadBase ls(sub_task()->target_surface);
+		if (!ls.convert(SurfaceSW::token.handle(), false) && !ls.convert(rendering::Surface::Token::Handle(), false, true))
+			return false;
+
+		if (SurfaceSW::Handle src_sw = ls.cast<SurfaceSW>()) {
+			synfig::Surface &src = src_sw->get_surface(); // TODO: make blit_to constant
+			synfig::Surface::pen p = dst.get_pen(rd.minx, rd.miny);
+			src.blit_to(p, rs.minx, rs.miny, w, h);
+			return true;
+		}
+
+		const rendering::Surface &src = *ls.get_surface();
+		std::vector<Color> pixels(src.get_pixels_count());
+		if (pixels.empty() || !src.get_pixels(&pixels.front()))
+			return false;
+		w = std::min(w, std::min(src.get_width() - rs.minx, dst.get_w() - rd.minx));
+		h = std::min(h, std::min(src.get_height() - rs.miny, dst.get_h() - rd.miny));
+		for(int y = 0; y < h; ++y) {
+			const Color *row = &pixels[(rs.miny + y)*src.get_width() + rs.minx];
+			std::copy(row, row + w, &dst[rd.miny + y][rd.minx]);
+		}
+		return true;
+	}
+};
+
+
+Task::Token TaskCacheSW::token(
+	DescReal<TaskCacheSW, TaskCache>("CacheSW") );
+
+} // end of anonimous namespace
+
+/* === E N T R Y P O I N T ================================================= */
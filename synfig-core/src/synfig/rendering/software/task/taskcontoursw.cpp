@@ -79,6 +79,10 @@ public:
 	virtual Color::BlendMethodFlags get_supported_blend_methods() const
 		{ return Color::BLEND_METHODS_ALL & ~Color::BLEND_METHODS_STRAIGHT; }
 
+	// coverage of each pixel is accumulated from the polyspan
+	virtual Real get_split_pixel_cost() const
+		{ return 4.0; }
+
 	virtual bool run(RunParams&) const {
 		if (!is_valid())
 			return true;
@@ -97,7 +101,7 @@ public:
 
 		Polyspan polyspan;
 		polyspan.init(target_rect);
-		software::Contour::build_polyspan(contour->get_chunks(), matrix, polyspan, detail);
+		software::Contour::build_polyspan(*contour, matrix, polyspan, detail);
 		polyspan.close();
 		polyspan.sort_marks();
 
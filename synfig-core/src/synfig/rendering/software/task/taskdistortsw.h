@@ -64,7 +64,8 @@ protected:
 	 * Convert @a point coordinates in target vectorial region to the vectorial coordinates in source region.
 	 *
 	 * @param point The transformed vectorial coordinates in target region
-	 * @return From where in source region should take the color (in vectorial coordinates)
+	 * @return From where in source region should take the color (in vectorial coordinates),
+	 *         or a point with NaN coordinates to leave target pixel transparent
 	 */
 	virtual Point point_vfunc(const Point &point) const = 0;
 
@@ -33,6 +33,8 @@
 #	include <config.h>
 #endif
 
+#include <vector>
+
 #include "taskpaintpixelsw.h"
 
 #include <synfig/general.h>
@@ -71,6 +73,14 @@ synfig::rendering::TaskPaintPixelSW::get_supported_blend_methods() const
 	return Color::BLEND_METHODS_ALL;
 }
 
+void
+synfig::rendering::TaskPaintPixelSW::get_color_span(const Vector& start, const Vector& step, int count, Color* out) const
+{
+	Vector p = start;
+	for(Color *end = out + count; out < end; ++out, p += step)
+		*out = get_color(p);
+}
+
 bool
 synfig::rendering::TaskPaintPixelSW::run_task() const
 {
@@ -101,7 +111,7 @@ synfig::rendering::TaskPaintPixelSW::run_task() const
 
 	int tw = target_rect.get_width();
 	Vector dx = inv_matrix.axis_x();
-	Vector dy = inv_matrix.axis_y() - dx*(Real)tw;
+	Vector dy = inv_matrix.axis_y();
 	Vector p = inv_matrix.get_transformed( Vector((Real)target_rect.minx, (Real)target_rect.miny) );
 
 	pre_run(matrix, inv_matrix);
@@ -114,10 +124,11 @@ synfig::rendering::TaskPaintPixelSW::run_task() const
 	ColorReal amount = blend ? this->amount : ColorReal(1.0);
 	apen.set_blend_method(blend ? blend_method : Color::BLEND_COMPOSITE);
 
+	std::vector<Color> row(tw);
 	for(int iy = target_rect.miny; iy < target_rect.maxy; ++iy, p += dy, apen.inc_y(), apen.dec_x(tw)) {
-		for(int ix = target_rect.minx; ix < target_rect.maxx; ++ix, p += dx, apen.inc_x()) {
-			apen.put_value(get_color(p), amount);
-		}
+		get_color_span(p, dx, tw, &row.front());
+		for(std::vector<Color>::const_iterator i = row.begin(); i != row.end(); ++i, apen.inc_x())
+			apen.put_value(*i, amount);
 	}
 
 	return true;
@@ -49,7 +49,7 @@ namespace rendering
 /**
  * Paint each pixel depending on its position.
  *
- * The color of each pixel is defined by get_color() or get_color_antialias() calls.
+ * The color of each pixel is defined by get_color() or get_color_span() calls.
  *
  * To use this abstract class, call run_task() inside of your implementation of Task::run().
  *
@@ -71,9 +71,18 @@ public:
 	//! Fetch color at position p (in synfig units) when antialias is false
 	virtual Color get_color(const Vector& p) const = 0;
 
+	//! Fetch colors of \a count pixels placed at start, start + step, start + 2*step, etc.
+	//! run_task() calls it for each row of pixels, so override it when colors of
+	//! a row may be computed faster together. By default calls get_color() for each pixel
+	virtual void get_color_span(const Vector& start, const Vector& step, int count, Color* out) const;
+
 	//! Call this method from run() method of the real task implementation
 	virtual bool run_task() const;
 
+	//! Colors are computed for each pixel, it is more expensive than plain blending
+	virtual Real get_split_pixel_cost() const
+		{ return 4.0; }
+
 	void on_target_set_as_source() override;
 
 	Color::BlendMethodFlags get_supported_blend_methods() const override;
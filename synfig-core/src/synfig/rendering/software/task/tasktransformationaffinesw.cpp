@@ -103,7 +103,9 @@ public:
 
 		// resample
 		LockReadBase lsrc(sub_task());
-		if (lsrc.convert<SurfaceSWPacked>(false)) {
+		if ( lsrc.convert<SurfaceSWPacked>(false)
+		  || lsrc.convert<SurfaceSWPackedHalf>(false)
+		  || lsrc.convert<SurfaceSWPackedByte>(false) ) {
 			SurfaceSWPacked::Handle src = lsrc.cast<SurfaceSWPacked>();
 			if (!src) return false;
 			software::Resample::resample(
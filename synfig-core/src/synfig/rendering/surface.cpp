@@ -52,7 +52,7 @@ using namespace rendering;
 /* === M E T H O D S ======================================================= */
 
 synfig::Token Surface::token;
-int SurfaceResource::last_id = 0;
+std::atomic<int> SurfaceResource::last_id(0);
 
 Surface::Surface():
 	blank(true),
@@ -220,6 +220,7 @@ SurfaceResource::SurfaceResource():
 { }
 
 SurfaceResource::SurfaceResource(Surface::Handle surface):
+	id(++last_id),
 	width(),
 	height(),
 	blank(true)
@@ -353,4 +354,14 @@ SurfaceResource::reset()
 	surfaces.clear();
 }
 
+size_t
+SurfaceResource::get_memory_size() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t size = 0;
+	for(Map::const_iterator i = surfaces.begin(); i != surfaces.end(); ++i)
+		size += i->second->get_memory_size();
+	return size;
+}
+
 /* === E N T R Y P O I N T ================================================= */
@@ -30,6 +30,7 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -160,6 +161,9 @@ public:
 		{ return get_width()*get_height(); }
 	size_t get_buffer_size() const
 		{ return get_pixels_count()*sizeof(Color); }
+	//! Size of memory used by pixels, may differ from get_buffer_size() for packed formats
+	virtual size_t get_memory_size() const
+		{ return get_buffer_size(); }
 	bool is_exists() const
 		{ return get_width() > 0 && get_height() > 0; }
 	bool is_blank() const
@@ -329,7 +333,7 @@ public:
 	};
 
 private:
-	static int last_id;
+	static std::atomic<int> last_id;
 
 	int id = 0;
 	int width;
@@ -361,7 +365,7 @@ public:
 	void create(const VectorInt &x)
 		{ create(x[0], x[1]); }
 
-	int get_id() const //!< helps to debug of renderer optimizers
+	int get_id() const //!< unique id, helps to debug of renderer optimizers and to identify the resource in caches
 		{ return id; }
 	int get_width() const
 		{ std::lock_guard<std::mutex> lock(mutex); return width; }
@@ -378,6 +382,8 @@ public:
 	template<typename T>
 	bool has_surface() const
 		{ return has_surface(T::token.handle()); }
+	//! Total memory used by all stored formats of the surface
+	size_t get_memory_size() const;
 	bool get_tokens(std::vector<Surface::Token::Handle> &outTokens) const {
 		std::lock_guard<std::mutex> lock(mutex);
 		for(Map::const_iterator i = surfaces.begin(); i != surfaces.end(); ++i)
@@ -60,6 +60,8 @@ SYNFIG_EXPORT Task::Token TaskSurface::token(
 	DescSpecial<TaskSurface>("Surface") );
 Task::Token TaskLockSurface::token(
 	DescSpecial<TaskLockSurface>("LoskSurface") );
+SYNFIG_EXPORT Task::Token TaskSurfaceConvert::token(
+	DescSpecial<TaskSurfaceConvert>("SurfaceConvert") );
 Task::Token TaskList::token(
 	DescSpecial<TaskList>("List") );
 SYNFIG_EXPORT Task::Token TaskEvent::token(
@@ -318,11 +320,58 @@ Task::set_coords_sub_tasks()
 		if (*i) (*i)->set_coords(source_rect, target_rect.get_size());
 }
 
+bool
+Task::calc_hash_recursive(TaskHash &hash, HashMap *out_hashes) const
+{
+	const String &name = get_token()->name;
+	hash.add(name.c_str(), name.size() + 1);
+	hash << source_rect.minx << source_rect.miny << source_rect.maxx << source_rect.maxy;
+	hash << target_rect.minx << target_rect.miny << target_rect.maxx << target_rect.maxy;
+
+	// sub-trees of unhashable task still should be collected
+	bool valid = calc_hash(hash);
+	if (!valid && !out_hashes)
+		return false;
+
+	hash << (int)sub_tasks.size();
+	for(List::const_iterator i = sub_tasks.begin(); i != sub_tasks.end(); ++i)
+	{
+		hash << (bool)*i;
+		if (*i) {
+			TaskHash sub_hash;
+			if ((*i)->calc_hash_recursive(sub_hash, out_hashes))
+				hash << sub_hash.get();
+			else
+			if (out_hashes)
+				valid = false;
+			else
+				return false;
+		}
+	}
+
+	if (valid && out_hashes)
+		(*out_hashes)[this] = hash.get();
+	return valid;
+}
+
 bool
 Task::run(RunParams & /* params */) const
 	{ return false; }
 
 
+// TaskSurface
+
+bool
+TaskSurface::calc_hash(TaskHash &hash) const
+{
+	// content of existing SurfaceResource is never changed by layers,
+	// they create a new one instead, so unique id is enough
+	if (!target_surface) return false;
+	hash << target_surface->get_id();
+	return true;
+}
+
+
 // TaskList
 
 VectorInt
@@ -378,6 +427,18 @@ TaskLockSurface::unlock() {
 }
 
 
+// TaskSurfaceConvert
+
+bool
+TaskSurfaceConvert::run(RunParams & /* params */) const
+{
+	if (!target_surface || !surface_token)
+		return false;
+	SurfaceResource::LockWriteBase lock(target_surface, surface_token);
+	return lock.convert(surface_token);
+}
+
+
 // TaskEvent
 
 TaskEvent&
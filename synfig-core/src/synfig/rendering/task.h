@@ -127,6 +127,36 @@ public:
 typedef std::vector<ModeToken::Handle> ModeList;
 
 
+// TaskHash
+
+
+//! Accumulates the hash of task-tree (FNV-1a), see Task::calc_hash()
+class TaskHash
+{
+public:
+	typedef unsigned long long Value;
+
+private:
+	Value value;
+
+public:
+	TaskHash(): value(14695981039346656037ull) { }
+
+	void add(const void *data, size_t size) {
+		for(const unsigned char *i = (const unsigned char*)data, *end = i + size; i != end; ++i)
+			value = (value ^ *i)*1099511628211ull;
+	}
+
+	//! Adds the raw memory of value, use it only for types without padding
+	template<typename T>
+	TaskHash& operator<< (const T &x)
+		{ add(&x, sizeof(x)); return *this; }
+
+	Value get() const
+		{ return value; }
+};
+
+
 // Task
 
 
@@ -136,6 +166,7 @@ public:
 	typedef etl::handle<Task> Handle;
 	typedef std::vector<Handle> List;
 	typedef std::set<Handle> Set;
+	typedef std::map<const Task*, TaskHash::Value> HashMap;
 
 	typedef Task* (*Fabric)();
 	typedef Task* (*CloneFabric)(const Task&);
@@ -284,6 +315,15 @@ public:
 
 	struct RendererData
 	{
+		enum State {
+			STATE_NONE,      //!< task is not in the render queue
+			STATE_WAITING,   //!< task waits for dependencies
+			STATE_READY,     //!< task is in one of ready queues
+			STATE_RUNNING,   //!< task is taken by a thread
+			STATE_DONE,      //!< task is finished
+			STATE_CANCELLED  //!< task will not be run
+		};
+
 		int batch_index;
 		int index;
 		Set deps;
@@ -295,7 +335,32 @@ public:
 		RunParams params;
 		bool success;
 
-		RendererData(): batch_index(), index(), success() { }
+		// fields below are managed by RenderQueue,
+		// they allow to resolve dependencies without locking of the whole queue
+		std::atomic<int> state;
+		std::atomic<int> deps_count;      //!< count of unfinished tasks from deps
+		std::atomic<int> back_deps_count; //!< count of not cancelled tasks from back_deps
+
+		RendererData():
+			batch_index(), index(), success(),
+			state(STATE_NONE), deps_count(), back_deps_count() { }
+		RendererData(const RendererData &other):
+			RendererData() { *this = other; }
+
+		RendererData& operator=(const RendererData &other) {
+			batch_index = other.batch_index;
+			index = other.index;
+			deps = other.deps;
+			back_deps = other.back_deps;
+			tmp_deps = other.tmp_deps;
+			tmp_back_deps = other.tmp_back_deps;
+			params = other.params;
+			success = other.success;
+			state = other.state.load();
+			deps_count = other.deps_count.load();
+			back_deps_count = other.back_deps_count.load();
+			return *this;
+		}
 	};
 
 	class LockReadBase: public SurfaceResource::LockReadBase
@@ -467,6 +532,17 @@ public:
 	virtual int get_pass_subtask_index() const
 		{ return PASSTO_THIS_TASK; }
 
+	//! Adds parameters of the task (except of coords and sub-tasks) to the hash.
+	//! Returns false when the result of the task depends from something
+	//! which can not be hashed, so the result can not be reused (default)
+	virtual bool calc_hash(TaskHash & /* hash */) const
+		{ return false; }
+	//! Calculates hash of the whole sub-tree including coordinates.
+	//! Sub-trees are hashed separately and only their values are added,
+	//! so when \a out_hashes is set then hashes of all hashable sub-trees
+	//! are collected there in one pass, even when the whole tree can not be hashed
+	bool calc_hash_recursive(TaskHash &hash, HashMap *out_hashes = nullptr) const;
+
 	void touch_coords();
 	void set_coords(const Rect &source_rect, const VectorInt &target_size);
 	void set_coords_zero();
@@ -492,6 +568,10 @@ class TaskInterfaceSplit
 public:
 	virtual bool is_splittable() const
 		{ return true; }
+	//! Relative cost of one pixel of target, used by OptimizerSplit
+	//! to decide how many parts the task should be split to
+	virtual Real get_split_pixel_cost() const
+		{ return 1.0; }
 	virtual ~TaskInterfaceSplit() { }
 };
 
@@ -529,6 +609,7 @@ public:
 	typedef etl::handle<TaskSurface> Handle;
 	SYNFIG_EXPORT static Token token;
 	virtual Token::Handle get_token() const { return token.handle(); }
+	virtual bool calc_hash(TaskHash &hash) const;
 };
 
 
@@ -559,6 +640,21 @@ public:
 };
 
 
+//! Converts the whole target surface to \a surface_token format and drops its other formats,
+//! so intermediate surfaces may be kept in compact formats until they are read
+class TaskSurfaceConvert: public Task
+{
+public:
+	typedef etl::handle<TaskSurfaceConvert> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	Surface::Token::Handle surface_token;
+
+	virtual bool run(RunParams & /* params */) const;
+};
+
+
 //! Tasks in TaskList executes sequentially and all of them draws at TaskList target surface.
 //! So all tasks inside TaskList should have the same target surface
 //! which should be same as TaskList target surface.
@@ -570,6 +666,8 @@ public:
 	virtual Token::Handle get_token() const { return token.handle(); }
 	virtual bool run(RunParams&) const
 		{ return true; }
+	virtual bool calc_hash(TaskHash&) const
+		{ return true; }
 	static VectorInt calc_target_offset(const Task &a, const Task &b);
 };
 
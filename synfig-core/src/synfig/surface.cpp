@@ -33,6 +33,9 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
 #include "surface.h"
 #include "target_scanline.h"
 #include "target_tile.h"
@@ -236,7 +239,57 @@ synfig::Surface::blit_to(alpha_pen& pen, int x, int y, int w, int h)
 		return;
 	}
 #endif
-	surface<Color, ColorPrep>::blit_to(pen,x,y,w,h);
+
+	if(x>=get_w() || y>=get_h())
+		return;
+
+	//clip source origin
+	if(x<0)
+	{
+		w+=x;	//decrease
+		x=0;
+	}
+
+	if(y<0)
+	{
+		h+=y;	//decrease
+		y=0;
+	}
+
+	//clip width against dest width
+	w = std::min((long)w,(long)(pen.end_x()-pen.x()));
+	h = std::min((long)h,(long)(pen.end_y()-pen.y()));
+
+	//clip width against src width
+	w = std::min(w,get_w()-x);
+	h = std::min(h,get_h()-y);
+
+	if(w<=0 || h<=0)
+		return;
+
+	// blend whole rows, see Color::blend_row()
+	for(int i=0;i<h;i++)
+	{
+		Color* dest(reinterpret_cast<Color*>(reinterpret_cast<char*>(pen.x())+i*pen.get_pitch()));
+		Color::blend_row(dest,operator[](y+i)+x,w,alpha,pen.get_blend_method());
+	}
+}
+
+void
+synfig::Surface::fill(Color v, alpha_pen& pen, int w, int h)
+{
+	w = std::min((long)w,(long)(pen.end_x()-pen.x()));
+	h = std::min((long)h,(long)(pen.end_y()-pen.y()));
+	if(w<=0 || h<=0)
+		return;
+
+	// blend rows of the same color, see Color::blend_row()
+	std::vector<Color> row(w, v);
+	for(int i=0;i<h;i++)
+	{
+		Color* dest(reinterpret_cast<Color*>(reinterpret_cast<char*>(pen.x())+i*pen.get_pitch()));
+		Color::blend_row(dest,&row.front(),w,pen.get_alpha(),pen.get_blend_method());
+	}
 }
 
 
@@ -110,6 +110,11 @@ public:
 
 	void clear();
 
+	using surface<Color, ColorPrep>::fill;
+
+	//! Blends \a w x \a h block of color \a v at the position of the pen
+	void fill(Color v, alpha_pen& DEST_PEN, int w, int h);
+
 	void blit_to(alpha_pen& DEST_PEN, int x, int y, int w, int h);
 };	// END of class Surface
 
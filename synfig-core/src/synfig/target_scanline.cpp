@@ -43,11 +43,14 @@
 #include "context.h"
 #include "string.h"
 #include "surface.h"
+#include "debug/profile.h"
 #include "rendering/renderer.h"
 #include "rendering/surface.h"
 #include "rendering/software/surfacesw.h"
 #include "rendering/common/task/tasktransformation.h"
 
+#include <deque>
+
 #endif
 
 /* === U S I N G =========================================================== */
@@ -67,7 +70,8 @@ using namespace rendering;
 
 Target_Scanline::Target_Scanline()
 	: threads_(2),
-	  pixel_rendering_limit_(DEFAULT_PIXEL_RENDERING_LIMIT)
+	  pixel_rendering_limit_(DEFAULT_PIXEL_RENDERING_LIMIT),
+	  frames_in_flight_(1)
 {
 	curr_frame_=0;
 	if (const char *s = getenv("SYNFIG_TARGET_DEFAULT_ENGINE"))
@@ -80,22 +84,22 @@ Target_Scanline::next_frame(Time& time)
 	return Target::next_frame(time);
 }
 
-bool
-synfig::Target_Scanline::call_renderer(
+rendering::Task::Handle
+synfig::Target_Scanline::build_renderer_task(
 	const etl::handle<rendering::SurfaceResource> &surface,
 	Canvas &canvas,
 	const ContextParams &context_params,
 	const RendDesc &renddesc )
 {
 	surface->create(renddesc.get_w(), renddesc.get_h());
-	rendering::Task::Handle task = canvas.build_rendering_task(context_params);
+	rendering::Task::Handle task;
+	{
+		debug::Profile::Scope profile_scope("canvas", "build rendering task");
+		task = canvas.build_rendering_task(context_params);
+	}
 
 	if (task)
 	{
-		rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
-		if (!renderer)
-			throw strprintf(_("Renderer '%s' not found"), get_engine().c_str());
-
 		Vector p0 = renddesc.get_tl();
 		Vector p1 = renddesc.get_br();
 		if (p0[0] > p1[0] || p0[1] > p1[1]) {
@@ -111,14 +115,146 @@ synfig::Target_Scanline::call_renderer(
 		task->target_surface = surface;
 		task->target_rect = RectInt( VectorInt(), surface->get_size() );
 		task->source_rect = Rect(p0, p1);
+	}
+	return task;
+}
+
+bool
+synfig::Target_Scanline::call_renderer(
+	const etl::handle<rendering::SurfaceResource> &surface,
+	Canvas &canvas,
+	const ContextParams &context_params,
+	const RendDesc &renddesc )
+{
+	rendering::Task::Handle task = build_renderer_task(surface, canvas, context_params, renddesc);
+
+	if (task)
+	{
+		rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
+		if (!renderer)
+			throw strprintf(_("Renderer '%s' not found"), get_engine().c_str());
 
 		rendering::Task::List list;
 		list.push_back(task);
+		debug::Profile::Scope profile_scope("renderer", "run renderer");
 		renderer->run(list);
 	}
 	return true;
 }
 
+bool
+synfig::Target_Scanline::render_frames_in_flight(ProgressCallback *cb, const ContextParams &context_params, int total_frames)
+{
+	struct FrameInFlight {
+		int frame;
+		debug::Profile::Time profile_begin;
+		SurfaceResource::Handle surface;
+		TaskEvent::Handle event;
+	};
+
+	rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
+	if (!renderer)
+		throw strprintf(_("Renderer '%s' not found"), get_engine().c_str());
+
+	std::deque<FrameInFlight> queue;
+
+	// Waits for the oldest frame and puts it onto the target.
+	// Some targets look at curr_frame_ while the frame is written,
+	// so it is temporarily rewound to the number of the frame being written.
+	auto flush_frame = [&]() -> bool {
+		FrameInFlight f = queue.front();
+		queue.pop_front();
+
+		if (f.event) {
+			f.event->wait();
+			if (!f.event->is_done()) {
+				if(cb)cb->error(_("Accelerated Renderer Failure"));
+				return false;
+			}
+		}
+
+		SurfaceResource::LockRead<SurfaceSW> lock(f.surface);
+		if(!lock)
+		{
+			if(cb)cb->error(_("Bad surface"));
+			return false;
+		}
+
+		const int next_curr_frame = curr_frame_;
+		curr_frame_ = f.frame;
+		const bool success = add_frame(&lock->get_surface(), cb);
+		curr_frame_ = next_curr_frame;
+
+		if (debug::Profile::is_enabled())
+			debug::Profile::add("frame", strprintf("frame %d", f.frame), f.profile_begin, debug::Profile::now());
+
+		if(!success)
+		{
+			if(cb)cb->error(_("Unable to put surface on target"));
+			return false;
+		}
+		return true;
+	};
+
+	// Cancels all frames which are still in the render queue
+	auto cancel_frames = [&]() {
+		for(const FrameInFlight &f : queue)
+			if (f.event) {
+				rendering::Renderer::cancel(f.event);
+				f.event->wait();
+			}
+		queue.clear();
+	};
+
+	try {
+		Time t = 0;
+		int frames = 0;
+		do{
+			// Grab the time
+			frames=next_frame(t);
+
+			// If we have a callback, and it returns
+			// false, go ahead and bail. (it may be a user cancel)
+			if(cb && !cb->amount_complete(total_frames-frames,total_frames))
+				{ cancel_frames(); return false; }
+
+			const debug::Profile::Time profile_begin = debug::Profile::is_enabled() ? debug::Profile::now() : 0;
+
+			// Set the time that we wish to render
+			if(!get_avoid_time_sync() || canvas->get_time()!=t) {
+				debug::Profile::Scope profile_scope("canvas", "set time");
+				canvas->set_time(t);
+				canvas->load_resources(t);
+			}
+			canvas->set_outline_grow(desc.get_outline_grow());
+
+			// Build the task tree of this frame, it doesn't depend on
+			// the canvas any more, so the canvas may be moved to the next frame
+			// while the renderer is still working on it
+			FrameInFlight f;
+			f.frame = curr_frame_;
+			f.profile_begin = profile_begin;
+			f.surface = new SurfaceResource();
+			rendering::Task::Handle task = build_renderer_task(f.surface, *canvas, context_params, desc);
+			if (task) {
+				f.event = new TaskEvent();
+				renderer->enqueue(task, f.event);
+			}
+			queue.push_back(f);
+
+			while((int)queue.size() >= frames_in_flight_ || (!frames && !queue.empty()))
+				if (!flush_frame())
+					{ cancel_frames(); return false; }
+		} while(frames);
+	}
+	catch(...)
+	{
+		cancel_frames();
+		throw;
+	}
+	return true;
+}
+
 bool
 synfig::Target_Scanline::render(ProgressCallback *cb)
 {
@@ -147,6 +283,9 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 	const int lastrowheight = desc.get_h() - (rows - 1) * rowheight;
 
 	try {
+		if (!is_rendering_split && frames_in_flight_ > 1)
+			return render_frames_in_flight(cb, context_params, total_frames);
+
 		Time t = 0;
 		int frames = 0;
 		do{
@@ -158,8 +297,13 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 			if(cb && !cb->amount_complete(total_frames-frames,total_frames))
 				return false;
 
+			debug::Profile::Scope frame_profile_scope("frame", "frame");
+			if (frame_profile_scope.is_active())
+				frame_profile_scope.set_name(strprintf("frame %d", curr_frame_));
+
 			// Set the time that we wish to render
 			if(!get_avoid_time_sync() || canvas->get_time()!=t) {
+				debug::Profile::Scope profile_scope("canvas", "set time");
 				canvas->set_time(t);
 				canvas->load_resources(t);
 			}
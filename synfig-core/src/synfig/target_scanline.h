@@ -31,6 +31,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <algorithm>
+
 #include "target.h"
 
 /* === M A C R O S ========================================================= */
@@ -41,7 +43,7 @@
 
 namespace synfig {
 
-namespace rendering { class SurfaceResource; }
+namespace rendering { class SurfaceResource; class Task; }
 
 /*!	\class Target_Scanline
 **	\brief This is a Target class that implements the render function
@@ -56,12 +58,23 @@ class Target_Scanline : public Target
 
 	int pixel_rendering_limit_;
 
+	//! Number of frames rendered concurrently
+	int frames_in_flight_;
+
+	etl::handle<rendering::Task> build_renderer_task(
+		const etl::handle<rendering::SurfaceResource> &surface,
+		Canvas &canvas,
+		const ContextParams &context_params,
+		const RendDesc &renddesc );
+
 	bool call_renderer(
 		const etl::handle<rendering::SurfaceResource> &surface,
 		Canvas &canvas,
 		const ContextParams &context_params,
 		const RendDesc &renddesc );
 
+	bool render_frames_in_flight(ProgressCallback *cb, const ContextParams &context_params, int total_frames);
+
 public:
 	typedef etl::handle<Target_Scanline> Handle;
 	typedef etl::loose_handle<Target_Scanline> LooseHandle;
@@ -121,6 +134,19 @@ public:
 	/** Get the loose limit of pixels to render. @see set_pixel_rendering_limit() */
 	int get_pixel_rendering_limit() const { return pixel_rendering_limit_; }
 
+	/**
+	 * Sets the number of frames that are rendered concurrently.
+	 *
+	 * The canvas is still evaluated frame by frame, but the rendering tasks
+	 * of up to \a x frames are kept in the render queue at the same time,
+	 * each one with its own surface. Finished frames are passed to the
+	 * target in order. Values less than 2 disable this mode.
+	 * It is ignored when the frame is rendered in blocks (see set_pixel_rendering_limit()).
+	 */
+	void set_frames_in_flight(int x) { frames_in_flight_ = std::max(1, x); }
+	/** Get the number of frames rendered concurrently. @see set_frames_in_flight() */
+	int get_frames_in_flight() const { return frames_in_flight_; }
+
 	//! Puts the rendered surface onto the target.
 	bool add_frame(const synfig::Surface *surface, ProgressCallback* cb);
 private:
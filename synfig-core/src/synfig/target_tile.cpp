@@ -51,6 +51,7 @@
 #include "surface.h"
 
 #include "debug/measure.h"
+#include "debug/profile.h"
 
 #include "rendering/renderer.h"
 #include "rendering/surface.h"
@@ -134,6 +135,7 @@ synfig::Target_Tile::call_renderer(
 		#ifdef DEBUG_MEASURE
 		debug::Measure t("build rendering task");
 		#endif
+		debug::Profile::Scope profile_scope("canvas", "build rendering task");
 		task = canvas.build_rendering_task(context_params);
 	}
 
@@ -166,6 +168,7 @@ synfig::Target_Tile::call_renderer(
 			#ifdef DEBUG_MEASURE
 			debug::Measure t("run renderer");
 			#endif
+			debug::Profile::Scope profile_scope("renderer", "run renderer");
 			renderer->run(list);
 		}
 	}
@@ -340,9 +343,16 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 				if(!start_frame(cb))
 					return false;
 
+				debug::Profile::Scope frame_profile_scope("frame", "frame");
+				if (frame_profile_scope.is_active())
+					frame_profile_scope.set_name(strprintf("frame %d", curr_frame_));
+
 				// Set the time that we wish to render
-				canvas->set_time(t);
-				canvas->load_resources(t);
+				{
+					debug::Profile::Scope profile_scope("canvas", "set time");
+					canvas->set_time(t);
+					canvas->load_resources(t);
+				}
 				canvas->set_outline_grow(desc.get_outline_grow());
 				if(!render_frame_(canvas, context_params, 0))
 					return false;
@@ -357,9 +367,14 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 			if(!start_frame(cb))
 				return false;
 
+			debug::Profile::Scope frame_profile_scope("frame", "frame");
+
 			// Set the time that we wish to render
-			canvas->set_time(t);
-			canvas->load_resources(t);
+			{
+				debug::Profile::Scope profile_scope("canvas", "set time");
+				canvas->set_time(t);
+				canvas->load_resources(t);
+			}
 			canvas->set_outline_grow(desc.get_outline_grow());
 
 			//synfig::info("2time_set_to %s",t.get_string().c_str());
@@ -48,7 +48,7 @@ struct TargetParam
 	 *  its own valid default settings.
 	 */
 	TargetParam (const std::string& Video_codec = "none", int Bitrate = -1):
-		video_codec(Video_codec), bitrate(Bitrate), sequence_separator("."), offset_x(0), offset_y(0),rows(0),columns(0),append(true),dir(HR)
+		video_codec(Video_codec), bitrate(Bitrate), sequence_separator("."), offset_x(0), offset_y(0),rows(0),columns(0),append(true),dir(HR),frames_in_flight(0)
 	{ }
 
 	std::string video_codec;
@@ -61,6 +61,8 @@ struct TargetParam
 	int columns;
 	bool append;
 	Direction dir;
+	//! Number of frames rendered concurrently by scanline targets (0 - target default)
+	int frames_in_flight;
 };
 
 }; // END of namespace synfig
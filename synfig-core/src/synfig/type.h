@@ -33,7 +33,9 @@
 #include <cassert>
 #include <vector>
 #include <map>
+#include <new>
 #include <typeinfo>
+#include <type_traits>
 #include "string.h"
 
 /* === M A C R O S ========================================================= */
@@ -137,10 +139,14 @@ public:
 	typedef void* InternalPointer;
 	typedef const void* ConstInternalPointer;
 
+	//! Size of buffer in ValueBase for values stored without allocation
+	enum { INLINE_SIZE = 24 };
+
 	enum OperationType {
 		TYPE_NONE,
 		TYPE_CREATE,
 		TYPE_DESTROY,
+		TYPE_CONSTRUCT,
 		TYPE_SET,
 		TYPE_PUT,
 		TYPE_GET,
@@ -152,6 +158,7 @@ public:
 
 	typedef InternalPointer	(*CreateFunc)	();
 	typedef void			(*DestroyFunc)	(ConstInternalPointer);
+	typedef void			(*ConstructFunc)(InternalPointer place);
 	typedef void			(*CopyFunc)		(InternalPointer dest, ConstInternalPointer src);
 	typedef bool			(*EqualFunc)	(ConstInternalPointer, ConstInternalPointer);
 	typedef bool			(*LessFunc)		(ConstInternalPointer, ConstInternalPointer);
@@ -169,6 +176,13 @@ public:
 		GenericFuncs() { }
 	};
 
+	//! Values which may be stored inside of ValueBase and copied as raw memory
+	template<typename Inner>
+	class IsInline: public std::integral_constant<bool,
+		std::is_trivially_copyable<Inner>::value
+		&& sizeof(Inner) <= INLINE_SIZE
+		&& alignof(Inner) <= alignof(double) > { };
+
 	class DefaultFuncs
 	{
 	public:
@@ -176,6 +190,9 @@ public:
 		static InternalPointer create()
 			{ return new Inner(); }
 		template<typename Inner>
+		static void construct(InternalPointer place)
+			{ new(place) Inner(); }
+		template<typename Inner>
 		static void destroy(ConstInternalPointer x)
 			{ return delete (Inner*)x; }
 		template<typename Inner, typename Outer>
@@ -232,6 +249,8 @@ public:
 			{ return Description(TYPE_CREATE, type); }
 		inline static Description get_destroy(TypeId type)
 			{ return Description(TYPE_DESTROY, 0, type); }
+		inline static Description get_construct(TypeId type)
+			{ return Description(TYPE_CONSTRUCT, type); }
 		inline static Description get_set(TypeId type)
 			{ return Description(TYPE_SET, 0, type); }
 		inline static Description get_put(TypeId type)
@@ -489,6 +508,8 @@ private:
 		{ register_operation(Operation::Description::get_create(type), func); }
 	inline void register_destroy(TypeId type, Operation::DestroyFunc func)
 		{ register_operation(Operation::Description::get_destroy(type), func); }
+	inline void register_construct(TypeId type, Operation::ConstructFunc func)
+		{ register_operation(Operation::Description::get_construct(type), func); }
 	template<typename T>
 	inline void register_set(TypeId type, typename Operation::GenericFuncs<T>::SetFunc func)
 		{ register_operation(Operation::Description::get_set(type), func); }
@@ -523,6 +544,9 @@ protected:
 		{ register_create(identifier, func); }
 	inline void register_destroy(Operation::DestroyFunc func)
 		{ register_destroy(identifier, func); }
+	//! Registered construct function tells ValueBase to keep the value inline
+	inline void register_construct(Operation::ConstructFunc func)
+		{ register_construct(identifier, func); }
 	template<typename T>
 	inline void register_set(typename Operation::GenericFuncs<T>::SetFunc func)
 		{ register_set<T>(identifier, func); }
@@ -549,11 +573,19 @@ protected:
 		register_get<Outer> ( Operation::DefaultFuncs::get<Inner, Outer>      );
 	}
 
+	template<typename Inner>
+	inline void register_inline(std::true_type)
+		{ register_construct( Operation::DefaultFuncs::construct<Inner> ); }
+	template<typename Inner>
+	inline void register_inline(std::false_type)
+		{ }
+
 	template<typename Inner, typename Outer, String (*Func)(const Inner&)>
 	inline void register_all_but_compare()
 	{
 		register_create     ( Operation::DefaultFuncs::create<Inner>          );
 		register_destroy    ( Operation::DefaultFuncs::destroy<Inner>         );
+		register_inline<Inner>( Operation::IsInline<Inner>()                  );
 		register_copy       ( Operation::DefaultFuncs::copy<Inner>            );
 		register_to_string  ( Operation::DefaultFuncs::to_string<Inner, Func> );
 		register_alias<Inner, Outer>();
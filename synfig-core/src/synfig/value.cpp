@@ -34,6 +34,8 @@
 #	include <config.h>
 #endif
 
+#include <cstring>
+
 #include "value.h"
 
 #endif
@@ -67,9 +69,19 @@ ValueBase::ValueBase(Type &x):
 	create(x);
 }
 
-ValueBase::ValueBase(const ValueBase& x)
-	: ValueBase(*x.type)
+ValueBase::ValueBase(const ValueBase& x):
+	type(&type_nil),data(nullptr),ref_count(0),loop_(x.loop_),static_(x.static_),interpolation_(x.interpolation_)
 {
+	if (x.is_inline())
+	{
+		// trivially copyable value, so copy it without Type operations
+		std::memcpy(inline_data, x.inline_data, sizeof(inline_data));
+		type = x.type;
+		data = inline_data;
+		return;
+	}
+
+	create(*x.type);
 	if(data != x.data)
 	{
 		Operation::CopyFunc copy_func =
@@ -85,10 +97,6 @@ ValueBase::ValueBase(const ValueBase& x)
 			ref_count = x.ref_count;
 		}
 	}
-
-	loop_ = x.loop_;
-	static_ = x.static_;
-	interpolation_ = x.interpolation_;
 }
 
 ValueBase::ValueBase(ValueBase&& x) noexcept
@@ -121,7 +129,7 @@ ValueBase::get_string() const
 bool
 ValueBase::is_valid()const
 {
-	return type != &type_nil && ref_count;
+	return type != &type_nil && (is_inline() || ref_count);
 }
 
 void
@@ -131,12 +139,23 @@ ValueBase::create(Type &type)
 	type.initialize();
 #endif
 	if (type == type_nil) { clear(); return; }
+	clear();
+	this->type = &type;
+
+	Operation::ConstructFunc construct_func =
+		Type::get_operation<Operation::ConstructFunc>(
+			Operation::Description::get_construct(type.identifier) );
+	if (construct_func)
+	{
+		construct_func(inline_data);
+		data = inline_data;
+		return;
+	}
+
 	Operation::CreateFunc func =
 		Type::get_operation<Operation::CreateFunc>(
 			Operation::Description::get_create(type.identifier) );
 	assert(func);
-	clear();
-	this->type = &type;
 	data = func();
 	ref_count.reset();
 }
@@ -149,7 +168,7 @@ ValueBase::copy(const ValueBase& x)
 			Operation::Description::get_copy(type->identifier, x.type->identifier));
 	if (func)
 	{
-		if (!ref_count.unique()) create();
+		if (!is_data_owner()) create();
 		func(data, x.data);
 	}
 	else
@@ -159,7 +178,7 @@ ValueBase::copy(const ValueBase& x)
 				Operation::Description::get_copy(x.type->identifier, x.type->identifier));
 		if (func)
 		{
-			if (!ref_count.unique()) create(*x.type);
+			if (!is_data_owner()) create(*x.type);
 			func(data, x.data);
 		}
 	}
@@ -191,7 +210,8 @@ ValueBase::get_contained_type()const
 void
 ValueBase::clear()
 {
-	if(ref_count.unique() && data)
+	// inline values are trivially destructible
+	if(!is_inline() && ref_count.unique() && data)
 	{
 		Operation::DestroyFunc func =
 			Type::get_operation<Operation::DestroyFunc>(
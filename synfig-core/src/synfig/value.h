@@ -34,6 +34,7 @@
 
 #include <vector>
 #include <list>
+#include <utility>
 
 #include "base_types.h"
 #include "interpolation.h"
@@ -82,6 +83,8 @@ protected:
 	Type *type;
 	//! Pointer to hold the data of the value
 	void *data;
+	//! Buffer for small trivially copyable values, \a data points here for them
+	alignas(double) unsigned char inline_data[Operation::INLINE_SIZE];
 	//! Counter of Value Nodes that refers to this Value Base
 	//! Value base can only be destructed if the ref_count is not greater than 0
 	//!\see etl::reference_counter
@@ -182,8 +185,15 @@ public:
 
 	//! Swap object contents
 	friend void swap(ValueBase& first, ValueBase& second) {
+		const bool first_inline = first.is_inline();
+		const bool second_inline = second.is_inline();
 		std::swap(first.type, second.type);
 		std::swap(first.data, second.data);
+		if (first_inline || second_inline) {
+			std::swap(first.inline_data, second.inline_data);
+			if (first_inline) second.data = second.inline_data;
+			if (second_inline) first.data = first.inline_data;
+		}
 		std::swap(first.ref_count, second.ref_count);
 		std::swap(first.loop_, second.loop_);
 		std::swap(first.static_, second.static_);
@@ -354,6 +364,11 @@ private:
 	void create(Type &type);
 	inline void create() { create(*type); }
 
+	//! True if the value is stored in \a inline_data
+	inline bool is_inline() const { return data == inline_data; }
+	//! True if the data is not shared with other ValueBase objects
+	inline bool is_data_owner() const { return is_inline() || ref_count.unique(); }
+
 	template <typename T>
 	inline static bool _can_get(const TypeId type, const T &)
 	{
@@ -429,7 +444,7 @@ private:
 					Operation::Description::get_set(current_type.identifier) );
 			if (func)
 			{
-				if (!ref_count.unique()) create(current_type);
+				if (!is_data_owner()) create(current_type);
 				func(data, x);
 				return;
 			}
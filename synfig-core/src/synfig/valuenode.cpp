@@ -42,6 +42,8 @@
 #include "canvas.h"
 #include "layer.h"
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
 
 #endif
 
@@ -55,6 +57,37 @@ using namespace synfig;
 
 static int value_node_count(0);
 
+namespace {
+
+struct EvaluationKey
+{
+	const ValueNode *node;
+	Real time;
+	bool operator==(const EvaluationKey &other) const
+		{ return node == other.node && time == other.time; }
+};
+
+struct EvaluationKeyHash
+{
+	size_t operator()(const EvaluationKey &key) const
+		{ return std::hash<const void*>()(key.node) ^ (std::hash<Real>()(key.time) << 1); }
+};
+
+//! Values cached by ValueNode::EvaluationScope in the current thread
+struct EvaluationCache
+{
+	int depth = 0;
+	unsigned long generation = 0;
+	std::unordered_map<EvaluationKey, ValueBase, EvaluationKeyHash> values;
+};
+
+//! Incremented when any ValueNode is changed or deleted
+std::atomic<unsigned long> evaluation_generation(0);
+
+thread_local EvaluationCache evaluation_cache;
+
+}
+
 /* === P R O C E D U R E S ================================================= */
 
 ValueNode::LooseHandle
@@ -132,6 +165,7 @@ LinkableValueNode::unlink_all()
 ValueNode::~ValueNode()
 {
 	value_node_count--;
+	++evaluation_generation;
 
 	begin_delete();
 }
@@ -150,9 +184,48 @@ ValueNode::on_changed()
 	else if(get_root_canvas())
 		get_root_canvas()->signal_value_node_changed()(this);
 
+	++evaluation_generation;
 	Node::on_changed();
 }
 
+ValueNode::EvaluationScope::EvaluationScope()
+{
+	if (!evaluation_cache.depth++)
+		evaluation_cache.generation = evaluation_generation;
+}
+
+ValueNode::EvaluationScope::~EvaluationScope()
+{
+	if (!--evaluation_cache.depth)
+		evaluation_cache.values.clear();
+}
+
+ValueBase
+ValueNode::evaluate(Time t)const
+{
+	// node owned by single handle is evaluated once per frame anyway
+	EvaluationCache &cache = evaluation_cache;
+	if (!cache.depth || use_count() < 2)
+		return (*this)(t);
+
+	const unsigned long generation = evaluation_generation;
+	if (cache.generation != generation) {
+		cache.values.clear();
+		cache.generation = generation;
+	}
+
+	const EvaluationKey key = { this, (Real)t };
+	auto i = cache.values.find(key);
+	if (i != cache.values.end())
+		return i->second;
+
+	ValueBase value = (*this)(t);
+	// evaluation may change nodes
+	if (cache.generation == evaluation_generation)
+		cache.values[key] = value;
+	return value;
+}
+
 int
 ValueNode::replace(ValueNode::Handle x)
 {
@@ -113,6 +113,22 @@ public:
 
 	typedef etl::rhandle<ValueNode> RHandle;
 
+	//! Frame-scoped cache of values of shared nodes
+	/*!	While an instance exists, evaluate() remembers values of nodes
+	**	referenced from several places, so every such node is evaluated
+	**	only once for each time. The cache belongs to the current thread,
+	**	nested scopes use the outermost one. Any call of changed() for
+	**	any ValueNode drops all cached values.
+	*/
+	class EvaluationScope
+	{
+	public:
+		EvaluationScope();
+		~EvaluationScope();
+		EvaluationScope(const EvaluationScope&) = delete;
+		EvaluationScope& operator=(const EvaluationScope&) = delete;
+	};
+
 	static void breakpoint();
 
 	/*
@@ -201,6 +217,10 @@ public:
 	virtual ValueBase operator()(Time /*t*/)const
 		{ return ValueBase(); }
 
+	//! Returns the value of the ValueNode at time \a t, same as operator()
+	/*!	Uses the cache of EvaluationScope when it is active */
+	ValueBase evaluate(Time t)const;
+
 	//! \internal Sets the id of the ValueNode
 	void set_id(const String &x);
 
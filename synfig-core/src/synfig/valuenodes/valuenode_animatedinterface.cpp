@@ -34,6 +34,7 @@
 #endif
 
 #include <cmath>
+#include <cstdint>
 
 #include <algorithm>
 #include <typeinfo>
@@ -228,6 +229,38 @@ clamped_tangent<Gradient>(Gradient p1, Gradient p2, Gradient p3, Time t1, Time t
 	return ret;
 };
 
+//! Remembers the last segment found by each interpolator in the current thread,
+//! so sequential playback does not search the segment again.
+//! Stored index is only a hint, it must be checked by the caller
+class LookupCursor
+{
+	struct Entry
+	{
+		const void *owner;
+		std::size_t index;
+	};
+
+	static Entry& entry(const void *owner)
+	{
+		static thread_local Entry entries[64] = { };
+		return entries[(reinterpret_cast<std::uintptr_t>(owner) >> 4) % 64];
+	}
+
+public:
+	static std::size_t get(const void *owner)
+	{
+		const Entry &e = entry(owner);
+		return e.owner == owner ? e.index : 0;
+	}
+
+	static void set(const void *owner, std::size_t index)
+	{
+		Entry &e = entry(owner);
+		e.owner = owner;
+		e.index = index;
+	}
+};
+
 class ValueNode_AnimatedInterfaceConst::Interpolator
 {
 public:
@@ -254,6 +287,26 @@ public:
 				animated.node().time_to_frame( animated.waypoint_list().back().get_time() ) );
 	}
 
+	//! Returns the last waypoint placed before or at time \a t,
+	//! \a t must be between the first and the last waypoints
+	WaypointList::const_iterator find_waypoint_before(const Time &t) const
+	{
+		const WaypointList &list = animated.waypoint_list();
+
+		// check the last found waypoint and the next one
+		std::size_t index = LookupCursor::get(this);
+		for(std::size_t i = index; i < index + 2 && i + 1 < list.size(); ++i)
+			if (t >= list[i].get_time() && t < list[i + 1].get_time())
+				{ LookupCursor::set(this, i); return list.begin() + i; }
+
+		WaypointList::const_iterator iter = std::upper_bound(list.begin(), list.end(), t,
+			[](const Time &t, const Waypoint &w) { return t < w.get_time(); } );
+		if (iter != list.begin())
+			--iter;
+		LookupCursor::set(this, iter - list.begin());
+		return iter;
+	}
+
 	void calc_values_constant(std::map<Time, ValueBase> &x) const
 	{
 		if (animated.waypoint_list().empty())
@@ -656,15 +709,21 @@ public:
 			if(t>=s)
 				return animated.waypoint_list_.back().get_value(t);
 
-			typename curve_list_type::const_iterator iter;
-
-			// This next line will set iter to the
-			// correct iterator for the given time.
-			for(iter=curve_list.begin();iter<curve_list.end() && t>=iter->first.get_s();++iter)
-				continue;
-			if(iter==curve_list.end())
-				return animated.waypoint_list_.back().get_value(t);
-			return iter->resolve(t);
+			// find the first curve which ends after t,
+			// check the last found curve and the next one before binary search
+			const std::size_t count = curve_list.size();
+			std::size_t index = LookupCursor::get(this);
+			if ( !(index < count && t < curve_list[index].first.get_s() && (index == 0 || t >= curve_list[index - 1].first.get_s())) )
+			{
+				++index;
+				if ( !(index < count && t < curve_list[index].first.get_s() && t >= curve_list[index - 1].first.get_s()) )
+					index = std::upper_bound(curve_list.begin(), curve_list.end(), t,
+						[](const Time &t, const PathSegment &c) { return t < c.first.get_s(); } ) - curve_list.begin();
+				if (index == count)
+					return animated.waypoint_list_.back().get_value(t);
+				LookupCursor::set(this, index);
+			}
+			return curve_list[index].resolve(t);
 		}
 	}; // END of class Hermite
 
@@ -747,15 +806,7 @@ public:
 			if(t>=s)
 				return animated.waypoint_list_.back().get_value(t);
 
-			WaypointList::const_iterator iter;
-			WaypointList::const_iterator next;
-
-			// This next line will set iter to the
-			// correct iterator for the given time.
-			for(next=animated.waypoint_list_.begin(),iter=next++;next!=animated.waypoint_list_.end() && t>=next->get_time();iter=next++)
-				continue;
-
-			return iter->get_value(t);
+			return find_waypoint_before(t)->get_value(t);
 		}
 
 		virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const
@@ -838,13 +889,8 @@ public:
 			if(t>=s)
 				return animated.waypoint_list_.back().get_value(t);
 
-			WaypointList::const_iterator iter = animated.waypoint_list_.begin();
-
 			// A waypoint sets the boolean value until next waypoint
-			for (auto next = iter+1; next != animated.waypoint_list_.end(); iter = next++)
-				if (iter->get_time()==t || t < next->get_time())
-					return iter->get_value(t);
-			return iter->get_value(t);
+			return find_waypoint_before(t)->get_value(t);
 		}
 
 		virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const
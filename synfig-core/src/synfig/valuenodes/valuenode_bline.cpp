@@ -933,7 +933,7 @@ ValueNode_BLine::check_type(Type &type)
 BLinePoint
 ValueNode_BLine::get_blinepoint(std::vector<ListEntry>::const_iterator current, Time t) const
 {
-	BLinePoint bpcurr((*current->value_node)(t).get(BLinePoint()));
+	BLinePoint bpcurr(current->value_node->evaluate(t).get(BLinePoint()));
 	if(!bpcurr.get_boned_vertex_flag())
 		return bpcurr;
 
@@ -955,8 +955,8 @@ ValueNode_BLine::get_blinepoint(std::vector<ListEntry>::const_iterator current,
 		previous=list.end();
 	previous--;
 
-	bpprev=(*previous->value_node)(t).get(BLinePoint());
-	bpnext=(*next->value_node)(t).get(BLinePoint());
+	bpprev=previous->value_node->evaluate(t).get(BLinePoint());
+	bpnext=next->value_node->evaluate(t).get(BLinePoint());
 
 	t1=bpcurr.get_tangent1();
 	t2=bpcurr.get_tangent2();
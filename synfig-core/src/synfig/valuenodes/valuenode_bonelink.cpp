@@ -151,7 +151,7 @@ ValueNode_BoneLink::get_bone_transformation(Time t)const
 	ValueNode_Bone::Handle bone_node = (*bone_)(t).get(ValueNode_Bone::Handle());
 	if (bone_node)
 	{
-		Bone bone      = (*bone_node) (t).get(Bone());
+		Bone bone      = bone_node->evaluate(t).get(Bone());
 		bool translate = (*translate_)(t).get(true);
 		bool rotate    = (*rotate_)   (t).get(true);
 		bool skew      = (*skew_)     (t).get(true);
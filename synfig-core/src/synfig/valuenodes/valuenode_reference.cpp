@@ -112,7 +112,7 @@ ValueNode_Reference::operator()(Time t)const
 	DEBUG_LOG("SYNFIG_DEBUG_VALUENODE_OPERATORS",
 		"%s:%d operator()\n", __FILE__, __LINE__);
 
-	return (*link_)(t);
+	return link_->evaluate(t);
 }
 
 
@@ -32,7 +32,12 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstring>
+
+#include <sigc++/bind.h>
+
+#include "threadpool.h"
 #include "zstreambuf.h"
 
 #endif
@@ -47,6 +52,74 @@ using namespace synfig;
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+struct DeflateBlock
+{
+	const char *dictionary;
+	size_t dictionary_size;
+	const char *data;
+	size_t size;
+	bool last;
+
+	std::vector<char> out;
+	uLong crc;
+	bool success;
+};
+
+void
+deflate_block(DeflateBlock *block)
+{
+	block->crc = crc32(crc32(0, nullptr, 0), (const Bytef*)block->data, (uInt)block->size);
+	block->success = false;
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (Z_OK != deflateInit2(&stream,
+			zstreambuf::option_compression_level,
+			zstreambuf::option_method,
+			zstreambuf::compression::deflate,
+			zstreambuf::option_mem_level,
+			zstreambuf::option_strategy
+	)) return;
+
+	if (block->dictionary_size
+	 && Z_OK != deflateSetDictionary(&stream, (const Bytef*)block->dictionary, (uInt)block->dictionary_size))
+		{ deflateEnd(&stream); return; }
+
+	// sync flush adds empty stored block to align output to the byte boundary
+	block->out.resize(deflateBound(&stream, (uLong)block->size) + 16);
+	stream.avail_in = (uInt)block->size;
+	stream.next_in = (Bytef*)const_cast<char*>(block->data);
+	stream.avail_out = (uInt)block->out.size();
+	stream.next_out = (Bytef*)block->out.data();
+	while(true)
+	{
+		int ret = ::deflate(&stream, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+		if (ret == Z_STREAM_ERROR) break;
+		if (stream.avail_out != 0 || ret == Z_STREAM_END)
+		{
+			block->out.resize(block->out.size() - stream.avail_out);
+			block->success = stream.avail_in == 0;
+			break;
+		}
+		size_t size = block->out.size();
+		block->out.resize(size + zstreambuf::option_bufsize);
+		stream.avail_out = zstreambuf::option_bufsize;
+		stream.next_out = (Bytef*)&block->out[size];
+	}
+	deflateEnd(&stream);
+}
+
+void
+write_uint32(std::streambuf *buf, uLong x)
+{
+	const char bytes[] = { (char)(x & 0xff), (char)((x >> 8) & 0xff), (char)((x >> 16) & 0xff), (char)((x >> 24) & 0xff) };
+	buf->sputn(bytes, sizeof(bytes));
+}
+
+} // end of anonymous namespace
+
 /* === M E T H O D S ======================================================= */
 
 zstreambuf::zstreambuf(std::streambuf *buf, zstreambuf::compression compression):
@@ -55,7 +128,10 @@ zstreambuf::zstreambuf(std::streambuf *buf, zstreambuf::compression compression)
 	inflate_initialized(false),
 	inflate_stream_{},
 	deflate_initialized(false),
-	deflate_stream_{}
+	deflate_finished(false),
+	deflate_crc_(0),
+	deflate_size_(0),
+	dictionary_size_(0)
 {
 }
 
@@ -63,7 +139,6 @@ zstreambuf::~zstreambuf()
 {
 	sync();
 	if (inflate_initialized) inflateEnd(&inflate_stream_);
-	if (deflate_initialized) deflateEnd(&deflate_stream_);
 }
 
 bool zstreambuf::pack(std::vector<char> &dest, const void *src, size_t size, bool fast) {
@@ -201,40 +276,68 @@ bool zstreambuf::inflate_buf()
 
 bool zstreambuf::deflate_buf(bool flush)
 {
-	if (pbase() && pptr() > pbase())
+	const size_t size = pbase() ? (size_t)(pptr() - pbase()) : 0;
+	if (deflate_finished) return size == 0;
+	// nothing was written, keep the output empty
+	if (!size && !(flush && deflate_initialized)) return true;
+
+	const bool gzip = compression_ != compression::deflate;
+	if (!deflate_initialized)
 	{
-		// initialize deflate if need
-		if (!deflate_initialized)
+		if (gzip)
 		{
-			memset(&deflate_stream_, 0, sizeof(deflate_stream_));
-
-			if (Z_OK != deflateInit2(&deflate_stream_,
-					option_compression_level,
-					option_method,
-					option_window_bits,
-					option_mem_level,
-					option_strategy
-			)) return false;
+			// magic, deflate method, no flags, no time, best compression, unknown OS
+			const char header[] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 2, '\xff' };
+			buf_->sputn(header, sizeof(header));
+		}
+		deflate_crc_ = crc32(0, nullptr, 0);
+		deflate_size_ = 0;
+		deflate_initialized = true;
+	}
 
-			deflate_initialized = true;
+	// compress blocks in parallel
+	const char *data = write_buffer_.data() + dictionary_size_;
+	const size_t count = size ? (size - 1)/option_block_size + 1 : 1;
+	std::vector<DeflateBlock> blocks(count);
+	{
+		ThreadPool::Group group;
+		for(size_t i = 0; i < count; ++i)
+		{
+			DeflateBlock &block = blocks[i];
+			block.data = data + i*option_block_size;
+			block.size = std::min((size_t)option_block_size, size - i*option_block_size);
+			block.dictionary_size = i ? (size_t)option_dictionary_size : dictionary_size_;
+			block.dictionary = block.data - block.dictionary_size;
+			block.last = flush && i + 1 == count;
+			group.enqueue(sigc::bind(sigc::ptr_fun(&deflate_block), &block));
 		}
+		group.run();
+	}
+
+	// write blocks in order
+	for(std::vector<DeflateBlock>::const_iterator i = blocks.begin(); i != blocks.end(); ++i)
+	{
+		if (!i->success) return false;
+		if ((std::streamsize)i->out.size() != buf_->sputn(i->out.data(), i->out.size())) return false;
+		deflate_crc_ = crc32_combine(deflate_crc_, i->crc, (z_off_t)i->size);
+		deflate_size_ += i->size;
+	}
 
-		// deflate and write new chunk of data
-		char out_buf[option_bufsize];
-		deflate_stream_.avail_in = (uInt)(pptr() - pbase());
-		deflate_stream_.next_in = (Bytef*)pbase();
-		do
+	if (flush)
+	{
+		if (gzip)
 		{
-			deflate_stream_.avail_out = sizeof(out_buf);
-			deflate_stream_.next_out = (Bytef*)out_buf;
-			if (Z_STREAM_ERROR == ::deflate(&deflate_stream_, flush ? Z_FINISH : Z_NO_FLUSH))
-				return false;
-			if (deflate_stream_.avail_out < sizeof(out_buf))
-				buf_->sputn(out_buf, sizeof(out_buf) - deflate_stream_.avail_out);
-		} while (deflate_stream_.avail_out == 0);
-		assert(deflate_stream_.avail_in == 0);
-		setp(nullptr, nullptr);
+			write_uint32(buf_, deflate_crc_);
+			write_uint32(buf_, deflate_size_);
+		}
+		deflate_finished = true;
 	}
+
+	// keep the tail of data as dictionary for the next blocks
+	const size_t tail = std::min((size_t)option_dictionary_size, dictionary_size_ + size);
+	memmove(write_buffer_.data(), data + size - tail, tail);
+	dictionary_size_ = tail;
+	setp(nullptr, nullptr);
 	return true;
 }
 
@@ -262,9 +365,11 @@ int zstreambuf::overflow(int c)
 	if (pptr() >= epptr())
 	{
 		if (!deflate_buf(false)) return EOF;
-		if (write_buffer_.size() < option_bufsize) write_buffer_.resize(option_bufsize);
-		char *pointer = &write_buffer_.front();
-		setp(pointer, pointer + write_buffer_.size());
+		// one block for each thread
+		const size_t size = option_block_size*std::max(1, ThreadPool::instance().get_max_threads());
+		if (write_buffer_.size() < option_dictionary_size + size) write_buffer_.resize(option_dictionary_size + size);
+		char *pointer = &write_buffer_[dictionary_size_];
+		setp(pointer, pointer + size);
 	}
 
 	// put character
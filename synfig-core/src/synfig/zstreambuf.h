@@ -67,7 +67,14 @@ namespace synfig {
 
 			fast_option_compression_level = Z_BEST_SPEED,
 			fast_option_mem_level		= 9,
-			fast_option_strategy		= Z_FIXED
+			fast_option_strategy		= Z_FIXED,
+
+			// Written data is split into blocks which are compressed
+			// in parallel, like pigz does. Each block uses the tail
+			// of previous data as dictionary, and ends by sync flush,
+			// so concatenated blocks make one regular deflate stream.
+			option_block_size			= 128*1024,
+			option_dictionary_size		= 32*1024
 		};
 
 	private:
@@ -79,7 +86,10 @@ namespace synfig {
 		std::vector<char> read_buffer_;
 
 		bool deflate_initialized;
-		z_stream deflate_stream_;
+		bool deflate_finished;
+		uLong deflate_crc_;
+		uLong deflate_size_;
+		size_t dictionary_size_; //!< size of the tail of previous data at the front of write_buffer_
 		std::vector<char> write_buffer_;
 
 		bool inflate_buf();
@@ -137,12 +147,7 @@ namespace synfig {
 
 	protected:
 		virtual size_t internal_write(const void *buffer, size_t size)
-		{
-			for(size_t i = 0; i < size; i++)
-				if (!ostream_.put(((const char*)buffer)[i]).good())
-					return i;
-			return size;
-		}
+			{ return ostream_.write((const char*)buffer, size).good() ? size : 0; }
 
 	public:
 		ZWriteStream(FileSystem::WriteStream::Handle stream):
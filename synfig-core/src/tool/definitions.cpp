@@ -103,3 +103,13 @@ void SynfigToolGeneralOptions::set_repeats(int repeats)
 {
 	_repeats = repeats;
 }
+
+const std::string& SynfigToolGeneralOptions::get_profile_file() const
+{
+	return _profile_file;
+}
+
+void SynfigToolGeneralOptions::set_profile_file(const std::string& profile_file)
+{
+	_profile_file = profile_file;
+}
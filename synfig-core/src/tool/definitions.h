@@ -114,6 +114,14 @@ public:
 
 	void set_repeats(int repeats);
 
+	/**
+	 * File to write the profile of rendering to,
+	 * profiling is disabled when it is empty.
+	 */
+	const std::string& get_profile_file() const;
+
+	void set_profile_file(const std::string& profile_file);
+
 private:
 	SynfigToolGeneralOptions();
 	std::string _binary_path;
@@ -123,6 +131,7 @@ private:
 		 _should_print_benchmarks;
 
 	int _repeats;
+	std::string _profile_file;
 };
 
 #endif
@@ -44,6 +44,7 @@
 #include <synfig/target_tile.h>
 #include <synfig/savecanvas.h>
 #include <synfig/filesystemnative.h>
+#include <synfig/debug/profile.h>
 
 #include "definitions.h"
 #include "synfigtoolexception.h"
@@ -178,12 +179,14 @@ static void set_canvas_quality_and_alpha_mode(Job& job)
 	}
 }
 
-static void set_target_engine_and_threads(Job& job)
+static void set_target_engine_and_threads(Job& job, const TargetParam& target_parameters)
 {
 	if(auto scanline_target = Target_Scanline::Handle::cast_dynamic(job.target))
 	{
 		scanline_target->set_threads(SynfigToolGeneralOptions::instance()->get_threads());
 		scanline_target->set_engine(job.render_engine);
+		if (target_parameters.frames_in_flight > 0)
+			scanline_target->set_frames_in_flight(target_parameters.frames_in_flight);
 	} else if(auto tile_target = Target_Tile::Handle::cast_dynamic(job.target))
 	{
 		tile_target->set_threads(SynfigToolGeneralOptions::instance()->get_threads());
@@ -222,7 +225,7 @@ bool setup_job(Job& job, const TargetParam& target_parameters)
 	set_canvas_quality_and_alpha_mode(job);
 
 	// Set the threads and render engine for the target
-	set_target_engine_and_threads(job);
+	set_target_engine_and_threads(job, target_parameters);
 
 	return true;
 }
@@ -247,16 +250,28 @@ static void save_canvas_to_file(const std::string& filename, const synfig::Canva
 	}
 }
 
-void render_job(const Job& job, RenderProgress& progress, bool should_print_benchmarks, int repeats) {
+void render_job(const Job& job, RenderProgress& progress, bool should_print_benchmarks, int repeats, const std::string& profile_file) {
 	double total_duration = 0.f;
 
+	if (!profile_file.empty())
+		synfig::debug::Profile::start();
+
 	for(int i = 0; i < repeats; i++)
 	{
 		std::chrono::steady_clock::time_point start_timepoint =
 				std::chrono::steady_clock::now();
 
 		// Call the render member of the target
-		if(!job.target->render(&progress)) {
+		bool success;
+		{
+			synfig::debug::Profile::Scope profile_scope("render", "render");
+			if (profile_scope.is_active())
+				profile_scope.set_args(synfig::strprintf("\"repeat\":%d", i));
+			success = job.target->render(&progress);
+		}
+		if(!success) {
+			if (!profile_file.empty())
+				synfig::debug::Profile::stop(profile_file);
 			throw (SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure.")));
 		}
 
@@ -268,6 +283,9 @@ void render_job(const Job& job, RenderProgress& progress, bool should_print_benc
 		}
 	}
 
+	if (!profile_file.empty())
+		synfig::debug::Profile::stop(profile_file);
+
 	if(should_print_benchmarks)
 	{
 		std::cout << job.filename.c_str()
@@ -299,8 +317,9 @@ void process_job (Job& job)
 
 		bool should_print_benchmarks = SynfigToolGeneralOptions::instance()->should_print_benchmarks();
 		int repeats = SynfigToolGeneralOptions::instance()->get_repeats();
+		const std::string& profile_file = SynfigToolGeneralOptions::instance()->get_profile_file();
 
-		render_job(job, p, should_print_benchmarks, repeats);
+		render_job(job, p, should_print_benchmarks, repeats, profile_file);
 	}
 
 	VERBOSE_OUT(1) << _("Done.") << std::endl;
@@ -96,6 +96,7 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	set_antialias(),
 	set_quality(),
 	set_num_threads(),
+	set_frames_in_flight(),
 	set_input_file(),
 	set_output_file(),
 	set_sequence_separator(),
@@ -114,6 +115,7 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	sw_verbosity(),
 	sw_quiet(),
 	sw_print_benchmarks(),
+	sw_profile_file(),
 	sw_extract_alpha(),
 
 	// Misc group
@@ -156,6 +158,7 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_set, "antialias",   'a', set_antialias,	_("Set antialias amount for parametric renderer."), "1..30");
 	//og_set.add_option("quality",     'Q', quality_arg_desc, strprintf(_("Specify image quality for accelerated renderer (Default: %d)"), DEFAULT_QUALITY).c_str(), "NUM");
 	add_option(og_set, "threads",     'T', set_num_threads, _("Enable multithreaded renderer using the specified number of threads"), "NUM");
+	add_option(og_set, "frames-in-flight", ' ', set_frames_in_flight, _("Render up to the specified number of frames concurrently"), "NUM");
 	add_option(og_set, "input-file",  'i', set_input_file, 	_("Specify input filename"), "filename");
 	add_option(og_set, "output-file", 'o', set_output_file, _("Specify output filename"), "filename");
 	add_option(og_set, "renderer",    ' ', set_renderer,    _("Specify which renderer to use"), "string");
@@ -176,6 +179,7 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_switch, "verbose",       'v', sw_verbosity, 			_("Output verbosity level"), "NUM");
 	add_option(og_switch, "quiet",         'q', sw_quiet, 				_("Quiet mode (No progress/time-remaining display)"), "");
 	add_option(og_switch, "benchmarks",    'b', sw_print_benchmarks,	_("Print benchmarks"), "");
+	add_option_filename(og_switch, "profile", ' ', sw_profile_file,	_("Write timings of frames and rendering tasks to <filename> in Chrome trace format"), _("filename"));
 	add_option(og_switch, "extract-alpha", 'x', sw_extract_alpha, 		_("Extract alpha"), "");
 
 	//SynfigOptionGroup og_misc("misc", _("Misc options"), "Show Misc options help");
@@ -357,6 +361,11 @@ void SynfigCommandLineParser::process_settings_options() const
 		SynfigToolGeneralOptions::instance()->set_should_print_benchmarks(true);
 	}
 
+	if (!sw_profile_file.empty())
+	{
+		SynfigToolGeneralOptions::instance()->set_profile_file(sw_profile_file);
+	}
+
 	if(set_repeats > 0)
 	{
 		SynfigToolGeneralOptions::instance()->set_repeats(set_repeats);
@@ -653,6 +662,12 @@ TargetParam SynfigCommandLineParser::extract_targetparam()
                        << "'."
 					   << std::endl;
 	}
+	if (set_frames_in_flight > 0)
+	{
+		params.frames_in_flight = set_frames_in_flight;
+		VERBOSE_OUT(1) << _("Frames in flight set to: ") << params.frames_in_flight
+					   << std::endl;
+	}
 
 	return params;
 }
@@ -64,7 +64,7 @@ public:
 	synfig::RendDesc extract_renddesc(const synfig::RendDesc& renddesc);
 
 	/// Extract the target parameters from the options given in the command line
-	/// video-codec, bitrate, sequence-separator
+	/// video-codec, bitrate, sequence-separator, frames-in-flight
 	synfig::TargetParam extract_targetparam();
 
 	/// Determine which parameters to show in the canvas info
@@ -104,6 +104,7 @@ private:
 	int				set_antialias;
 	int				set_quality;
 	int				set_num_threads;
+	int				set_frames_in_flight;
 	Glib::ustring	set_input_file;
 	Glib::ustring	set_output_file;
 	Glib::ustring   set_renderer;
@@ -123,6 +124,7 @@ private:
 	int				sw_verbosity;
 	bool			sw_quiet;
 	bool			sw_print_benchmarks;
+	std::string		sw_profile_file;
 	bool			sw_extract_alpha;
 
 	// Misc group
@@ -24,18 +24,35 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <cmath>
 #include <cstdio>
+#include <vector>
+
+#include <glibmm/miscutils.h>
 
 #include <synfig/angle.h>
 #include <synfig/bezier.h>
 #include <synfig/clock.h>
+#include <synfig/color.h>
+#include <synfig/string_helper.h>
 #include <synfig/surface_etl.h>
+#include <synfig/threadpool.h>
+#include <synfig/type.h>
+#include <synfig/value.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/rendering/common/task/taskblend.h>
+#include <synfig/rendering/common/task/taskblur.h>
+#include <synfig/rendering/common/task/taskcontour.h>
+#include <synfig/rendering/software/surfacesw.h>
 
 /* === M A C R O S ========================================================= */
 
 using namespace synfig;
 
 #define HERMITE_TEST_ITERATIONS		(100000)
+#define VALUE_TEST_ITERATIONS		(1000000)
+#define RENDER_TEST_SIZE			(2048)
+#define RENDER_TEST_ITERATIONS		(3)
 
 /* === C L A S S E S ======================================================= */
 
@@ -281,6 +298,115 @@ int hermite_angle_test(void)
 	return ret;
 }
 
+//! Copies and sets parameters like Layer::set_param_list() does
+int value_copy_test(void)
+{
+	int ret=0,i;
+	std::vector<ValueBase> params(8);
+
+	synfig::clock timer;
+	double t;
+
+	for(i=0,timer.reset();i<VALUE_TEST_ITERATIONS;i++)
+	{
+		params[0]=Real(i);
+		params[1]=Vector(i,-i);
+		params[2]=Color(0.5f,0.5f,0.5f,1.f);
+		params[3]=Angle::deg(i);
+		params[4]=(i&1)!=0;
+		params[5]=params[0];
+		params[6]=ValueBase(params[1]);
+		params[7]=params[3];
+	}
+	t=timer();
+
+	if(params[5].get(Real())!=Real(VALUE_TEST_ITERATIONS-1))
+		ret++;
+
+	printf("ValueBase copies:time=%f milliseconds, %f nanoseconds per value\n",t*1000,t*1e9/(VALUE_TEST_ITERATIONS*8.0));
+	return ret;
+}
+
+//! Flower of cubic petals, it covers the most part of square (-1, -1)-(1, 1)
+static rendering::Task::Handle
+render_test_contour(int petals, Real radius, const Color &color)
+{
+	rendering::Contour::Handle contour(new rendering::Contour());
+	const Real step = 2.0*PI/petals;
+	contour->move_to(Vector(radius, 0.0));
+	for(int i = 0; i < petals; ++i)
+	{
+		const Real a = step*i;
+		contour->cubic_to(
+			Vector(radius*std::cos(a + step), radius*std::sin(a + step)),
+			Vector(1.5*radius*std::cos(a + 0.25*step), 1.5*radius*std::sin(a + 0.25*step)),
+			Vector(1.5*radius*std::cos(a + 0.75*step), 1.5*radius*std::sin(a + 0.75*step)) );
+	}
+	contour->close();
+	contour->color = color;
+
+	rendering::TaskContour::Handle task(new rendering::TaskContour());
+	task->contour = contour;
+	return task;
+}
+
+//! Large blurred flower under the sharp one
+static rendering::Task::Handle
+render_test_scene()
+{
+	rendering::TaskBlur::Handle blur(new rendering::TaskBlur());
+	blur->blur = rendering::Blur(rendering::Blur::FASTGAUSSIAN, Vector(0.05, 0.05));
+	blur->sub_task() = render_test_contour(64, 0.6, Color(0.f, 0.f, 1.f, 1.f));
+
+	rendering::TaskBlend::Handle blend(new rendering::TaskBlend());
+	blend->sub_task_a() = blur;
+	blend->sub_task_b() = render_test_contour(48, 0.5, Color(1.f, 0.5f, 0.f, 0.75f));
+	return blend;
+}
+
+//! Seconds to render the scene by renderer, which was started with \a threads
+static float
+render_time(int threads)
+{
+	// renderer takes count of threads and size of cache at start
+	Glib::setenv("SYNFIG_RENDERING_THREADS", strprintf("%d", threads), true);
+	Glib::setenv("SYNFIG_RENDERING_CACHE_SIZE", "0", true);
+	rendering::Renderer::subsys_init();
+	const rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer("software");
+
+	float best = 0.f;
+	for(int i = 0; i < RENDER_TEST_ITERATIONS; i++)
+	{
+		rendering::SurfaceResource::Handle surface(new rendering::SurfaceResource());
+		surface->create(RENDER_TEST_SIZE, RENDER_TEST_SIZE);
+
+		rendering::Task::Handle task = render_test_scene();
+		task->target_surface = surface;
+		task->target_rect = RectInt(0, 0, RENDER_TEST_SIZE, RENDER_TEST_SIZE);
+		task->source_rect = Rect(-1.0, -1.0, 1.0, 1.0);
+
+		synfig::clock timer;
+		renderer->run(task, true);
+		const float t = timer();
+		if (i == 0 || t < best) best = t;
+	}
+
+	rendering::Renderer::subsys_stop();
+	return best;
+}
+
+int render_threads_test(void)
+{
+	printf("render %dx%d, contours and blur:\n", RENDER_TEST_SIZE, RENDER_TEST_SIZE);
+	const float single = render_time(1);
+	for(int threads = 1; threads <= 64; threads *= 2)
+	{
+		const float t = threads == 1 ? single : render_time(threads);
+		printf("threads=%2d:time=%f milliseconds, speedup=%.2f\n", threads, t*1000, t > 0 ? single/t : 0.f);
+	}
+	return 0;
+}
+
 
 /* === E N T R Y P O I N T ================================================= */
 
@@ -293,5 +419,13 @@ int main()
 	error+=hermite_int_test();
 	error+=hermite_angle_test();
 
+	Type::subsys_init();
+	error+=value_copy_test();
+	Type::subsys_stop();
+
+	ThreadPool::subsys_init();
+	error+=render_threads_test();
+	ThreadPool::subsys_stop();
+
 	return error;
 }
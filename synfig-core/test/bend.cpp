@@ -0,0 +1,159 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file bend.cpp
+**	\brief Test reuse of outline segments generated by rendering::Bend
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include <synfig/threadpool.h>
+#include <synfig/rendering/primitive/bend.h>
+#include <synfig/rendering/primitive/contour.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace rendering;
+
+static const int segments = 8;
+
+//! Wavy line with variable width, built like the outline layer does it
+static void
+build(Bend &bend, Contour &contour, int count, const Vector &shift = Vector())
+{
+	bend.points.clear();
+	std::vector<Real> widths;
+	for(int i = 0; i < count; ++i) {
+		const Vector p(i*0.5, std::sin(i*0.7));
+		const Vector t(1.0, std::cos(i*0.7)*0.7);
+		bend.add(i == count/2 ? p + shift : p, t, t, i % 3 ? Bend::ROUND : Bend::CORNER, true, 16);
+		widths.push_back(0.1 + 0.05*(i % 4));
+	}
+	bend.tails();
+
+	contour.clear();
+	contour.move_to(Vector(bend.length0(), widths.front()));
+	for(int i = 1; i < count; ++i)
+		contour.line_to(Vector(bend.points[i*16].length, widths[i]));
+	for(int i = count - 1; i >= 0; --i)
+		contour.line_to(Vector(bend.points[i*16].length, -widths[i]));
+	contour.close();
+}
+
+static void
+check_equal(const Contour &expected, const Contour &contour, Real precision)
+{
+	const Contour::ChunkList &a = expected.get_chunks();
+	const Contour::ChunkList &b = contour.get_chunks();
+	ASSERT_EQUAL(a.size(), b.size())
+	for(size_t i = 0; i < a.size(); ++i) {
+		ASSERT_EQUAL(a[i].type, b[i].type)
+		ASSERT(std::fabs(a[i].p1[0] - b[i].p1[0]) <= precision)
+		ASSERT(std::fabs(a[i].p1[1] - b[i].p1[1]) <= precision)
+		ASSERT(std::fabs(a[i].pp0[0] - b[i].pp0[0]) <= precision)
+		ASSERT(std::fabs(a[i].pp0[1] - b[i].pp0[1]) <= precision)
+		ASSERT(std::fabs(a[i].pp1[0] - b[i].pp1[0]) <= precision)
+		ASSERT(std::fabs(a[i].pp1[1] - b[i].pp1[1]) <= precision)
+	}
+}
+
+static std::set<Bend::Segment*>
+get_segments(const Bend::Cache &cache)
+{
+	std::set<Bend::Segment*> s;
+	for(Bend::Cache::List::const_iterator i = cache.list.begin(); i != cache.list.end(); ++i)
+		s.insert(i->get());
+	return s;
+}
+
+void test_cached_segments_are_reused() {
+	Bend bend;
+	Contour contour;
+	build(bend, contour, 40);
+
+	Contour expected, result;
+	bend.bend(expected, contour, Matrix(), segments);
+
+	Bend::Cache::Handle cache(new Bend::Cache());
+	bend.bend(result, contour, Matrix(), segments, cache);
+	check_equal(expected, result, 0.0);
+	const std::set<Bend::Segment*> first = get_segments(*cache);
+	ASSERT(!first.empty())
+
+	result.clear();
+	bend.bend(result, contour, Matrix(), segments, cache);
+	check_equal(expected, result, 0.0);
+	ASSERT(first == get_segments(*cache))
+}
+
+void test_only_changed_segments_are_generated() {
+	Bend bend;
+	Contour contour;
+	build(bend, contour, 40);
+	Bend::Cache::Handle cache(new Bend::Cache());
+	Contour result;
+	bend.bend(result, contour, Matrix(), segments, cache);
+	const std::set<Bend::Segment*> before = get_segments(*cache);
+
+	// move one vertex, lengths of all following points are changed too
+	build(bend, contour, 40, Vector(0.1, 0.3));
+	Contour expected;
+	bend.bend(expected, contour, Matrix(), segments);
+	result.clear();
+	bend.bend(result, contour, Matrix(), segments, cache);
+	check_equal(expected, result, 1e-6);
+
+	const std::set<Bend::Segment*> after = get_segments(*cache);
+	int reused = 0;
+	for(std::set<Bend::Segment*>::const_iterator i = after.begin(); i != after.end(); ++i)
+		if (before.count(*i)) ++reused;
+	ASSERT(reused > 0)
+	ASSERT(after.size() - reused <= 12)
+}
+
+void test_long_outline() {
+	Bend bend;
+	Contour contour;
+	build(bend, contour, 2000);
+	ASSERT(bend.points.size() > 4*Bend::MIN_THREAD_POINTS)
+
+	Contour expected, result;
+	bend.bend(expected, contour, Matrix(), segments);
+	Bend::Cache::Handle cache(new Bend::Cache());
+	bend.bend(result, contour, Matrix(), segments, cache);
+	check_equal(expected, result, 0.0);
+}
+
+int main() {
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_cached_segments_are_reused)
+		TEST_FUNCTION(test_only_changed_segments_are_generated)
+		TEST_FUNCTION(test_long_outline)
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+
+	return tst_exit_status;
+}
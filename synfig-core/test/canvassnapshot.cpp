@@ -0,0 +1,193 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvassnapshot.cpp
+**	\brief Test that snapshots of a canvas match the canvas at their times
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <glibmm/miscutils.h>
+
+#include <synfig/canvas.h>
+#include <synfig/canvassnapshot.h>
+#include <synfig/context.h>
+#include <synfig/layer.h>
+#include <synfig/main.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/rendering/software/surfacesw.h>
+#include <synfig/valuenodes/valuenode_animated.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+static const int size = 16;
+
+//! Root canvas with animated solid color and a group, which contains animated layer too
+static Canvas::Handle
+create_canvas()
+{
+	Canvas::Handle canvas = Canvas::create();
+	canvas->rend_desc().set_w(size);
+	canvas->rend_desc().set_h(size);
+	canvas->rend_desc().set_tl(Point(-1.0, -1.0));
+	canvas->rend_desc().set_br(Point(1.0, 1.0));
+
+	ValueNode_Animated::Handle color = ValueNode_Animated::create(type_color);
+	color->new_waypoint(Time(0.0), ValueBase(Color(1.f, 0.f, 0.f, 1.f)));
+	color->new_waypoint(Time(1.0), ValueBase(Color(0.f, 0.f, 1.f, 1.f)));
+	Layer::Handle background = Layer::create("SolidColor");
+	background->connect_dynamic_param("color", ValueNode::LooseHandle(color));
+	canvas->push_back(background);
+
+	Canvas::Handle inner = Canvas::create_inline(canvas);
+	ValueNode_Animated::Handle amount = ValueNode_Animated::create(type_real);
+	amount->new_waypoint(Time(0.0), ValueBase(Real(0.0)));
+	amount->new_waypoint(Time(1.0), ValueBase(Real(1.0)));
+	Layer::Handle foreground = Layer::create("SolidColor");
+	foreground->set_param("color", ValueBase(Color(0.f, 1.f, 0.f, 1.f)));
+	foreground->connect_dynamic_param("amount", ValueNode::LooseHandle(amount));
+	inner->push_back(foreground);
+
+	Layer::Handle group = Layer::create("group");
+	group->set_param("canvas", ValueBase(inner));
+	canvas->push_front(group);
+	return canvas;
+}
+
+//! Static parameters of all layers, including layers of inline canvases
+static std::vector<Layer::ParamList>
+get_params(const Canvas &canvas)
+{
+	std::vector<Layer::ParamList> result;
+	for(Canvas::const_iterator i = canvas.begin(); i != canvas.end(); ++i) {
+		Layer::ParamList params = (*i)->get_param_list();
+		Layer::ParamList::iterator c = params.find("canvas");
+		if (c != params.end()) {
+			Canvas::Handle sub_canvas = c->second.get(Canvas::Handle());
+			params.erase(c); // handles differ between copies
+			if (sub_canvas) {
+				std::vector<Layer::ParamList> sub_params = get_params(*sub_canvas);
+				result.insert(result.end(), sub_params.begin(), sub_params.end());
+			}
+		}
+		result.push_back(params);
+	}
+	return result;
+}
+
+static String
+get_signature(const rendering::Task::Handle &task)
+{
+	if (!task)
+		return "-";
+	String signature = task->get_token()->name + "(";
+	for(rendering::Task::List::const_iterator i = task->sub_tasks.begin(); i != task->sub_tasks.end(); ++i)
+		signature += get_signature(*i) + " ";
+	return signature + ")";
+}
+
+static std::vector<Color>
+render(const rendering::Task::Handle &task, const RendDesc &rend_desc)
+{
+	rendering::SurfaceResource::Handle surface = new rendering::SurfaceResource();
+	surface->create(rend_desc.get_w(), rend_desc.get_h());
+	task->target_surface = surface;
+	task->target_rect = RectInt(VectorInt(), surface->get_size());
+	task->source_rect = Rect(rend_desc.get_tl(), rend_desc.get_br());
+	ASSERT(rendering::Renderer::get_renderer("software")->run(task))
+
+	rendering::SurfaceResource::LockRead<rendering::SurfaceSW> lock(surface);
+	ASSERT(lock)
+	const synfig::Surface &pixels = lock->get_surface();
+	return std::vector<Color>(pixels[0], pixels[0] + pixels.get_w()*pixels.get_h());
+}
+
+static void
+check_snapshot(const CanvasSnapshot::Handle &snapshot, Canvas &canvas)
+{
+	canvas.set_time(snapshot->get_time());
+	ASSERT(get_params(canvas) == get_params(*snapshot->get_canvas()))
+
+	rendering::Task::Handle expected_task = canvas.build_rendering_task(ContextParams());
+	rendering::Task::Handle task = snapshot->get_task();
+	ASSERT_EQUAL(get_signature(expected_task), get_signature(task))
+
+	const std::vector<Color> expected = render(expected_task, canvas.rend_desc());
+	const std::vector<Color> pixels = render(task, canvas.rend_desc());
+	for(size_t i = 0; i < expected.size(); ++i) {
+		ASSERT(std::fabs(expected[i].get_r() - pixels[i].get_r()) < 1e-6f)
+		ASSERT(std::fabs(expected[i].get_g() - pixels[i].get_g()) < 1e-6f)
+		ASSERT(std::fabs(expected[i].get_b() - pixels[i].get_b()) < 1e-6f)
+		ASSERT(std::fabs(expected[i].get_a() - pixels[i].get_a()) < 1e-6f)
+	}
+}
+
+void test_snapshots_on_two_threads() {
+	Canvas::Handle canvas = create_canvas();
+	canvas->set_time(Time(0.5));
+	const std::vector<Layer::ParamList> live_params = get_params(*canvas);
+
+	const Time times[] = { Time(0.25), Time(0.75) };
+	CanvasSnapshot::Handle snapshots[2];
+	for(int repeat = 0; repeat < 10; ++repeat) {
+		std::thread threads[2];
+		for(int i = 0; i < 2; ++i)
+			threads[i] = std::thread([&, i]() { snapshots[i] = CanvasSnapshot::create(*canvas, times[i]); });
+		for(int i = 0; i < 2; ++i)
+			threads[i].join();
+	}
+
+	// live layers keep the time set before
+	ASSERT(live_params == get_params(*canvas))
+
+	for(int i = 0; i < 2; ++i) {
+		ASSERT(snapshots[i])
+		ASSERT(times[i] == snapshots[i]->get_time())
+	}
+	// snapshots are really different
+	ASSERT_FALSE(get_params(*snapshots[0]->get_canvas()) == get_params(*snapshots[1]->get_canvas()))
+
+	for(int i = 0; i < 2; ++i)
+		check_snapshot(snapshots[i], *canvas);
+}
+
+int main() {
+	// results of the same sub-trees must not be taken from the cache of the previous render
+	Glib::setenv("SYNFIG_RENDERING_CACHE_SIZE", "0", true);
+	// only core layers are used, installed modules are not needed
+	const char modules_list[] = "test_canvassnapshot_modules.cfg";
+	std::ofstream(modules_list).close();
+	Glib::setenv("SYNFIG_MODULE_LIST", modules_list, true);
+	Main main(".");
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_snapshots_on_two_threads)
+	TEST_SUITE_END()
+
+	std::remove(modules_list);
+
+	return tst_exit_status;
+}
@@ -0,0 +1,168 @@
+/* === S Y N F I G ========================================================= */
+/*! \file color_blend.cpp
+**  \brief Test row blending of colors against per-pixel Color::blend()
+**
+** Copyright (c) 2024 Synfig contributors
+**
+** This file is part of Synfig.
+**
+** Synfig is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** Synfig is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**
+** ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+#include <vector>
+
+#include <synfig/color.h>
+#include <synfig/surface.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === C L A S S E S ======================================================= */
+
+static float
+random_value(unsigned int &seed)
+{
+	seed = seed*1103515245u + 12345u;
+	return (float)((seed >> 8) & 0xffff)/65535.f;
+}
+
+//! Random colors mixed with the corner cases: transparent, opaque, gray and black pixels
+static std::vector<Color>
+build_row(int count, unsigned int seed)
+{
+	std::vector<Color> row(count);
+	for(int i = 0; i < count; ++i) {
+		Color &c = row[i];
+		c = Color(random_value(seed), random_value(seed), random_value(seed), random_value(seed));
+		switch(i % 7) {
+		case 1: c.set_a(0.f); break;
+		case 2: c.set_a(1.f); break;
+		case 3: c = Color(c.get_r(), c.get_r(), c.get_r(), c.get_a()); break;
+		case 5: c = Color(0.f, 0.f, 0.f, c.get_a()); break;
+		default: break;
+		}
+	}
+	return row;
+}
+
+static bool
+is_close(float expected, float value)
+{
+	if (std::isnan(expected) || std::isnan(value))
+		return std::isnan(expected) && std::isnan(value);
+	return std::fabs(expected - value) <= 1e-4f*(1.f + std::fabs(expected));
+}
+
+static void
+check_blend_method(Color::BlendMethod method, float amount, int count)
+{
+	const std::vector<Color> src = build_row(count, 1 + count + 31*method);
+	const std::vector<Color> dest = build_row(count, 7 + 3*count + 17*method);
+
+	std::vector<Color> result(dest);
+	Color::blend_row(&result.front(), &src.front(), count, amount, method);
+
+	for(int i = 0; i < count; ++i) {
+		const Color expected = Color::blend(src[i], dest[i], amount, method);
+		const Color &value = result[i];
+		if ( !is_close(expected.get_r(), value.get_r())
+		  || !is_close(expected.get_g(), value.get_g())
+		  || !is_close(expected.get_b(), value.get_b())
+		  || !is_close(expected.get_a(), value.get_a()) )
+		{
+			std::ostringstream oss;
+			oss.precision(8);
+			oss << "\t - method " << method << ", amount " << amount
+				<< ", pixel " << i << " of " << count
+				<< ": expected " << expected.get_string()
+				<< ", but got " << value.get_string() << std::endl;
+			throw SynfigTestException{__FUNCTION__, __LINE__, oss.str()};
+		}
+	}
+}
+
+void test_blend_row_matches_blend_for_all_methods()
+{
+	const float amounts[] = { 1.f, 0.5f, 0.f, 1e-7f, -0.5f, -1.f, 2.f };
+	for(int method = 0; method < Color::BLEND_END; ++method)
+		for(float amount : amounts)
+			check_blend_method((Color::BlendMethod)method, amount, 61);
+}
+
+void test_blend_row_handles_any_row_length()
+{
+	for(int count = 1; count <= 17; ++count) {
+		check_blend_method(Color::BLEND_COMPOSITE, 0.75f, count);
+		check_blend_method(Color::BLEND_STRAIGHT, 0.75f, count);
+		check_blend_method(Color::BLEND_HUE, 0.75f, count);
+	}
+}
+
+void test_blend_row_ignores_empty_row()
+{
+	Color c(0.25f, 0.5f, 0.75f, 1.f);
+	Color d(c);
+	Color::blend_row(&d, &c, 0, 1.f, Color::BLEND_ADD);
+	ASSERT(c == d)
+}
+
+void test_surface_blit_with_alpha_pen_uses_blend_method()
+{
+	const int w = 13, h = 5;
+	const std::vector<Color> src = build_row(w*h, 3);
+	const std::vector<Color> dest = build_row(w*h, 5);
+
+	Surface a(w, h), b(w, h);
+	for(int y = 0; y < h; ++y)
+		for(int x = 0; x < w; ++x)
+			a[y][x] = src[y*w + x], b[y][x] = dest[y*w + x];
+
+	Surface::alpha_pen pen(b.get_pen(1, 1));
+	pen.set_blend_method(Color::BLEND_MULTIPLY);
+	pen.set_alpha(0.5f);
+	a.blit_to(pen, 0, 0, w, h);
+
+	for(int y = 0; y < h; ++y) {
+		for(int x = 0; x < w; ++x) {
+			Color expected = dest[y*w + x];
+			if (x >= 1 && y >= 1)
+				expected = Color::blend(src[(y - 1)*w + x - 1], expected, 0.5f, Color::BLEND_MULTIPLY);
+			ASSERT(is_close(expected.get_r(), b[y][x].get_r()))
+			ASSERT(is_close(expected.get_g(), b[y][x].get_g()))
+			ASSERT(is_close(expected.get_b(), b[y][x].get_b()))
+			ASSERT(is_close(expected.get_a(), b[y][x].get_a()))
+		}
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_blend_row_matches_blend_for_all_methods)
+	TEST_FUNCTION(test_blend_row_handles_any_row_length)
+	TEST_FUNCTION(test_blend_row_ignores_empty_row)
+	TEST_FUNCTION(test_surface_blit_with_alpha_pen_uses_blend_method)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,248 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file loadcanvas.cpp
+**	\brief Test that streaming and DOM loading of .sif files give the same result
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <glibmm/miscutils.h>
+
+#include <synfig/filesystemnative.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/main.h>
+#include <synfig/savecanvas.h>
+#include <synfig/zstreambuf.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+static const char canvas_begin[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<canvas version=\"1.2\" width=\"480\" height=\"270\" xres=\"2834.645669\" yres=\"2834.645669\""
+	" view-box=\"-4 2.25 4 -2.25\" antialias=\"1\" fps=\"24\" begin-time=\"0f\" end-time=\"5s\" bgcolor=\"0.5 0.5 0.5 1\">\n"
+	"  <name>test</name>\n"
+	"  <defs>\n"
+	"    <real id=\"amount\" value=\"0.5\"/>\n"
+	"  </defs>\n"
+	"  <keyframe time=\"1s\" active=\"true\">key</keyframe>\n";
+
+static const char layers[] =
+	"  <layer type=\"SolidColor\" active=\"true\" version=\"0.1\" desc=\"background\">\n"
+	"    <param name=\"amount\" use=\"amount\"/>\n"
+	"    <param name=\"color\"><color><r>1</r><g>0.5</g><b>0.25</b><a>1</a></color></param>\n"
+	"  </layer>\n"
+	"  <layer type=\"group\" active=\"true\" version=\"0.1\" desc=\"group\">\n"
+	"    <param name=\"canvas\">\n"
+	"      <canvas>\n"
+	"        <layer type=\"SolidColor\" active=\"false\" version=\"0.1\" desc=\"inner\">\n"
+	"          <param name=\"amount\"><real value=\"0.25\"/></param>\n"
+	"        </layer>\n"
+	"      </canvas>\n"
+	"    </param>\n"
+	"  </layer>\n";
+
+static const char canvas_end[] =
+	"</canvas>\n";
+
+struct LoadResult
+{
+	bool loaded;
+	String text;
+	String errors;
+	String warnings;
+};
+
+static String
+fixture_name(const String &name, bool compressed)
+	{ return "test_loadcanvas_" + name + (compressed ? ".sifz" : ".sif"); }
+
+static void
+write_fixture(const String &filename, const String &data, bool compressed)
+{
+	FileSystem::WriteStream::Handle stream = FileSystemNative::instance()->get_write_stream(filename);
+	ASSERT(stream)
+	if (compressed)
+		stream = FileSystem::WriteStream::Handle(new ZWriteStream(stream));
+	ASSERT(stream->write_whole_block(data.data(), data.size()))
+}
+
+static LoadResult
+load(const String &filename, bool streaming, bool allow_errors)
+{
+	Glib::setenv("SYNFIG_STREAM_LOADING", streaming ? "1" : "0", true);
+
+	LoadResult result;
+	const FileSystem::Identifier identifier = FileSystemNative::instance()->get_identifier(filename);
+	Canvas::Handle canvas;
+	if (allow_errors) {
+		canvas = open_canvas_as(identifier, filename, result.errors, result.warnings);
+	} else {
+		CanvasParser parser;
+		canvas = parser.parse_from_file_as(identifier, filename, result.errors);
+		result.warnings = parser.get_warnings_text();
+	}
+	result.loaded = (bool)canvas;
+	if (canvas)
+		result.text = canvas_to_string(canvas);
+
+	Glib::unsetenv("SYNFIG_STREAM_LOADING");
+	return result;
+}
+
+//! Loads the same fixture by both parsers and compares canvas, errors and warnings
+static LoadResult
+check_fixture(const String &name, const String &data, bool allow_errors)
+{
+	LoadResult expected;
+	for(int compressed = 0; compressed < 2; ++compressed) {
+		const String filename = fixture_name(name, compressed);
+		write_fixture(filename, data, compressed);
+
+		const LoadResult dom = load(filename, false, allow_errors);
+		const LoadResult stream = load(filename, true, allow_errors);
+		FileSystemNative::instance()->file_remove(filename);
+
+		ASSERT_EQUAL(dom.loaded, stream.loaded)
+		ASSERT_EQUAL(dom.text, stream.text)
+		ASSERT_EQUAL(dom.errors, stream.errors)
+		ASSERT_EQUAL(dom.warnings, stream.warnings)
+		if (!compressed)
+			expected = dom;
+	}
+	return expected;
+}
+
+void test_valid_file() {
+	const LoadResult result = check_fixture("valid", String(canvas_begin) + layers + canvas_end, true);
+	ASSERT(result.loaded)
+	ASSERT(result.errors.empty())
+	ASSERT(result.warnings.empty())
+	ASSERT(result.text.find("desc=\"inner\"") != String::npos)
+	ASSERT(result.text.find("use=\"amount\"") != String::npos)
+}
+
+void test_file_with_warnings() {
+	const String data = String(canvas_begin)
+		+ "  <meta content=\"no name\"/>\n"
+		+ layers
+		+ "  <layer type=\"SolidColor\" version=\"99.0\" desc=\"newer\"/>\n"
+		+ canvas_end;
+	const LoadResult result = check_fixture("warnings", data, true);
+	ASSERT(result.loaded)
+	ASSERT(result.errors.empty())
+	ASSERT(result.warnings.find("<meta> must have a name") != String::npos)
+	ASSERT(result.warnings.find("layer version") != String::npos)
+}
+
+void test_semantically_broken_file() {
+	const String data = String(canvas_begin)
+		+ "  <layer desc=\"no type\"/>\n"
+		+ layers
+		+ "  <layer type=\"SolidColor\" desc=\"undefined\"><param name=\"amount\" use=\"undefined\"/></layer>\n"
+		+ canvas_end;
+	const LoadResult result = check_fixture("broken", data, true);
+	ASSERT_FALSE(result.loaded)
+	ASSERT(result.errors.find("Missing \"type\" attribute") != String::npos)
+	ASSERT(result.errors.find("undefined") != String::npos)
+
+	const LoadResult strict = check_fixture("broken_strict", data, false);
+	ASSERT_FALSE(strict.loaded)
+	ASSERT(strict.errors.find("Missing \"type\" attribute") != String::npos)
+}
+
+void test_nested_canvases() {
+	// layers of exported and inline canvases are parsed while the file is read
+	const String data = String(canvas_begin)
+		+ "  <defs>\n"
+		+ "    <canvas id=\"exported\">\n"
+		+ "      <layer type=\"SolidColor\" desc=\"exported_layer\"/>\n"
+		+ "    </canvas>\n"
+		+ "  </defs>\n"
+		+ layers
+		+ "  <layer type=\"group\" desc=\"outer\">\n"
+		+ "    <param name=\"amount\"><real value=\"0.75\"/></param>\n"
+		+ "    <param name=\"canvas\">\n"
+		+ "      <!-- comment -->\n"
+		+ "      <canvas>\n"
+		+ "        <layer type=\"group\" desc=\"middle\">\n"
+		+ "          <param name=\"canvas\"><canvas><layer type=\"SolidColor\" desc=\"deep\"/></canvas></param>\n"
+		+ "        </layer>\n"
+		+ "      </canvas>\n"
+		+ "      <real value=\"1\"/>\n"
+		+ "    </param>\n"
+		+ "    <param name=\"z_depth\"><real value=\"0.5\"/></param>\n"
+		+ "  </layer>\n"
+		+ canvas_end;
+	const LoadResult result = check_fixture("nested", data, true);
+	ASSERT(result.loaded)
+	ASSERT(result.errors.empty())
+	ASSERT(result.warnings.find("Unexpected element <real> after <param> data") != String::npos)
+	ASSERT(result.text.find("desc=\"exported_layer\"") != String::npos)
+	ASSERT(result.text.find("desc=\"deep\"") != String::npos)
+
+	const String empty = String(canvas_begin)
+		+ "  <layer type=\"group\" desc=\"empty\"><param name=\"canvas\"> </param></layer>\n"
+		+ canvas_end;
+	const LoadResult empty_result = check_fixture("nested_empty", empty, true);
+	ASSERT_FALSE(empty_result.loaded)
+	ASSERT(empty_result.errors.find("missing its contents") != String::npos)
+}
+
+void test_malformed_file() {
+	// semantic error goes before xml error, but xml error is reported
+	const String data = String(canvas_begin)
+		+ "  <layer desc=\"no type\"/>\n"
+		+ layers
+		+ "  <layer type=\"SolidColor\">\n"
+		+ canvas_end;
+	const LoadResult result = check_fixture("malformed", data, true);
+	ASSERT_FALSE(result.loaded)
+	ASSERT_FALSE(result.errors.empty())
+	ASSERT(result.errors.find("Missing \"type\" attribute") == String::npos)
+
+	const LoadResult strict = check_fixture("malformed_strict", data, false);
+	ASSERT_FALSE(strict.loaded)
+	ASSERT_EQUAL(result.errors, strict.errors)
+}
+
+int main() {
+	// only core layers are used, installed modules are not needed
+	const char modules_list[] = "test_loadcanvas_modules.cfg";
+	std::ofstream(modules_list).close();
+	Glib::setenv("SYNFIG_MODULE_LIST", modules_list, true);
+	Main main(".");
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_valid_file)
+		TEST_FUNCTION(test_file_with_warnings)
+		TEST_FUNCTION(test_semantically_broken_file)
+		TEST_FUNCTION(test_nested_canvases)
+		TEST_FUNCTION(test_malformed_file)
+	TEST_SUITE_END()
+
+	std::remove(modules_list);
+
+	return tst_exit_status;
+}
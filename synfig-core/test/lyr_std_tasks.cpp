@@ -0,0 +1,276 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file lyr_std_tasks.cpp
+**	\brief Test that rendering tasks of lyr_std layers match their legacy rendering
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <glibmm/miscutils.h>
+
+#include <synfig/blinepoint.h>
+#include <synfig/canvas.h>
+#include <synfig/context.h>
+#include <synfig/main.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/rendering/common/task/tasklayer.h>
+#include <synfig/rendering/software/surfacesw.h>
+
+#include <modules/lyr_std/booleancurve.h>
+#include <modules/lyr_std/insideout.h>
+#include <modules/lyr_std/julia.h>
+#include <modules/lyr_std/mandelbrot.h>
+#include <modules/lyr_std/sphere_distort.h>
+#include <modules/lyr_std/xorpattern.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace modules::lyr_std;
+
+static const int size = 32;
+static const Color background(0.5f, 0.5f, 0.5f, 1.f);
+
+static Layer::Handle
+create_polygon(const std::vector<Point> &points, const Color &color)
+{
+	ValueBase::List list;
+	for(std::vector<Point>::const_iterator i = points.begin(); i != points.end(); ++i)
+		list.push_back(ValueBase(*i));
+	Layer::Handle layer = Layer::create("polygon");
+	layer->set_param("vector_list", ValueBase(list));
+	layer->set_param("color", ValueBase(color));
+	return layer;
+}
+
+//! Opaque canvas, with shapes to be distorted if \a detailed
+static Canvas::Handle
+create_canvas(bool detailed)
+{
+	Canvas::Handle canvas = Canvas::create();
+	canvas->rend_desc().set_w(size);
+	canvas->rend_desc().set_h(size);
+	canvas->rend_desc().set_tl(Point(-2.0, -2.0));
+	canvas->rend_desc().set_br(Point(2.0, 2.0));
+
+	Layer::Handle solid = Layer::create("SolidColor");
+	solid->set_param("color", ValueBase(background));
+	canvas->push_back(solid);
+
+	if (detailed) {
+		canvas->push_front(create_polygon(
+			{ Point(-1.5, -1.5), Point(1.5, -1.0), Point(0.0, 1.5) },
+			Color(1.f, 0.f, 0.f, 1.f) ));
+		// inverted by inside out into the neighbourhood of its origin
+		canvas->push_front(create_polygon(
+			{ Point(2.2, -0.6), Point(3.6, -0.6), Point(3.6, 0.6), Point(2.2, 0.6) },
+			Color(0.f, 0.f, 1.f, 1.f) ));
+	}
+	return canvas;
+}
+
+static std::vector<Color>
+render(const rendering::Task::Handle &task, const RendDesc &rend_desc)
+{
+	rendering::SurfaceResource::Handle surface = new rendering::SurfaceResource();
+	surface->create(rend_desc.get_w(), rend_desc.get_h());
+	task->target_surface = surface;
+	task->target_rect = RectInt(VectorInt(), surface->get_size());
+	task->source_rect = Rect(rend_desc.get_tl(), rend_desc.get_br());
+	ASSERT(rendering::Renderer::get_renderer("software")->run(task))
+
+	rendering::SurfaceResource::LockRead<rendering::SurfaceSW> lock(surface);
+	ASSERT(lock)
+	const synfig::Surface &pixels = lock->get_surface();
+	return std::vector<Color>(pixels[0], pixels[0] + pixels.get_w()*pixels.get_h());
+}
+
+static float
+difference(const Color &a, const Color &b)
+{
+	return std::max(
+		std::max(std::fabs(a.get_r() - b.get_r()), std::fabs(a.get_g() - b.get_g())),
+		std::max(std::fabs(a.get_b() - b.get_b()), std::fabs(a.get_a() - b.get_a())) );
+}
+
+//! Images must be equal except of at most \a max_edge_pixels pixels
+//! at the edges of shapes
+static void
+compare(const std::vector<Color> &expected, const std::vector<Color> &pixels, size_t max_edge_pixels)
+{
+	ASSERT_EQUAL(expected.size(), pixels.size())
+
+	// reference is not trivial
+	size_t uniform = 0;
+	for(size_t i = 0; i < expected.size(); ++i)
+		if (difference(expected[i], expected[0]) < 1e-3f)
+			++uniform;
+	ASSERT(uniform < expected.size())
+
+	size_t different = 0;
+	float sum = 0.f;
+	for(size_t i = 0; i < expected.size(); ++i) {
+		const float d = difference(expected[i], pixels[i]);
+		sum += d;
+		if (d > 1e-3f)
+			++different;
+	}
+	ASSERT(different <= max_edge_pixels)
+	ASSERT(sum/expected.size() < 0.01f)
+}
+
+//! Samples which fall exactly on the boundary of the context area
+//! may be rounded to the other side of it
+static const size_t boundary_pixels = 4;
+
+//! Renders \a layer placed over \a canvas by its own task and by the legacy TaskLayer
+static void
+render_layer(
+	const Layer::Handle &layer,
+	const Canvas::Handle &canvas,
+	std::vector<Color> &expected,
+	std::vector<Color> &pixels )
+{
+	canvas->push_front(layer);
+	const Context context = canvas->get_context(ContextParams());
+
+	rendering::Task::Handle task = context.build_rendering_task();
+	ASSERT(task)
+	ASSERT_FALSE(task.type_is<rendering::TaskLayer>())
+
+	rendering::TaskLayer::Handle legacy(new rendering::TaskLayer());
+	legacy->layer = layer;
+	legacy->sub_task() = context.get_next().build_rendering_task();
+
+	expected = render(legacy, canvas->rend_desc());
+	pixels = render(task, canvas->rend_desc());
+}
+
+static void
+check_layer(const Layer::Handle &layer, const Canvas::Handle &canvas, size_t max_edge_pixels = boundary_pixels)
+{
+	std::vector<Color> expected, pixels;
+	render_layer(layer, canvas, expected, pixels);
+	compare(expected, pixels, max_edge_pixels);
+}
+
+void test_inside_out() {
+	// origin is at the corner of the pixel (16, 16), so it is sampled itself
+	Layer::Handle layer(new InsideOut());
+	layer->set_param("origin", ValueBase(Point(0.0, 0.0)));
+
+	std::vector<Color> expected, pixels;
+	render_layer(layer, create_canvas(true), expected, pixels);
+	compare(expected, pixels, boundary_pixels);
+
+	// origin itself and its neighbourhood are mapped out of the context area
+	// of the legacy layer (-5, -5)-(5, 5), and must be transparent
+	for(int y = 15; y <= 17; ++y) {
+		for(int x = 15; x <= 17; ++x) {
+			const size_t i = y*size + x;
+			ASSERT(expected[i].get_a() < 1e-6f)
+			ASSERT(pixels[i].get_a() < 1e-6f)
+		}
+	}
+}
+
+void test_sphere_distort() {
+	Layer::Handle layer(new Layer_SphereDistort());
+	layer->set_param("center", ValueBase(Point(0.25, -0.25)));
+	layer->set_param("radius", ValueBase(Real(1.25)));
+	// context is sampled by the cubic filter of TaskDistortSW,
+	// the legacy layer samples it linearly
+	check_layer(layer, create_canvas(true), size*size/8);
+}
+
+void test_xor_pattern() {
+	Layer::Handle layer(new XORPattern());
+	layer->set_param("amount", ValueBase(Real(0.75)));
+	check_layer(layer, create_canvas(true));
+}
+
+void test_julia() {
+	Layer::Handle layer(new Julia());
+	layer->set_param("seed", ValueBase(Point(-0.4, 0.6)));
+	layer->set_param("ocolor", ValueBase(Color(1.f, 1.f, 0.f, 1.f)));
+	layer->set_param("color_outside", ValueBase(true));
+	check_layer(layer, create_canvas(true));
+}
+
+void test_mandelbrot() {
+	Layer::Handle layer(new Mandelbrot());
+	check_layer(layer, create_canvas(true));
+}
+
+void test_boolean_curve() {
+	// regions of straight segments are the same as polygons,
+	// boolean curve had no rendering before,
+	// its regions are built of curves, so edges may be rasterized a bit differently
+	const std::vector<Point> triangle = { Point(-1.5, -1.5), Point(-0.2, -1.4), Point(-1.0, 1.2) };
+	const std::vector<Point> square = { Point(0.3, -0.7), Point(1.6, -0.7), Point(1.6, 0.9), Point(0.3, 0.9) };
+	const Color color(0.f, 0.5f, 0.f, 1.f);
+
+	ValueBase::List regions;
+	for(const std::vector<Point> *region : { &triangle, &square }) {
+		std::vector<BLinePoint> points(region->size());
+		for(size_t i = 0; i < region->size(); ++i)
+			points[i].set_vertex((*region)[i]);
+		regions.push_back(ValueBase(points));
+	}
+	Layer::Handle layer(new BooleanCurve());
+	ASSERT(layer->set_param("regions", ValueBase(regions)))
+	layer->set_param("color", ValueBase(color));
+
+	Canvas::Handle canvas = create_canvas(false);
+	canvas->push_front(layer);
+	rendering::Task::Handle task = canvas->get_context(ContextParams()).build_rendering_task();
+
+	Canvas::Handle expected_canvas = create_canvas(false);
+	expected_canvas->push_front(create_polygon(triangle, color));
+	expected_canvas->push_front(create_polygon(square, color));
+	rendering::Task::Handle expected_task = expected_canvas->get_context(ContextParams()).build_rendering_task();
+
+	compare(render(expected_task, canvas->rend_desc()), render(task, canvas->rend_desc()), size*size/8);
+}
+
+int main() {
+	// layers are linked into the test, installed modules must not be loaded
+	const char modules_list[] = "test_lyr_std_tasks_modules.cfg";
+	std::ofstream(modules_list).close();
+	Glib::setenv("SYNFIG_MODULE_LIST", modules_list, true);
+	Main main(".");
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_inside_out)
+		TEST_FUNCTION(test_sphere_distort)
+		TEST_FUNCTION(test_xor_pattern)
+		TEST_FUNCTION(test_julia)
+		TEST_FUNCTION(test_mandelbrot)
+		TEST_FUNCTION(test_boolean_curve)
+	TEST_SUITE_END()
+
+	std::remove(modules_list);
+
+	return tst_exit_status;
+}
@@ -0,0 +1,181 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file mesh.cpp
+**	\brief Test lookup of triangles in rendering::Mesh
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <random>
+#include <vector>
+
+#include <synfig/rendering/primitive/mesh.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace rendering;
+
+//! Lookup by the reverse scan of all triangles, as it was done before the index
+static bool
+find_by_scan(const Mesh &mesh, bool by_tex_coords, const Vector &src, Vector &dest)
+{
+	for(int i = (int)mesh.triangles.size() - 1; i >= 0; --i) {
+		const Mesh::Triangle &t = mesh.triangles[i];
+		const Mesh::Vertex &v0 = mesh.vertices[t.vertices[0]];
+		const Mesh::Vertex &v1 = mesh.vertices[t.vertices[1]];
+		const Mesh::Vertex &v2 = mesh.vertices[t.vertices[2]];
+		if (by_tex_coords
+		  ? Mesh::transform_coord_texture_to_world(src, dest, v0.position, v0.tex_coords, v1.position, v1.tex_coords, v2.position, v2.tex_coords)
+		  : Mesh::transform_coord_world_to_texture(src, dest, v0.position, v0.tex_coords, v1.position, v1.tex_coords, v2.position, v2.tex_coords) )
+			return true;
+	}
+	return false;
+}
+
+//! Points of the regular grid over \a bounds, and the vertices and middles of edges of triangles
+static std::vector<Vector>
+sample_points(const Mesh &mesh, bool by_tex_coords, const Rect &bounds)
+{
+	const Vector Mesh::Vertex::*coord = by_tex_coords ? &Mesh::Vertex::tex_coords : &Mesh::Vertex::position;
+	std::vector<Vector> points;
+	const int count = 100;
+	for(int j = 0; j <= count; ++j)
+		for(int i = 0; i <= count; ++i)
+			points.push_back(Vector(
+				bounds.minx + bounds.get_width()*i/count,
+				bounds.miny + bounds.get_height()*j/count ));
+	for(Mesh::TriangleList::const_iterator t = mesh.triangles.begin(); t != mesh.triangles.end(); ++t) {
+		for(int k = 0; k < 3; ++k) {
+			const Vector &a = mesh.vertices[t->vertices[k]].*coord;
+			const Vector &b = mesh.vertices[t->vertices[(k + 1)%3]].*coord;
+			points.push_back(a);
+			points.push_back((a + b)*0.5);
+		}
+	}
+	return points;
+}
+
+static void
+check_lookup(const Mesh &mesh, const Rect &bounds)
+{
+	for(int by_tex_coords = 0; by_tex_coords < 2; ++by_tex_coords) {
+		const std::vector<Vector> points = sample_points(mesh, by_tex_coords, bounds);
+		for(std::vector<Vector>::const_iterator p = points.begin(); p != points.end(); ++p) {
+			Vector expected, dest;
+			const bool expected_found = find_by_scan(mesh, by_tex_coords, *p, expected);
+			const bool found = by_tex_coords
+			                 ? mesh.transform_coord_texture_to_world(*p, dest)
+			                 : mesh.transform_coord_world_to_texture(*p, dest);
+			ASSERT_EQUAL(expected_found, found)
+			if (found) {
+				// the same triangle must be chosen, so the results are exactly equal
+				ASSERT_EQUAL(expected[0], dest[0])
+				ASSERT_EQUAL(expected[1], dest[1])
+			}
+		}
+	}
+}
+
+//! Overlapping triangles, each one maps its area to the other place of texture
+static void
+add_random_triangles(Mesh &mesh, int count, std::mt19937 &generator)
+{
+	std::uniform_real_distribution<Real> coord(-10.0, 10.0);
+	std::uniform_real_distribution<Real> size(0.5, 6.0);
+	for(int i = 0; i < count; ++i) {
+		const int first = (int)mesh.vertices.size();
+		const Vector origin(coord(generator), coord(generator));
+		const Vector offset(coord(generator), coord(generator));
+		for(int k = 0; k < 3; ++k) {
+			const Vector p = origin + Vector(size(generator), size(generator))*(k == 0 ? 0.0 : 1.0)
+			                        - Vector(0.0, k == 2 ? 2.0*size(generator) : 0.0);
+			mesh.vertices.push_back(Mesh::Vertex(p, p*0.5 + offset));
+		}
+		mesh.triangles.push_back(Mesh::Triangle(first, first + 1, first + 2));
+	}
+}
+
+void test_index_matches_linear_scan() {
+	std::mt19937 generator(42);
+	Mesh mesh;
+	add_random_triangles(mesh, 300, generator);
+	check_lookup(mesh, Rect(-20.0, -20.0, 20.0, 20.0));
+}
+
+void test_last_triangle_wins() {
+	// two triangles at the same place, with different texture coords
+	Mesh mesh;
+	mesh.vertices.push_back(Mesh::Vertex(Vector(0.0, 0.0), Vector(0.0, 0.0)));
+	mesh.vertices.push_back(Mesh::Vertex(Vector(1.0, 0.0), Vector(1.0, 0.0)));
+	mesh.vertices.push_back(Mesh::Vertex(Vector(0.0, 1.0), Vector(0.0, 1.0)));
+	mesh.vertices.push_back(Mesh::Vertex(Vector(0.0, 0.0), Vector(5.0, 5.0)));
+	mesh.vertices.push_back(Mesh::Vertex(Vector(1.0, 0.0), Vector(7.0, 5.0)));
+	mesh.vertices.push_back(Mesh::Vertex(Vector(0.0, 1.0), Vector(5.0, 7.0)));
+	mesh.triangles.push_back(Mesh::Triangle(0, 1, 2));
+	mesh.triangles.push_back(Mesh::Triangle(3, 4, 5));
+
+	Vector dest;
+	ASSERT(mesh.transform_coord_world_to_texture(Vector(0.25, 0.25), dest))
+	ASSERT_VECTOR_APPROX_EQUAL_MICRO(Vector(5.5, 5.5), dest)
+	ASSERT_FALSE(mesh.transform_coord_world_to_texture(Vector(0.75, 0.75), dest))
+
+	// order of triangles is changed, so index must be rebuilt
+	std::swap(mesh.triangles[0], mesh.triangles[1]);
+	mesh.reset_coord_index();
+	ASSERT(mesh.transform_coord_world_to_texture(Vector(0.25, 0.25), dest))
+	ASSERT_VECTOR_APPROX_EQUAL_MICRO(Vector(0.25, 0.25), dest)
+}
+
+void test_reset_coord_index() {
+	std::mt19937 generator(7);
+	Mesh mesh;
+	add_random_triangles(mesh, 100, generator);
+	check_lookup(mesh, Rect(-20.0, -20.0, 20.0, 20.0));
+
+	// move the mesh and add more triangles to it
+	for(Mesh::VertexList::iterator i = mesh.vertices.begin(); i != mesh.vertices.end(); ++i) {
+		i->position += Vector(15.0, -5.0);
+		i->tex_coords *= 2.0;
+	}
+	add_random_triangles(mesh, 100, generator);
+	mesh.reset_coord_index();
+	check_lookup(mesh, Rect(-30.0, -30.0, 30.0, 30.0));
+
+	// assign() and clear() reset the index too
+	Mesh other;
+	add_random_triangles(other, 50, generator);
+	mesh.assign(other);
+	check_lookup(mesh, Rect(-20.0, -20.0, 20.0, 20.0));
+
+	mesh.clear();
+	Vector dest;
+	ASSERT_FALSE(mesh.transform_coord_world_to_texture(Vector(), dest))
+	ASSERT_FALSE(mesh.transform_coord_texture_to_world(Vector(), dest))
+}
+
+int main() {
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_index_matches_linear_scan)
+		TEST_FUNCTION(test_last_triangle_wins)
+		TEST_FUNCTION(test_reset_coord_index)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,116 @@
+/* === S Y N F I G ========================================================= */
+/*! \file optimizer_split.cpp
+**  \brief Test splitting of rendering tasks to parts for threads
+**
+** Copyright (c) 2024 Synfig contributors
+**
+** This file is part of Synfig.
+**
+** Synfig is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** Synfig is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**
+** ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <algorithm>
+#include <vector>
+
+#include <synfig/rendering/common/optimizer/optimizersplit.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace rendering;
+
+/* === C L A S S E S ======================================================= */
+
+//! Checks that parts do not intersect and cover whole \a rect
+static void
+check_parts(const RectInt &rect, const std::vector<RectInt> &parts)
+{
+	const int w = rect.maxx - rect.minx;
+	const int h = rect.maxy - rect.miny;
+	std::vector<int> covered(w*h, 0);
+	for(const RectInt &r : parts) {
+		ASSERT(r.is_valid())
+		ASSERT(rect.contains(r))
+		ASSERT(r.maxx - r.minx >= std::min(w, (int)OptimizerSplit::min_part_size))
+		ASSERT(r.maxy - r.miny >= std::min(h, (int)OptimizerSplit::min_part_size))
+		for(int y = r.miny; y < r.maxy; ++y)
+			for(int x = r.minx; x < r.maxx; ++x)
+				++covered[(y - rect.miny)*w + x - rect.minx];
+	}
+	for(int c : covered)
+		ASSERT_EQUAL(1, c)
+}
+
+void test_split_covers_whole_rect()
+{
+	const RectInt rects[] = {
+		RectInt(0, 0, 1920, 1080),
+		RectInt(-100, 37, 901, 1000),
+		RectInt(5, 5, 4000, 300),
+		RectInt(0, 0, 300, 4000) };
+	const int threads[] = { 2, 3, 8, 64 };
+	for(const RectInt &rect : rects)
+		for(int t : threads)
+			check_parts(rect, OptimizerSplit::split_rect(rect, 1.0, t));
+}
+
+void test_small_task_is_not_split()
+{
+	ASSERT(OptimizerSplit::split_rect(RectInt(0, 0, 64, 64), 1.0, 8).empty())
+	ASSERT(OptimizerSplit::split_rect(RectInt(0, 0, 128, 128), 1.0, 64).empty())
+	ASSERT(OptimizerSplit::split_rect(RectInt(0, 0, 100, 100), 1.0, 8).empty())
+	// but expensive one is split
+	ASSERT_FALSE(OptimizerSplit::split_rect(RectInt(0, 0, 128, 128), 16.0, 8).empty())
+}
+
+void test_single_thread_does_not_split()
+{
+	ASSERT(OptimizerSplit::split_rect(RectInt(0, 0, 4000, 4000), 100.0, 1).empty())
+	ASSERT(OptimizerSplit::split_rect(RectInt(0, 0, 4000, 4000), 100.0, 0).empty())
+	ASSERT(OptimizerSplit::split_rect(RectInt(0, 0, 4000, 4000), 0.0, 8).empty())
+}
+
+void test_count_of_parts_depends_on_threads()
+{
+	const RectInt rect(0, 0, 1920, 1080);
+	size_t prev = 0;
+	for(int t = 2; t <= 64; t *= 2) {
+		const size_t count = OptimizerSplit::split_rect(rect, 4.0, t).size();
+		ASSERT(count >= (size_t)t)
+		ASSERT(count >= prev)
+		prev = count;
+	}
+	// parts of the wide task fit into the cache
+	for(const RectInt &r : OptimizerSplit::split_rect(RectInt(0, 0, 16000, 64), 4.0, 4))
+		ASSERT((r.maxx - r.minx)*(r.maxy - r.miny)*(int)sizeof(Color) <= OptimizerSplit::cache_size)
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_split_covers_whole_rect)
+	TEST_FUNCTION(test_small_task_is_not_split)
+	TEST_FUNCTION(test_single_thread_does_not_split)
+	TEST_FUNCTION(test_count_of_parts_depends_on_threads)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
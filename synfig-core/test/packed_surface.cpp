@@ -0,0 +1,156 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file packed_surface.cpp
+**	\brief Test lossy formats of software::PackedSurface
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <synfig/rendering/software/function/packedsurface.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace rendering;
+using namespace software;
+
+static float
+channel(const Color &color, int index)
+{
+	switch(index) {
+	case 0: return color.get_r();
+	case 1: return color.get_g();
+	case 2: return color.get_b();
+	}
+	return color.get_a();
+}
+
+static std::vector<Color>
+make_pixels(int width, int height)
+{
+	std::vector<Color> pixels;
+	for(int y = 0; y < height; ++y)
+		for(int x = 0; x < width; ++x)
+			pixels.push_back(Color(
+				x/(float)width,
+				1.5f - y/(float)height,
+				(x*y % 7)/6.f,
+				(x + y) % 3 ? 1.f : 0.25f ));
+	return pixels;
+}
+
+void test_half_conversion() {
+	ASSERT_EQUAL(0x0000, (int)PackedSurface::float_to_half(0.f))
+	ASSERT_EQUAL(0x3c00, (int)PackedSurface::float_to_half(1.f))
+	ASSERT_EQUAL(0xc000, (int)PackedSurface::float_to_half(-2.f))
+	ASSERT_EQUAL(0x7bff, (int)PackedSurface::float_to_half(65504.f))
+	ASSERT_EQUAL(0x7c00, (int)PackedSurface::float_to_half(1e6f))
+	ASSERT_EQUAL(0x0001, (int)PackedSurface::float_to_half(5.9604645e-8f))
+	// ties are rounded to even
+	ASSERT_EQUAL(0x3c00, (int)PackedSurface::float_to_half(1.f + 1.f/2048.f))
+	ASSERT_EQUAL(0x3c02, (int)PackedSurface::float_to_half(1.f + 3.f/2048.f))
+	ASSERT(std::isnan(PackedSurface::half_to_float(PackedSurface::float_to_half(std::numeric_limits<float>::quiet_NaN()))))
+
+	// all finite half values are converted exactly
+	for(int i = 0; i < 0x10000; ++i) {
+		if ((i & 0x7c00) == 0x7c00) continue;
+		const float f = PackedSurface::half_to_float((unsigned short)i);
+		ASSERT_EQUAL(i, (int)PackedSurface::float_to_half(f))
+	}
+}
+
+void test_half_surface() {
+	const int width = 37, height = 23;
+	const std::vector<Color> pixels = make_pixels(width, height);
+
+	PackedSurface surface;
+	surface.set_pixels_lossy(&pixels.front(), width, height, PackedSurface::ChannelFloat16);
+	ASSERT(surface.get_channel_type() == PackedSurface::ChannelFloat16)
+	ASSERT_EQUAL(pixels.size()*8, surface.get_data_size())
+
+	std::vector<Color> result(pixels.size());
+	surface.get_pixels(&result.front());
+	for(size_t i = 0; i < pixels.size(); ++i)
+		for(int c = 0; c < 4; ++c)
+			ASSERT(std::fabs(channel(pixels[i], c) - channel(result[i], c)) <= 1e-3f)
+
+	PackedSurface::Reader reader(surface);
+	ASSERT(result[5*width + 7] == reader.get_pixel(7, 5))
+}
+
+void test_premulted_byte_surface() {
+	const int width = 37, height = 23;
+	const std::vector<Color> pixels = make_pixels(width, height);
+
+	PackedSurface surface;
+	surface.set_pixels_lossy(&pixels.front(), width, height, PackedSurface::ChannelUInt8Premulted);
+	ASSERT_EQUAL(pixels.size()*4, surface.get_data_size())
+
+	std::vector<Color> result(pixels.size());
+	surface.get_pixels(&result.front());
+	for(size_t i = 0; i < pixels.size(); ++i) {
+		const Color &p = pixels[i];
+		const Color &r = result[i];
+		ASSERT(std::fabs(p.get_a() - r.get_a()) <= 0.5f/255.f + 1e-6f)
+		// premultiplied values are clamped to 0..1 and have precision of 8 bits
+		for(int c = 0; c < 3; ++c)
+			ASSERT(std::fabs(std::min(1.f, channel(p, c)*p.get_a()) - channel(r, c)*r.get_a()) <= 1.f/255.f)
+	}
+}
+
+void test_premulted_bytes_written_directly() {
+	const int width = 5, height = 3;
+	PackedSurface surface;
+	unsigned char *bytes = surface.create_premulted_bytes(width, height);
+	ASSERT(bytes)
+	ASSERT(surface.get_channel_type() == PackedSurface::ChannelUInt8Premulted)
+	ASSERT_EQUAL((size_t)width*height*4, surface.get_data_size())
+	for(int i = 0; i < width*height; ++i) {
+		bytes[i*4 + 0] = 255;
+		bytes[i*4 + 1] = (unsigned char)(i*10);
+		bytes[i*4 + 2] = 0;
+		bytes[i*4 + 3] = 255;
+	}
+	bytes[7*4 + 0] = 51;
+	bytes[7*4 + 3] = 102;
+
+	std::vector<Color> result(width*height);
+	surface.get_pixels(&result.front());
+	ASSERT(result[3] == Color(1.f, 30/255.f, 0.f, 1.f))
+	ASSERT(std::fabs(result[7].get_r() - 0.5f) < 1e-6f)
+	ASSERT(std::fabs(result[7].get_a() - 0.4f) < 1e-6f)
+
+	ASSERT(!surface.create_premulted_bytes(0, 10))
+	ASSERT_EQUAL((size_t)0, surface.get_data_size())
+}
+
+int main() {
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_half_conversion)
+		TEST_FUNCTION(test_half_surface)
+		TEST_FUNCTION(test_premulted_byte_surface)
+		TEST_FUNCTION(test_premulted_bytes_written_directly)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
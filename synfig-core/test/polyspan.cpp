@@ -0,0 +1,316 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file polyspan.cpp
+**	\brief Test building, sorting and rendering of polyspans
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include <synfig/surface.h>
+#include <synfig/threadpool.h>
+#include <synfig/rendering/primitive/contour.h>
+#include <synfig/rendering/primitive/polyspan.h>
+#include <synfig/rendering/software/function/contour.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace rendering;
+
+static const int size = 512;
+
+//! Pseudo-random coordinate, slightly out of the window sometimes
+static Real
+rnd()
+{
+	static unsigned int seed = 12345;
+	seed = seed*1103515245u + 12345u;
+	return (seed >> 8)%100000*(size + 64)/100000.0 - 32;
+}
+
+//! Draws many random self-intersecting curves to get a lot of marks
+static void
+build(Polyspan &polyspan, int segments)
+{
+	polyspan.init(0, 0, size, size);
+	polyspan.move_to(rnd(), rnd());
+	for(int i = 0; i < segments; ++i) {
+		if (i % 97 == 96)
+			polyspan.move_to(rnd(), rnd());
+		else
+		if (i % 3)
+			polyspan.line_to(rnd(), rnd());
+		else
+			polyspan.cubic_to(rnd(), rnd(), rnd(), rnd(), rnd(), rnd(), 0.25);
+	}
+	polyspan.close();
+}
+
+static void
+check_equal(const Polyspan::cover_array &expected, const Polyspan::cover_array &covers)
+{
+	ASSERT_EQUAL(expected.size(), covers.size())
+	for(size_t i = 0; i < covers.size(); ++i) {
+		ASSERT_EQUAL(expected[i].y, covers[i].y)
+		ASSERT_EQUAL(expected[i].x, covers[i].x)
+		ASSERT_EQUAL(expected[i].cover, covers[i].cover)
+		ASSERT_EQUAL(expected[i].area, covers[i].area)
+	}
+}
+
+//! Compares marks sorted by polyspan with std::stable_sort of the same marks
+static void
+check_sort(int segments)
+{
+	Polyspan polyspan;
+	build(polyspan, segments);
+	// flush the current cell, so all marks are in list before sorting
+	polyspan.move_to(-10, -10);
+
+	Polyspan::cover_array expected = polyspan.get_covers();
+	std::stable_sort(expected.begin(), expected.end());
+	polyspan.sort_marks();
+	check_equal(expected, polyspan.get_covers());
+}
+
+static void
+render(
+	Surface &surface,
+	const Polyspan &polyspan,
+	bool invert,
+	bool antialias,
+	Contour::WindingStyle winding_style,
+	Color::value_type opacity,
+	int bands )
+{
+	surface.set_wh(size, size);
+	surface.fill(Color(0.25f, 0.5f, 0.75f, 0.5f));
+	software::Contour::render_polyspan(
+		surface, polyspan, invert, antialias, winding_style,
+		Color(1.f, 0.5f, 0.f, 1.f), opacity, Color::BLEND_COMPOSITE, bands );
+}
+
+void test_sort_few_marks() {
+	check_sort(3);
+}
+
+void test_sort_many_marks() {
+	check_sort(3000);
+	ASSERT(software::Contour::get_band_count(software::Contour::MIN_BAND_MARKS*4) > 1)
+}
+
+void test_sort_of_open_list() {
+	Polyspan polyspan;
+	build(polyspan, 300);
+	polyspan.encapsulate_current();
+	const size_t closed = polyspan.get_covers().size();
+	polyspan.move_to(10, 10);
+	polyspan.line_to(400, 300);
+	polyspan.line_to(100, 500);
+	polyspan.close();
+	polyspan.move_to(-10, -10);
+
+	Polyspan::cover_array expected = polyspan.get_covers();
+	std::stable_sort(expected.begin() + closed, expected.end());
+	polyspan.sort_marks();
+	check_equal(expected, polyspan.get_covers());
+}
+
+void test_bands_are_pixel_identical() {
+	Polyspan polyspan;
+	build(polyspan, 3000);
+	polyspan.sort_marks();
+	ASSERT(polyspan.get_covers().size() > 4*software::Contour::MIN_BAND_MARKS)
+
+	Surface expected, surface;
+	for(int flags = 0; flags < 16; ++flags) {
+		const bool invert = flags & 1;
+		const bool antialias = flags & 2;
+		const Contour::WindingStyle winding_style = flags & 4 ? Contour::WINDING_EVEN_ODD : Contour::WINDING_NON_ZERO;
+		const Color::value_type opacity = flags & 8 ? 0.7f : 1.f;
+
+		render(expected, polyspan, invert, antialias, winding_style, opacity, 1);
+		const int bands[] = { 0, 2, 7, 1000000 };
+		for(int b : bands) {
+			render(surface, polyspan, invert, antialias, winding_style, opacity, b);
+			for(int y = 0; y < size; ++y)
+				for(int x = 0; x < size; ++x)
+					ASSERT(expected[y][x] == surface[y][x])
+		}
+	}
+}
+
+void test_empty_polyspan() {
+	Polyspan polyspan;
+	polyspan.init(0, 0, size, size);
+	polyspan.sort_marks();
+
+	Surface surface;
+	render(surface, polyspan, true, true, Contour::WINDING_NON_ZERO, 1.f, 0);
+	ASSERT(surface[size/2][size/3] == Color(1.f, 0.5f, 0.f, 1.f))
+	render(surface, polyspan, false, true, Contour::WINDING_NON_ZERO, 1.f, 0);
+	ASSERT(surface[size/2][size/3] == Color(0.25f, 0.5f, 0.75f, 0.5f))
+}
+
+//! Circles made from cubic curves at the positions of grid
+static void
+build_contour(Contour &contour, Real radius)
+{
+	const Real k = 0.5522847498*radius;
+	contour.clear();
+	for(int i = 0; i < 4; ++i) {
+		const Vector c(1.0 + 2.0*(i % 2), 1.0 + 2.0*(i / 2));
+		contour.move_to(c + Vector(radius, 0));
+		contour.cubic_to(c + Vector(0, radius), c + Vector(radius, k), c + Vector(k, radius));
+		contour.cubic_to(c + Vector(-radius, 0), c + Vector(-k, radius), c + Vector(-radius, k));
+		contour.cubic_to(c + Vector(0, -radius), c + Vector(-radius, -k), c + Vector(-k, -radius));
+		contour.cubic_to(c + Vector(radius, 0), c + Vector(k, -radius), c + Vector(radius, -k));
+		contour.close();
+	}
+}
+
+static Matrix
+scale_translate(Real scale, Real dx, Real dy)
+{
+	Matrix matrix;
+	matrix.m00 = matrix.m11 = scale;
+	matrix.m20 = dx;
+	matrix.m21 = dy;
+	return matrix;
+}
+
+void test_flattened_contour_is_cached() {
+	Contour contour;
+	build_contour(contour, 0.75);
+	const Matrix matrix = scale_translate(100.0, 10.0, 20.0);
+	const Matrix moved = scale_translate(100.0, -50.0, 7.0);
+
+	Contour::Flattened::Handle flattened = contour.get_flattened(matrix, 0.25);
+	ASSERT(flattened)
+	ASSERT_EQUAL(contour.get_chunks().size(), flattened->entries.size())
+	ASSERT(flattened == contour.get_flattened(matrix, 0.25))
+	ASSERT(flattened != contour.get_flattened(moved, 0.25))
+	ASSERT(flattened != contour.get_flattened(matrix, 0.5))
+	ASSERT(flattened == contour.get_flattened(matrix, 0.25))
+
+	// copies share flattened chunks, also when contour is rebuilt with the same chunks
+	Contour copy;
+	copy.assign(contour);
+	build_contour(copy, 0.75);
+	ASSERT(flattened == copy.get_flattened(matrix, 0.25))
+
+	// only changed chunks are flattened again
+	Contour changed;
+	changed.assign(contour);
+	Contour::ChunkList chunks = contour.get_chunks();
+	chunks[2].pp0 += Vector(0.1, 0.2);
+	changed.clear();
+	changed.add_chunks(chunks);
+	Contour::Flattened::Handle changed_flattened = changed.get_flattened(matrix, 0.25);
+	ASSERT(flattened != changed_flattened)
+	for(int i = 0; i < (int)chunks.size(); ++i) {
+		const Contour::Flattened::Entry &a = flattened->entries[i];
+		const Contour::Flattened::Entry &b = changed_flattened->entries[i];
+		if (i == 2) continue;
+		ASSERT_EQUAL(a.end - a.begin, b.end - b.begin)
+		for(int j = 0; j < a.end - a.begin; ++j)
+			ASSERT(flattened->points[a.begin + j] == changed_flattened->points[b.begin + j])
+	}
+}
+
+//! Polyspan built from the cached flattened curves must be exactly the same as built from chunks
+static void
+check_flattened_polyspan(const Contour &contour, const Matrix &matrix, const RectInt &window)
+{
+	Polyspan expected_polyspan, polyspan;
+	expected_polyspan.init(window);
+	polyspan.init(window);
+	software::Contour::build_polyspan(contour.get_chunks(), matrix, expected_polyspan);
+	software::Contour::build_polyspan(contour, matrix, polyspan);
+	expected_polyspan.close();
+	polyspan.close();
+	expected_polyspan.sort_marks();
+	polyspan.sort_marks();
+
+	const Polyspan::cover_array &expected = expected_polyspan.get_covers();
+	const Polyspan::cover_array &covers = polyspan.get_covers();
+	ASSERT_EQUAL(expected.size(), covers.size())
+	for(int i = 0; i < (int)expected.size(); ++i) {
+		ASSERT_EQUAL(expected[i].x, covers[i].x)
+		ASSERT_EQUAL(expected[i].y, covers[i].y)
+		ASSERT_EQUAL(expected[i].cover, covers[i].cover)
+		ASSERT_EQUAL(expected[i].area, covers[i].area)
+	}
+
+	Surface expected_surface, surface;
+	render(expected_surface, expected_polyspan, false, true, Contour::WINDING_NON_ZERO, 1.f, 0);
+	render(surface, polyspan, false, true, Contour::WINDING_NON_ZERO, 1.f, 0);
+	for(int y = 0; y < size; ++y)
+		for(int x = 0; x < size; ++x)
+			ASSERT(expected_surface[y][x] == surface[y][x])
+}
+
+void test_flattened_contour_is_rendered_as_chunks() {
+	Contour contour;
+	build_contour(contour, 0.9);
+	const Matrix matrix = scale_translate(size/4.0 - 1.0, 0.25, 0.5);
+	check_flattened_polyspan(contour, matrix, RectInt(0, 0, size, size));
+
+	// curves crossing the borders of tiles are clipped by polyspan
+	for(int y = 0; y < size; y += size/4)
+		for(int x = 0; x < size; x += size/3)
+			check_flattened_polyspan(contour, matrix, RectInt(x, y, std::min(size, x + size/3), y + size/4));
+
+	// small curves are joined into lines, following curve is split from the end of these lines
+	Contour small;
+	build_contour(small, 0.9);
+	const Vector c(2.0, 2.0);
+	small.move_to(c);
+	for(int i = 1; i <= 8; ++i)
+		small.cubic_to(c + Vector(0.002*i, 0.0), c + Vector(0.002*i - 0.0015, 0.001), c + Vector(0.002*i - 0.0005, 0.001));
+	small.cubic_to(c + Vector(0.5, 0.9), c + Vector(0.0, 0.6), c + Vector(0.6, 0.3));
+	small.close();
+	check_flattened_polyspan(small, matrix, RectInt(0, 0, size, size));
+
+	// projective transformation is not cached
+	Matrix projective = matrix;
+	projective.m02 = 0.01;
+	check_flattened_polyspan(contour, projective, RectInt(0, 0, size, size));
+}
+
+int main() {
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_sort_few_marks)
+		TEST_FUNCTION(test_sort_many_marks)
+		TEST_FUNCTION(test_sort_of_open_list)
+		TEST_FUNCTION(test_bands_are_pixel_identical)
+		TEST_FUNCTION(test_empty_polyspan)
+		TEST_FUNCTION(test_flattened_contour_is_cached)
+		TEST_FUNCTION(test_flattened_contour_is_rendered_as_chunks)
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+
+	return tst_exit_status;
+}
@@ -0,0 +1,123 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file profile.cpp
+**	\brief Test recording of timings in Chrome trace event format
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <synfig/debug/profile.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace debug;
+
+static const char *filename = "test_synfig_profile.json";
+
+static String
+stop_and_read()
+{
+	ASSERT(Profile::stop(filesystem::Path(filename)))
+	std::ifstream f(filename);
+	std::stringstream s;
+	s << f.rdbuf();
+	std::remove(filename);
+	return s.str();
+}
+
+static int
+count(const String &text, const String &x)
+{
+	int c = 0;
+	for(String::size_type i = text.find(x); i != String::npos; i = text.find(x, i + 1))
+		++c;
+	return c;
+}
+
+void test_scope_is_inactive_when_disabled() {
+	ASSERT_FALSE(Profile::is_enabled())
+	Profile::Scope scope("test", "disabled");
+	ASSERT_FALSE(scope.is_active())
+}
+
+void test_nested_scopes_are_written() {
+	Profile::start();
+	{
+		Profile::Scope outer("test", "outer");
+		ASSERT(outer.is_active())
+		outer.set_args("\"frame\":7");
+		Profile::Scope inner("test", "inner");
+		inner.set_name("inner 1");
+	}
+	const String text = stop_and_read();
+
+	ASSERT_FALSE(Profile::is_enabled())
+	ASSERT(text.find("\"traceEvents\":[") != String::npos)
+	ASSERT_EQUAL(2, count(text, "\"ph\":\"X\""))
+	ASSERT_EQUAL(1, count(text, "\"name\":\"outer\""))
+	ASSERT_EQUAL(1, count(text, "\"name\":\"inner 1\""))
+	ASSERT_EQUAL(1, count(text, "\"args\":{\"frame\":7}"))
+	ASSERT_EQUAL(2, count(text, "\"tdur\":"))
+}
+
+void test_events_of_threads_are_collected() {
+	Profile::start();
+	std::thread thread([]() {
+		Profile::Scope scope("test", "thread");
+	});
+	thread.join();
+	Profile::add("test", "manual", 10, 25);
+	const String text = stop_and_read();
+
+	ASSERT_EQUAL(1, count(text, "\"name\":\"thread\""))
+	ASSERT_EQUAL(1, count(text, "\"ts\":10,\"dur\":15"))
+}
+
+void test_start_drops_old_events() {
+	Profile::start();
+	{ Profile::Scope scope("test", "old"); }
+	Profile::start();
+	{ Profile::Scope scope("test", "new"); }
+	const String text = stop_and_read();
+
+	ASSERT_EQUAL(0, count(text, "\"name\":\"old\""))
+	ASSERT_EQUAL(1, count(text, "\"name\":\"new\""))
+}
+
+void test_escape() {
+	ASSERT_EQUAL(String("a\\\"b\\\\c\\u000a"), Profile::escape("a\"b\\c\n"))
+}
+
+int main() {
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_scope_is_inactive_when_disabled)
+		TEST_FUNCTION(test_nested_scopes_are_written)
+		TEST_FUNCTION(test_events_of_threads_are_collected)
+		TEST_FUNCTION(test_start_drops_old_events)
+		TEST_FUNCTION(test_escape)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
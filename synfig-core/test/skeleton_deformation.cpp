@@ -0,0 +1,265 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file skeleton_deformation.cpp
+**	\brief Test that the adaptive mesh of Layer_SkeletonDeformation matches the dense grid
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cmath>
+#include <vector>
+
+#include <synfig/bone.h>
+#include <synfig/threadpool.h>
+#include <synfig/type.h>
+#include <synfig/value.h>
+#include <synfig/layers/layer_skeletondeformation.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+typedef Layer_SkeletonDeformation::BonePair BonePair;
+
+static const Point grid_p0(-4.0, 4.0);
+static const Point grid_p1(4.0, -4.0);
+static const int subdivisions = 32;
+
+class TestLayer: public Layer_SkeletonDeformation
+{
+public:
+	const rendering::Mesh::Handle& get_mesh() const { return mesh; }
+};
+
+//! Deformation of the whole grid, as it was computed before the adaptive blocks
+struct DenseGrid {
+	int count;
+	Vector step;
+	std::vector<Vector> positions;
+	std::vector<bool> used;
+
+	explicit DenseGrid(const std::vector<BonePair> &bones):
+		count(subdivisions + 1),
+		step((grid_p1 - grid_p0)/(Real)subdivisions),
+		positions(count*count),
+		used(count*count, false)
+	{
+		const Real diagonal = step.mag();
+		std::vector<Vector> summary_position(positions.size());
+		std::vector<Real> summary_weight(positions.size(), 0.0);
+		for(std::vector<BonePair>::const_iterator b = bones.begin(); b != bones.end(); ++b) {
+			Bone::Shape shape0 = b->first.get_shape();
+			Bone::Shape shape1 = b->second.get_shape();
+			Bone::Shape expanded = shape0;
+			expanded.r0 += 2.0*diagonal;
+			expanded.r1 += 2.0*diagonal;
+			Matrix into_bone(
+				shape0.p1[0] - shape0.p0[0], shape0.p1[1] - shape0.p0[1], 0.0,
+				shape0.p0[1] - shape0.p1[1], shape0.p1[0] - shape0.p0[0], 0.0,
+				shape0.p0[0], shape0.p0[1], 1.0 );
+			into_bone.invert();
+			Matrix from_bone(
+				shape1.p1[0] - shape1.p0[0], shape1.p1[1] - shape1.p0[1], 0.0,
+				shape1.p0[1] - shape1.p1[1], shape1.p1[0] - shape1.p0[0], 0.0,
+				shape1.p0[0], shape1.p0[1], 1.0 );
+			Matrix matrix = from_bone * into_bone;
+
+			for(int k = 0; k < (int)positions.size(); ++k) {
+				const Vector p = initial(k%count, k/count);
+				Real percent = Bone::distance_to_shape_center_percent(expanded, p);
+				if (percent > 1e-10) {
+					Vector line = shape0.p1 - shape0.p0;
+					Real distance = std::min((p - shape0.p0).mag(), (p - shape0.p1).mag());
+					Real pos = (p - shape0.p0)*line/line.mag();
+					if (pos > 0.0 && pos < line.mag())
+						distance = std::min(distance, std::fabs((p - shape0.p0)*line.perp()/line.mag()));
+					distance = std::max(distance, 1e-10);
+					Real weight = percent/(distance*distance);
+					summary_position[k] += matrix.get_transformed(p)*weight;
+					summary_weight[k] += weight;
+					used[k] = true;
+				}
+			}
+		}
+		for(int k = 0; k < (int)positions.size(); ++k)
+			positions[k] = summary_weight[k] > 1e-10 ? summary_position[k]/summary_weight[k] : initial(k%count, k/count);
+	}
+
+	Vector initial(Real i, Real j) const
+		{ return Vector(grid_p0[0] + i*step[0], grid_p0[1] + j*step[1]); }
+
+	//! Cell is covered when all its corners are affected by bones
+	bool covers(int ci, int cj) const
+	{
+		return used[cj*count + ci] && used[cj*count + ci + 1]
+		    && used[(cj + 1)*count + ci + 1] && used[(cj + 1)*count + ci];
+	}
+
+	//! Returns false if point (i, j) given in grid units is not covered by the grid
+	bool deform(Real i, Real j, Vector &position) const
+	{
+		const int ci = (int)std::floor(i), cj = (int)std::floor(j);
+		const int v[] = { cj*count + ci, cj*count + ci + 1, (cj + 1)*count + ci + 1, (cj + 1)*count + ci };
+		if (!covers(ci, cj))
+			return false;
+		// cell is split by the diagonal from (1, 0) to (0, 1)
+		const Real u = i - ci, w = j - cj;
+		if (u + w <= 1.0)
+			position = positions[v[0]] + (positions[v[1]] - positions[v[0]])*u + (positions[v[3]] - positions[v[0]])*w;
+		else
+			position = positions[v[2]] + (positions[v[3]] - positions[v[2]])*(1.0 - u) + (positions[v[1]] - positions[v[2]])*(1.0 - w);
+		return true;
+	}
+};
+
+//! Returns false if point is not covered by mesh
+static bool
+deform_by_mesh(const rendering::Mesh &mesh, const Vector &point, Vector &position)
+{
+	for(rendering::Mesh::TriangleList::const_iterator t = mesh.triangles.begin(); t != mesh.triangles.end(); ++t) {
+		const rendering::Mesh::Vertex &a = mesh.vertices[t->vertices[0]];
+		const rendering::Mesh::Vertex &b = mesh.vertices[t->vertices[1]];
+		const rendering::Mesh::Vertex &c = mesh.vertices[t->vertices[2]];
+		const Vector ab = b.tex_coords - a.tex_coords;
+		const Vector ac = c.tex_coords - a.tex_coords;
+		const Vector ap = point - a.tex_coords;
+		const Real d = ab[0]*ac[1] - ab[1]*ac[0];
+		if (std::fabs(d) < 1e-12)
+			continue;
+		const Real u = (ap[0]*ac[1] - ap[1]*ac[0])/d;
+		const Real w = (ab[0]*ap[1] - ab[1]*ap[0])/d;
+		if (u < -1e-9 || w < -1e-9 || u + w > 1.0 + 1e-9)
+			continue;
+		position = a.position + (b.position - a.position)*u + (c.position - a.position)*w;
+		return true;
+	}
+	return false;
+}
+
+static Bone
+create_bone(const Point &origin, Real angle, Real length, Real width, Real tipwidth)
+{
+	Bone bone;
+	bone.set_origin(origin);
+	bone.set_angle(Angle::deg(angle));
+	bone.set_length(length);
+	bone.set_width(width);
+	bone.set_tipwidth(tipwidth);
+	return bone;
+}
+
+static void
+check_rig(const std::vector<BonePair> &bones)
+{
+	etl::handle<TestLayer> layer(new TestLayer());
+	layer->set_param("point1", ValueBase(grid_p0));
+	layer->set_param("point2", ValueBase(grid_p1));
+	layer->set_param("x_subdivisions", ValueBase(subdivisions));
+	layer->set_param("y_subdivisions", ValueBase(subdivisions));
+	ValueBase bones_value;
+	bones_value.set_list_of(bones);
+	ASSERT(layer->set_param("bones", bones_value))
+
+	ASSERT(layer->get_mesh())
+	const rendering::Mesh &mesh = *layer->get_mesh();
+	const DenseGrid grid(bones);
+
+	// vertices are deformed grid points, mesh has less triangles than the grid
+	for(rendering::Mesh::VertexList::const_iterator v = mesh.vertices.begin(); v != mesh.vertices.end(); ++v) {
+		const Real i = (v->tex_coords[0] - grid_p0[0])/grid.step[0];
+		const Real j = (v->tex_coords[1] - grid_p0[1])/grid.step[1];
+		ASSERT_APPROX_EQUAL(i, std::round(i))
+		ASSERT_APPROX_EQUAL(j, std::round(j))
+		ASSERT_VECTOR_APPROX_EQUAL_MICRO(grid.positions[(int)std::round(j)*grid.count + (int)std::round(i)], v->position)
+	}
+	size_t grid_triangles = 0;
+	for(int j = 0; j < subdivisions; ++j)
+		for(int i = 0; i < subdivisions; ++i)
+			if (grid.covers(i, j))
+				grid_triangles += 2;
+	ASSERT(mesh.triangles.size() < grid_triangles)
+
+	// no vertex lies inside of an edge of any triangle, so there are no T-junctions
+	for(rendering::Mesh::TriangleList::const_iterator t = mesh.triangles.begin(); t != mesh.triangles.end(); ++t) {
+		for(int e = 0; e < 3; ++e) {
+			const Vector &a = mesh.vertices[t->vertices[e]].tex_coords;
+			const Vector &b = mesh.vertices[t->vertices[(e + 1)%3]].tex_coords;
+			for(rendering::Mesh::VertexList::const_iterator v = mesh.vertices.begin(); v != mesh.vertices.end(); ++v) {
+				const Vector ab = b - a, ap = v->tex_coords - a;
+				const Real pos = ap*ab/ab.mag_squared();
+				ASSERT_FALSE(std::fabs(ab[0]*ap[1] - ab[1]*ap[0]) < 1e-9 && pos > 1e-9 && pos < 1.0 - 1e-9)
+			}
+		}
+	}
+
+	// mesh covers the same area as the grid, and deforms it in the same way
+	const Real offsets[][2] = { {0.3, 0.2}, {0.7, 0.6}, {0.1, 0.55}, {0.85, 0.15} };
+	for(int j = 0; j < subdivisions; ++j) {
+		for(int i = 0; i < subdivisions; ++i) {
+			for(const Real *o : offsets) {
+				Vector expected, position;
+				const bool covered = grid.deform(i + o[0], j + o[1], expected);
+				ASSERT_EQUAL(covered, deform_by_mesh(mesh, grid.initial(i + o[0], j + o[1]), position))
+				if (covered)
+					ASSERT_VECTOR_APPROX_EQUAL_MICRO(expected, position)
+			}
+		}
+	}
+}
+
+void test_single_bone() {
+	check_rig({
+		BonePair(
+			create_bone(Point(-2.5, -1.0), 0.0, 5.0, 1.5, 1.5),
+			create_bone(Point(-2.0, -1.5), 10.0, 5.0, 1.5, 1.5) ),
+	});
+}
+
+void test_many_bones() {
+	// a wide bone, which is simple inside, overlapped by the small ones
+	check_rig({
+		BonePair(
+			create_bone(Point(-2.5, -1.0), 0.0, 5.0, 1.5, 1.5),
+			create_bone(Point(-2.0, -1.5), 10.0, 5.0, 1.5, 1.5) ),
+		BonePair(
+			create_bone(Point(-1.0, 1.0), 30.0, 2.0, 0.5, 0.3),
+			create_bone(Point(-1.0, 1.2), 60.0, 2.0, 0.5, 0.3) ),
+		BonePair(
+			create_bone(Point(0.5, 1.5), -45.0, 1.5, 0.4, 0.4),
+			create_bone(Point(0.7, 1.3), -30.0, 1.5, 0.4, 0.4) ),
+		BonePair(
+			create_bone(Point(1.0, -1.5), 90.0, 1.0, 0.3, 0.2),
+			create_bone(Point(1.2, -1.5), 120.0, 1.0, 0.3, 0.2) ),
+	});
+}
+
+int main() {
+	Type::subsys_init();
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_single_bone)
+		TEST_FUNCTION(test_many_bones)
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+	Type::subsys_stop();
+
+	return tst_exit_status;
+}
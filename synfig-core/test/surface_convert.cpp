@@ -0,0 +1,170 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file surface_convert.cpp
+**	\brief Test conversion of intermediate surfaces to compact formats
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cmath>
+#include <vector>
+
+#include <synfig/rendering/common/optimizer/optimizersurfaceconvert.h>
+#include <synfig/rendering/common/task/taskblend.h>
+#include <synfig/rendering/common/task/taskcontour.h>
+#include <synfig/rendering/software/rendererdraftsw.h>
+#include <synfig/rendering/software/rendererpreviewsw.h>
+#include <synfig/rendering/software/renderersw.h>
+#include <synfig/rendering/software/surfacesw.h>
+#include <synfig/rendering/software/surfaceswpacked.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace rendering;
+
+static SurfaceResource::Handle
+create_surface()
+{
+	rendering::Surface::Handle surface(new SurfaceSW());
+	surface->create(16, 16);
+	return new SurfaceResource(surface);
+}
+
+static Task::Handle
+create_task(Task *task, const SurfaceResource::Handle &target)
+{
+	task->target_surface = target;
+	task->source_rect = Rect(0.0, 0.0, 1.0, 1.0);
+	task->target_rect = RectInt(0, 0, 16, 16);
+	return task;
+}
+
+//! Surface which is read by the next task as sub-task, like in the linearized list
+static Task::Handle
+create_sub_task(const SurfaceResource::Handle &surface)
+	{ return create_task(new TaskSurface(), surface); }
+
+//! Contour is drawn into intermediate surface and blended onto the target
+static Task::List
+create_list(const SurfaceResource::Handle &intermediate, const SurfaceResource::Handle &target)
+{
+	Task::List list;
+	list.push_back(create_task(new TaskContour(), intermediate));
+	list.push_back(create_task(new TaskContour(), target));
+	Task::Handle blend = create_task(new TaskBlend(), target);
+	blend->sub_tasks.push_back(create_sub_task(target));
+	blend->sub_tasks.push_back(create_sub_task(intermediate));
+	list.push_back(blend);
+	return list;
+}
+
+static void
+run_optimizer(const rendering::Surface::Token::Handle &token, Task::List &list)
+{
+	Optimizer::RunParams params(Optimizer::CATEGORY_ALL_SPECIALIZED, list);
+	OptimizerSurfaceConvert(token).run(params);
+}
+
+static rendering::Surface::Token::Handle
+get_convert_token(const Renderer &renderer)
+{
+	const Optimizer::List &optimizers = renderer.get_optimizers(Optimizer::CATEGORY_ID_LIST);
+	for(Optimizer::List::const_iterator i = optimizers.begin(); i != optimizers.end(); ++i)
+		if (const OptimizerSurfaceConvert *optimizer = dynamic_cast<const OptimizerSurfaceConvert*>(i->get()))
+			return optimizer->surface_token;
+	return rendering::Surface::Token::Handle();
+}
+
+void test_intermediate_surface_is_converted() {
+	SurfaceResource::Handle intermediate = create_surface();
+	SurfaceResource::Handle target = create_surface();
+	Task::List list = create_list(intermediate, target);
+	run_optimizer(SurfaceSWPackedHalf::token.handle(), list);
+
+	// converted right after it is drawn, the target keeps its format
+	ASSERT_EQUAL(4u, list.size())
+	TaskSurfaceConvert::Handle convert = TaskSurfaceConvert::Handle::cast_dynamic(list[1]);
+	ASSERT(convert)
+	ASSERT(convert->surface_token == SurfaceSWPackedHalf::token.handle())
+	ASSERT(convert->target_surface == intermediate)
+	ASSERT(convert->target_rect == RectInt(0, 0, 16, 16))
+	ASSERT(convert->is_valid())
+	ASSERT(list[2]->target_surface == target)
+	ASSERT(list[3].type_is<TaskBlend>())
+
+	// list is processed once
+	run_optimizer(SurfaceSWPackedHalf::token.handle(), list);
+	ASSERT_EQUAL(4u, list.size())
+}
+
+void test_surface_drawn_after_read_is_not_converted() {
+	SurfaceResource::Handle intermediate = create_surface();
+	Task::List list = create_list(intermediate, create_surface());
+	list.push_back(create_task(new TaskContour(), intermediate));
+	run_optimizer(SurfaceSWPackedByte::token.handle(), list);
+	ASSERT_EQUAL(4u, list.size())
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		ASSERT_FALSE(i->type_is<TaskSurfaceConvert>())
+}
+
+void test_convert_task_keeps_only_packed_format() {
+	SurfaceResource::Handle surface = create_surface();
+	{
+		SurfaceResource::LockWrite<SurfaceSW> lock(surface);
+		ASSERT(lock)
+		lock->get_surface().fill(Color(0.25f, 0.5f, 0.75f, 1.f));
+	}
+
+	TaskSurfaceConvert::Handle convert(new TaskSurfaceConvert());
+	create_task(convert.get(), surface);
+	convert->surface_token = SurfaceSWPackedByte::token.handle();
+	Task::RunParams params;
+	ASSERT(convert->run(params))
+
+	SurfaceResource::LockReadBase lock(surface);
+	ASSERT_FALSE(lock.convert<SurfaceSW>(false))
+	ASSERT(lock.convert<SurfaceSWPackedByte>(false))
+	std::vector<Color> pixels(16*16);
+	ASSERT(lock.get_surface()->get_pixels(&pixels.front()))
+	for(std::vector<Color>::const_iterator i = pixels.begin(); i != pixels.end(); ++i) {
+		ASSERT(std::fabs(i->get_r() - 0.25f) < 1.f/255.f)
+		ASSERT(std::fabs(i->get_g() - 0.5f) < 1.f/255.f)
+		ASSERT(std::fabs(i->get_b() - 0.75f) < 1.f/255.f)
+		ASSERT(std::fabs(i->get_a() - 1.f) < 1.f/255.f)
+	}
+}
+
+void test_renderers_choose_packed_formats() {
+	ASSERT(get_convert_token(RendererPreviewSW()) == SurfaceSWPackedHalf::token.handle())
+	ASSERT(get_convert_token(RendererDraftSW()) == SurfaceSWPackedByte::token.handle())
+	// final rendering keeps full precision
+	ASSERT_FALSE(get_convert_token(RendererSW()))
+}
+
+int main() {
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_intermediate_surface_is_converted)
+		TEST_FUNCTION(test_surface_drawn_after_read_is_not_converted)
+		TEST_FUNCTION(test_convert_task_keeps_only_packed_format)
+		TEST_FUNCTION(test_renderers_choose_packed_formats)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,399 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file taskcache.cpp
+**	\brief Test hashes of task sub-trees and storage of their results
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <vector>
+
+#include <synfig/rendering/common/optimizer/optimizercache.h>
+#include <synfig/rendering/common/task/taskblend.h>
+#include <synfig/rendering/common/task/taskblur.h>
+#include <synfig/rendering/common/task/taskcache.h>
+#include <synfig/rendering/common/task/taskcontour.h>
+#include <synfig/rendering/common/task/taskmesh.h>
+#include <synfig/rendering/common/task/tasktransformation.h>
+#include <synfig/rendering/software/surfacesw.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace rendering;
+
+static TaskContour::Handle
+create_contour(const Color &color)
+{
+	TaskContour::Handle task(new TaskContour());
+	task->contour = new Contour();
+	task->contour->move_to(Vector(0.0, 0.0));
+	task->contour->line_to(Vector(1.0, 0.0));
+	task->contour->line_to(Vector(0.0, 1.0));
+	task->contour->close();
+	task->contour->color = color;
+	task->transformation->matrix = Matrix().set_scale(2.0);
+	return task;
+}
+
+//! Blend of two contours moved by transformation and blurred
+static Task::Handle
+create_tree()
+{
+	TaskBlend::Handle blend(new TaskBlend());
+	blend->blend_method = Color::BLEND_COMPOSITE;
+	blend->amount = 0.5;
+	blend->sub_task_a() = create_contour(Color(1.f, 0.f, 0.f, 1.f));
+
+	TaskTransformationAffine::Handle transformation(new TaskTransformationAffine());
+	transformation->transformation->matrix = Matrix().set_translate(1.0, 2.0);
+	transformation->sub_task() = create_contour(Color(0.f, 0.f, 1.f, 1.f));
+
+	TaskBlur::Handle blur(new TaskBlur());
+	blur->blur.size = Vector(0.5, 0.5);
+	blur->sub_task() = transformation;
+	blend->sub_task_b() = blur;
+
+	blend->source_rect = Rect(-2.0, -2.0, 2.0, 2.0);
+	blend->target_rect = RectInt(0, 0, 64, 64);
+	return blend;
+}
+
+static bool
+calc_hash(const Task::Handle &task, TaskHash::Value &value)
+{
+	TaskHash hash;
+	const bool valid = task->calc_hash_recursive(hash);
+	value = hash.get();
+	return valid;
+}
+
+static TaskHash::Value
+get_hash(const Task::Handle &task)
+{
+	TaskHash::Value value;
+	ASSERT(calc_hash(task, value))
+	return value;
+}
+
+static SurfaceResource::Handle
+create_surface(int width, int height)
+{
+	rendering::Surface::Handle surface(new SurfaceSW());
+	surface->create(width, height);
+	return new SurfaceResource(surface);
+}
+
+//! Signature of the task with target of \a width x \a height pixels
+static TaskCacheStorage::Signature
+create_signature(int width, int height)
+{
+	TaskSurface task;
+	task.source_rect = Rect(0.0, 0.0, 1.0, 1.0);
+	task.target_rect = RectInt(0, 0, width, height);
+	return TaskCacheStorage::Signature(task);
+}
+
+//! Tree with coordinates and target surfaces, so each task may be cached
+static Task::Handle
+create_valid_tree()
+{
+	Task::Handle tree = create_tree();
+	std::vector<Task::Handle> tasks(1, tree);
+	for(size_t i = 0; i < tasks.size(); ++i) {
+		tasks[i]->source_rect = tree->source_rect;
+		tasks[i]->target_rect = tree->target_rect;
+		tasks[i]->target_surface = create_surface(64, 64);
+		for(const Task::Handle &sub_task : tasks[i]->sub_tasks)
+			if (sub_task) tasks.push_back(sub_task);
+	}
+	return tree;
+}
+
+static Task::Handle
+optimize(const OptimizerCache &optimizer, const Task::Handle &task)
+{
+	Optimizer::RunParams params(Optimizer::CATEGORY_BEGIN, task, nullptr);
+	optimizer.run(params);
+	return params.ref_task;
+}
+
+void test_equal_trees_have_equal_hash() {
+	ASSERT_EQUAL(get_hash(create_tree()), get_hash(create_tree()))
+	// copy of tree too
+	Task::Handle tree = create_tree();
+	ASSERT_EQUAL(get_hash(tree), get_hash(tree->clone_recursive()))
+}
+
+void test_hash_changes_with_params() {
+	const TaskHash::Value hash = get_hash(create_tree());
+
+	Task::Handle tree = create_tree();
+	TaskBlend::Handle::cast_static(tree)->amount = 0.75;
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	TaskBlend::Handle::cast_static(tree)->blend_method = Color::BLEND_ADD;
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	TaskContour::Handle::cast_static(tree->sub_task(0))->contour->color = Color(0.f, 1.f, 0.f, 1.f);
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	TaskContour::Handle::cast_static(tree->sub_task(0))->contour->line_to(Vector(-1.0, 0.0));
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	TaskTransformationAffine::Handle::cast_static(tree->sub_task(1)->sub_task(0))->transformation->matrix = Matrix().set_translate(1.0, 2.5);
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	TaskBlur::Handle::cast_static(tree->sub_task(1))->blur.size = Vector(0.5, 0.25);
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	tree->target_rect = RectInt(0, 0, 64, 32);
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	tree->sub_task(1)->source_rect = Rect(0.0, 0.0, 1.0, 1.0);
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	std::swap(tree->sub_task(0), tree->sub_task(1));
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+
+	tree = create_tree();
+	tree->sub_task(0).reset();
+	ASSERT_NOT_EQUAL(hash, get_hash(tree))
+}
+
+void test_surface_is_identified_by_resource() {
+	TaskSurface::Handle a(new TaskSurface());
+	TaskSurface::Handle b(new TaskSurface());
+	a->target_surface = create_surface(4, 4);
+	b->target_surface = a->target_surface;
+	ASSERT_EQUAL(get_hash(a), get_hash(b))
+	b->target_surface = create_surface(4, 4);
+	ASSERT_NOT_EQUAL(get_hash(a), get_hash(b))
+
+	TaskHash::Value value;
+	ASSERT_FALSE(calc_hash(new TaskSurface(), value))
+}
+
+void test_tree_with_unknown_task_is_not_hashed() {
+	Task::Handle tree = create_tree();
+	tree->sub_task(1)->sub_task(0)->sub_task(0) = new TaskMesh();
+	TaskHash::Value value;
+	ASSERT_FALSE(calc_hash(tree, value))
+}
+
+void test_sub_tree_hashes_are_collected() {
+	Task::Handle tree = create_tree();
+	Task::HashMap hashes;
+	TaskHash hash;
+	ASSERT(tree->calc_hash_recursive(hash, &hashes))
+	ASSERT_EQUAL(get_hash(tree), hash.get())
+
+	// each sub-tree has the same hash as when it is hashed separately
+	std::vector<Task::Handle> tasks(1, tree);
+	for(size_t i = 0; i < tasks.size(); ++i) {
+		ASSERT(hashes.count(tasks[i].get()))
+		ASSERT_EQUAL(get_hash(tasks[i]), hashes[tasks[i].get()])
+		for(const Task::Handle &sub_task : tasks[i]->sub_tasks)
+			if (sub_task) tasks.push_back(sub_task);
+	}
+	ASSERT_EQUAL(tasks.size(), hashes.size())
+
+	// unhashable task excludes its parents only
+	tree->sub_task(1)->sub_task(0)->sub_task(0) = new TaskMesh();
+	hashes.clear();
+	ASSERT_FALSE(tree->calc_hash_recursive(hash, &hashes))
+	ASSERT_FALSE(hashes.count(tree.get()))
+	ASSERT_FALSE(hashes.count(tree->sub_task(1).get()))
+	ASSERT_FALSE(hashes.count(tree->sub_task(1)->sub_task(0).get()))
+	ASSERT(hashes.count(tree->sub_task(0).get()))
+}
+
+void test_storage_find_and_store() {
+	TaskCacheStorage::Handle storage(new TaskCacheStorage(1024*1024));
+	const TaskCacheStorage::Signature signature = create_signature(16, 16);
+	SurfaceResource::Handle surface;
+	RectInt rect;
+
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_REQUESTED, storage->find(1, signature, surface, rect))
+	ASSERT_FALSE(surface)
+
+	SurfaceResource::Handle stored = create_surface(16, 16);
+	storage->store(1, signature, stored, RectInt(0, 0, 16, 16));
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(1, signature, surface, rect))
+	ASSERT(surface == stored)
+	ASSERT(rect == RectInt(0, 0, 16, 16))
+	ASSERT_EQUAL(stored->get_memory_size(), storage->get_memory_used())
+
+	// the first result is kept
+	storage->store(1, signature, create_surface(16, 16), RectInt(0, 0, 16, 16));
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(1, signature, surface, rect))
+	ASSERT(surface == stored)
+
+	storage->clear();
+	ASSERT_EQUAL(0u, storage->get_memory_used())
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, signature, surface, rect))
+}
+
+void test_storage_compares_signatures() {
+	TaskCacheStorage::Handle storage(new TaskCacheStorage(1024*1024));
+	const TaskCacheStorage::Signature signature = create_signature(16, 16);
+	const TaskCacheStorage::Signature other = create_signature(16, 8);
+	SurfaceResource::Handle surface;
+	RectInt rect;
+
+	// the same key of the other sub-tree is not mistaken for request
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, other, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_REQUESTED, storage->find(1, signature, surface, rect))
+
+	// and the stored result is not reused for it
+	storage->store(1, signature, create_surface(16, 16), RectInt(0, 0, 16, 16));
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, other, surface, rect))
+	ASSERT_FALSE(surface)
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(1, signature, surface, rect))
+
+	// task type is compared too
+	TaskCacheStorage::Signature blend = signature;
+	blend.token = TaskBlend::token.handle();
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, blend, surface, rect))
+}
+
+void test_storage_release() {
+	TaskCacheStorage::Handle storage(new TaskCacheStorage(1024*1024));
+	const TaskCacheStorage::Signature signature = create_signature(16, 16);
+	SurfaceResource::Handle surface;
+	RectInt rect;
+
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, signature, surface, rect))
+	storage->release(1);
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, signature, surface, rect))
+
+	// stored result is kept
+	storage->store(1, signature, create_surface(16, 16), RectInt(0, 0, 16, 16));
+	storage->release(1);
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(1, signature, surface, rect))
+}
+
+void test_storage_memory_limit() {
+	const size_t size = create_surface(16, 16)->get_memory_size();
+	TaskCacheStorage::Handle storage(new TaskCacheStorage(3*size));
+	const TaskCacheStorage::Signature signature = create_signature(16, 16);
+	SurfaceResource::Handle surface;
+	RectInt rect;
+
+	// surface larger than the limit is not stored
+	storage->store(1, signature, create_surface(64, 64), RectInt(0, 0, 64, 64));
+	ASSERT_EQUAL(0u, storage->get_memory_used())
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(1, signature, surface, rect))
+
+	// zero limit disables the cache
+	storage->set_memory_limit(0);
+	storage->store(2, signature, create_surface(16, 16), RectInt(0, 0, 16, 16));
+	ASSERT_EQUAL(0u, storage->get_memory_used())
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(2, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(2, signature, surface, rect))
+}
+
+void test_storage_evicts_least_recently_used() {
+	const size_t size = create_surface(16, 16)->get_memory_size();
+	TaskCacheStorage::Handle storage(new TaskCacheStorage(3*size));
+	const TaskCacheStorage::Signature signature = create_signature(16, 16);
+	SurfaceResource::Handle surface;
+	RectInt rect;
+
+	for(TaskCacheStorage::Key key = 1; key <= 3; ++key)
+		storage->store(key, signature, create_surface(16, 16), RectInt(0, 0, 16, 16));
+	ASSERT_EQUAL(3*size, storage->get_memory_used())
+
+	// 1 becomes recently used, so 2 is evicted by 4
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(1, signature, surface, rect))
+	storage->store(4, signature, create_surface(16, 16), RectInt(0, 0, 16, 16));
+	ASSERT_EQUAL(3*size, storage->get_memory_used())
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(1, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(2, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(3, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(4, signature, surface, rect))
+
+	// lower limit evicts the oldest results at once
+	storage->set_memory_limit(size);
+	ASSERT_EQUAL(size, storage->get_memory_used())
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_FOUND, storage->find(4, signature, surface, rect))
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW, storage->find(3, signature, surface, rect))
+}
+
+void test_optimizer_reuses_sub_trees() {
+	TaskCacheStorage::Handle storage(new TaskCacheStorage(1024*1024));
+	OptimizerCache optimizer(storage);
+
+	// first frame, everything is new
+	Task::Handle tree = create_valid_tree();
+	ASSERT(optimize(optimizer, tree) == tree)
+
+	// root is changed, but its sub-trees are met second time
+	Task::Handle changed = create_valid_tree();
+	TaskBlend::Handle::cast_static(changed)->amount = 0.75;
+	Task::Handle result = optimize(optimizer, changed);
+	ASSERT(result != changed)
+	ASSERT(result.type_is<TaskBlend>())
+	ASSERT(result->sub_task(0).type_is<TaskCache>())
+	ASSERT(result->sub_task(1).type_is<TaskCache>())
+	// original tree is not modified
+	ASSERT(changed->sub_task(0).type_is<TaskContour>())
+
+	// requests of sub-trees of the cached ones are released
+	TaskCacheStorage::Signature signature(*changed->sub_task(1)->sub_task(0));
+	SurfaceResource::Handle surface;
+	RectInt rect;
+	ASSERT_EQUAL(TaskCacheStorage::STATUS_NEW,
+		storage->find(get_hash(changed->sub_task(1)->sub_task(0)), signature, surface, rect))
+
+	// the same frame again, whole tree is cached
+	changed = create_valid_tree();
+	TaskBlend::Handle::cast_static(changed)->amount = 0.75;
+	result = optimize(optimizer, changed);
+	ASSERT(result.type_is<TaskCache>())
+	ASSERT(TaskCache::Handle::cast_static(result)->signature == TaskCacheStorage::Signature(*changed))
+}
+
+int main() {
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_equal_trees_have_equal_hash)
+		TEST_FUNCTION(test_hash_changes_with_params)
+		TEST_FUNCTION(test_surface_is_identified_by_resource)
+		TEST_FUNCTION(test_tree_with_unknown_task_is_not_hashed)
+		TEST_FUNCTION(test_sub_tree_hashes_are_collected)
+		TEST_FUNCTION(test_storage_find_and_store)
+		TEST_FUNCTION(test_storage_compares_signatures)
+		TEST_FUNCTION(test_storage_release)
+		TEST_FUNCTION(test_storage_memory_limit)
+		TEST_FUNCTION(test_storage_evicts_least_recently_used)
+		TEST_FUNCTION(test_optimizer_reuses_sub_trees)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
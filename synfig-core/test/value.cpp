@@ -0,0 +1,94 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file value.cpp
+**	\brief Test ValueBase storage of small values
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <vector>
+
+#include <synfig/time.h>
+#include <synfig/value.h>
+#include <synfig/vector.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+void test_small_values_are_copied() {
+	ValueBase a(Real(2.5));
+	ValueBase b(a);
+	ValueBase c;
+	c = a;
+	b = Real(4.0);
+
+	ASSERT_EQUAL(2.5, a.get(Real()))
+	ASSERT_EQUAL(4.0, b.get(Real()))
+	ASSERT_EQUAL(2.5, c.get(Real()))
+	ASSERT(a == c)
+	ASSERT(a.is_valid())
+	ASSERT_FALSE(ValueBase().is_valid())
+}
+
+void test_swap_of_inline_and_allocated_values() {
+	ValueBase v(Vector(1.0, 2.0));
+	ValueBase s(String("abc"));
+	swap(v, s);
+
+	ASSERT_EQUAL(String("abc"), v.get(String()))
+	ASSERT_EQUAL(2.0, s.get(Vector())[1])
+
+	ValueBase moved(std::move(s));
+	ASSERT_EQUAL(1.0, moved.get(Vector())[0])
+	ASSERT_FALSE(s.is_valid())
+}
+
+void test_copy_between_types() {
+	ValueBase t(Time(3.0));
+	ValueBase r(Real(1.0));
+	r.copy(t);
+	ASSERT_EQUAL(3.0, r.get(Real()))
+	ASSERT(r.get_type() == type_real)
+}
+
+void test_list_of_small_values() {
+	std::vector<ValueBase> list;
+	for(int i = 0; i < 100; ++i)
+		list.push_back(ValueBase(Real(i)));
+	ValueBase value(list);
+	ValueBase copy(value);
+	ASSERT_EQUAL(100, (int)copy.get_list().size())
+	ASSERT_EQUAL(77.0, copy.get_list()[77].get(Real()))
+}
+
+int main() {
+	Type::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_small_values_are_copied)
+		TEST_FUNCTION(test_swap_of_inline_and_allocated_values)
+		TEST_FUNCTION(test_copy_between_types)
+		TEST_FUNCTION(test_list_of_small_values)
+	TEST_SUITE_END()
+
+	Type::subsys_stop();
+
+	return tst_exit_status;
+}
@@ -0,0 +1,157 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file valuenode_cache.cpp
+**	\brief Test frame-scoped cache of ValueNode values
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <thread>
+
+#include <synfig/valuenode.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+//! Returns time multiplied by \a factor and counts calls
+struct CountingNode : public ValueNode
+{
+	mutable int calls = 0;
+	Real factor = 1.0;
+
+	CountingNode() : ValueNode(type_real) { }
+
+	ValueBase operator()(Time t) const override
+	{
+		++calls;
+		return Real(t)*factor;
+	}
+
+	String get_name() const override { return "counting"; }
+	String get_local_name() const override { return "Counting"; }
+	ValueNode::Handle clone(etl::loose_handle<Canvas>, const GUID&) const override
+		{ return ValueNode::Handle(); }
+
+protected:
+	void get_times_vfunc(time_set &) const override { }
+};
+
+void test_evaluate_without_scope_is_not_cached() {
+	ValueNode::Handle node(new CountingNode());
+	ValueNode::Handle other(node);
+	CountingNode &counting = static_cast<CountingNode&>(*node);
+
+	ASSERT_EQUAL(2.0, node->evaluate(2.0).get(Real()))
+	ASSERT_EQUAL(2.0, node->evaluate(2.0).get(Real()))
+	ASSERT_EQUAL(2, counting.calls)
+}
+
+void test_evaluate_caches_shared_node_per_time() {
+	ValueNode::Handle node(new CountingNode());
+	ValueNode::Handle other(node);
+	CountingNode &counting = static_cast<CountingNode&>(*node);
+
+	ValueNode::EvaluationScope scope;
+	for(int i = 0; i < 5; ++i)
+		ASSERT_EQUAL(2.0, node->evaluate(2.0).get(Real()))
+	ASSERT_EQUAL(1, counting.calls)
+
+	ASSERT_EQUAL(3.0, node->evaluate(3.0).get(Real()))
+	ASSERT_EQUAL(2, counting.calls)
+}
+
+void test_evaluate_does_not_cache_unshared_node() {
+	ValueNode::Handle node(new CountingNode());
+	CountingNode &counting = static_cast<CountingNode&>(*node);
+
+	ValueNode::EvaluationScope scope;
+	node->evaluate(2.0);
+	node->evaluate(2.0);
+	ASSERT_EQUAL(2, counting.calls)
+}
+
+void test_changed_drops_cached_values() {
+	ValueNode::Handle node(new CountingNode());
+	ValueNode::Handle other(node);
+	CountingNode &counting = static_cast<CountingNode&>(*node);
+
+	ValueNode::EvaluationScope scope;
+	ASSERT_EQUAL(2.0, node->evaluate(2.0).get(Real()))
+	counting.factor = 10.0;
+	counting.changed();
+	ASSERT_EQUAL(20.0, node->evaluate(2.0).get(Real()))
+	ASSERT_EQUAL(2, counting.calls)
+}
+
+void test_cache_is_cleared_when_outer_scope_ends() {
+	ValueNode::Handle node(new CountingNode());
+	ValueNode::Handle other(node);
+	CountingNode &counting = static_cast<CountingNode&>(*node);
+
+	{
+		ValueNode::EvaluationScope scope;
+		{
+			ValueNode::EvaluationScope nested_scope;
+			node->evaluate(2.0);
+		}
+		node->evaluate(2.0);
+		ASSERT_EQUAL(1, counting.calls)
+	}
+	{
+		ValueNode::EvaluationScope scope;
+		node->evaluate(2.0);
+		ASSERT_EQUAL(2, counting.calls)
+	}
+}
+
+void test_threads_have_separate_caches() {
+	ValueNode::Handle node(new CountingNode());
+	ValueNode::Handle other(node);
+
+	Real values[2] = { 0.0, 0.0 };
+	ValueNode::EvaluationScope scope;
+	node->evaluate(1.0);
+	std::thread thread([&]() {
+		ValueNode::EvaluationScope thread_scope;
+		values[1] = node->evaluate(2.0).get(Real());
+	});
+	values[0] = node->evaluate(1.0).get(Real());
+	thread.join();
+
+	ASSERT_EQUAL(1.0, values[0])
+	ASSERT_EQUAL(2.0, values[1])
+}
+
+int main() {
+	Type::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_evaluate_without_scope_is_not_cached)
+		TEST_FUNCTION(test_evaluate_caches_shared_node_per_time)
+		TEST_FUNCTION(test_evaluate_does_not_cache_unshared_node)
+		TEST_FUNCTION(test_changed_drops_cached_values)
+		TEST_FUNCTION(test_cache_is_cleared_when_outer_scope_ends)
+		TEST_FUNCTION(test_threads_have_separate_caches)
+	TEST_SUITE_END()
+
+	Type::subsys_stop();
+
+	return tst_exit_status;
+}
@@ -0,0 +1,177 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file zstreambuf.cpp
+**	\brief Test block-buffered and parallel gzip compression of ZWriteStream
+**
+**	\legal
+**	Copyright (c) 2024 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <synfig/threadpool.h>
+#include <synfig/zstreambuf.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+class MemoryWriteStream: public FileSystem::WriteStream
+{
+public:
+	typedef etl::handle<MemoryWriteStream> Handle;
+
+	std::string data;
+	int writes;
+
+	MemoryWriteStream(): FileSystem::WriteStream(FileSystem::Handle()), writes(0) { }
+
+protected:
+	virtual size_t internal_write(const void *buffer, size_t size)
+		{ data.append((const char*)buffer, size); ++writes; return size; }
+};
+
+class MemoryReadStream: public FileSystem::ReadStream
+{
+public:
+	std::string data;
+	size_t position;
+
+	explicit MemoryReadStream(const std::string &data):
+		FileSystem::ReadStream(FileSystem::Handle()), data(data), position(0) { }
+
+protected:
+	virtual size_t internal_read(void *buffer, size_t size)
+	{
+		size = std::min(size, data.size() - position);
+		memcpy(buffer, data.data() + position, size);
+		position += size;
+		return size;
+	}
+};
+
+//! Xml-like text, compressible but not too much
+static std::string
+make_text(size_t size)
+{
+	std::string text;
+	unsigned int seed = 12345;
+	while(text.size() < size) {
+		seed = seed*1103515245u + 12345u;
+		text += "<waypoint time=\"" + std::to_string(seed % 1000) + "\" value=\"" + std::to_string((seed >> 10) % 100000) + "\"/>\n";
+	}
+	text.resize(size);
+	return text;
+}
+
+static std::string
+compress(const std::string &text, size_t chunk)
+{
+	MemoryWriteStream::Handle memory(new MemoryWriteStream());
+	{
+		ZWriteStream stream(FileSystem::WriteStream::Handle(memory.get()));
+		for(size_t i = 0; i < text.size(); i += chunk) {
+			if (chunk == 1)
+				stream.put(text[i]);
+			else
+				stream.write_block(text.data() + i, std::min(chunk, text.size() - i));
+		}
+	}
+	return memory->data;
+}
+
+static std::string
+uncompress(const std::string &data, size_t max_size)
+{
+	std::string result(max_size, ' ');
+	result.resize(zstreambuf::unpack(&result[0], result.size(), data.data(), data.size()));
+	return result;
+}
+
+void test_small_data() {
+	const std::string text = "<canvas/>\n";
+	const std::string data = compress(text, 1);
+	ASSERT(data.size() > 18)
+	ASSERT_EQUAL('\x1f', data[0])
+	ASSERT_EQUAL('\x8b', data[1])
+	ASSERT_EQUAL(text, uncompress(data, text.size() + 100))
+}
+
+void test_empty_data() {
+	ASSERT(compress(std::string(), 1).empty())
+}
+
+void test_many_blocks() {
+	const std::string text = make_text(5*zstreambuf::option_block_size + 12345);
+	const std::string data = compress(text, 10000);
+	ASSERT_EQUAL(text, uncompress(data, text.size() + 100))
+	ASSERT_EQUAL(data, compress(text, 1))
+
+	// blocks are compressed almost as well as the whole stream
+	std::vector<char> packed;
+	ASSERT(zstreambuf::pack(packed, text.data(), text.size()))
+	ASSERT(data.size() < text.size()/2)
+	ASSERT(data.size() < packed.size() + packed.size()/50 + 64)
+}
+
+void test_output_does_not_depend_on_threads() {
+	const std::string text = make_text(9*zstreambuf::option_block_size);
+	ThreadPool::instance().set_num_threads(2);
+	const std::string data = compress(text, 4096);
+	ThreadPool::instance().set_num_threads(8);
+	ASSERT_EQUAL(data, compress(text, 4096))
+	ThreadPool::instance().set_num_threads(0);
+}
+
+void test_block_write_and_read() {
+	const std::string text = make_text(3*zstreambuf::option_block_size);
+	MemoryWriteStream::Handle memory(new MemoryWriteStream());
+	{
+		ZWriteStream stream(FileSystem::WriteStream::Handle(memory.get()));
+		ASSERT(stream.write_whole_block(text.data(), text.size()))
+	}
+	// compressed blocks are passed to the underlying stream at once
+	ASSERT(memory->writes < 16)
+
+	FileSystem::ReadStream::Handle source(new MemoryReadStream(memory->data));
+	ZReadStream stream(source, zstreambuf::compression::gzip);
+	std::string result(text.size(), ' ');
+	ASSERT(stream.read_whole_block(&result[0], 1000))
+	ASSERT(stream.read_whole_block(&result[1000], text.size() - 1000))
+	ASSERT_EQUAL(text, result)
+	char c;
+	ASSERT_FALSE(stream.read_variable(c))
+}
+
+int main() {
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_small_data)
+		TEST_FUNCTION(test_empty_data)
+		TEST_FUNCTION(test_many_blocks)
+		TEST_FUNCTION(test_output_does_not_depend_on_threads)
+		TEST_FUNCTION(test_block_write_and_read)
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+
+	return tst_exit_status;
+}
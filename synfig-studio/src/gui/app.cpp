@@ -290,6 +290,7 @@ synfig::Color studio::App::default_background_layer_color =
 String        studio::App::default_background_layer_image = "undefined";
 synfig::Color studio::App::preview_background_color =
 	synfig::Color(0.742187, 0.742187, 0.742187, 1.000000);  //X11 Gray
+int           studio::App::preview_cache_size = 512;
 
 bool   studio::App::enable_mainwin_menubar = true;
 bool   studio::App::enable_mainwin_toolbar = true;
@@ -593,6 +594,11 @@ public:
 					);
 				return true;
 			}
+			if(key=="preview_cache_size")
+			{
+				value=strprintf("%i",App::preview_cache_size);
+				return true;
+			}
 			if(key=="use_render_done_sound")
 			{
 				value=strprintf("%i",(int)App::use_render_done_sound);
@@ -780,6 +786,11 @@ public:
 				App::preview_background_color = synfig::Color(r,g,b,a);
 				return true;
 			}
+			if(key=="preview_cache_size")
+			{
+				App::preview_cache_size=atoi(value.c_str());
+				return true;
+			}
 			if(key=="use_render_done_sound")
 			{
 				int i(atoi(value.c_str()));
@@ -847,6 +858,7 @@ public:
 		ret.push_back("default_background_layer_color");
 		ret.push_back("default_background_layer_image");
 		ret.push_back("preview_background_color");
+		ret.push_back("preview_cache_size");
 		ret.push_back("use_render_done_sound");
 		ret.push_back("enable_mainwin_menubar");
 		ret.push_back("ui_handle_tooltip_flag");
@@ -94,6 +94,7 @@ Dialog_Setup::Dialog_Setup(Gtk::Window& parent):
 	adj_pref_y_size(Gtk::Adjustment::create(270,1,10000,1,10,0)),
 	adj_pref_fps(Gtk::Adjustment::create(24.0,1.0,100,0.1,1,0)),
 	adj_number_of_threads(Gtk::Adjustment::create(App::number_of_threads,2,std::thread::hardware_concurrency(),1,10,0)),
+	adj_preview_cache_size(Gtk::Adjustment::create(App::preview_cache_size,16,65536,16,256,0)),
 	pref_modification_flag(false),
 	refreshing(false)
 {
@@ -747,6 +748,12 @@ Dialog_Setup::create_render_page(PageInfo pi)
 	preview_background_color_button.signal_color_set().connect(
 		sigc::mem_fun(*this, &studio::Dialog_Setup::on_preview_background_color_changed) );
 
+	// Render - Memory for preview frames
+	attach_label(pi.grid, _("Preview memory limit (MB)"), ++row);
+	Gtk::SpinButton *preview_cache_size_select = Gtk::manage(new Gtk::SpinButton(adj_preview_cache_size,0,0));
+	preview_cache_size_select->set_tooltip_text(_("Preview frames above this limit are compressed to a temporary file."));
+	pi.grid->attach(*preview_cache_size_select, 1, row, 1, 1);
+	preview_cache_size_select->set_hexpand(true);
 }
 
 void
@@ -929,6 +936,7 @@ Dialog_Setup::on_restore_pressed()
 		adj_pref_fps->set_value(24.0);
 		image_sequence_separator.set_text(".");
 		adj_number_of_threads->set_value(std::thread::hardware_concurrency());
+		adj_preview_cache_size->set_value(512);
 
 		workarea_renderer_combo.set_active_id("");
 		def_background_none.set_active();
@@ -1083,6 +1091,9 @@ Dialog_Setup::on_apply_pressed()
 	// Set the number of threads
 	App::number_of_threads = int(adj_number_of_threads->get_value());
 
+	// Set the memory limit of the preview
+	App::preview_cache_size = int(adj_preview_cache_size->get_value());
+
 	// Set the workarea render and navigator render flag
 	App::navigator_renderer = App::workarea_renderer  = workarea_renderer_combo.get_active_id();
 
@@ -1390,6 +1401,9 @@ Dialog_Setup::refresh()
 	// Refresh the number of threads
 	number_of_threads_select->set_value(App::number_of_threads);
 
+	// Refresh the memory limit of the preview
+	adj_preview_cache_size->set_value(App::preview_cache_size);
+
 	// Refresh the status of the workarea_renderer
 	workarea_renderer_combo.set_active_id(App::workarea_renderer);
 
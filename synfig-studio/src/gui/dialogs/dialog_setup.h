@@ -167,6 +167,7 @@ class Dialog_Setup : public Dialog_Template
 	Gtk::ColorButton        def_background_color_button;
 	Gtk::FileChooserButton  fcbutton_image;
 	Gtk::ColorButton        preview_background_color_button;
+	Glib::RefPtr<Gtk::Adjustment> adj_preview_cache_size;
 	//Gtk::FileFilter         filter_images;
 	//Gtk::FileFilter         filter_any;
 
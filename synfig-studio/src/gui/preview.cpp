@@ -37,6 +37,8 @@
 
 #include <gui/preview.h>
 
+#include <algorithm>
+
 #include <gdkmm/general.h>
 
 #include <gtkmm/alignment.h>
@@ -49,9 +51,12 @@
 #include <gui/exception_guard.h>
 #include <gui/localization.h>
 
+#include <synfig/general.h>
 #include <synfig/string.h>
+#include <synfig/string_helper.h>
 #include <synfig/surface.h>
 #include <synfig/target_scanline.h>
+#include <synfig/zstreambuf.h>
 
 #endif
 
@@ -157,7 +162,10 @@ studio::Preview::Preview(const CanvasView::LooseHandle &h, float zoom, float f):
 	overbegin(false),
 	overend(false),
 	quality(),
-	global_fps()
+	global_fps(),
+	memory_used(),
+	first_frame_in_memory(),
+	decoded_index(-1)
 { }
 
 void studio::Preview::set_canvasview(const CanvasView::LooseHandle &h)
@@ -237,7 +245,7 @@ void studio::Preview::render()
 		target->set_rend_desc(&desc);
 
 		//... first we must clear our current selves of space
-		frames.resize(0);
+		clear();
 
 		//now tell it to go... with inherited prog. reporting...
 		if(renderer) renderer->stop();
@@ -249,6 +257,11 @@ void studio::Preview::render()
 void studio::Preview::clear()
 {
 	frames.clear();
+	memory_used = 0;
+	first_frame_in_memory = 0;
+	frames_file_system.reset();
+	decoded_index = -1;
+	decoded_frame.reset();
 }
 
 const Canvas::Handle&
@@ -270,46 +283,129 @@ void studio::Preview::frame_finish(const Preview_Target *targ)
 	FlipbookElem	fe;
 	float           time = targ->get_time();
 	const Surface&  surf = targ->get_surface();
-	const RendDesc& r    = targ->get_rend_desc();
 
 	//synfig::warning("Finished a frame at %f s",time);
 
 	//copy EVERYTHING!
 	PixelFormat pf(PF_RGB);
 
-	const int total_bytes(r.get_w() * r.get_h() * synfig::pixel_size(pf));
-
-	//synfig::warning("Creating a buffer");
-	unsigned char *buffer((unsigned char*)malloc(total_bytes));
-
-	if(!buffer)
+	const size_t total_bytes((size_t)surf.get_w() * surf.get_h() * synfig::pixel_size(pf));
+	if (!total_bytes)
 		return;
 
+	std::vector<unsigned char> buffer(total_bytes);
+
 	//convert all the pixels to the pixbuf... buffer... thing...
-	//synfig::warning("Converting...");
-	color_to_pixelformat(buffer, surf[0], pf, 0, surf.get_w(), surf.get_h());
+	color_to_pixelformat(&buffer.front(), surf[0], pf, 0, surf.get_w(), surf.get_h());
+
+	// fast deflate may expand the data up to 9/8 of its size
+	pack_buffer.resize(total_bytes + total_bytes/8 + 1024);
+	const size_t packed_size = zstreambuf::pack(&pack_buffer.front(), pack_buffer.size(), &buffer.front(), total_bytes, true);
+	if (!packed_size)
+	{
+		synfig::warning("Preview: Cannot compress frame at %f s", time);
+		return;
+	}
 
 	//load time
 	fe.t = time;
+	fe.w = surf.get_w();
+	fe.h = surf.get_h();
+	fe.packed.assign(pack_buffer.begin(), pack_buffer.begin() + packed_size);
+	fe.packed_size = packed_size;
+
+	//add the flipbook element to the list (assume time is correct)
+	//synfig::info("Prev: Adding %f s to the list", time);
+	memory_used += packed_size;
+	frames.push_back(std::move(fe));
+	spill_frames();
+
+	signal_changed()();
+}
+
+void studio::Preview::spill_frames()
+{
+	const size_t limit = (size_t)std::max(App::preview_cache_size, 0) * 1024 * 1024;
+
+	// the last frame stays in memory, it is shown while rendering
+	while (memory_used > limit && first_frame_in_memory + 1 < frames.size())
+	{
+		if (!frames_file_system)
+		{
+			frames_file_system = new FileSystemTemporary("preview");
+			frames_file_system->set_autosave(false);
+		}
+
+		FlipbookElem &fe = frames[first_frame_in_memory];
+		fe.filename = strprintf("frame%06d", (int)first_frame_in_memory);
+		FileSystem::WriteStream::Handle stream = frames_file_system->get_write_stream(fe.filename);
+		if (!stream || !stream->write_block(&fe.packed.front(), fe.packed_size))
+		{
+			synfig::warning("Preview: Cannot write frame to temporary file, keeping it in memory");
+			fe.filename.clear();
+			break;
+		}
+
+		memory_used -= fe.packed_size;
+		std::vector<char>().swap(fe.packed);
+		++first_frame_in_memory;
+	}
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+studio::Preview::get_frame(int index) const
+{
+	if (index < 0 || index >= (int)frames.size())
+		return Glib::RefPtr<Gdk::Pixbuf>();
+	if (index == decoded_index)
+		return decoded_frame;
+
+	const FlipbookElem &fe = frames[index];
+
+	std::vector<char> spilled;
+	const char *packed = fe.packed.empty() ? nullptr : &fe.packed.front();
+	if (!packed)
+	{
+		FileSystem::ReadStream::Handle stream;
+		if (frames_file_system && !fe.filename.empty())
+			stream = frames_file_system->get_read_stream(fe.filename);
+		spilled.resize(fe.packed_size);
+		if (!stream || !stream->read_whole_block(&spilled.front(), spilled.size()))
+		{
+			synfig::warning("Preview: Cannot read frame at %f s from temporary file", fe.t);
+			return Glib::RefPtr<Gdk::Pixbuf>();
+		}
+		packed = &spilled.front();
+	}
+
+	PixelFormat pf(PF_RGB);
+	const size_t total_bytes((size_t)fe.w * fe.h * synfig::pixel_size(pf));
+
+	unsigned char *buffer((unsigned char*)malloc(total_bytes));
+	if(!buffer)
+		return Glib::RefPtr<Gdk::Pixbuf>();
+
+	if (zstreambuf::unpack(buffer, total_bytes, packed, fe.packed_size) != total_bytes)
+	{
+		free(buffer);
+		synfig::warning("Preview: Cannot decompress frame at %f s", fe.t);
+		return Glib::RefPtr<Gdk::Pixbuf>();
+	}
+
 	//uses and manages the memory for the buffer...
-	//synfig::warning("Create a pixmap...");
-	fe.buf =
+	decoded_frame =
 	Gdk::Pixbuf::create_from_data(
 		buffer,	                               // pointer to the data
 		Gdk::COLORSPACE_RGB,                   // the colorspace
 		((pf & PF_A) == PF_A),                 // has alpha?
 		8,                                     // bits per sample
-		surf.get_w(),                          // width
-		surf.get_h(),                          // height
-		surf.get_w() * synfig::pixel_size(pf), // stride (pitch)
+		fe.w,                                  // width
+		fe.h,                                  // height
+		fe.w * synfig::pixel_size(pf),         // stride (pitch)
 		sigc::ptr_fun(free_guint8)
 	);
-
-	//add the flipbook element to the list (assume time is correct)
-	//synfig::info("Prev: Adding %f s to the list", time);
-	frames.push_back(fe);
-
-	signal_changed()();
+	decoded_index = index;
+	return decoded_frame;
 }
 
 static Gtk::Button*
@@ -612,8 +708,8 @@ void studio::Widget_Preview::update()
 				timedisp = -1;
 			}else
 			{
-				currentbuf = i->buf;
 				currentindex = i-beg;
+				currentbuf = preview->get_frame(currentindex);
 				if(timedisp != i->t)
 				{
 					timedisp = i->t;
@@ -52,6 +52,7 @@
 
 #include <synfig/canvas.h>
 #include <synfig/clock.h>
+#include <synfig/filesystemtemporary.h>
 #include <synfig/soundprocessor.h>
 #include <synfig/time.h>
 
@@ -70,22 +71,16 @@ class CanvasView;
 class Preview : public sigc::trackable, public etl::shared_object
 {
 public:
+	//! Rendered frame, its RGB pixels are kept compressed and decoded by get_frame()
 	class FlipbookElem
 	{
 	public:
 		float t;
-		Glib::RefPtr<Gdk::Pixbuf> buf; //at whatever resolution they are rendered at (resized at run time)
-		cairo_surface_t* surface;
-		FlipbookElem(): t(), surface(nullptr) { }
-		//Copy constructor
-		FlipbookElem(const FlipbookElem& other): t(other.t) ,buf(other.buf), surface(cairo_surface_reference(other.surface))
-		{
-		}
-		~FlipbookElem()
-		{
-			if(surface)
-				cairo_surface_destroy(surface);
-		}
+		int w, h; //at whatever resolution they are rendered at (resized at run time)
+		std::vector<char> packed; //compressed pixels, empty if the frame is moved to disk
+		size_t packed_size;
+		synfig::String filename; //name of the file in the temporary file system
+		FlipbookElem(): t(), w(), h(), packed_size() { }
 	};
 
 	etl::handle<studio::AsyncRenderer>	renderer;
@@ -97,6 +92,20 @@ private:
 
 	FlipBook frames;
 
+	//! Memory used by compressed frames
+	size_t memory_used;
+	//! Frames before this index are moved to disk
+	size_t first_frame_in_memory;
+	//! Holds frames which do not fit into App::preview_cache_size
+	synfig::FileSystemTemporary::Handle frames_file_system;
+	std::vector<char> pack_buffer;
+
+	mutable int decoded_index;
+	mutable Glib::RefPtr<Gdk::Pixbuf> decoded_frame;
+
+	//! Moves oldest frames to disk until memory usage fits into the limit
+	void spill_frames();
+
 	etl::loose_handle<CanvasView> canvasview;
 
 	//synfig::RendDesc		description; //for rendering the preview...
@@ -177,10 +186,12 @@ public:
 
 	FlipBook::const_iterator	begin() const {return frames.begin();}
 	FlipBook::const_iterator	end() const	  {return frames.end();}
-	void push_back(FlipbookElem fe) { frames.push_back(fe); }
 	// Used to clear the FlipBook. Do not use directly the std::vector<>::clear member
-	// because the cairo_surface_t* wouldn't be destroyed.
+	// because the temporary files and the decoded frame wouldn't be released.
 	void clear();
+
+	//! Decodes pixels of the frame, returns empty pointer on failure
+	Glib::RefPtr<Gdk::Pixbuf> get_frame(int index) const;
 	
 	unsigned int				numframes() const  {return frames.size();}
 
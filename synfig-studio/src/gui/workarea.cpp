@@ -270,6 +270,7 @@ WorkArea::WorkArea(etl::loose_handle<synfigapp::CanvasInterface> canvas_interfac
 	drawing_area->signal_size_allocate().connect(sigc::hide(sigc::mem_fun(*this, &WorkArea::refresh_dimension_info)));
 
 	canvas_interface->signal_rend_desc_changed().connect(sigc::mem_fun(*this, &WorkArea::refresh_dimension_info));
+	get_canvas()->signal_child_changed().connect(sigc::mem_fun(*renderer_canvas, &Renderer_Canvas::on_canvas_child_changed));
 	canvas_interface->signal_time_changed().connect(sigc::mem_fun(*this, &WorkArea::queue_draw));
 	// When either of the scrolling adjustments change, then redraw.
 	get_scrollx_adjustment()->signal_value_changed().connect(sigc::mem_fun(*this, &WorkArea::queue_scroll));
@@ -2162,6 +2163,21 @@ studio::WorkArea::queue_render(bool refresh)
 	}, *this));
 }
 
+void
+studio::WorkArea::queue_render_changes()
+{
+	assert(dirty_trap_count >= 0);
+	if (dirty_trap_count > 0)
+		{ dirty_trap_queued++; return; }
+	dirty_trap_queued = 0;
+	Glib::signal_idle().connect_once(sigc::track_obj([=] () {
+		renderer_canvas->invalidate_changes();
+		Glib::signal_idle().connect_once(
+					sigc::mem_fun(*renderer_canvas, &Renderer_Canvas::enqueue_render),
+					Glib::PRIORITY_DEFAULT );
+	}, *this));
+}
+
 void
 studio::WorkArea::set_cursor(const Glib::RefPtr<Gdk::Cursor> &x)
 {
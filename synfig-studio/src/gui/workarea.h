@@ -451,6 +451,9 @@ public:
 	//! initiate background rendering of canvas
 	void queue_render(bool refresh = true);
 
+	//! initiate background rendering of canvas, re-render only areas touched by changed layers
+	void queue_render_changes();
+
 	void zoom_in();
 	void zoom_out();
 	void zoom_fit();
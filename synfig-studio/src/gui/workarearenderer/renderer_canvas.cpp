@@ -81,6 +81,36 @@ static long long
 image_rect_size(const RectInt &rect)
 	{ return 4ll*rect.get_width()*rect.get_height(); }
 
+static bool
+is_finite_rect(const Rect &rect)
+{
+	return std::isfinite(rect.minx) && std::isfinite(rect.maxx)
+	    && std::isfinite(rect.miny) && std::isfinite(rect.maxy);
+}
+
+static bool
+is_empty_rect(const Rect &rect)
+	{ return !rect.valid() || approximate_less_or_equal(rect.area(), 0.0); }
+
+static Cairo::RefPtr<Cairo::ImageSurface>
+crop_surface(const Cairo::RefPtr<Cairo::ImageSurface> &surface, int x, int y, int width, int height)
+{
+	Cairo::RefPtr<Cairo::ImageSurface> cropped =
+		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+
+	surface->flush();
+	cropped->flush();
+	const int src_stride = surface->get_stride();
+	const int dst_stride = cropped->get_stride();
+	const unsigned char *src = surface->get_data() + y*src_stride + 4*x;
+	unsigned char *dst = cropped->get_data();
+	for(int i = 0; i < height; ++i, src += src_stride, dst += dst_stride)
+		memcpy(dst, src, 4*width);
+	cropped->mark_dirty();
+	cropped->flush();
+	return cropped;
+}
+
 /* === M E T H O D S ======================================================= */
 
 Renderer_Canvas::Renderer_Canvas():
@@ -95,6 +125,7 @@ Renderer_Canvas::Renderer_Canvas():
 	max_enqueued_tasks (6),
 	enqueued_tasks(),
 	tiles_size(),
+	layer_bounds_valid(),
 	pixel_format()
 {
 	// check endianness
@@ -696,6 +727,23 @@ Renderer_Canvas::enqueue_render()
 				if(!is_playing)
 					canvas->set_time(orig_time);
 
+				// remember bounds of layers for the current frame,
+				// but don't overwrite bounds which are not processed by invalidate_changes() yet
+				if (is_playing) {
+					layer_bounds_valid = false;
+				} else
+				if (!layer_bounds_valid || layer_bounds_time != orig_time) {
+					if (changed_layers.empty()) {
+						build_layer_bounds(canvas, layer_bounds);
+						layer_bounds_valid = true;
+						layer_bounds_time = orig_time;
+						layer_bounds_tl = canvas->rend_desc().get_tl();
+						layer_bounds_br = canvas->rend_desc().get_br();
+					} else {
+						layer_bounds_valid = false;
+					}
+				}
+
 				if(enqueued)
 					get_work_area()->signal_rendering()();
 			}
@@ -739,11 +787,254 @@ Renderer_Canvas::clear_render()
 		tiles.clear();
 		rendering_error_msg_map.clear();
 	}
+	layer_bounds_valid = false;
+	changed_layers.clear();
 	rendering::Renderer::cancel(events);
 	if (cleared && get_work_area())
 		get_work_area()->signal_rendering()();
 }
 
+void
+Renderer_Canvas::invalidate_tiles(TileList &list, const RectInt &rect, rendering::Task::List &events)
+{
+	// mutex must be already locked
+
+	TileList pieces;
+	for(TileList::iterator i = list.begin(); i != list.end(); ) {
+		Tile::Handle tile = *i;
+		if (!tile || !(tile->rect && rect)) { ++i; continue; }
+
+		// keep already rendered parts of tile outside of the rect
+		if (!tile->event && tile->cairo_surface) {
+			std::vector<RectInt> rects(1, tile->rect);
+			rects_subtract(rects, rect);
+			for(std::vector<RectInt>::iterator j = rects.begin(); j != rects.end(); ++j) {
+				Tile::Handle piece = new Tile(tile->frame_id, *j);
+				piece->cairo_surface = crop_surface(
+					tile->cairo_surface,
+					j->minx - tile->rect.minx,
+					j->miny - tile->rect.miny,
+					j->get_width(),
+					j->get_height() );
+				pieces.push_back(piece);
+			}
+		}
+
+		i = erase_tile(list, i, events);
+	}
+
+	for(TileList::const_iterator i = pieces.begin(); i != pieces.end(); ++i)
+		insert_tile(list, *i);
+}
+
+RectInt
+Renderer_Canvas::frame_rect(const FrameId &id, const Rect &rect, const Vector &tl, const Vector &br)
+{
+	const int tile_grid_step = 64;
+	const int antialias_border = 2;
+
+	if (!is_finite_rect(rect))
+		return id.rect();
+
+	// pixel (0, 0) of the frame is always at the top-left corner of canvas,
+	// even if the rendered image is flipped (see enqueue_render_frame)
+	Real kx = approximate_equal(tl[0], br[0]) ? 0.0 : id.width/(br[0] - tl[0]);
+	Real ky = approximate_equal(tl[1], br[1]) ? 0.0 : id.height/(br[1] - tl[1]);
+	if (!kx || !ky)
+		return id.rect();
+
+	// clamp coordinates to avoid overflow of int
+	const Real border = tile_grid_step;
+	Real x0 = synfig::clamp((rect.minx - tl[0])*kx, -border, id.width  + border);
+	Real x1 = synfig::clamp((rect.maxx - tl[0])*kx, -border, id.width  + border);
+	Real y0 = synfig::clamp((rect.miny - tl[1])*ky, -border, id.height + border);
+	Real y1 = synfig::clamp((rect.maxy - tl[1])*ky, -border, id.height + border);
+	RectInt r(
+		(int)std::floor(std::min(x0, x1)) - antialias_border,
+		(int)std::floor(std::min(y0, y1)) - antialias_border,
+		(int)std::ceil (std::max(x0, x1)) + antialias_border,
+		(int)std::ceil (std::max(y0, y1)) + antialias_border );
+
+	r.minx = int_floor(r.minx, tile_grid_step);
+	r.miny = int_floor(r.miny, tile_grid_step);
+	r.maxx = int_ceil (r.maxx, tile_grid_step);
+	r.maxy = int_ceil (r.maxy, tile_grid_step);
+	return r &= id.rect();
+}
+
+void
+Renderer_Canvas::invalidate(const Rect &rect, const Time &time_begin, const Time &time_end)
+{
+	Canvas::Handle canvas = get_work_area() ? get_work_area()->get_canvas() : Canvas::Handle();
+	if (!canvas || is_empty_rect(rect))
+		return;
+	Vector tl = canvas->rend_desc().get_tl();
+	Vector br = canvas->rend_desc().get_br();
+
+	rendering::Task::List events;
+	bool invalidated = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(TileMap::iterator i = tiles.begin(); i != tiles.end(); ++i) {
+			if (i->first.time < time_begin || time_end < i->first.time)
+				continue;
+			RectInt r = frame_rect(i->first, rect, tl, br);
+			if (r.is_valid()) {
+				invalidate_tiles(i->second, r, events);
+				rendering_error_msg_map.erase(i->first.time);
+				invalidated = true;
+			}
+		}
+	}
+	rendering::Renderer::cancel(events);
+	if (invalidated && get_work_area())
+		get_work_area()->signal_rendering()();
+}
+
+void
+Renderer_Canvas::build_layer_bounds(const Canvas::Handle &canvas, LayerBoundsList &out_list) const
+{
+	out_list.clear();
+	if (!canvas) return;
+
+	// the same params as used by enqueue_render_frame()
+	const Context begin = canvas->get_context(ContextParams(true));
+
+	// empty context after the last layer, gives the area covered by layer itself
+	Context end = begin;
+	while(!end->empty()) ++end;
+
+	for(Context context = begin; !context->empty(); ++context) {
+		const Layer::Handle &layer = *context;
+		if (!context.active())
+			{ out_list.push_back(LayerBounds(layer.get(), Rect::zero())); continue; }
+
+		// groups return the bounds of their content here,
+		// but transformations and filters have no area of their own,
+		// so they affect the whole area of their context
+		Rect rect = layer->get_full_bounding_rect(end);
+		if (layer->reads_context() || is_empty_rect(rect))
+			rect = layer->get_full_bounding_rect(context.get_next());
+		out_list.push_back(LayerBounds(layer.get(), rect));
+	}
+}
+
+void
+Renderer_Canvas::get_changes_time_range(
+	const std::set<const Layer*> &layers,
+	const Time &time,
+	Time &out_begin,
+	Time &out_end ) const
+{
+	out_begin = Time::begin();
+	out_end = Time::end();
+
+	// out of animation mode the change is applied to the whole timeline
+	CanvasView::Handle canvas_view = get_work_area() ? get_work_area()->get_canvas_view() : CanvasView::Handle();
+	if (!canvas_view || !(canvas_view->get_mode() & synfigapp::MODE_ANIMATE))
+		return;
+
+	// in animation mode the change is a waypoint at the current time,
+	// it changes the interpolation until the second waypoint at each side,
+	// because tangents of the neighbour waypoints depend on it
+	Node::time_set times;
+	for(std::set<const Layer*>::const_iterator i = layers.begin(); i != layers.end(); ++i)
+		times.insert((*i)->get_times().begin(), (*i)->get_times().end());
+
+	Node::time_set::const_iterator next = times.upper_bound(TimePoint(time));
+	if (next != times.end() && ++next != times.end())
+		out_end = next->get_time();
+	Node::time_set::const_reverse_iterator prev(times.lower_bound(TimePoint(time)));
+	if (prev != times.rend() && ++prev != times.rend())
+		out_begin = prev->get_time();
+}
+
+void
+Renderer_Canvas::invalidate_changes()
+{
+	Canvas::Handle canvas = get_work_area() ? get_work_area()->get_canvas() : Canvas::Handle();
+
+	std::set<const Layer*> changed;
+	changed.swap(changed_layers);
+
+	bool localized = canvas
+	              && layer_bounds_valid
+	              && !changed.empty()
+	              && layer_bounds_time == canvas->get_time()
+	              && layer_bounds_tl == canvas->rend_desc().get_tl()
+	              && layer_bounds_br == canvas->rend_desc().get_br();
+
+	LayerBoundsList prev_bounds;
+	prev_bounds.swap(layer_bounds);
+	build_layer_bounds(canvas, layer_bounds);
+	layer_bounds_valid = false;
+	if (!canvas)
+		{ clear_render(); return; }
+
+	// layers must be the same and in the same order,
+	// otherwise the layer was inserted, removed or moved without notification
+	if (localized && prev_bounds.size() != layer_bounds.size())
+		localized = false;
+
+	// collect dirty area from the bottom layer to the top one,
+	// the layers above the changed ones may spread the change inside of their bounds
+	Rect dirty = Rect::zero();
+	bool has_dirty = false;
+	for(int i = (int)layer_bounds.size() - 1; localized && i >= 0; --i) {
+		const LayerBounds &prev = prev_bounds[i];
+		const LayerBounds &curr = layer_bounds[i];
+		if (prev.layer != curr.layer || curr.layer->get_z_depth() != 0.f)
+			{ localized = false; break; }
+
+		// layer changed silently if its bounds was changed
+		if (changed.count(curr.layer) || prev.rect != curr.rect) {
+			if (!is_finite_rect(prev.rect) || !is_finite_rect(curr.rect))
+				{ localized = false; break; }
+			if (!is_empty_rect(prev.rect))
+				{ dirty = has_dirty ? dirty | prev.rect : prev.rect; has_dirty = true; }
+			if (!is_empty_rect(curr.rect))
+				{ dirty = has_dirty ? dirty | curr.rect : curr.rect; has_dirty = true; }
+		} else
+		if (has_dirty && !is_empty_rect(curr.rect)) {
+			if (!is_finite_rect(curr.rect))
+				{ localized = false; break; }
+			if (!is_empty_rect(curr.rect & dirty))
+				dirty |= curr.rect;
+		}
+	}
+
+	if (!localized)
+		{ clear_render(); return; }
+
+	layer_bounds_valid = true;
+	layer_bounds_time = canvas->get_time();
+	layer_bounds_tl = canvas->rend_desc().get_tl();
+	layer_bounds_br = canvas->rend_desc().get_br();
+
+	// bounds of layers are known for the current time only,
+	// so frames at the other times within the range of the change are invalidated entirely
+	Time time_begin, time_end;
+	get_changes_time_range(changed, layer_bounds_time, time_begin, time_end);
+	if (has_dirty)
+		invalidate(dirty, layer_bounds_time, layer_bounds_time);
+	if (time_begin < layer_bounds_time)
+		invalidate(Rect::full_plane(), time_begin, layer_bounds_time - Time::epsilon());
+	if (layer_bounds_time < time_end)
+		invalidate(Rect::full_plane(), layer_bounds_time + Time::epsilon(), time_end);
+	get_work_area()->signal_rendering()();
+}
+
+void
+Renderer_Canvas::on_canvas_child_changed(const Node *node)
+{
+	// accept only direct children of the canvas,
+	// changes of nested layers are reported by their parents
+	const Layer *layer = dynamic_cast<const Layer*>(node);
+	Canvas::Handle canvas = get_work_area() ? get_work_area()->get_canvas() : Canvas::Handle();
+	if (layer && canvas && layer->get_canvas().get() == canvas.get())
+		changed_layers.insert(layer);
+}
+
 Renderer_Canvas::FrameStatus
 Renderer_Canvas::merge_status(FrameStatus a, FrameStatus b) {
 	static const FrameStatus map[FS_Count][FS_Count] = {
@@ -33,6 +33,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 
 #include <synfig/canvas.h>
 #include <synfig/rendering/task.h>
@@ -135,6 +136,17 @@ public:
 	typedef std::vector<Tile::Handle> TileList;
 	typedef std::map<FrameId, TileList> TileMap;
 
+	class LayerBounds {
+	public:
+		const synfig::Layer *layer;
+		synfig::Rect rect;
+		LayerBounds(): layer() { }
+		LayerBounds(const synfig::Layer *layer, const synfig::Rect &rect):
+			layer(layer), rect(rect) { }
+	};
+
+	typedef std::vector<LayerBounds> LayerBoundsList;
+
 private:
 	// cache options
 	const long long max_tiles_size_soft; //!< threshold for creation of new tiles
@@ -162,9 +174,22 @@ private:
 	FrameId current_frame;
 	synfig::Time frame_duration;
 
-	//! increment of this field makes all tiles outdated
+	//! summary size of all stored tiles in bytes
 	long long tiles_size;
 
+	// fields below are used from the main thread only
+
+	//! bounds of the layers of canvas at the time of current frame,
+	//! they are stored before change to know which area was covered by layer
+	LayerBoundsList layer_bounds;
+	bool layer_bounds_valid;
+	synfig::Time layer_bounds_time;
+	synfig::Vector layer_bounds_tl;
+	synfig::Vector layer_bounds_br;
+
+	//! layers which was changed since last call of invalidate_changes()
+	std::set<const synfig::Layer*> changed_layers;
+
 	synfig::PixelFormat pixel_format;
 
 	//! uses to normalize alpha value after blending of onion surfaces
@@ -201,6 +226,27 @@ private:
 	//! mutex must be locked before call
 	void remove_extra_tiles(synfig::rendering::Task::List &events);
 
+	//! mutex must be locked before call
+	//! removes parts of tiles which intersects with rect (in pixels),
+	//! already rendered parts outside of rect are kept
+	void invalidate_tiles(TileList &list, const synfig::RectInt &rect, synfig::rendering::Task::List &events);
+
+	//! converts rect in canvas units into rect of pixels of frame, snapped to the tile grid
+	static synfig::RectInt frame_rect(
+		const FrameId &id,
+		const synfig::Rect &rect,
+		const synfig::Vector &tl,
+		const synfig::Vector &br );
+
+	//! fills layer_bounds from the current state of canvas
+	void build_layer_bounds(const synfig::Canvas::Handle &canvas, LayerBoundsList &out_list) const;
+	//! range of times of frames which may be affected by the change of \a layers at \a time
+	void get_changes_time_range(
+		const std::set<const synfig::Layer*> &layers,
+		const synfig::Time &time,
+		synfig::Time &out_begin,
+		synfig::Time &out_end ) const;
+
 	//! mutex must be locked before call
 	void build_onion_frames();
 
@@ -228,6 +274,20 @@ public:
 	void wait_render();
 	void clear_render();
 
+	//! removes the tiles of frames in time range [time_begin, time_end]
+	//! which intersects with rect (in canvas units)
+	void invalidate(
+		const synfig::Rect &rect,
+		const synfig::Time &time_begin = synfig::Time::begin(),
+		const synfig::Time &time_end = synfig::Time::end() );
+
+	//! removes only the tiles covered by layers which was changed since previous call,
+	//! calls clear_render() when area of changes cannot be determined
+	void invalidate_changes();
+
+	//! should be connected to signal_child_changed() of the canvas
+	void on_canvas_child_changed(const synfig::Node *node);
+
 	void get_render_status(StatusMap &out_map);
 
 	void get_rendering_error_messages(std::vector<std::string>& messages);